@@ -0,0 +1,237 @@
+// addr_pool_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Test and benchmark of the address allocator (cf. addr_pool.c)
+// across networks of different prefix lengths and pool sizes. For every pool,
+// all addresses are allocated and checked to be handed out in ascending order,
+// once each, within the network and without the network's, broadcast and
+// router's address; then addresses are released and allocated again. The time
+// of allocating and releasing the last free address of an otherwise full pool
+// is measured over -n rounds (minimum of -r repetitions) and compared to a
+// linear scan of the range, like the former allocation of the DHCP-server.
+//
+// Finally, the router is brought up with a /22-network, whose router address
+// isn't X.X.X.1 and whose DHCP-range spans four /24-blocks, and the clients of
+// the soft access-point get their addresses via DHCP.
+//
+// Usage: addr_pool_bench [-v] [-n rounds] [-r repeat]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "router.h"
+#include "uplink_sched.h"
+#include "addr_pool.h"
+#include "config.h"
+#include "dhcp_server.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+
+/*------------------------------------*/
+
+#define BENCH_STATION_ADDR "10.0.0.42"
+#define BENCH_STATION_NETMASK "255.255.255.0"
+#define BENCH_STATION_GW "10.0.0.1"
+
+#define BENCH_CLIENTS 8
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Pool of a network
+struct bench_pool {
+  const char *name;
+  const char *ip;
+  const char *netmask;
+  const char *start;
+  const char *stop;
+};
+
+// Declaration and initialization of variables:
+
+static const struct bench_pool bench_pools[] = {
+  {"/28", "192.168.13.1", "255.255.255.240", "192.168.13.0", "192.168.13.15"},
+  {"/24", "192.168.13.1", "255.255.255.0", "192.168.13.2", "192.168.13.64"},
+  {"/24-full", "192.168.13.100", "255.255.255.0", "192.168.13.0", "192.168.13.255"},
+  {"/22", "172.16.3.254", "255.255.252.0", "172.16.0.1", "172.16.3.254"},
+  {"/16", "10.20.0.1", "255.255.0.0", "10.20.0.0", "10.20.255.255"},
+  {"/8", "10.0.0.1", "255.0.0.0", "10.128.0.0", "10.128.3.255"},
+};
+
+static uint32_t failures = 0;
+static uint32_t bench_rounds = 10000;
+static uint32_t bench_repeat = 5;
+
+static uint8_t bench_used[ADDR_POOL_MAX];   // State of the linear scan
+static uint32_t bench_last = 0;             // Highest allocated address
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t bench_ntohl(uint32_t ip) {
+  const uint8_t *bytes = (const uint8_t *) &ip;
+
+  return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Allocate the lowest free address by a linear scan of the range
+static uint32_t bench_linear_alloc(uint16_t size) {
+  uint16_t idx;
+
+  for (idx = 0; idx < size; idx++) {
+    if (!bench_used[idx]) {
+      bench_used[idx] = 1;
+      return idx + 1;
+    }
+  }
+  return 0;
+}
+
+// Check the allocation of all addresses of the pool; returns the number of
+// allocated addresses
+static uint32_t bench_check(const struct bench_pool *config, struct addr_pool *pool) {
+  uint32_t ip = ipaddr_addr(config->ip), netmask = ipaddr_addr(config->netmask);
+  uint32_t addr, prev = 0, count = 0, first = 0;
+
+  CHECK(addr_pool_init(pool, ip, netmask, ipaddr_addr(config->start), ipaddr_addr(config->stop)));
+  CHECK(!addr_pool_is_free(pool, ip) && !addr_pool_take(pool, ip));
+  while ((addr = addr_pool_alloc(pool)) != 0) {
+    CHECK((addr & netmask) == (ip & netmask));
+    CHECK(addr != ip && (addr & ~netmask) != 0 && (addr & ~netmask) != ~netmask);
+    CHECK(bench_ntohl(addr) > prev);
+    CHECK(addr_pool_contains(pool, addr) && !addr_pool_is_free(pool, addr));
+    prev = bench_ntohl(addr);
+    first = (first) ? first : addr;
+    count++;
+  }
+  CHECK(pool->used == pool->size && !pool->summary);
+
+  // Released addresses are handed out again, the lowest first
+  bench_last = bench_ntohl(prev);
+  addr_pool_release(pool, bench_last);
+  addr_pool_release(pool, first);
+  addr_pool_release(pool, first);
+  CHECK(pool->used == pool->size - 2);
+  CHECK(addr_pool_alloc(pool) == first && addr_pool_alloc(pool) == bench_last);
+  CHECK(!addr_pool_is_free(pool, first) && !addr_pool_take(pool, first));
+  return count;
+}
+
+// Measure allocating and releasing the last free address of a full pool;
+// returns the minimum time per round in ns
+static double bench_run(struct addr_pool *pool, bool linear) {
+  uint64_t start, ns, min_ns = ~0ULL;
+  uint32_t round, rep, addr = 0, sink = 0;
+
+  os_memset(bench_used, 1, pool->size);
+  for (rep = 0; rep < bench_repeat; rep++) {
+    start = host_clock_ns();
+    for (round = 0; round < bench_rounds; round++) {
+      if (linear) {
+        bench_used[pool->size - 1] = 0;
+        sink += bench_linear_alloc(pool->size);
+      }
+      else {
+        addr_pool_release(pool, bench_last);
+        addr = addr_pool_alloc(pool);
+        sink += addr;
+      }
+    }
+    ns = host_clock_ns() - start;
+    min_ns = (ns < min_ns) ? ns : min_ns;
+  }
+  CHECK(sink != 0 && (linear || addr == bench_last));
+  return (double) min_ns / bench_rounds;
+}
+
+/*------------------------------------*/
+
+static void bench_usage(void) {
+  fprintf(stderr, "Usage: addr_pool_bench [-v] [-n rounds] [-r repeat]\n");
+}
+
+int main(int argc, char **argv) {
+  struct addr_pool pool;
+  struct host_dhcp_reply reply;
+  struct ip_info softap_info;
+  uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint32_t idx, count, expected;
+  double bitmap_ns, linear_ns;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vn:r:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': bench_rounds = strtoul(optarg, NULL, 0); break;
+      case 'r': bench_repeat = strtoul(optarg, NULL, 0); break;
+      default: bench_usage(); return 1;
+    }
+  }
+  if (!bench_rounds || !bench_repeat) {
+    bench_usage();
+    return 1;
+  }
+
+  printf("%-10s %16s %6s %10s %10s\n", "pool", "router", "addrs", "bitmap_ns", "linear_ns");
+  for (idx = 0; idx < sizeof(bench_pools) / sizeof(bench_pools[0]); idx++) {
+    count = bench_check(&bench_pools[idx], &pool);
+    expected = pool.size - addr_pool_contains(&pool, ipaddr_addr(bench_pools[idx].ip));
+    CHECK(count == expected);
+    bitmap_ns = bench_run(&pool, false);
+    linear_ns = bench_run(&pool, true);
+    printf("%-10s %16s %6u %10.1f %10.1f\n", bench_pools[idx].name, bench_pools[idx].ip, count, bitmap_ns, linear_ns);
+  }
+
+  // Invalid ranges are rejected
+  CHECK(!addr_pool_init(&pool, ipaddr_addr("192.168.13.1"), ipaddr_addr("255.255.255.0"), ipaddr_addr("192.168.13.64"), ipaddr_addr("192.168.13.2")));
+  CHECK(!addr_pool_init(&pool, ipaddr_addr("192.168.13.1"), ipaddr_addr("255.255.255.0"), ipaddr_addr("192.168.13.2"), ipaddr_addr("192.168.14.2")));
+  CHECK(!addr_pool_init(&pool, ipaddr_addr("192.168.13.1"), ipaddr_addr("255.255.255.0"), ipaddr_addr("192.168.13.255"), ipaddr_addr("192.168.13.255")));
+
+  // The router keeps its configured address in a /22-network and serves the
+  // clients from a range across several /24-blocks
+  CHECK(config_set("ap_addr", "172.16.3.254") && config_set("ap_netmask", "255.255.252.0") && config_set("ap_gw", "172.16.3.254"));
+  CHECK(config_set("dhcp_start", "172.16.0.250") && config_set("dhcp_stop", "172.16.3.253"));
+  CHECK(config_save());
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "addr_pool_bench: Failed to bring up the router!\n");
+    return 1;
+  }
+  CHECK(wifi_get_ip_info(SOFTAP_IF, &softap_info) && softap_info.ip.addr == ipaddr_addr("172.16.3.254"));
+  dhcp_server_flush();
+  for (idx = 0; idx < BENCH_CLIENTS; idx++) {
+    mac[5] = idx + 1;
+    host_wifi_sta_connected(mac);
+    CHECK(host_dhcp_exchange(HOST_DHCP_DISCOVER, mac, 0, (idx == 1) ? ipaddr_addr("172.16.2.77") : 0, 0, &reply) && reply.type == HOST_DHCP_OFFER);
+    CHECK(host_dhcp_exchange(HOST_DHCP_REQUEST, mac, 0, reply.yiaddr, reply.server, &reply) && reply.type == HOST_DHCP_ACK);
+    CHECK(reply.netmask == ipaddr_addr("255.255.252.0") && reply.router == ipaddr_addr("172.16.3.254"));
+    if (idx == 1) {
+      CHECK(reply.yiaddr == ipaddr_addr("172.16.2.77"));
+    }
+    else {
+      // 172.16.0.250 to 172.16.0.255 and 172.16.1.0 are host addresses of
+      // the /22-network
+      CHECK(bench_ntohl(reply.yiaddr) == bench_ntohl(ipaddr_addr("172.16.0.250")) + idx - (idx > 1));
+    }
+  }
+  printf("dhcp: %u clients in " IPSTR "/22, last " IPSTR "\n", dhcp_server_count(), IP2STR(&softap_info.ip), IP2STR(&reply.yiaddr));
+  CHECK(dhcp_server_count() == BENCH_CLIENTS);
+
+  if (failures) {
+    printf("addr_pool_bench: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,197 @@
+// batch_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Benchmark of the batched processing of received frames (cf.
+// napt_netif_set_batch). The router is brought up like on the device and
+// MAX_CLIENTS clients send UDP-datagrams of BENCH_FLOWS_PER_CLIENT flows each
+// (every fourth one full-sized, the others small); every datagram is answered
+// by its peer. The frames are injected in groups of the batch size, i.e. like
+// the WiFi-driver delivers a burst of frames, followed by the task processing
+// an incomplete batch.
+//
+// Every round injects the frames of both directions once per batch size of 1,
+// 4, 8 and 16 frames (interleaved, so that a disturbance of the host doesn't
+// penalize a single size). The packets/s of the fastest round per size and
+// direction (measured with the host's real clock) are reported together with
+// the speedup relative to the unbatched processing; every packet has to be
+// forwarded.
+//
+// Usage: batch_bench [-v] [-n packets] [-r rounds]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "napt_netif.h"
+#include "router.h"
+#include "uplink_sched.h"
+#include "user_config.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define BENCH_STATION_ADDR "10.0.0.42"
+#define BENCH_STATION_NETMASK "255.255.255.0"
+#define BENCH_STATION_GW "10.0.0.1"
+
+#define BENCH_FRAME_MAX 1600
+#define BENCH_FLOWS_PER_CLIENT 4
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+struct bench_frame {
+  uint8_t data[BENCH_FRAME_MAX];
+  uint16_t len;
+};
+
+// Declaration and initialization of variables:
+
+static const uint8_t bench_batch_sizes[] = {1, 4, 8, 16};
+
+static uint32_t failures = 0;
+static uint32_t bench_packets = 4096;
+static uint32_t bench_rounds = 20;
+
+static struct bench_frame *bench_outbound = NULL;  // Frames of the clients
+static struct bench_frame *bench_inbound = NULL;   // Answers of the peers
+static uint32_t bench_inbound_count = 0;
+static bool bench_collect = false;
+static uint32_t bench_sent = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Count the frames sent by the router; while collecting, the answers to the
+// frames of the clients are stored
+static void bench_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  bench_sent++;
+  if (bench_collect && if_index == STATION_IF && bench_inbound_count < bench_packets && len <= BENCH_FRAME_MAX) {
+    bench_inbound[bench_inbound_count].len = host_packet_reply(frame, len, bench_inbound[bench_inbound_count].data);
+    if (bench_inbound[bench_inbound_count].len) {
+      bench_inbound_count++;
+    }
+  }
+}
+
+// Inject the given frames in groups of batch frames on the network interface
+// if_index; returns the elapsed real time (in ns)
+static uint64_t bench_inject(const struct bench_frame *frames, uint32_t count, uint8_t if_index, uint8_t batch) {
+  uint64_t start = host_clock_ns();
+  uint32_t idx;
+
+  for (idx = 0; idx < count; idx++) {
+    host_netif_input(if_index, frames[idx].data, frames[idx].len);
+    if ((idx + 1) % batch == 0 || idx + 1 == count) {
+      host_os_run();
+    }
+  }
+  return host_clock_ns() - start;
+}
+
+/*------------------------------------*/
+
+static void bench_usage(void) {
+  fprintf(stderr, "Usage: batch_bench [-v] [-n packets] [-r rounds]\n");
+}
+
+int main(int argc, char **argv) {
+  double pps[2][sizeof(bench_batch_sizes)], base;
+  uint8_t softap_mac[6], station_mac[6];
+  struct ip_info softap_info;
+  uint32_t idx, round, flow, sent;
+  uint64_t ns[2][sizeof(bench_batch_sizes)], elapsed;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vn:r:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': bench_packets = strtoul(optarg, NULL, 0); break;
+      case 'r': bench_rounds = strtoul(optarg, NULL, 0); break;
+      default: bench_usage(); return 1;
+    }
+  }
+  if (!bench_packets || !bench_rounds) {
+    bench_usage();
+    return 1;
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);  // Measure the forwarding itself (cf. uplink_sim)
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "batch_bench: Failed to bring up the router!\n");
+    return 1;
+  }
+  wifi_get_macaddr(SOFTAP_IF, softap_mac);
+  wifi_get_macaddr(STATION_IF, station_mac);
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  host_netif_tx_cb = bench_tx_cb;
+
+  bench_outbound = malloc(bench_packets * sizeof(struct bench_frame));
+  bench_inbound = malloc(bench_packets * sizeof(struct bench_frame));
+  if (!bench_outbound || !bench_inbound) {
+    fprintf(stderr, "batch_bench: Failed to allocate the frames!\n");
+    return 1;
+  }
+  for (idx = 0; idx < bench_packets; idx++) {
+    flow = idx % (MAX_CLIENTS * BENCH_FLOWS_PER_CLIENT);
+    bench_outbound[idx].len = host_packet_build(bench_outbound[idx].data, softap_mac, NAPT_PROTO_UDP, (softap_info.ip.addr & softap_info.netmask.addr) | ((2 + flow % MAX_CLIENTS) << 24),
+                                                41000 + flow / MAX_CLIENTS, IPADDR(198, 51, 100, 1 + flow), 5683, 0, (flow % 4) ? 64 : 1400);
+  }
+
+  // The first pass creates the translation entries and collects the answers
+  // of the peers
+  bench_collect = true;
+  bench_inject(bench_outbound, bench_packets, SOFTAP_IF, 1);
+  bench_collect = false;
+  CHECK(bench_inbound_count == bench_packets);
+  for (idx = 0; idx < bench_inbound_count; idx++) {
+    os_memcpy(bench_inbound[idx].data, station_mac, 6);
+  }
+
+  for (round = 0; round < bench_rounds; round++) {
+    for (idx = 0; idx < sizeof(bench_batch_sizes); idx++) {
+      napt_netif_set_batch(bench_batch_sizes[idx]);
+      sent = bench_sent;
+      elapsed = bench_inject(bench_outbound, bench_packets, SOFTAP_IF, bench_batch_sizes[idx]);
+      ns[0][idx] = (!round || elapsed < ns[0][idx]) ? elapsed : ns[0][idx];
+      elapsed = bench_inject(bench_inbound, bench_inbound_count, STATION_IF, bench_batch_sizes[idx]);
+      ns[1][idx] = (!round || elapsed < ns[1][idx]) ? elapsed : ns[1][idx];
+      CHECK(bench_sent - sent == bench_packets + bench_inbound_count);
+    }
+  }
+
+  printf("%-6s %12s %12s %9s %9s\n", "batch", "pps_out", "pps_in", "x_out", "x_in");
+  for (idx = 0; idx < sizeof(bench_batch_sizes); idx++) {
+    pps[0][idx] = (ns[0][idx]) ? (double) bench_packets * 1e9 / ns[0][idx] : 0;
+    pps[1][idx] = (ns[1][idx]) ? (double) bench_inbound_count * 1e9 / ns[1][idx] : 0;
+    base = (pps[0][0] > 0) ? pps[0][0] : 1;
+    printf("%-6u %12.0f %12.0f %9.2f", bench_batch_sizes[idx], pps[0][idx], pps[1][idx], pps[0][idx] / base);
+    base = (pps[1][0] > 0) ? pps[1][0] : 1;
+    printf(" %9.2f\n", pps[1][idx] / base);
+  }
+  napt_netif_set_batch(NAPT_BATCH_SIZE);
+  CHECK(napt_stats_get()->drops == 0);
+
+  free(bench_outbound);
+  free(bench_inbound);
+  if (failures) {
+    printf("batch_bench: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,248 @@
+// chksum_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side test and benchmark of the incremental checksum update
+// (cf. napt_chksum.c). First, random TCP-, UDP- and ICMP-packets are rewritten
+// like the NAPT-engine does (address and port resp. ICMP-identifier) and the
+// incrementally updated checksums are compared with a full recomputation.
+// Afterwards, the time per packet of the incremental update is compared with
+// rewriting the fields and recomputing the IP-header- and the transport-layer-
+// checksum over the whole packet, as inet_chksum resp. inet_chksum_pseudo in
+// liblwip.a do, for payloads of 64, 576 and 1460 bytes.
+//
+// Usage: chksum_bench [iterations per payload size]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "napt.h"
+#include "napt_chksum.h"
+
+/*------------------------------------*/
+
+#define BENCH_ITERATIONS_DEFAULT 2000000
+#define BENCH_PACKET_MAX 1600
+
+#define IP_HLEN 20
+
+/*------------------------------------*/
+
+static unsigned failures = 0;
+static volatile uint32_t bench_sink;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static uint32_t rnd_state = 0x2468ACE1;
+
+static uint32_t rnd(void) {
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+// Model of lwip_standard_chksum: one's complement sum over the given data
+static uint16_t full_sum(const uint8_t *data, uint16_t len, uint32_t sum) {
+  uint16_t idx;
+
+  for (idx = 0; idx + 1 < len; idx += 2) {
+    sum += (data[idx] << 8) | data[idx+1];
+  }
+  if (len & 1) {
+    sum += data[len-1] << 8;
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return (uint16_t) sum;
+}
+
+static uint16_t l4_chksum_offset(uint8_t proto) {
+  return (proto == NAPT_PROTO_TCP) ? 16 : (proto == NAPT_PROTO_UDP) ? 6 : 2;
+}
+
+static uint16_t l4_hlen(uint8_t proto) {
+  return (proto == NAPT_PROTO_TCP) ? 20 : 8;
+}
+
+// Recompute the IP-header- and the transport-layer-checksum of a packet over
+// the whole packet (equivalent of inet_chksum and inet_chksum_pseudo)
+static void full_chksum(uint8_t *pkt, uint16_t len) {
+  uint8_t *l4 = pkt + IP_HLEN, proto = pkt[9];
+  uint16_t l4len = len - IP_HLEN, off = l4_chksum_offset(proto), chksum;
+  uint32_t sum = 0;
+
+  pkt[10] = pkt[11] = 0;
+  chksum = ~full_sum(pkt, IP_HLEN, 0);
+  pkt[10] = chksum >> 8;
+  pkt[11] = chksum & 0xFF;
+
+  l4[off] = l4[off+1] = 0;
+  if (proto != NAPT_PROTO_ICMP) {
+    sum = full_sum(pkt + 12, 8, 0) + proto + l4len;
+  }
+  chksum = ~full_sum(l4, l4len, sum);
+  if (proto == NAPT_PROTO_UDP && !chksum) {
+    chksum = 0xFFFF;
+  }
+  l4[off] = chksum >> 8;
+  l4[off+1] = chksum & 0xFF;
+}
+
+// Verify the IP-header- and the transport-layer-checksum of a packet
+static bool full_valid(const uint8_t *pkt, uint16_t len) {
+  uint8_t proto = pkt[9];
+  uint32_t sum = 0;
+
+  if (full_sum(pkt, IP_HLEN, 0) != 0xFFFF) {
+    return false;
+  }
+  if (proto != NAPT_PROTO_ICMP) {
+    sum = full_sum(pkt + 12, 8, 0) + proto + (len - IP_HLEN);
+  }
+  return full_sum(pkt + IP_HLEN, len - IP_HLEN, sum) == 0xFFFF;
+}
+
+// Build a packet with random addresses, ports and payload
+static uint16_t packet_build(uint8_t *pkt, uint8_t proto, uint16_t payload) {
+  uint16_t len = IP_HLEN + l4_hlen(proto) + payload, idx;
+
+  for (idx = 0; idx < len; idx++) {
+    pkt[idx] = rnd();
+  }
+  pkt[0] = 0x45;
+  pkt[2] = len >> 8;
+  pkt[3] = len & 0xFF;
+  pkt[9] = proto;
+  if (proto == NAPT_PROTO_ICMP) {
+    pkt[IP_HLEN] = 8;
+  }
+  full_chksum(pkt, len);
+  return len;
+}
+
+// Rewrite the source address and port resp. ICMP-identifier of a packet and
+// update the checksums incrementally (like napt_rewrite)
+static void incremental_rewrite(uint8_t *pkt, uint32_t addr, uint16_t port) {
+  uint8_t proto = pkt[9], *l4 = pkt + IP_HLEN, *field = l4 + ((proto == NAPT_PROTO_ICMP) ? 4 : 0);
+  uint8_t *chksum = l4 + l4_chksum_offset(proto);
+  uint32_t delta = napt_chksum_delta(0, pkt + 12, (uint8_t *) &addr, 4);
+
+  napt_chksum_apply(pkt + 10, delta);
+  napt_chksum_apply(chksum, napt_chksum_delta((proto != NAPT_PROTO_ICMP) ? delta : 0, field, (uint8_t *) &port, 2));
+  if (!chksum[0] && !chksum[1]) {
+    chksum[0] = chksum[1] = 0xFF;
+  }
+  os_memcpy(pkt + 12, &addr, 4);
+  os_memcpy(field, &port, 2);
+}
+
+// Rewrite the same fields and recompute the checksums over the whole packet
+static void full_rewrite(uint8_t *pkt, uint16_t len, uint32_t addr, uint16_t port) {
+  uint8_t *l4 = pkt + IP_HLEN;
+
+  os_memcpy(pkt + 12, &addr, 4);
+  os_memcpy(l4 + ((pkt[9] == NAPT_PROTO_ICMP) ? 4 : 0), &port, 2);
+  full_chksum(pkt, len);
+}
+
+/*------------------------------------*/
+
+// Tests:
+
+static void test_incremental(void) {
+  static const uint8_t protos[] = {NAPT_PROTO_TCP, NAPT_PROTO_UDP, NAPT_PROTO_ICMP};
+  uint8_t pkt[BENCH_PACKET_MAX], ref[BENCH_PACKET_MAX];
+  uint16_t len, off;
+  uint32_t idx, mismatches = 0, invalid = 0;
+
+  for (idx = 0; idx < 100000; idx++) {
+    len = packet_build(pkt, protos[idx % 3], rnd() % 1461);
+    os_memcpy(ref, pkt, len);
+    incremental_rewrite(pkt, rnd(), rnd());
+    invalid += !full_valid(pkt, len);
+    invalid += !napt_chksum_valid(pkt, IP_HLEN);
+    pkt[idx % IP_HLEN] ^= 1 << (idx % 8);
+    invalid += napt_chksum_valid(pkt, IP_HLEN);
+    pkt[idx % IP_HLEN] ^= 1 << (idx % 8);
+
+    // Both results have to match (0x0000 and 0xFFFF are equivalent)
+    os_memcpy(ref + 12, pkt + 12, 8);
+    os_memcpy(ref + IP_HLEN, pkt + IP_HLEN, l4_hlen(pkt[9]));
+    full_chksum(ref, len);
+    off = IP_HLEN + l4_chksum_offset(pkt[9]);
+    if (os_memcmp(ref + 10, pkt + 10, 2) != 0 || (os_memcmp(ref + off, pkt + off, 2) != 0 && !((ref[off] | ref[off+1]) == 0 || (ref[off] & ref[off+1]) == 0xFF))) {
+      mismatches++;
+    }
+  }
+  CHECK(invalid == 0);
+  CHECK(mismatches == 0);
+
+  // Edge cases of the one's complement arithmetic
+  os_memset(pkt, 0, sizeof(pkt));
+  len = packet_build(pkt, NAPT_PROTO_UDP, 0);
+  incremental_rewrite(pkt, 0, 0);
+  CHECK(full_valid(pkt, len));
+  incremental_rewrite(pkt, 0xFFFFFFFF, 0xFFFF);
+  CHECK(full_valid(pkt, len));
+}
+
+/*------------------------------------*/
+
+// Benchmark:
+
+static void bench(uint8_t proto, uint16_t payload, uint32_t iterations) {
+  uint8_t pkt[BENCH_PACKET_MAX];
+  uint16_t len = packet_build(pkt, proto, payload);
+  uint32_t idx, addrs[2] = {rnd(), rnd()};
+  uint16_t ports[2] = {rnd(), rnd()};
+  uint64_t start, incremental_ns, full_ns;
+
+  // Alternate between two translations, so that every iteration changes the
+  // packet
+  start = host_clock_ns();
+  for (idx = 0; idx < iterations; idx++) {
+    incremental_rewrite(pkt, addrs[idx & 1], ports[idx & 1]);
+  }
+  incremental_ns = host_clock_ns() - start;
+  bench_sink += pkt[10];
+  CHECK(full_valid(pkt, len));
+
+  start = host_clock_ns();
+  for (idx = 0; idx < iterations; idx++) {
+    full_rewrite(pkt, len, addrs[idx & 1], ports[idx & 1]);
+  }
+  full_ns = host_clock_ns() - start;
+  bench_sink += pkt[10];
+  CHECK(full_valid(pkt, len));
+
+  printf("%-4s %4u bytes: incremental %7.1f ns/packet | full %7.1f ns/packet | speedup %6.1fx\n", (proto == NAPT_PROTO_TCP) ? "TCP" : (proto == NAPT_PROTO_UDP) ? "UDP" : "ICMP",
+         payload, (double) incremental_ns / iterations, (double) full_ns / iterations, (double) full_ns / incremental_ns);
+}
+
+int main(int argc, char **argv) {
+  static const uint16_t payloads[] = {64, 576, 1460};
+  static const uint8_t protos[] = {NAPT_PROTO_TCP, NAPT_PROTO_UDP, NAPT_PROTO_ICMP};
+  uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_ITERATIONS_DEFAULT;
+  unsigned proto, payload;
+
+  test_incremental();
+  printf("chksum_bench: %s\n", failures ? "tests FAILED" : "tests passed");
+
+  for (proto = 0; proto < sizeof(protos); proto++) {
+    for (payload = 0; payload < sizeof(payloads) / sizeof(payloads[0]); payload++) {
+      // The full recomputation is O(n), so scale the iterations down
+      bench(protos[proto], payloads[payload], iterations / (1 + payloads[payload] / 64));
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+// config_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side simulation of the configuration store (cf. config.c)
+// on the emulated flash. The router is brought up with the defaults of an
+// erased flash and reconfigured via DEVICE_COM_PORT by a client of the soft
+// access-point (requests from other networks have to be rejected). The
+// following is checked:
+//
+//  - the records are written alternately to the sectors A and B and the newest
+//    one is loaded again
+//  - inconsistent configurations and invalid values are rejected; the
+//    modifications are staged and only applied, once they have been saved
+//  - a power failure while saving (the newest sector erased resp. only partly
+//    written) falls back to the previous record, a corruption of both records
+//    to the defaults
+//  - the router comes up with the stored SSID-prefix, network, number of
+//    clients and portmaps (without the cleared ones) after a restart
+//
+// Finally, the time of config_load with two valid records is measured over -n
+// calls (the minimum is taken, since the host is noisy; on the device, it's
+// reported by the CONFIG-request).
+//
+// Usage: config_sim [-v] [-n calls]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "espconn.h"
+#include "spi_flash.h"
+#include "user_interface.h"
+#include "router.h"
+#include "device_info.h"
+#include "uplink_sched.h"
+#include "napt.h"
+#include "config.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_REPLY_MAX 1500
+#define SIM_LOAD_MAX_US 1000
+
+#define HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) >> 8) & 0xFF)))
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+uint32 user_rf_cal_sector_set(void);
+
+static uint32_t failures = 0;
+static uint32_t sim_calls = 1000;
+
+static const uint8_t sim_client_ip[4] = {192, 168, 13, 2};    // Client of the soft access-point
+static const uint8_t sim_foreign_ip[4] = {10, 0, 0, 99};      // Host in the station's network
+static const uint8_t sim_moved_ip[4] = {10, 20, 0, 10};       // Client of the reconfigured soft access-point
+static const uint8_t *sim_remote_ip = sim_client_ip;
+
+static char sim_reply[SIM_REPLY_MAX + 1];
+static uint16_t sim_reply_len = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static void sim_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  if (espconn->proto.udp->local_port == DEVICE_COM_PORT && len <= SIM_REPLY_MAX) {
+    os_memcpy(sim_reply, data, len);
+    sim_reply[len] = '\0';
+    sim_reply_len = len;
+  }
+}
+
+// Send the request to DEVICE_COM_PORT and return the reply
+static const char *sim_request(const char *request) {
+  sim_reply_len = 0;
+  sim_reply[0] = '\0';
+  host_espconn_recv(DEVICE_COM_PORT, sim_remote_ip, 50000, (char *) request, strlen(request));
+  return sim_reply;
+}
+
+// Set the key via DEVICE_COM_PORT; returns true, if the router replied "OK"
+static bool sim_set(const char *key, const char *value) {
+  char request[128];
+
+  snprintf(request, sizeof(request), "%s%s %s\n", CONFIG_SET_REQUEST_STRING, key, value);
+  return !strcmp(sim_request(request), "OK\n");
+}
+
+static uint32_t sim_sector(uint8_t slot) {
+  return user_rf_cal_sector_set() - 2 - slot;
+}
+
+// Emulate a power failure while saving to the given slot: the sector has been
+// erased and only the first len bytes of the record have been written
+static void sim_power_fail(uint8_t slot, uint32_t len) {
+  uint32 record[128];
+
+  spi_flash_read(sim_sector(slot) * SPI_FLASH_SEC_SIZE, record, sizeof(record));
+  spi_flash_erase_sector(sim_sector(slot));
+  if (len) {
+    spi_flash_write(sim_sector(slot) * SPI_FLASH_SEC_SIZE, record, len);
+  }
+}
+
+// Restart the router, like on its next activation
+static void sim_router_restart(void) {
+  router_set_hitless_reconnect(false);
+  host_wifi_disconnected(REASON_BEACON_TIMEOUT);
+  router_init();
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: config_sim [-v] [-n calls]\n");
+}
+
+int main(int argc, char **argv) {
+  const struct config_stats *stats = config_stats_get();
+  const struct config *config = config_get();
+  struct softap_config ap_conf;
+  struct ip_info softap_info;
+  struct host_flash_stats flash_before;
+  uint64_t start, ns, min_ns = ~0ULL;
+  uint32_t call, erases;
+  char long_prefix[CONFIG_SSID_PREFIX_LEN + 1];
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vn:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': sim_calls = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!sim_calls) {
+    sim_usage();
+    return 1;
+  }
+
+  // An erased flash yields the defaults
+  host_flash_erase();
+  CHECK(!config_load());
+  CHECK(stats->slot == 0xFF && stats->seq == 0);
+  CHECK(!strcmp(config->ssid_prefix, WIFI_AP_SSID_PREFIX));
+  CHECK(config->ap_addr == ipaddr_addr(WIFI_AP_NETWORK_ADDR) && config->max_clients == MAX_CLIENTS);
+  CHECK(config->portmap[0].proto == 6 && config->portmap[0].mport == 8883);
+  CHECK(config_check(config));
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "config_sim: Failed to bring up the router!\n");
+    return 1;
+  }
+  device_info_init();
+  host_espconn_sent_cb = sim_sent_cb;
+  CHECK(wifi_softap_get_config(&ap_conf) && !strncmp((char *) ap_conf.ssid, WIFI_AP_SSID_PREFIX "_", strlen(WIFI_AP_SSID_PREFIX) + 1));
+
+  printf("defaults: %s", sim_request(CONFIG_REQUEST_STRING));
+  CHECK(!strncmp(sim_reply, "CONFIG,0,-,", 11) && strstr(sim_reply, ",ssid_prefix=" WIFI_AP_SSID_PREFIX ",") && !strstr(sim_reply, WIFI_AP_PASSWORD));
+
+  // Requests from outside of the soft access-point's network are rejected
+  sim_remote_ip = sim_foreign_ip;
+  CHECK(!sim_set("ssid_prefix", "FOREIGN"));
+  CHECK(strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(sim_request(CONFIG_REQUEST_STRING)[0] == '\0');
+  CHECK(!strcmp(config->ssid_prefix, WIFI_AP_SSID_PREFIX) && stats->saves == 0);
+  sim_remote_ip = sim_client_ip;
+
+  // Invalid keys and values are rejected
+  memset(long_prefix, 'X', CONFIG_SSID_PREFIX_LEN);
+  long_prefix[CONFIG_SSID_PREFIX_LEN] = '\0';
+  CHECK(!sim_set("ssid_prefix", long_prefix));
+  CHECK(!sim_set("max_clients", "0") && !sim_set("max_clients", "9"));
+  CHECK(!sim_set("ap_addr", "10.20.300.1"));
+  CHECK(!sim_set("conn_timeout", "99999999999"));
+  CHECK(!sim_set("portmap8", "0") && !sim_set("portmap1", "6:80:10.20.0.10"));
+  CHECK(!sim_set("mesh", "2"));
+  CHECK(!sim_set("client_rate4", "0") && !sim_set("client_rate0", "02:00:00:00:01:100000"));
+  CHECK(!sim_set("unknown", "1"));
+  CHECK(strcmp(sim_request(CONFIG_SET_REQUEST_STRING "ssid_prefix\n"), "OK\n"));
+
+  // Reconfigure the network and save it
+  CHECK(sim_set("ssid_prefix", "LAB"));
+  CHECK(sim_set("password", "correct horse battery"));
+  CHECK(sim_set("max_clients", "4"));
+  CHECK(sim_set("ap_addr", "10.20.0.1") && sim_set("ap_netmask", "255.255.0.0") && sim_set("ap_gw", "10.20.0.1"));
+  CHECK(sim_set("dhcp_start", "10.20.0.10") && sim_set("dhcp_stop", "10.20.1.200"));
+  CHECK(sim_set("dns_server", "1.1.1.1"));
+  CHECK(sim_set("portmap0", "0") && sim_set("portmap1", "17:5000:10.20.0.10:5000:1"));
+  CHECK(sim_set("vital_sign_interval", "60000"));
+  CHECK(sim_set("uplink_rate", "560000") && sim_set("client_rate0", "02:00:00:00:00:01:100000"));
+
+  // The modifications are staged until they're saved
+  CHECK(!strcmp(config->ssid_prefix, WIFI_AP_SSID_PREFIX) && config->ap_addr == ipaddr_addr(WIFI_AP_NETWORK_ADDR));
+  CHECK(strstr(sim_request(CONFIG_REQUEST_STRING), ",ssid_prefix=LAB,") != NULL);
+
+  // An inconsistent configuration isn't saved (nor applied)
+  CHECK(sim_set("dhcp_stop", "10.21.0.1") && sim_set("conn_timeout", "0"));
+  CHECK(strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(config->conn_timeout == ROUTER_CONN_TIMEOUT && stats->saves == 0);
+  CHECK(sim_set("dhcp_stop", "10.20.1.200") && sim_set("conn_timeout", "60000") && sim_set("client_rate1", "02:00:00:00:00:02:1000"));
+  CHECK(strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(sim_set("client_rate1", "0"));
+  CHECK(sim_set("mesh", "1") && sim_set("mesh_key", "short"));
+  CHECK(strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(sim_set("mesh_key", "shared mesh secret") && !strstr(sim_request(CONFIG_REQUEST_STRING), "shared mesh secret"));
+  CHECK(sim_set("mesh", "0"));
+
+  erases = host_flash_stats.erases;
+  CHECK(!strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(stats->slot == 0 && stats->seq == 1 && host_flash_stats.erases == erases + 1);
+  CHECK(sim_set("conn_timeout", "120000"));
+  CHECK(!strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n"));
+  CHECK(stats->slot == 1 && stats->seq == 2 && stats->saves == 2);
+  printf("saved:    %s", sim_request(CONFIG_REQUEST_STRING));
+  CHECK(!strncmp(sim_reply, "CONFIG,2,B,", 11) && strstr(sim_reply, ",portmap1=17:5000:10.20.0.10:5000:1"));
+  CHECK(strstr(sim_reply, ",uplink_rate=560000,") && strstr(sim_reply, ",client_rate0=02:00:00:00:00:01:100000"));
+
+  // The newest record is loaded again (discarding the staged defaults)
+  config_reset();
+  CHECK(!strcmp(config->ssid_prefix, "LAB"));
+  CHECK(strstr(sim_request(CONFIG_REQUEST_STRING), ",ssid_prefix=" WIFI_AP_SSID_PREFIX ",") != NULL);
+  CHECK(config_load());
+  CHECK(strstr(sim_request(CONFIG_REQUEST_STRING), ",ssid_prefix=LAB,") != NULL);
+  CHECK(stats->slot == 1 && stats->seq == 2);
+  CHECK(!strcmp(config->ssid_prefix, "LAB") && !strcmp(config->password, "correct horse battery"));
+  CHECK(config->ap_addr == ipaddr_addr("10.20.0.1") && config->ap_netmask == ipaddr_addr("255.255.0.0"));
+  CHECK(config->dhcp_start == ipaddr_addr("10.20.0.10") && config->dhcp_stop == ipaddr_addr("10.20.1.200"));
+  CHECK(config->dns_server == ipaddr_addr("1.1.1.1") && config->max_clients == 4 && config->conn_timeout == 120000);
+  CHECK(config->portmap[1].proto == 17 && config->portmap[1].daddr == ipaddr_addr("10.20.0.10") && config->portmap[1].dir == 1);
+  CHECK(config->uplink_rate == 560000 && config->client_rate[0].mac[5] == 1 && config->client_rate[0].rate == 100000 && !config->client_rate[1].rate);
+
+  // The router comes up with the stored configuration
+  sim_router_restart();
+  CHECK(is_connected());
+  CHECK(wifi_softap_get_config(&ap_conf) && !strncmp((char *) ap_conf.ssid, "LAB_", 4) && ap_conf.ssid_len == 21);
+  CHECK(!strcmp((char *) ap_conf.password, "correct horse battery") && ap_conf.max_connection == 4);
+  CHECK(wifi_get_ip_info(SOFTAP_IF, &softap_info) && softap_info.ip.addr == ipaddr_addr("10.20.0.1") && softap_info.netmask.addr == ipaddr_addr("255.255.0.0"));
+  CHECK(napt_portmap_count() == 1 && !napt_portmap_find(NAPT_PROTO_TCP, HTONS(8883)) && napt_portmap_find(NAPT_PROTO_UDP, HTONS(5000)));
+
+  // The clients are in the new network now
+  CHECK(sim_request(CONFIG_REQUEST_STRING)[0] == '\0');
+  sim_remote_ip = sim_moved_ip;
+
+  // A power failure after erasing the newest sector resp. while writing it
+  // leaves the previous record
+  CHECK(sim_set("max_clients", "2"));
+  CHECK(!strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n") && stats->slot == 0 && stats->seq == 3);
+  sim_power_fail(0, 0);
+  CHECK(config_load() && stats->slot == 1 && stats->seq == 2 && config->max_clients == 4);
+  CHECK(sim_set("max_clients", "2"));
+  CHECK(!strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n") && stats->slot == 0 && stats->seq == 3);
+  sim_power_fail(0, 128);
+  CHECK(config_load() && stats->slot == 1 && stats->seq == 2 && config->max_clients == 4);
+  printf("power fail: record %u of sector %c kept\n", stats->seq, 'A' + stats->slot);
+
+  // Load time with two valid records
+  CHECK(!strcmp(sim_request(CONFIG_SAVE_REQUEST_STRING), "OK\n") && stats->slot == 0 && stats->seq == 3);
+  flash_before = host_flash_stats;
+  for (call = 0; call < sim_calls; call++) {
+    start = host_clock_ns();
+    config_load();
+    ns = host_clock_ns() - start;
+    if (ns < min_ns) {
+      min_ns = ns;
+    }
+  }
+  CHECK(stats->slot == 0 && stats->seq == 3);
+  CHECK(host_flash_stats.reads - flash_before.reads == 2 * sim_calls && host_flash_stats.erases == flash_before.erases);
+  printf("load: %.2f us (2 records of %u bytes)\n", (double) min_ns / 1000, (unsigned) sizeof(struct config) + 16);
+  CHECK(min_ns < SIM_LOAD_MAX_US * 1000ULL);
+
+  // A corruption of both records yields the defaults
+  sim_power_fail(1, 0);
+  spi_flash_write(sim_sector(0) * SPI_FLASH_SEC_SIZE + 16, (uint32 *) "\0\0\0\0", 4); // Clears the SSID-prefix
+  CHECK(!config_load() && stats->slot == 0xFF);
+  CHECK(!strcmp(config->ssid_prefix, WIFI_AP_SSID_PREFIX) && config->max_clients == MAX_CLIENTS);
+
+  host_espconn_sent_cb = NULL;
+  device_info_disable();
+  if (failures) {
+    printf("config_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
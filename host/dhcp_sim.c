@@ -0,0 +1,357 @@
+// dhcp_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side simulation of the clients of the soft access-point
+// reconnecting after a flap of the WAN-connection (station network interface).
+// The router is brought up like on the device and -c clients join the soft
+// access-point one after another. Then the station network interface loses its
+// connection for -d ms; when it's re-established, the soft access-point is
+// reconfigured (the hitless reconnect is disabled, cf. router.c) and all
+// clients re-associate (staggered by 20 ms) and try to get their previous
+// address back.
+//
+// The clients follow the state machine of lwIP's DHCP-client: a client with a
+// previous address re-requests it (INIT-REBOOT) and falls back to a discovery
+// after two unanswered requests (timeouts of 1 s and 2 s) or a DHCPNAK;
+// discoveries and requests are retransmitted with an exponential backoff.
+// Replies are processed 1 ms after they have been sent. The time from the
+// association to the DHCPACK is measured for three cases:
+//
+//  kept     - the router's DHCP-server keeps its bindings (cf. dhcp_server.c)
+//  reboot   - the router has been restarted while the WAN was down; the
+//             bindings are reloaded from the (emulated) flash
+//  flushed  - the bindings are lost, like with the SDK's DHCP-server, that is
+//             restarted on every reconnect
+//
+// Usage: dhcp_sim [-v] [-c clients] [-d down_ms]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "spi_flash.h"
+#include "router.h"
+#include "dhcp_server.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_CLIENTS_MAX 16
+#define SIM_STAGGER_MS 20       // Delay between the associations of the clients
+#define SIM_REASSOC_MS 500      // Delay of the first association after the reconnect
+#define SIM_TIMEOUT_MS 30000    // Time after which a client is considered failed
+#define SIM_REBOOT_TRIES 2      // Unanswered INIT-REBOOT-requests before a discovery
+#define SIM_REQUEST_TRIES 5     // Unanswered requests before a new discovery
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+enum sim_state {
+  SIM_IDLE,
+  SIM_REBOOTING,
+  SIM_SELECTING,
+  SIM_REQUESTING,
+  SIM_BOUND
+};
+
+// Emulated DHCP-client
+struct sim_client {
+  uint8_t mac[6];
+  enum sim_state state;
+  uint32_t ip;              // Bound resp. previous address
+  uint32_t offered, server;
+  uint32_t xid;
+  uint8_t tries;
+  uint32_t assoc_ms;        // Time of the association
+  uint32_t next_ms;         // Time of the next transmission
+  uint32_t bound_ms;        // Time to the DHCPACK since the association
+  struct host_dhcp_reply reply;
+  uint32_t reply_ms;        // Time the reply is processed (0 = no reply)
+};
+
+// Declaration and initialization of variables:
+
+static struct sim_client sim_clients[SIM_CLIENTS_MAX];
+static uint16_t sim_clients_count = 8;
+static uint32_t sim_now_ms = 0;
+static uint32_t failures = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static void sim_time_advance(uint32_t ms) {
+  host_time_advance(ms * 1000);
+  sim_now_ms += ms;
+}
+
+static void sim_send(struct sim_client *client, uint8_t type, uint32_t requested, uint32_t server) {
+  uint8_t msg[HOST_DHCP_MSG_LEN], remote_ip[4] = {0, 0, 0, 0};
+  uint16_t len = host_dhcp_build(msg, type, client->mac, client->xid, 0, requested, server);
+
+  host_espconn_recv(67, remote_ip, 68, (char *) msg, len);
+}
+
+// Replies of the DHCP-server are handed to the client with the MAC-address
+// given in the message
+static void sim_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  struct host_dhcp_reply reply;
+  struct sim_client *client;
+
+  if (espconn->proto.udp->local_port != 67 || !host_dhcp_parse(data, len, &reply)) {
+    return;
+  }
+  for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+    if (os_memcmp(client->mac, reply.mac, 6) == 0 && reply.xid == client->xid) {
+      client->reply = reply;
+      client->reply_ms = sim_now_ms + 1;
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Clients:
+
+static void sim_client_discover(struct sim_client *client) {
+  client->state = SIM_SELECTING;
+  client->xid = os_random();
+  client->tries = 0;
+  client->next_ms = sim_now_ms;
+}
+
+static void sim_client_associate(struct sim_client *client) {
+  CHECK(host_wifi_sta_connected(client->mac));
+  client->assoc_ms = sim_now_ms;
+  client->bound_ms = 0;
+  client->reply_ms = 0;
+  if (client->ip) {
+    client->state = SIM_REBOOTING;
+    client->xid = os_random();
+    client->tries = 0;
+    client->next_ms = sim_now_ms;
+  }
+  else {
+    sim_client_discover(client);
+  }
+}
+
+// Process a pending reply resp. (re-)transmit the current message of the
+// client
+static void sim_client_step(struct sim_client *client) {
+  struct host_dhcp_reply *reply = &client->reply;
+
+  if (client->reply_ms && client->reply_ms <= sim_now_ms) {
+    client->reply_ms = 0;
+    if (reply->type == HOST_DHCP_NAK && client->state != SIM_BOUND) {
+      client->ip = 0;
+      sim_client_discover(client);
+    }
+    else if (reply->type == HOST_DHCP_OFFER && client->state == SIM_SELECTING) {
+      client->state = SIM_REQUESTING;
+      client->offered = reply->yiaddr;
+      client->server = reply->server;
+      client->tries = 0;
+      client->next_ms = sim_now_ms;
+    }
+    else if (reply->type == HOST_DHCP_ACK && (client->state == SIM_REBOOTING || client->state == SIM_REQUESTING)) {
+      client->state = SIM_BOUND;
+      client->ip = reply->yiaddr;
+      client->bound_ms = sim_now_ms - client->assoc_ms;
+    }
+  }
+
+  if (client->state == SIM_IDLE || client->state == SIM_BOUND || (int32_t) (client->next_ms - sim_now_ms) > 0) {
+    return;
+  }
+  switch (client->state) {
+    case SIM_REBOOTING:
+      if (client->tries == SIM_REBOOT_TRIES) {
+        sim_client_discover(client);
+        sim_client_step(client);
+        return;
+      }
+      sim_send(client, HOST_DHCP_REQUEST, client->ip, 0);
+      break;
+    case SIM_SELECTING:
+      sim_send(client, HOST_DHCP_DISCOVER, 0, 0);
+      break;
+    case SIM_REQUESTING:
+      if (client->tries == SIM_REQUEST_TRIES) {
+        sim_client_discover(client);
+        sim_client_step(client);
+        return;
+      }
+      sim_send(client, HOST_DHCP_REQUEST, client->offered, client->server);
+      break;
+    default:
+      return;
+  }
+  client->tries++;
+  client->next_ms = sim_now_ms + ((client->tries < 6) ? 1000 << (client->tries - 1) : 60000);
+}
+
+// Associate the clients one after another (every SIM_STAGGER_MS, starting at
+// the current time) and run them until all of them are bound; returns false on
+// a timeout
+static bool sim_clients_join(void) {
+  struct sim_client *client;
+  uint32_t start_ms = sim_now_ms;
+  bool done;
+
+  for (;;) {
+    done = true;
+    for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+      if (client->state == SIM_IDLE && sim_now_ms - start_ms >= (client - sim_clients) * SIM_STAGGER_MS) {
+        sim_client_associate(client);
+      }
+      sim_client_step(client);
+      done &= client->state == SIM_BOUND;
+    }
+    if (done || sim_now_ms - start_ms >= SIM_TIMEOUT_MS) {
+      return done;
+    }
+    sim_time_advance(1);
+  }
+}
+
+/*------------------------------------*/
+
+// Scenarios:
+
+// Flap the WAN-connection and let the clients reconnect; returns the mean
+// time to the address
+static double sim_flap(const char *name, uint32_t down_ms) {
+  struct sim_client *client;
+  uint32_t max_ms = 0, sum_ms = 0, erases = host_flash_stats.erases;
+  uint16_t same = 0;
+  uint32_t previous[SIM_CLIENTS_MAX];
+  bool done;
+  uint16_t idx;
+
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    previous[idx] = sim_clients[idx].ip;
+  }
+
+  host_wifi_disconnected(2);
+  if (name[0] == 'r') {
+    // Power loss of the router: the bindings are only kept in the flash
+    dhcp_server_stop();
+  }
+  sim_time_advance(down_ms);
+  if (name[0] == 'f') {
+    // Former behaviour: the DHCP-server forgets all bindings on the reconnect
+    dhcp_server_flush();
+  }
+
+  // The soft access-point is reconfigured and the clients re-associate
+  for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+    host_wifi_sta_disconnected(client->mac);
+    client->state = SIM_IDLE;
+  }
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  CHECK(is_connected());
+  sim_time_advance(SIM_REASSOC_MS);
+  done = sim_clients_join();
+  CHECK(done);
+
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    client = &sim_clients[idx];
+    sum_ms += client->bound_ms;
+    max_ms = (client->bound_ms > max_ms) ? client->bound_ms : max_ms;
+    same += client->ip == previous[idx];
+  }
+  if (name[0] != 'f') {
+    // The clients get their previous address back without waiting for a
+    // timeout and without writing the flash
+    CHECK(same == sim_clients_count);
+    CHECK(max_ms < 1000);
+    CHECK(host_flash_stats.erases == erases);
+  }
+  printf("%-8s %6u %10.1f %10u %6u/%u %8u\n", name, down_ms, (double) sum_ms / sim_clients_count, max_ms, same, sim_clients_count, host_flash_stats.erases - erases);
+  return (double) sum_ms / sim_clients_count;
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: dhcp_sim [-v] [-c clients] [-d down_ms]\n");
+}
+
+int main(int argc, char **argv) {
+  const struct dhcp_server_stats *stats = dhcp_server_stats_get();
+  struct ip_info softap_info;
+  uint32_t down_ms = 3000, saves, pool, idx, jdx;
+  double kept, flushed;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vc:d:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'c': sim_clients_count = strtoul(optarg, NULL, 0); break;
+      case 'd': down_ms = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!sim_clients_count || sim_clients_count > SIM_CLIENTS_MAX) {
+    sim_usage();
+    return 1;
+  }
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    sim_clients[idx].mac[0] = 0x02;
+    sim_clients[idx].mac[5] = idx + 1;
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  router_set_hitless_reconnect(false);
+  host_espconn_sent_cb = sim_sent_cb;
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "dhcp_sim: Failed to bring up the router!\n");
+    return 1;
+  }
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+
+  // First association of the clients; each is bound to a distinct address of
+  // the pool and the bindings are written to the flash once
+  CHECK(sim_clients_join());
+  pool = ipaddr_addr(DHCP_START_ADDR);
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    CHECK((sim_clients[idx].ip & softap_info.netmask.addr) == (pool & softap_info.netmask.addr) && sim_clients[idx].ip != softap_info.ip.addr);
+    CHECK(dhcp_server_lookup(sim_clients[idx].mac) == sim_clients[idx].ip);
+    for (jdx = 0; jdx < idx; jdx++) {
+      CHECK(sim_clients[idx].ip != sim_clients[jdx].ip);
+    }
+  }
+  CHECK(dhcp_server_count() == sim_clients_count);
+  sim_time_advance(DHCP_LEASE_SAVE_DELAY);
+  saves = stats->saves;
+  CHECK(saves == 1);
+
+  printf("%-8s %6s %10s %10s %8s %8s\n", "case", "down", "mean_ms", "max_ms", "same", "erases");
+  kept = sim_flap("kept", down_ms);
+  sim_flap("reboot", down_ms);
+  flushed = sim_flap("flushed", down_ms);
+  CHECK(kept * 10 < flushed);
+
+  printf("dhcp_sim: %u clients, %u offers, %u acks, %u naks, %u drops, %u flash writes\n", sim_clients_count, stats->offers, stats->acks, stats->naks, stats->drops, stats->saves);
+  if (failures) {
+    printf("dhcp_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,471 @@
+// dns_replay.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side replay of the DNS-queries of IoT-devices through the
+// router's DNS-proxy (cf. dns_proxy.c). The router is brought up like on the
+// device; the clients' queries are delivered to the proxy's socket on port 53
+// and the queries forwarded by the proxy are answered by an emulated upstream
+// server after a round trip time of -r ms (A-records, resp. NXDOMAIN for names
+// marked as such, with the TTL of the name).
+//
+// Without a trace-file, a built-in trace of MAX_CLIENTS devices is replayed for
+// -d seconds: smart plugs, cameras and sensors, that resolve the names of their
+// cloud endpoints, NTP-servers and connectivity checks before every connection
+// (most IoT-stacks don't cache answers themselves), all booting at the same
+// time. A trace-file holds one query per line ("<time in ms> <client> <name>"),
+// whose names are answered with the TTL given by -t.
+//
+// Every answer of the upstream server is preceded by forged copies from another
+// address resp. port, which the proxy has to drop. Every answer is checked
+// against the query of the client (ID, question, TTL not above the
+// upstream's); finally, the cache hit rate and the reduction of
+// the queries sent upstream (each of which would have occupied an entry of the
+// NAPT-table without the proxy) are reported.
+//
+// Usage: dns_replay [-v] [-d seconds] [-r rtt_ms] [-t ttl] [trace.txt]
+
+#include <ctype.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "router.h"
+#include "device_info.h"
+#include "dns_proxy.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+
+/*------------------------------------*/
+
+#define REPLAY_STATION_ADDR "10.0.0.42"
+#define REPLAY_STATION_NETMASK "255.255.255.0"
+#define REPLAY_STATION_GW "10.0.0.1"
+
+#define REPLAY_NAME_MAX 128
+#define REPLAY_MSG_MAX 512
+#define REPLAY_ANSWERS_MAX 64   // Answers of the upstream server in transit
+#define REPLAY_OUTSTANDING 4096 // Queries of the clients awaiting an answer
+#define REPLAY_NAMES_MAX 64
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Name answered by the emulated upstream server
+struct replay_name {
+  const char *name;
+  uint32_t ttl;       // TTL of the upstream's answer (in s)
+  bool nxdomain;
+};
+
+// Device of the built-in trace, querying the given names periodically
+struct replay_device {
+  const char *kind;
+  uint8_t names[4];     // Indexes of replay_names
+  uint32_t periods[4];  // Interval between two lookups (in s; 0 = unused)
+};
+
+struct replay_query {
+  uint64_t ts_ms;
+  uint8_t client;
+  uint8_t name;         // Index of the name
+};
+
+// Answer of the upstream server in transit
+struct replay_answer {
+  uint64_t due_ms;
+  uint16_t port;      // Local port of the proxy, the query has been sent from
+  uint16_t len;
+  uint8_t msg[REPLAY_MSG_MAX];
+};
+
+// Query of a client, that hasn't been answered yet (indexed by its port)
+struct replay_outstanding {
+  bool valid;
+  uint16_t id;
+  uint8_t name;
+};
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct replay_name replay_names[REPLAY_NAMES_MAX] = {
+  {"a3k7odshaiipe8-ats.iot.eu-west-1.amazonaws.com", 60, false},
+  {"pool.ntp.org", 150, false},
+  {"telemetry.plug-vendor.com", 300, false},
+  {"stream.cam-cloud.net", 30, false},
+  {"ota.cam-cloud.net", 0, true},
+  {"time.google.com", 3600, false},
+  {"api.sensor-hub.io", 120, false},
+  {"connectivitycheck.gstatic.com", 300, false},
+};
+static uint16_t replay_names_count = 8;
+
+static const struct replay_device replay_devices[] = {
+  {"plug", {0, 1, 2, 7}, {300, 900, 60, 120}},
+  {"plug", {0, 1, 2, 7}, {300, 900, 60, 120}},
+  {"plug", {0, 1, 2, 7}, {300, 900, 60, 120}},
+  {"camera", {3, 4, 5, 7}, {30, 900, 3600, 60}},
+  {"camera", {3, 4, 5, 7}, {30, 900, 3600, 60}},
+  {"sensor", {6, 1, 0, 0}, {15, 1800, 0, 0}},
+  {"sensor", {6, 1, 0, 0}, {15, 1800, 0, 0}},
+  {"sensor", {6, 1, 0, 0}, {15, 1800, 0, 0}},
+};
+
+static struct replay_query *replay_queries = NULL;
+static uint32_t replay_queries_count = 0, replay_queries_size = 0;
+
+static struct replay_answer replay_answers[REPLAY_ANSWERS_MAX];
+static uint16_t replay_answers_count = 0;
+static struct replay_outstanding replay_outstanding[REPLAY_OUTSTANDING];
+
+static uint32_t replay_rtt_ms = 30, replay_default_ttl = 300;
+static uint64_t replay_now_ms = 0;
+static uint32_t replay_upstream_port = 0, replay_upstream_ports = 0, replay_upstream_queries = 0, replay_answered = 0, replay_forged = 0;
+static uint32_t replay_client_net;
+static const uint8_t replay_dhcp_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static uint32_t failures = 0;
+static uint32_t rnd_state = 0x12345678;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t rnd(void) {
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+static int replay_query_cmp(const void *a, const void *b) {
+  const struct replay_query *x = (const struct replay_query *) a, *y = (const struct replay_query *) b;
+  return (x->ts_ms > y->ts_ms) - (x->ts_ms < y->ts_ms);
+}
+
+static void replay_query_add(uint64_t ts_ms, uint8_t client, uint8_t name) {
+  if (replay_queries_count == replay_queries_size) {
+    replay_queries_size = (replay_queries_size) ? 2 * replay_queries_size : 4096;
+    replay_queries = realloc(replay_queries, replay_queries_size * sizeof(struct replay_query));
+  }
+  replay_queries[replay_queries_count++] = (struct replay_query) {ts_ms, client, name};
+}
+
+// Encode the given name as a sequence of labels and return its length
+static uint16_t replay_name_encode(uint8_t *buf, const char *name) {
+  uint16_t len = 0, label;
+
+  while (*name) {
+    for (label = 0; name[label] && name[label] != '.'; label++) {
+      buf[len + 1 + label] = name[label];
+    }
+    buf[len] = label;
+    len += label + 1;
+    name += label + (name[label] == '.');
+  }
+  buf[len++] = 0;
+  return len;
+}
+
+// Build a query of type A for the given name
+static uint16_t replay_query_build(uint8_t *msg, uint16_t id, const char *name) {
+  uint16_t len;
+
+  os_memset(msg, 0, 12);
+  msg[0] = id >> 8;
+  msg[1] = id & 0xFF;
+  msg[2] = 0x01;  // Recursion desired
+  msg[5] = 1;
+  len = 12 + replay_name_encode(msg + 12, name);
+  msg[len++] = 0;
+  msg[len++] = 1;
+  msg[len++] = 0;
+  msg[len++] = 1;
+  return len;
+}
+
+// Return the index of the name, that the question of the given message asks
+// for, resp. replay_names_count
+static uint16_t replay_name_lookup(const uint8_t *msg, uint16_t len) {
+  uint8_t encoded[REPLAY_NAME_MAX + 2];
+  uint16_t idx, name_len;
+
+  for (idx = 0; idx < replay_names_count; idx++) {
+    name_len = replay_name_encode(encoded, replay_names[idx].name);
+    if (12 + name_len <= len && os_memcmp(msg + 12, encoded, name_len) == 0) {
+      break;
+    }
+  }
+  return idx;
+}
+
+/*------------------------------------*/
+
+// Emulation of the upstream server and the clients:
+
+// Queue the answer of the upstream server to a query of the proxy
+static void replay_upstream_answer(const uint8_t *query, uint16_t len) {
+  struct replay_answer *answer;
+  uint16_t name = replay_name_lookup(query, len), qlen = len;
+  uint32_t ttl, addr;
+  uint8_t *msg;
+
+  if (replay_answers_count == REPLAY_ANSWERS_MAX || name == replay_names_count || len + 16 > REPLAY_MSG_MAX) {
+    return;
+  }
+  answer = &replay_answers[replay_answers_count++];
+  answer->due_ms = replay_now_ms + replay_rtt_ms;
+  answer->port = replay_upstream_port;
+  msg = answer->msg;
+  os_memcpy(msg, query, qlen);
+  msg[2] = 0x81;
+  msg[3] = (replay_names[name].nxdomain) ? 0x83 : 0x80;
+  if (!replay_names[name].nxdomain) {
+    ttl = replay_names[name].ttl;
+    addr = 0x5DB80000 | (name + 1);
+    msg[7] = 1;
+    msg += qlen;
+    os_memset(msg, 0, 16);
+    msg[0] = 0xC0;  // Pointer to the name of the question
+    msg[1] = 0x0C;
+    msg[3] = 1;     // Type A
+    msg[5] = 1;     // Class IN
+    msg[6] = ttl >> 24;
+    msg[7] = (ttl >> 16) & 0xFF;
+    msg[8] = (ttl >> 8) & 0xFF;
+    msg[9] = ttl & 0xFF;
+    msg[11] = 4;
+    os_memcpy(msg + 12, &addr, 4);
+    qlen += 16;
+  }
+  answer->len = qlen;
+}
+
+// Check an answer of the proxy to a client
+static void replay_client_answer(const uint8_t *msg, uint16_t len, uint16_t port) {
+  struct replay_outstanding *query = &replay_outstanding[port % REPLAY_OUTSTANDING];
+  uint32_t ttl;
+
+  CHECK(query->valid);
+  if (!query->valid) {
+    return;
+  }
+  CHECK(len >= 12 && (msg[2] & 0x80) && ((msg[0] << 8) | msg[1]) == query->id);
+  CHECK(replay_name_lookup(msg, len) == query->name);
+  if (!replay_names[query->name].nxdomain) {
+    CHECK((msg[3] & 0x0F) == 0 && msg[7] == 1 && len >= 16);
+    ttl = ((uint32_t) msg[len-10] << 24) | (msg[len-9] << 16) | (msg[len-8] << 8) | msg[len-7];
+    CHECK(ttl > 0 && ttl <= replay_names[query->name].ttl);
+  }
+  else {
+    CHECK((msg[3] & 0x0F) == 3);
+  }
+  query->valid = false;
+  replay_answered++;
+}
+
+static void replay_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  if (espconn->proto.udp->remote_port == 53) {
+    replay_upstream_ports += (espconn->proto.udp->local_port != replay_upstream_port);
+    replay_upstream_port = espconn->proto.udp->local_port;
+    replay_upstream_queries++;
+    replay_upstream_answer(data, len);
+  }
+  else {
+    replay_client_answer(data, len, espconn->proto.udp->remote_port);
+  }
+}
+
+// Advance the virtual time and deliver the upstream's answers, that are due
+// in between
+static void replay_time_advance(uint64_t ts_ms) {
+  const struct dns_proxy_stats *stats = dns_proxy_stats_get();
+  uint8_t upstream_ip[4] = {8, 8, 8, 8}, forged_ip[4] = {8, 8, 4, 4};
+  struct replay_answer answer;
+  uint32_t answers;
+  uint64_t next, step;
+  uint16_t idx;
+
+  do {
+    next = ts_ms;
+    for (idx = 0; idx < replay_answers_count; idx++) {
+      if (replay_answers[idx].due_ms < next) {
+        next = replay_answers[idx].due_ms;
+      }
+    }
+    while (replay_now_ms < next) {
+      step = (next - replay_now_ms > 1000) ? 1000 : next - replay_now_ms;
+      host_time_advance(step * 1000);
+      replay_now_ms += step;
+    }
+    for (idx = 0; idx < replay_answers_count; idx++) {
+      if (replay_answers[idx].due_ms <= replay_now_ms) {
+        answer = replay_answers[idx];
+        replay_answers[idx--] = replay_answers[--replay_answers_count];
+        answers = stats->answers;
+        host_espconn_recv(answer.port, forged_ip, 53, (char *) answer.msg, answer.len);
+        host_espconn_recv(answer.port, upstream_ip, 5353, (char *) answer.msg, answer.len);
+        CHECK(stats->answers == answers);
+        replay_forged += 2;
+        host_espconn_recv(answer.port, upstream_ip, 53, (char *) answer.msg, answer.len);
+      }
+    }
+  } while (next < ts_ms);
+}
+
+/*------------------------------------*/
+
+// Traces:
+
+// Lookups of the devices of the built-in trace; each device boots within the
+// first 200 ms and resolves all of its names, afterwards each name with its
+// period (+-10 %)
+static void replay_trace_builtin(uint32_t duration_s) {
+  uint32_t dev, idx;
+  uint64_t ts;
+
+  for (dev = 0; dev < MAX_CLIENTS; dev++) {
+    const struct replay_device *device = &replay_devices[dev % (sizeof(replay_devices) / sizeof(replay_devices[0]))];
+
+    for (idx = 0; idx < 4; idx++) {
+      if (!device->periods[idx]) {
+        continue;
+      }
+      for (ts = rnd() % 200; ts < (uint64_t) duration_s * 1000; ts += device->periods[idx] * 900 + rnd() % (device->periods[idx] * 200)) {
+        replay_query_add(ts, dev, device->names[idx]);
+      }
+    }
+  }
+}
+
+// Read a trace-file with one query per line: "<time in ms> <client> <name>"
+static bool replay_trace_read(const char *path) {
+  char line[256], name[REPLAY_NAME_MAX];
+  unsigned long long ts;
+  unsigned int client;
+  uint16_t idx;
+  FILE *file = fopen(path, "r");
+
+  if (!file) {
+    return false;
+  }
+  replay_names_count = 0;
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#' || sscanf(line, "%llu %u %127s", &ts, &client, name) != 3) {
+      continue;
+    }
+    for (idx = 0; idx < REPLAY_NAME_MAX && name[idx]; idx++) {
+      name[idx] = tolower((unsigned char) name[idx]);
+    }
+    for (idx = 0; idx < replay_names_count && os_strcmp(replay_names[idx].name, name); idx++);
+    if (idx == replay_names_count) {
+      if (replay_names_count == REPLAY_NAMES_MAX) {
+        continue;
+      }
+      replay_names[idx] = (struct replay_name) {strdup(name), replay_default_ttl, false};
+      replay_names_count++;
+    }
+    replay_query_add(ts, client % MAX_CLIENTS, idx);
+  }
+  fclose(file);
+  return true;
+}
+
+/*------------------------------------*/
+
+static void replay_usage(void) {
+  fprintf(stderr, "Usage: dns_replay [-v] [-d seconds] [-r rtt_ms] [-t ttl] [trace.txt]\n");
+}
+
+int main(int argc, char **argv) {
+  const struct dns_proxy_stats *stats;
+  struct ip_info softap_info;
+  struct host_dhcp_reply dhcp_reply;
+  struct replay_outstanding *outstanding;
+  uint8_t msg[REPLAY_MSG_MAX], client_ip[4];
+  uint32_t duration_s = 3600, idx, client;
+  uint16_t len, port;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vd:r:t:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'd': duration_s = strtoul(optarg, NULL, 0); break;
+      case 'r': replay_rtt_ms = strtoul(optarg, NULL, 0); break;
+      case 't': replay_default_ttl = strtoul(optarg, NULL, 0); break;
+      default: replay_usage(); return 1;
+    }
+  }
+  if (optind < argc) {
+    if (!replay_trace_read(argv[optind])) {
+      fprintf(stderr, "dns_replay: Failed to read %s!\n", argv[optind]);
+      return 1;
+    }
+  }
+  else {
+    replay_trace_builtin(duration_s);
+  }
+  qsort(replay_queries, replay_queries_count, sizeof(struct replay_query), replay_query_cmp);
+
+  // Bring the router up like on the device; the clients have to be handed the
+  // router's own address as DNS-server
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  device_info_init();
+  host_wifi_got_ip(ipaddr_addr(REPLAY_STATION_ADDR), ipaddr_addr(REPLAY_STATION_NETMASK), ipaddr_addr(REPLAY_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "dns_replay: Failed to bring up the router!\n");
+    return 1;
+  }
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  CHECK(host_wifi_sta_connected(replay_dhcp_mac));
+  CHECK(host_dhcp_exchange(HOST_DHCP_DISCOVER, replay_dhcp_mac, 0, 0, 0, &dhcp_reply) && dhcp_reply.dns == softap_info.ip.addr);
+  replay_client_net = softap_info.ip.addr & softap_info.netmask.addr;
+  host_espconn_sent_cb = replay_sent_cb;
+
+  for (idx = 0; idx < replay_queries_count; idx++) {
+    replay_time_advance(replay_queries[idx].ts_ms);
+
+    // Every query uses a new port of the client, by which its answer is
+    // matched
+    client = replay_client_net | ((2 + replay_queries[idx].client) << 24);
+    os_memcpy(client_ip, &client, 4);
+    port = 10000 + idx % REPLAY_OUTSTANDING;
+    outstanding = &replay_outstanding[port % REPLAY_OUTSTANDING];
+    outstanding->valid = true;
+    outstanding->id = rnd() & 0xFFFF;
+    outstanding->name = replay_queries[idx].name;
+    len = replay_query_build(msg, outstanding->id, replay_names[outstanding->name].name);
+    host_espconn_recv(53, client_ip, port, (char *) msg, len);
+  }
+  replay_time_advance(replay_now_ms + 10 * replay_rtt_ms + 1);
+
+  stats = dns_proxy_stats_get();
+  CHECK(replay_answered == replay_queries_count);
+  CHECK(stats->queries == replay_queries_count && stats->upstream == replay_upstream_queries);
+  CHECK(stats->hits + stats->coalesced + stats->upstream == stats->queries);
+  CHECK(stats->answers == replay_upstream_queries && stats->drops == replay_forged);
+  CHECK(replay_upstream_ports > 1);
+
+  printf("dns_replay: %s, %u clients, %u names, %u s, rtt %u ms\n", (optind < argc) ? argv[optind] : "built-in IoT trace", MAX_CLIENTS, replay_names_count, (uint32_t) (replay_now_ms / 1000), replay_rtt_ms);
+  printf("queries:     %u\n", stats->queries);
+  printf("answered:    %u (%.2f%%)\n", replay_answered, (stats->queries) ? 100.0 * replay_answered / stats->queries : 0);
+  printf("cache hits:  %u (%.2f%%)\n", stats->hits, (stats->queries) ? 100.0 * stats->hits / stats->queries : 0);
+  printf("coalesced:   %u\n", stats->coalesced);
+  printf("upstream:    %u (-%.2f%% compared to %u without the proxy)\n", stats->upstream, (stats->queries) ? 100.0 - 100.0 * stats->upstream / stats->queries : 0, stats->queries);
+  printf("cache:       %u of %u entries\n", dns_proxy_count(), DNS_PROXY_CACHE_SIZE);
+
+  free(replay_queries);
+  if (failures) {
+    printf("%u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,220 @@
+// fastboot_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side simulation of the activation of the router with and
+// without the fast boot (cf. fast_boot.c). The station connects to the host
+// access-point emulated by the host's WiFi-API (cf. host_wifi_ap in
+// host_sdk.c), which takes -j ms to join with a known BSSID and channel and
+// additionally -s ms to scan for the SSID otherwise. ESP-TOUCH is emulated:
+// the credentials are received -e ms after its start, then the station
+// connects and the success is reported once it got its address.
+//
+// The time from the actuation of the pushbutton until the router is up (cf.
+// lifecycle_stats_get) is measured for these activations:
+//
+//  first    - no cached credentials (ESP-TOUCH)
+//  warm     - restart with cached credentials, BSSID and channel
+//  cold     - power loss; the BSSID and channel (RTC-memory) are lost
+//  moved    - the host access-point has been replaced (new BSSID and channel)
+//  changed  - the password of the host access-point has been changed; the fast
+//             boot times out and falls back to ESP-TOUCH
+//  disabled - like warm, but without the fast boot (the former behaviour)
+//
+// Usage: fastboot_sim [-v] [-s scan_ms] [-j join_ms] [-e esptouch_ms]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "router.h"
+#include "lifecycle.h"
+#include "fast_boot.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_STEP_MS 10
+#define SIM_TIMEOUT_MS 120000
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static uint32_t failures = 0;
+static uint32_t sim_esptouch_ms = 8000;
+static bool sim_fast_boot = true;
+static os_timer_t sim_esptouch_timer;
+
+/*------------------------------------*/
+
+// Emulated ESP-TOUCH:
+
+// The success is reported after the station got its address (cf.
+// SC_STATUS_LINK_OVER in esp_touch.c)
+static void sim_esptouch_link_over(void *arg) {
+  if (wifi_station_get_connect_status() != STATION_GOT_IP) {
+    os_timer_arm(&sim_esptouch_timer, SIM_STEP_MS, false);
+    return;
+  }
+  lifecycle_event(LIFECYCLE_EVENT_ESPTOUCH_SUCCESS);
+}
+
+// The credentials have been received from the intermediary-device; they are
+// stored by the SDK (cf. SC_STATUS_LINK in esp_touch.c)
+static void sim_esptouch_link(void *arg) {
+  struct station_config config;
+
+  os_memset(&config, 0, sizeof(config));
+  os_memcpy(config.ssid, host_wifi_ap.ssid, 32);
+  os_memcpy(config.password, host_wifi_ap.password, 64);
+  wifi_station_disconnect();
+  wifi_station_set_config(&config);
+  wifi_station_connect();
+  os_timer_setfn(&sim_esptouch_timer, (os_timer_func_t *) sim_esptouch_link_over, NULL);
+  os_timer_arm(&sim_esptouch_timer, SIM_STEP_MS, false);
+}
+
+/*------------------------------------*/
+
+// Hooks of the state machine (cf. user_main.c):
+
+static bool sim_enable(void) {
+  router_init();
+  return true;
+}
+
+static bool sim_connect(void) {
+  return sim_fast_boot && fast_boot_connect();
+}
+
+static bool sim_provision(void) {
+  fast_boot_stop();
+  wifi_station_disconnect();
+  wifi_set_opmode(STATION_MODE);
+  os_timer_disarm(&sim_esptouch_timer);
+  os_timer_setfn(&sim_esptouch_timer, (os_timer_func_t *) sim_esptouch_link, NULL);
+  os_timer_arm(&sim_esptouch_timer, sim_esptouch_ms, false);
+  return true;
+}
+
+static void sim_online(void) {
+  fast_boot_save();
+}
+
+static void sim_disable(void) {
+  fast_boot_stop();
+  os_timer_disarm(&sim_esptouch_timer);
+  router_disable();
+  wifi_station_disconnect();
+  wifi_set_opmode(NULL_MODE);
+  wifi_set_event_handler_cb(NULL);
+}
+
+static const struct lifecycle_hooks sim_hooks = {sim_enable, sim_connect, sim_provision, sim_online, sim_disable};
+
+/*------------------------------------*/
+
+// Activations:
+
+// Restart the device, actuate the pushbutton and wait until the router is up;
+// returns the time to the router being up (in ms)
+static uint32_t sim_activate(const char *name) {
+  const struct lifecycle_stats *stats = lifecycle_stats_get();
+  uint32_t elapsed = 0;
+
+  sim_disable();
+  lifecycle_init(&sim_hooks);
+  lifecycle_event(LIFECYCLE_EVENT_BUTTON);
+  while (lifecycle_state_get() != LIFECYCLE_ONLINE && elapsed < SIM_TIMEOUT_MS) {
+    host_time_advance(SIM_STEP_MS * 1000);
+    elapsed += SIM_STEP_MS;
+  }
+  CHECK(lifecycle_state_get() == LIFECYCLE_ONLINE);
+  CHECK(is_connected());
+  printf("%-9s %-10s %10u %10u\n", name, (stats->up_fast) ? "fast_boot" : "esptouch", stats->up_time, stats->fallbacks);
+  return stats->up_time;
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: fastboot_sim [-v] [-s scan_ms] [-j join_ms] [-e esptouch_ms]\n");
+}
+
+int main(int argc, char **argv) {
+  const struct lifecycle_stats *stats = lifecycle_stats_get();
+  uint32_t first, warm, cold, moved, changed, disabled;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vs:j:e:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 's': host_wifi_ap.scan_ms = strtoul(optarg, NULL, 0); break;
+      case 'j': host_wifi_ap.join_ms = strtoul(optarg, NULL, 0); break;
+      case 'e': sim_esptouch_ms = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!host_wifi_ap.join_ms) {
+    sim_usage();
+    return 1;
+  }
+
+  // Host access-point
+  host_wifi_ap.up = true;
+  os_strcpy((char *) host_wifi_ap.ssid, "upstream");
+  os_strcpy((char *) host_wifi_ap.password, "secret-1");
+  os_memcpy(host_wifi_ap.bssid, "\x02\xAA\x00\x00\x00\x01", 6);
+  host_wifi_ap.channel = 6;
+  host_wifi_ap.ip = ipaddr_addr(SIM_STATION_ADDR);
+  host_wifi_ap.netmask = ipaddr_addr(SIM_STATION_NETMASK);
+  host_wifi_ap.gw = ipaddr_addr(SIM_STATION_GW);
+
+  printf("%-9s %-10s %10s %10s\n", "case", "path", "up_ms", "fallbacks");
+  host_wifi_power_loss(false);
+  first = sim_activate("first");
+  CHECK(!stats->up_fast);
+
+  warm = sim_activate("warm");
+  CHECK(stats->up_fast && stats->fallbacks == 0);
+
+  host_wifi_power_loss(true);
+  cold = sim_activate("cold");
+  CHECK(stats->up_fast && stats->fallbacks == 0);
+
+  os_memcpy(host_wifi_ap.bssid, "\x02\xAA\x00\x00\x00\x02", 6);
+  host_wifi_ap.channel = 11;
+  moved = sim_activate("moved");
+  CHECK(stats->up_fast && stats->fallbacks == 0);
+
+  os_strcpy((char *) host_wifi_ap.password, "secret-2");
+  changed = sim_activate("changed");
+  CHECK(!stats->up_fast && stats->fallbacks == 1);
+  CHECK(changed >= FAST_BOOT_TIMEOUT);
+
+  sim_fast_boot = false;
+  disabled = sim_activate("disabled");
+  CHECK(!stats->up_fast);
+
+  // With the cached BSSID and channel, the scan is skipped; without, only
+  // ESP-TOUCH is skipped
+  CHECK(warm < cold && cold < first && moved < first);
+  CHECK(warm * 10 < disabled);
+
+  if (failures) {
+    printf("fastboot_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,276 @@
+// flow_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Benchmark of the flow cache (cf. flow_cache.c) on bulk
+// transfers. The router is brought up like on the device; the clients open -c
+// TCP-connections (1, 4, 16 and 64 by default) and upload full-sized segments
+// round-robin over them, while their peers acknowledge every second segment.
+// The virtual time advances by 100 us per segment, so that the cached flows
+// are resolved again every FLOW_CACHE_TIMEOUT ms.
+//
+// Every trace is run -r times alternately with the cache disabled and enabled
+// on the same connections. The fastest processing time per packet (measured
+// with the host's real clock around the input of the frames, so that their
+// construction isn't included), the saving and the hit rate of the cache are
+// reported; the frames sent by the router have to be identical in both runs.
+//
+// Usage: flow_bench [-v] [-c connections] [-n segments] [-r rounds]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "flow_cache.h"
+#include "uplink_sched.h"
+#include "user_config.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define BENCH_STATION_ADDR "10.0.0.42"
+#define BENCH_STATION_NETMASK "255.255.255.0"
+#define BENCH_STATION_GW "10.0.0.1"
+
+#define BENCH_FRAME_MAX 1600
+#define BENCH_REPLY_QUEUE 4
+#define BENCH_SEGMENT 1460
+#define BENCH_STEP_US 100
+#define BENCH_ACK_LEN (14 + 20 + 20)
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+struct bench_frame {
+  uint8_t data[BENCH_FRAME_MAX];
+  uint16_t len;
+};
+
+// Results of a run
+struct bench_result {
+  double ns;          // Processing time per packet
+  double hit_rate;
+  uint32_t sent;
+  uint64_t digest;    // Digest of all frames sent by the router
+};
+
+// Declaration and initialization of variables:
+
+static const uint32_t bench_conns_default[] = {1, 4, 16, 64};
+
+static uint32_t failures = 0;
+static uint32_t bench_segments = 20000;
+static uint32_t bench_rounds = 5;
+
+static uint8_t bench_softap_mac[6];
+static uint32_t bench_softap_net;
+
+static struct bench_frame bench_replies[BENCH_REPLY_QUEUE];
+static uint16_t bench_replies_count = 0;
+static bool bench_reflect = false;
+static uint32_t bench_sent = 0;
+static uint64_t bench_digest = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Digest the headers of the frames sent by the router (FNV-1a; the payload
+// isn't touched by the translation); the headers of the segments are kept, if
+// the peers are to acknowledge them
+static void bench_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  uint16_t idx;
+
+  bench_sent++;
+  for (idx = 0; idx < len && idx < BENCH_ACK_LEN; idx++) {
+    bench_digest = (bench_digest ^ frame[idx]) * 0x100000001B3ULL;
+  }
+  if (!bench_reflect || if_index != STATION_IF || bench_replies_count == BENCH_REPLY_QUEUE || len < BENCH_ACK_LEN) {
+    return;
+  }
+  os_memcpy(bench_replies[bench_replies_count].data, frame, BENCH_ACK_LEN);
+  bench_replies_count++;
+}
+
+// Send a segment of the given connection and inject the answers of the peer
+// (if reflect) as empty ACKs; returns the real time spent by the router (in
+// ns), without the construction of the frames
+static uint64_t bench_send(uint32_t conn, uint8_t tcp_flags, uint16_t payload, bool reflect) {
+  struct bench_frame frame, *reply;
+  uint64_t start, elapsed;
+  uint16_t idx, count;
+
+  frame.len = host_packet_build(frame.data, bench_softap_mac, NAPT_PROTO_TCP, bench_softap_net | ((2 + conn % MAX_CLIENTS) << 24), 40000 + conn / MAX_CLIENTS,
+                                IPADDR(93, 184, 216, 34), 443, tcp_flags, payload);
+  frame.data[6] = 0x02;   // MAC-address of the client (cf. host_packet_build)
+  bench_replies_count = 0;
+  bench_reflect = reflect;
+
+  start = host_clock_ns();
+  host_netif_input(SOFTAP_IF, frame.data, frame.len);
+  elapsed = host_clock_ns() - start;
+  bench_reflect = false;
+
+  count = bench_replies_count;
+  for (idx = 0; idx < count; idx++) {
+    reply = &bench_replies[idx];
+    reply->data[14 + 2] = 0;
+    reply->data[14 + 3] = BENCH_ACK_LEN - 14;
+    reply->len = host_packet_reply(reply->data, BENCH_ACK_LEN, reply->data);
+    if (!reply->len) {
+      continue;
+    }
+    start = host_clock_ns();
+    host_netif_input(STATION_IF, reply->data, reply->len);
+    elapsed += host_clock_ns() - start;
+  }
+  bench_replies_count = count;
+  return elapsed;
+}
+
+// Open conns connections on an empty NAPT-table
+static void bench_open(uint32_t conns) {
+  uint32_t conn;
+
+  napt_init(NAPT_TABLE_SIZE);
+  napt_enable(ipaddr_addr(WIFI_AP_NETWORK_ADDR), ipaddr_addr(WIFI_AP_NETWORK_NETMASK));
+
+  // Three-way-handshakes (the SYN/ACKs are answered with an ACK)
+  for (conn = 0; conn < conns; conn++) {
+    bench_send(conn, HOST_PACKET_TCP_SYN, 0, true);
+    bench_send(conn, HOST_PACKET_TCP_ACK, 0, false);
+  }
+}
+
+// Upload bench_segments segments round-robin over the connections
+static void bench_run(uint32_t conns, bool cache, struct bench_result *result) {
+  const struct flow_cache_stats *stats = flow_cache_stats_get();
+  uint32_t seq, hits, misses, packets = 0;
+  uint64_t total_ns = 0;
+
+  flow_cache_set_enabled(cache);
+  bench_sent = 0;
+  bench_digest = 0xCBF29CE484222325ULL;
+  hits = stats->hits;
+  misses = stats->misses;
+  for (seq = 0; seq < bench_segments; seq++) {
+    total_ns += bench_send(seq % conns, HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, BENCH_SEGMENT, (seq / conns) % 2);
+    packets += 1 + bench_replies_count;
+    host_time_advance(BENCH_STEP_US);
+  }
+
+  result->ns = (packets) ? (double) total_ns / packets : 0;
+  result->hit_rate = (stats->hits - hits + stats->misses - misses) ? (double) (stats->hits - hits) / (stats->hits - hits + stats->misses - misses) : 0;
+  result->sent = bench_sent;
+  result->digest = bench_digest;
+}
+
+// Inject a segment of the established connection 0 with an invalid
+// IPv4-header checksum and one with a total length beyond the frame; both have
+// to be dropped instead of being translated and forwarded
+static void bench_invalid(bool cache) {
+  struct bench_frame frame;
+  uint32_t sent = bench_sent, dropped = host_lwip_stats.dropped;
+
+  flow_cache_set_enabled(cache);
+  frame.len = host_packet_build(frame.data, bench_softap_mac, NAPT_PROTO_TCP, bench_softap_net | (2 << 24), 40000, IPADDR(93, 184, 216, 34), 443,
+                                HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, BENCH_SEGMENT);
+  frame.data[6] = 0x02;
+  frame.data[14 + 11] ^= 0x01;
+  host_netif_input(SOFTAP_IF, frame.data, frame.len);
+  frame.data[14 + 11] ^= 0x01;
+
+  // Keep the checksum valid (one's complement arithmetic), so that only the
+  // length is off
+  frame.data[14 + 2] += 0x01;
+  frame.data[14 + 10] -= 0x01;
+  host_netif_input(SOFTAP_IF, frame.data, frame.len);
+
+  CHECK(bench_sent == sent);
+  CHECK(host_lwip_stats.dropped == dropped + 2);
+}
+
+/*------------------------------------*/
+
+static void bench_usage(void) {
+  fprintf(stderr, "Usage: flow_bench [-v] [-c connections] [-n segments] [-r rounds]\n");
+}
+
+int main(int argc, char **argv) {
+  uint32_t conns_custom[1], *conns = (uint32_t *) bench_conns_default, conns_count = 4, idx, round;
+  struct bench_result result[2], off = {0}, on = {0};
+  struct ip_info softap_info;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vc:n:r:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'c': conns_custom[0] = strtoul(optarg, NULL, 0); conns = conns_custom; conns_count = 1; break;
+      case 'n': bench_segments = strtoul(optarg, NULL, 0); break;
+      case 'r': bench_rounds = strtoul(optarg, NULL, 0); break;
+      default: bench_usage(); return 1;
+    }
+  }
+  if (!bench_segments || !bench_rounds || !conns[0] || conns[0] > NAPT_TABLE_SIZE) {
+    bench_usage();
+    return 1;
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);  // Measure the forwarding itself (cf. uplink_sim)
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "flow_bench: Failed to bring up the router!\n");
+    return 1;
+  }
+  wifi_get_macaddr(SOFTAP_IF, bench_softap_mac);
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  bench_softap_net = softap_info.ip.addr & softap_info.netmask.addr;
+  host_netif_tx_cb = bench_tx_cb;
+
+  printf("%-6s %10s %10s %9s %9s\n", "conns", "ns_off", "ns_on", "saving", "hit_rate");
+  for (idx = 0; idx < conns_count; idx++) {
+    bench_open(conns[idx]);
+    for (round = 0; round < bench_rounds; round++) {
+      bench_run(conns[idx], false, &result[0]);
+      bench_run(conns[idx], true, &result[1]);
+      if (!round || result[0].ns < off.ns) {
+        off.ns = result[0].ns;
+      }
+      if (!round || result[1].ns < on.ns) {
+        on.ns = result[1].ns;
+      }
+      off.hit_rate = result[0].hit_rate;
+      on.hit_rate = result[1].hit_rate;
+      // The cache mustn't change a single bit of the forwarded frames
+      CHECK(result[1].sent == result[0].sent && result[1].digest == result[0].digest);
+    }
+    printf("%-6u %10.1f %10.1f %8.1f%% %8.1f%%\n", conns[idx], off.ns, on.ns, (off.ns > 0) ? 100.0 * (off.ns - on.ns) / off.ns : 0, 100.0 * on.hit_rate);
+
+    CHECK(off.hit_rate == 0);
+    if (conns[idx] == 1) {
+      CHECK(on.hit_rate > 0.99);
+    }
+  }
+  bench_invalid(false);
+  bench_invalid(true);
+  flow_cache_set_enabled(FLOW_CACHE);
+
+  if (failures) {
+    printf("flow_bench: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,146 @@
+// host_dhcp.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Messages of the DHCP-clients emulated by the host tools. The
+// messages are passed to the router's DHCP-server via its UDP-socket (cf.
+// host_espconn_recv); addresses are given in network byte order.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "espconn.h"
+#include "host_dhcp.h"
+
+/*------------------------------------*/
+
+#define HOST_DHCP_SERVER_PORT 67
+#define HOST_DHCP_CLIENT_PORT 68
+
+/*------------------------------------*/
+
+// Definition of functions:
+
+static uint32_t host_dhcp_get32(const uint8_t *ptr);
+static void host_dhcp_capture_cb(struct espconn *espconn, uint8 *data, uint16 len);
+uint16_t host_dhcp_build(uint8_t *msg, uint8_t type, const uint8_t *mac, uint32_t xid, uint32_t ciaddr, uint32_t requested, uint32_t server);
+bool host_dhcp_parse(const uint8_t *msg, uint16_t len, struct host_dhcp_reply *reply);
+bool host_dhcp_exchange(uint8_t type, const uint8_t *mac, uint32_t ciaddr, uint32_t requested, uint32_t server, struct host_dhcp_reply *reply);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+const char *host_dhcp_hostname = NULL;
+
+static struct host_dhcp_reply *host_dhcp_captured = NULL;
+static bool host_dhcp_capture_valid = false;
+
+/*------------------------------------*/
+
+static uint32_t host_dhcp_get32(const uint8_t *ptr) {
+  return ((uint32_t) ptr[0] << 24) | ((uint32_t) ptr[1] << 16) | ((uint32_t) ptr[2] << 8) | ptr[3];
+}
+
+static void host_dhcp_capture_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  if (espconn->proto.udp->local_port == HOST_DHCP_SERVER_PORT) {
+    host_dhcp_capture_valid = host_dhcp_parse(data, len, host_dhcp_captured);
+  }
+}
+
+// Build a message of a client with the given MAC-address; requested and server
+// are only added as options, if they aren't 0, the hostname, if
+// host_dhcp_hostname is set. Returns the length of the
+// message (msg must provide room for HOST_DHCP_MSG_LEN bytes).
+uint16_t host_dhcp_build(uint8_t *msg, uint8_t type, const uint8_t *mac, uint32_t xid, uint32_t ciaddr, uint32_t requested, uint32_t server) {
+  uint8_t *opt = msg + 240;
+
+  os_memset(msg, 0, HOST_DHCP_MSG_LEN);
+  msg[0] = 1;
+  msg[1] = 1;
+  msg[2] = 6;
+  msg[4] = xid >> 24;
+  msg[5] = (xid >> 16) & 0xFF;
+  msg[6] = (xid >> 8) & 0xFF;
+  msg[7] = xid & 0xFF;
+  os_memcpy(msg + 12, &ciaddr, 4);
+  os_memcpy(msg + 28, mac, 6);
+  msg[236] = 99;
+  msg[237] = 130;
+  msg[238] = 83;
+  msg[239] = 99;
+
+  *opt++ = 53;
+  *opt++ = 1;
+  *opt++ = type;
+  if (requested) {
+    *opt++ = 50;
+    *opt++ = 4;
+    os_memcpy(opt, &requested, 4);
+    opt += 4;
+  }
+  if (server) {
+    *opt++ = 54;
+    *opt++ = 4;
+    os_memcpy(opt, &server, 4);
+    opt += 4;
+  }
+  if (host_dhcp_hostname) {
+    *opt++ = 12;
+    *opt = os_strlen(host_dhcp_hostname);
+    *opt = (*opt > 32) ? 32 : *opt;
+    os_memcpy(opt + 1, host_dhcp_hostname, *opt);
+    opt += 1 + *opt;
+  }
+  *opt = 255;
+  return HOST_DHCP_MSG_LEN;
+}
+
+// Parse a reply of the DHCP-server; returns false, if it's malformed
+bool host_dhcp_parse(const uint8_t *msg, uint16_t len, struct host_dhcp_reply *reply) {
+  const uint8_t *opt = msg + 240;
+
+  if (len < 240 || msg[0] != 2 || host_dhcp_get32(msg + 236) != 0x63825363) {
+    return false;
+  }
+  os_memset(reply, 0, sizeof(struct host_dhcp_reply));
+  reply->xid = host_dhcp_get32(msg + 4);
+  os_memcpy(&reply->yiaddr, msg + 16, 4);
+  os_memcpy(reply->mac, msg + 28, 6);
+  while (opt + 2 <= msg + len && *opt != 255) {
+    if (*opt == 0) {
+      opt++;
+      continue;
+    }
+    if (opt + 2 + opt[1] > msg + len) {
+      return false;
+    }
+    switch (*opt) {
+      case 53: reply->type = opt[2]; break;
+      case 54: os_memcpy(&reply->server, opt + 2, 4); break;
+      case 1: os_memcpy(&reply->netmask, opt + 2, 4); break;
+      case 3: os_memcpy(&reply->router, opt + 2, 4); break;
+      case 6: os_memcpy(&reply->dns, opt + 2, 4); break;
+      case 51: reply->lease_time = host_dhcp_get32(opt + 2); break;
+    }
+    opt += 2 + opt[1];
+  }
+  return reply->type != 0;
+}
+
+// Pass a message of a client to the DHCP-server and return its reply; returns
+// false, if the server didn't answer
+bool host_dhcp_exchange(uint8_t type, const uint8_t *mac, uint32_t ciaddr, uint32_t requested, uint32_t server, struct host_dhcp_reply *reply) {
+  void (*sent_cb)(struct espconn *espconn, uint8 *data, uint16 len) = host_espconn_sent_cb;
+  uint8_t msg[HOST_DHCP_MSG_LEN], remote_ip[4];
+  uint16_t len = host_dhcp_build(msg, type, mac, os_random(), ciaddr, requested, server);
+
+  os_memcpy(remote_ip, &ciaddr, 4);
+  host_dhcp_captured = reply;
+  host_dhcp_capture_valid = false;
+  host_espconn_sent_cb = host_dhcp_capture_cb;
+  host_espconn_recv(HOST_DHCP_SERVER_PORT, remote_ip, HOST_DHCP_CLIENT_PORT, (char *) msg, len);
+  host_espconn_sent_cb = sent_cb;
+  return host_dhcp_capture_valid;
+}
@@ -0,0 +1,50 @@
+// host_dhcp.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __HOST_DHCP_H__
+#define __HOST_DHCP_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define HOST_DHCP_MSG_LEN 300
+
+#define HOST_DHCP_DISCOVER 1
+#define HOST_DHCP_OFFER 2
+#define HOST_DHCP_REQUEST 3
+#define HOST_DHCP_DECLINE 4
+#define HOST_DHCP_ACK 5
+#define HOST_DHCP_NAK 6
+#define HOST_DHCP_RELEASE 7
+#define HOST_DHCP_INFORM 8
+
+/*-------- structs and types ---------*/
+
+// Fields of a reply of the DHCP-server (addresses in network byte order)
+struct host_dhcp_reply {
+  uint8_t type;
+  uint32_t xid;
+  uint8_t mac[6];
+  uint32_t yiaddr;
+  uint32_t server;
+  uint32_t netmask;
+  uint32_t router;
+  uint32_t dns;
+  uint32_t lease_time;  // In s
+};
+
+/*------------ variables -------------*/
+
+extern const char *host_dhcp_hostname;  // Hostname of the clients (option 12)
+
+/*------------ functions -------------*/
+
+uint16_t host_dhcp_build(uint8_t *msg, uint8_t type, const uint8_t *mac, uint32_t xid, uint32_t ciaddr, uint32_t requested, uint32_t server);
+bool host_dhcp_parse(const uint8_t *msg, uint16_t len, struct host_dhcp_reply *reply);
+bool host_dhcp_exchange(uint8_t type, const uint8_t *mac, uint32_t ciaddr, uint32_t requested, uint32_t server, struct host_dhcp_reply *reply);
+
+#endif
@@ -0,0 +1,278 @@
+// host_lwip.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Minimal emulation of the parts of lwip, that are used by the
+// firmware's modules, for the host. Both network interfaces pass received frames
+// to an emulation of ip_input resp. ip_forward, which delivers packets addressed
+// to the router locally and forwards all others like liblwip.a does (routing by
+// subnet with the station network interface as default route, TTL-decrement
+// and incremental update of the IP-header-checksum). Sent frames are handed to
+// host_netif_tx_cb.
+
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "netif/etharp.h"
+
+/*------------------------------------*/
+
+// Space reserved in front of the payload of every pbuf for headers
+#define HOST_PBUF_HEADROOM 64
+
+// pbuf with the bookkeeping needed by pbuf_header and pbuf_free
+struct host_pbuf {
+  struct pbuf p;
+  uint8_t *base;
+  uint16_t size;
+};
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+struct host_lwip_stats host_lwip_stats;
+void (*host_netif_tx_cb)(uint8_t if_index, const uint8_t *frame, uint16_t len) = NULL;
+struct netif *netif_list = NULL;
+
+static struct netif host_netifs[2];
+
+/*------------------------------------*/
+
+// pbufs:
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type) {
+  struct host_pbuf *hp = calloc(1, sizeof(struct host_pbuf));
+
+  if (!hp) {
+    return NULL;
+  }
+  hp->size = HOST_PBUF_HEADROOM + length;
+  hp->base = malloc(hp->size);
+  if (!hp->base) {
+    free(hp);
+    return NULL;
+  }
+  hp->p.payload = hp->base + HOST_PBUF_HEADROOM;
+  hp->p.len = hp->p.tot_len = length;
+  hp->p.type = type;
+  hp->p.ref = 1;
+  host_lwip_stats.pbuf_alloc++;
+  host_lwip_stats.pbuf_bytes += sizeof(struct host_pbuf) + hp->size;
+  if (host_lwip_stats.pbuf_bytes > host_lwip_stats.pbuf_bytes_peak) {
+    host_lwip_stats.pbuf_bytes_peak = host_lwip_stats.pbuf_bytes;
+  }
+  return &hp->p;
+}
+
+uint8_t pbuf_free(struct pbuf *p) {
+  struct host_pbuf *hp = (struct host_pbuf *) p;
+
+  if (!p || --p->ref > 0) {
+    return 0;
+  }
+  host_lwip_stats.pbuf_free++;
+  host_lwip_stats.pbuf_bytes -= sizeof(struct host_pbuf) + hp->size;
+  free(hp->base);
+  free(hp);
+  return 1;
+}
+
+void pbuf_ref(struct pbuf *p) {
+  p->ref++;
+}
+
+// Move the payload-pointer by the given number of bytes (positive values add a
+// header in front of the payload)
+uint8_t pbuf_header(struct pbuf *p, int16_t header_size_increment) {
+  struct host_pbuf *hp = (struct host_pbuf *) p;
+  uint8_t *payload = (uint8_t *) p->payload - header_size_increment;
+
+  if (payload < hp->base || payload > hp->base + hp->size || (int32_t) p->len + header_size_increment < 0) {
+    return 1;
+  }
+  p->payload = payload;
+  p->len += header_size_increment;
+  p->tot_len += header_size_increment;
+  return 0;
+}
+
+/*------------------------------------*/
+
+// ARP:
+
+// The emulated ARP-table resolves every address to a locally administered
+// MAC-address containing the IP-address
+static void host_etharp_resolve(ip_addr_t *ipaddr, struct eth_addr *ethaddr) {
+  ethaddr->addr[0] = 0x02;
+  ethaddr->addr[1] = 0x00;
+  os_memcpy(&ethaddr->addr[2], &ipaddr->addr, 4);
+}
+
+int8_t etharp_find_addr(struct netif *netif, ip_addr_t *ipaddr, struct eth_addr **eth_ret, ip_addr_t **ip_ret) {
+  static struct eth_addr ethaddr;
+  static ip_addr_t ip;
+
+  host_etharp_resolve(ipaddr, &ethaddr);
+  ip = *ipaddr;
+  *eth_ret = &ethaddr;
+  *ip_ret = &ip;
+  return 0;
+}
+
+// Prepend the ethernet-header and send the packet; if there isn't enough space
+// for the header, the packet is copied into a new pbuf (like lwip does by
+// chaining a header-pbuf)
+err_t etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr) {
+  struct eth_hdr *ethhdr;
+  struct pbuf *p = q;
+  err_t err;
+
+  if (pbuf_header(q, SIZEOF_ETH_HDR)) {
+    p = pbuf_alloc(PBUF_RAW, q->len + SIZEOF_ETH_HDR, PBUF_RAM);
+    if (!p) {
+      return ERR_MEM;
+    }
+    os_memcpy((uint8_t *) p->payload + SIZEOF_ETH_HDR, q->payload, q->len);
+    host_lwip_stats.pbuf_copy++;
+  }
+
+  ethhdr = (struct eth_hdr *) p->payload;
+  host_etharp_resolve(ipaddr, &ethhdr->dest);
+  os_memcpy(&ethhdr->src, netif->hwaddr, ETHARP_HWADDR_LEN);
+  ethhdr->type = PP_HTONS(ETHTYPE_IP);
+  err = netif->linkoutput(netif, p);
+
+  if (p != q) {
+    pbuf_free(p);
+  }
+  else {
+    pbuf_header(q, -SIZEOF_ETH_HDR);
+  }
+  return err;
+}
+
+/*------------------------------------*/
+
+// Network interfaces:
+
+static err_t host_linkoutput(struct netif *netif, struct pbuf *p) {
+  if (host_netif_tx_cb) {
+    host_netif_tx_cb(netif->num, p->payload, p->len);
+  }
+  return ERR_OK;
+}
+
+// Emulation of ethernet_input, ip_input and ip_forward of liblwip.a
+static err_t host_ip_input(struct pbuf *p, struct netif *inp) {
+  struct eth_hdr *ethhdr = (struct eth_hdr *) p->payload;
+  uint8_t *iphdr = (uint8_t *) p->payload + SIZEOF_ETH_HDR;
+  struct netif *outp = NULL;
+  ip_addr_t dest, nexthop;
+  uint32_t chksum = 0;
+  uint16_t hlen, tot_len, idx;
+  uint8_t if_idx;
+
+  if (p->len < SIZEOF_ETH_HDR + 20 || ethhdr->type != PP_HTONS(ETHTYPE_IP)) {
+    host_lwip_stats.dropped++;
+    pbuf_free(p);
+    return ERR_OK;
+  }
+
+  // Invalid IPv4-headers (version, header resp. total length, checksum) are
+  // dropped
+  hlen = (iphdr[0] & 0x0F) * 4;
+  tot_len = (iphdr[2] << 8) | iphdr[3];
+  for (idx = 0; idx + 1 < hlen && SIZEOF_ETH_HDR + idx + 1 < p->len; idx += 2) {
+    chksum += (iphdr[idx] << 8) | iphdr[idx + 1];
+  }
+  chksum = (chksum & 0xFFFF) + (chksum >> 16);
+  chksum = (chksum & 0xFFFF) + (chksum >> 16);
+  if ((iphdr[0] >> 4) != 4 || hlen < 20 || SIZEOF_ETH_HDR + hlen > p->len || tot_len < hlen || SIZEOF_ETH_HDR + tot_len > p->tot_len || chksum != 0xFFFF) {
+    host_lwip_stats.dropped++;
+    pbuf_free(p);
+    return ERR_OK;
+  }
+
+  // Packets addressed to the router itself (incl. broad- and multicasts)
+  os_memcpy(&dest.addr, iphdr + 16, 4);
+  if (dest.addr == inp->ip_addr.addr || dest.addr == IPADDR_NONE || (dest.addr | inp->netmask.addr) == IPADDR_NONE || iphdr[16] >= 224) {
+    host_lwip_stats.local++;
+    pbuf_free(p);
+    return ERR_OK;
+  }
+
+  // Route by subnet; the station network interface is the default route
+  for (if_idx = STATION_IF; if_idx <= SOFTAP_IF; if_idx++) {
+    if (host_netifs[if_idx].ip_addr.addr && ip_addr_netcmp(&dest, &host_netifs[if_idx].ip_addr, &host_netifs[if_idx].netmask)) {
+      outp = &host_netifs[if_idx];
+      break;
+    }
+  }
+  if (!outp && host_netifs[STATION_IF].ip_addr.addr) {
+    outp = &host_netifs[STATION_IF];
+  }
+  if (!outp || outp == inp || iphdr[8] <= 1) {
+    host_lwip_stats.dropped++;
+    pbuf_free(p);
+    return ERR_OK;
+  }
+  nexthop = (outp->gw.addr && !ip_addr_netcmp(&dest, &outp->ip_addr, &outp->netmask)) ? outp->gw : dest;
+
+  // Decrement the TTL and update the checksum incrementally
+  iphdr[8]--;
+  chksum = ((iphdr[10] << 8) | iphdr[11]) + 0x100;
+  chksum = (chksum & 0xFFFF) + (chksum >> 16);
+  iphdr[10] = chksum >> 8;
+  iphdr[11] = chksum & 0xFF;
+
+  pbuf_header(p, -SIZEOF_ETH_HDR);
+  outp->output(outp, p, &nexthop);
+  host_lwip_stats.forwarded++;
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+// (Re-)create the given network interface (cf. wifi_set_opmode)
+void host_netif_reset(uint8_t if_index) {
+  struct netif *nif = &host_netifs[if_index];
+
+  os_memset(nif, 0, sizeof(struct netif));
+  nif->input = host_ip_input;
+  nif->output = etharp_output;
+  nif->linkoutput = host_linkoutput;
+  nif->mtu = 1500;
+  nif->hwaddr_len = ETHARP_HWADDR_LEN;
+  wifi_get_macaddr(if_index, nif->hwaddr);
+  nif->num = if_index;
+  nif->name[0] = (if_index == STATION_IF) ? 'e' : 'a';
+  nif->name[1] = (if_index == STATION_IF) ? 'w' : 'p';
+}
+
+struct netif *eagle_lwip_getif(uint8_t index) {
+  if (index > SOFTAP_IF || !(wifi_get_opmode() & (index + 1))) {
+    return NULL;
+  }
+  return &host_netifs[index];
+}
+
+// Pass a received frame to the input-function of the given network interface
+err_t host_netif_input(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  struct netif *nif = eagle_lwip_getif(if_index);
+  struct pbuf *p;
+
+  if (!nif) {
+    return ERR_IF;
+  }
+  p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+  if (!p) {
+    return ERR_MEM;
+  }
+  os_memcpy(p->payload, frame, len);
+  return nif->input(p, nif);
+}
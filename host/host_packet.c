@@ -0,0 +1,175 @@
+// host_packet.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Construction of Ethernet-frames with IPv4-packets for the host
+// tools and the emulation of the peers answering them. All addresses and ports
+// are given in network byte order resp. host byte order (ports), the frames
+// carry valid IP-header- and transport-layer-checksums.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "netif/etharp.h"
+#include "napt.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+// Definition of functions:
+
+static uint32_t host_packet_sum16(const uint8_t *data, uint16_t len, uint32_t sum);
+void host_packet_chksum_fill(uint8_t *iphdr, uint16_t len);
+uint16_t host_packet_build(uint8_t *frame, const uint8_t *dest_mac, uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags, uint16_t payload);
+uint16_t host_packet_reply(const uint8_t *frame, uint16_t len, uint8_t *reply);
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t host_packet_sum16(const uint8_t *data, uint16_t len, uint32_t sum) {
+  uint16_t idx;
+
+  for (idx = 0; idx + 1 < len; idx += 2) {
+    sum += (data[idx] << 8) | data[idx+1];
+  }
+  if (len & 1) {
+    sum += data[len-1] << 8;
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return sum;
+}
+
+// Recompute the IP-header- and transport-layer-checksums of an IPv4-packet
+void host_packet_chksum_fill(uint8_t *iphdr, uint16_t len) {
+  uint16_t hlen = (iphdr[0] & 0x0F) * 4, l4len = len - hlen, chksum;
+  uint8_t *l4hdr = iphdr + hlen, *field;
+  uint32_t sum = 0;
+
+  iphdr[10] = iphdr[11] = 0;
+  chksum = ~host_packet_sum16(iphdr, hlen, 0);
+  iphdr[10] = chksum >> 8;
+  iphdr[11] = chksum & 0xFF;
+
+  switch (iphdr[9]) {
+    case NAPT_PROTO_TCP:
+      field = l4hdr + 16;
+      sum = host_packet_sum16(iphdr + 12, 8, 0) + NAPT_PROTO_TCP + l4len;
+      break;
+    case NAPT_PROTO_UDP:
+      field = l4hdr + 6;
+      sum = host_packet_sum16(iphdr + 12, 8, 0) + NAPT_PROTO_UDP + l4len;
+      break;
+    case NAPT_PROTO_ICMP:
+      field = l4hdr + 2;
+      break;
+    default:
+      return;
+  }
+  field[0] = field[1] = 0;
+  chksum = ~host_packet_sum16(l4hdr, l4len, sum);
+  if (iphdr[9] == NAPT_PROTO_UDP && chksum == 0) {
+    chksum = 0xFFFF;
+  }
+  field[0] = chksum >> 8;
+  field[1] = chksum & 0xFF;
+}
+
+// Build an Ethernet-frame with a TCP-, UDP- or ICMP-packet (ICMP: echo request
+// with sport as identifier) and the given length of the (zeroed) payload; the
+// source MAC-address is derived from the source address. The frame must
+// provide room for SIZEOF_ETH_HDR + 40 + payload bytes. Returns the length of
+// the frame.
+uint16_t host_packet_build(uint8_t *frame, const uint8_t *dest_mac, uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags, uint16_t payload) {
+  uint8_t *iphdr = frame + SIZEOF_ETH_HDR, *l4hdr = iphdr + 20;
+  uint16_t len = 20 + ((proto == NAPT_PROTO_TCP) ? 20 : 8) + payload;
+
+  os_memset(frame, 0, SIZEOF_ETH_HDR + len);
+  os_memcpy(frame, dest_mac, 6);
+  frame[6] = 0x02;
+  os_memcpy(frame + 8, &src, 4);
+  frame[12] = ETHTYPE_IP >> 8;
+  frame[13] = ETHTYPE_IP & 0xFF;
+
+  iphdr[0] = 0x45;
+  iphdr[2] = len >> 8;
+  iphdr[3] = len & 0xFF;
+  iphdr[8] = 64;
+  iphdr[9] = proto;
+  os_memcpy(iphdr + 12, &src, 4);
+  os_memcpy(iphdr + 16, &dest, 4);
+  switch (proto) {
+    case NAPT_PROTO_TCP:
+      l4hdr[12] = 5 << 4;
+      l4hdr[13] = tcp_flags;
+      // Fall through
+    case NAPT_PROTO_UDP:
+      l4hdr[0] = sport >> 8;
+      l4hdr[1] = sport & 0xFF;
+      l4hdr[2] = dport >> 8;
+      l4hdr[3] = dport & 0xFF;
+      if (proto == NAPT_PROTO_UDP) {
+        l4hdr[4] = (len - 20) >> 8;
+        l4hdr[5] = (len - 20) & 0xFF;
+      }
+      break;
+    case NAPT_PROTO_ICMP:
+      l4hdr[0] = 8;
+      l4hdr[4] = sport >> 8;
+      l4hdr[5] = sport & 0xFF;
+      break;
+  }
+  host_packet_chksum_fill(iphdr, len);
+  return SIZEOF_ETH_HDR + len;
+}
+
+// Turn a frame into the reply of its receiver: the MAC-addresses, IP-addresses
+// and ports are swapped, a TCP-SYN is answered with a SYN/ACK and all other
+// TCP-segments with an ACK (keeping FIN and RST), an ICMP-echo-request with an
+// echo-reply. Returns the length of the reply or 0, if the frame isn't answered.
+uint16_t host_packet_reply(const uint8_t *frame, uint16_t len, uint8_t *reply) {
+  uint8_t *iphdr, *l4hdr, tmp[6];
+  uint16_t hlen;
+
+  if (len < SIZEOF_ETH_HDR + 20) {
+    return 0;
+  }
+  os_memcpy(reply, frame, len);
+
+  // Swap the MAC-addresses, the IP-addresses and the ports
+  os_memcpy(tmp, reply, 6);
+  os_memcpy(reply, reply + 6, 6);
+  os_memcpy(reply + 6, tmp, 6);
+  iphdr = reply + SIZEOF_ETH_HDR;
+  hlen = (iphdr[0] & 0x0F) * 4;
+  l4hdr = iphdr + hlen;
+  os_memcpy(tmp, iphdr + 12, 4);
+  os_memcpy(iphdr + 12, iphdr + 16, 4);
+  os_memcpy(iphdr + 16, tmp, 4);
+  iphdr[8] = 64;
+
+  switch (iphdr[9]) {
+    case NAPT_PROTO_TCP:
+      // SYN -> SYN/ACK, everything else is acknowledged
+      l4hdr[13] = (l4hdr[13] & HOST_PACKET_TCP_SYN && !(l4hdr[13] & HOST_PACKET_TCP_ACK)) ? HOST_PACKET_TCP_SYN | HOST_PACKET_TCP_ACK : (l4hdr[13] & (HOST_PACKET_TCP_FIN | HOST_PACKET_TCP_RST)) | HOST_PACKET_TCP_ACK;
+      // Fall through
+    case NAPT_PROTO_UDP:
+      os_memcpy(tmp, l4hdr, 2);
+      os_memcpy(l4hdr, l4hdr + 2, 2);
+      os_memcpy(l4hdr + 2, tmp, 2);
+      break;
+    case NAPT_PROTO_ICMP:
+      if (l4hdr[0] != 8) {
+        return 0;
+      }
+      l4hdr[0] = 0;
+      break;
+    default:
+      return 0;
+  }
+  host_packet_chksum_fill(iphdr, len - SIZEOF_ETH_HDR);
+  return len;
+}
@@ -0,0 +1,26 @@
+// host_packet.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __HOST_PACKET_H__
+#define __HOST_PACKET_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define HOST_PACKET_TCP_FIN 0x01
+#define HOST_PACKET_TCP_SYN 0x02
+#define HOST_PACKET_TCP_RST 0x04
+#define HOST_PACKET_TCP_PSH 0x08
+#define HOST_PACKET_TCP_ACK 0x10
+
+/*------------ functions -------------*/
+
+void host_packet_chksum_fill(uint8_t *iphdr, uint16_t len);
+uint16_t host_packet_build(uint8_t *frame, const uint8_t *dest_mac, uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags, uint16_t payload);
+uint16_t host_packet_reply(const uint8_t *frame, uint16_t len, uint8_t *reply);
+
+#endif
@@ -0,0 +1,780 @@
+// host_sdk.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-implementation of the SDK-functions used by the firmware's
+// modules. The system time is virtual, so that timeouts and timers behave
+// deterministically independent of the speed of the host; host_clock_ns
+// provides the real time for measurements. Armed timers are executed, when the
+// virtual time is advanced via host_time_advance. Posted events of tasks
+// (system_os_post) are executed by host_os_run resp. whenever the virtual time
+// is advanced, i.e. after the current "callback" of the host-tool has
+// returned, just like the SDK does.
+//
+// The WiFi-API keeps its state in memory; events (e.g. obtaining an IP-address
+// on the station network interface or the association of a station to the soft
+// access-point) are injected by the host-tools and passed to the registered
+// event-handler just like the SDK does. Alternatively, the station connects to
+// the emulated host access-point host_wifi_ap: wifi_station_connect then
+// emits the events of the connection after the configured scan- and join-time
+// and retries on failures like the SDK. The flash and the RTC-memory are
+// images in memory.
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <time.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "mem.h"
+#include "gpio.h"
+#include "espconn.h"
+#include "spi_flash.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+
+/*------------------------------------*/
+
+#define HOST_ESPCONN_MAX 8
+#define HOST_HEAP_SIZE 40960  // Free heap of the firmware after the boot
+#define HOST_HEAP_HDR 16      // Header of an allocation (size; keeps the alignment)
+#define HOST_FLASH_SIZE 0x100000  // FLASH_SIZE_8M_MAP_512_512
+#define HOST_STATIONS_MAX 16
+#define HOST_RTC_BLOCKS 192   // System (0 to 63) and user (64 to 191) blocks of 4 bytes
+
+/*------------------------------------*/
+
+// Provided by host_lwip.c
+void host_netif_reset(uint8 if_index);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+bool host_verbose = false;
+struct host_heap_stats host_heap_stats;
+struct host_flash_stats host_flash_stats;
+uint32 host_gpio_out = 0;
+struct host_wifi_ap host_wifi_ap = {false, "", "", {0}, 1, 0, 0, 0, 2500, 300};
+void (*host_espconn_sent_cb)(struct espconn *espconn, uint8 *data, uint16 len) = NULL;
+
+static uint32 host_time_us = 0;
+static os_timer_t *host_timers = NULL;
+
+// Registered tasks (cf. system_os_task) with their event-queues
+static struct {
+  os_task_t task;
+  os_event_t *queue;
+  uint8 qlen, head, count;
+} host_tasks[USER_TASK_PRIO_MAX];
+
+static uint8 host_opmode = NULL_MODE;
+static wifi_event_handler_cb_t host_event_cb = NULL;
+static uint8 host_macaddr[2][6] = {{0x18, 0xFE, 0x34, 0x00, 0x00, 0x01}, {0x1A, 0xFE, 0x34, 0x00, 0x00, 0x01}};
+static struct station_info host_stations[HOST_STATIONS_MAX];
+static uint8 host_stations_count = 0;
+static uint8 host_flash[HOST_FLASH_SIZE];
+static bool host_flash_init = false;
+static uint32 host_rtc[HOST_RTC_BLOCKS];
+
+static struct station_config host_station_config, host_station_config_default;
+static char host_station_hostname[33] = "ESP_HOST"; // Sent to the DHCP-server
+static struct softap_config host_softap_config;
+static uint8 host_station_status = STATION_IDLE;
+static uint8 host_channel = 1;
+static os_timer_t host_station_timer;   // Pending step of the connection
+
+static struct espconn *host_espconns[HOST_ESPCONN_MAX];
+static uint16 host_espconn_port = 49200;
+static uint32 host_random_state = 0x9E3779B9;
+static remot_info host_remote_info;
+
+/*------------------------------------*/
+
+// Time and timers:
+
+uint32 system_get_time(void) {
+  return host_time_us;
+}
+
+void host_time_set(uint32 time_us) {
+  host_time_us = time_us;
+}
+
+// Advance the virtual time and execute all timers, that expire in between (in
+// the order of their expiry)
+void host_time_advance(uint32 delta_us) {
+  uint32 target = host_time_us + delta_us;
+  os_timer_t *timer, *next;
+
+  host_os_run();
+  for (;;) {
+    next = NULL;
+    for (timer = host_timers; timer; timer = timer->timer_next) {
+      if (timer->timer_armed && (int32) (target - timer->timer_expire) >= 0 && (!next || (int32) (next->timer_expire - timer->timer_expire) > 0)) {
+        next = timer;
+      }
+    }
+    if (!next) {
+      break;
+    }
+    if ((int32) (next->timer_expire - host_time_us) > 0) {
+      host_time_us = next->timer_expire;
+    }
+    if (next->timer_period) {
+      next->timer_expire += next->timer_period;
+    }
+    else {
+      next->timer_armed = false;
+    }
+    next->timer_func(next->timer_arg);
+    host_os_run();
+  }
+  host_time_us = target;
+}
+
+// Return the host's monotonic real time in ns
+uint64_t host_clock_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Emulate the CPU's cycle counter (running at system_get_cpu_freq MHz) with
+// the host's real time
+uint32 host_ccount(void) {
+  return (uint32) (host_clock_ns() * system_get_cpu_freq() / 1000);
+}
+
+// Number of the armed timers (e.g. to check, that a module stopped all of its
+// timers)
+uint16 host_timers_armed(void) {
+  os_timer_t *timer;
+  uint16 count = 0;
+
+  for (timer = host_timers; timer; timer = timer->timer_next) {
+    count += timer->timer_armed;
+  }
+  return count;
+}
+
+void os_timer_setfn(os_timer_t *ptimer, os_timer_func_t *pfunction, void *parg) {
+  os_timer_t *timer;
+
+  for (timer = host_timers; timer && timer != ptimer; timer = timer->timer_next);
+  if (!timer) {
+    ptimer->timer_next = host_timers;
+    host_timers = ptimer;
+  }
+  ptimer->timer_func = pfunction;
+  ptimer->timer_arg = parg;
+  ptimer->timer_armed = false;
+}
+
+void os_timer_arm(os_timer_t *ptimer, uint32_t msec, bool repeat_flag) {
+  ptimer->timer_expire = host_time_us + msec * 1000;
+  ptimer->timer_period = (repeat_flag) ? msec * 1000 : 0;
+  ptimer->timer_armed = true;
+}
+
+// Disarm the timer and remove it from the list, since it might be freed
+// afterwards
+void os_timer_disarm(os_timer_t *ptimer) {
+  os_timer_t **timer;
+
+  for (timer = &host_timers; *timer; timer = &(*timer)->timer_next) {
+    if (*timer == ptimer) {
+      *timer = ptimer->timer_next;
+      break;
+    }
+  }
+  ptimer->timer_armed = false;
+}
+
+/*------------------------------------*/
+
+// Tasks:
+
+bool system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen) {
+  if (prio >= USER_TASK_PRIO_MAX || !task || !queue || !qlen) {
+    return false;
+  }
+  host_tasks[prio].task = task;
+  host_tasks[prio].queue = queue;
+  host_tasks[prio].qlen = qlen;
+  host_tasks[prio].head = host_tasks[prio].count = 0;
+  return true;
+}
+
+// Queue an event for the task of the given priority; fails, if its queue is
+// full
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par) {
+  os_event_t *evt;
+
+  if (prio >= USER_TASK_PRIO_MAX || !host_tasks[prio].task || host_tasks[prio].count >= host_tasks[prio].qlen) {
+    return false;
+  }
+  evt = &host_tasks[prio].queue[(host_tasks[prio].head + host_tasks[prio].count) % host_tasks[prio].qlen];
+  evt->sig = sig;
+  evt->par = par;
+  host_tasks[prio].count++;
+  return true;
+}
+
+// Execute the posted events, the ones of the highest priority first
+void host_os_run(void) {
+  os_event_t evt;
+  int8 prio;
+
+  for (prio = USER_TASK_PRIO_MAX - 1; prio >= 0; prio--) {
+    if (host_tasks[prio].count) {
+      evt = host_tasks[prio].queue[host_tasks[prio].head];
+      host_tasks[prio].head = (host_tasks[prio].head + 1) % host_tasks[prio].qlen;
+      host_tasks[prio].count--;
+      host_tasks[prio].task(&evt);
+      prio = USER_TASK_PRIO_MAX;  // Start over with the highest priority
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Heap:
+
+// Allocate a block with a header holding its size, so that the heap-usage can
+// be tracked on release
+void *host_heap_malloc(size_t size) {
+  uint8_t *block = malloc(HOST_HEAP_HDR + size);
+
+  if (!block) {
+    return NULL;
+  }
+  *(size_t *) block = size;
+  host_heap_stats.used += size;
+  host_heap_stats.allocs++;
+  if (host_heap_stats.used > host_heap_stats.peak) {
+    host_heap_stats.peak = host_heap_stats.used;
+  }
+  return block + HOST_HEAP_HDR;
+}
+
+void *host_heap_zalloc(size_t size) {
+  void *ptr = host_heap_malloc(size);
+
+  if (ptr) {
+    os_memset(ptr, 0, size);
+  }
+  return ptr;
+}
+
+void host_heap_free(void *ptr) {
+  uint8_t *block = (uint8_t *) ptr - HOST_HEAP_HDR;
+
+  if (!ptr) {
+    return;
+  }
+  host_heap_stats.used -= *(size_t *) block;
+  free(block);
+}
+
+// Restart the tracking of the maximum with the current usage
+void host_heap_reset_peak(void) {
+  host_heap_stats.peak = host_heap_stats.used;
+}
+
+/*------------------------------------*/
+
+// System:
+
+uint8 system_get_cpu_freq(void) {
+  return 80;
+}
+
+uint32 system_get_free_heap_size(void) {
+  return (host_heap_stats.used < HOST_HEAP_SIZE) ? HOST_HEAP_SIZE - host_heap_stats.used : 0;
+}
+
+enum flash_size_map system_get_flash_size_map(void) {
+  return FLASH_SIZE_8M_MAP_512_512;
+}
+
+// The RTC-memory is addressed in blocks of 4 bytes; only the user blocks can be
+// accessed
+bool system_rtc_mem_read(uint8 src_addr, void *des_addr, uint16 load_size) {
+  if (src_addr < 64 || src_addr * 4 + load_size > sizeof(host_rtc)) {
+    return false;
+  }
+  os_memcpy(des_addr, (uint8 *) host_rtc + src_addr * 4, load_size);
+  return true;
+}
+
+bool system_rtc_mem_write(uint8 des_addr, const void *src_addr, uint16 save_size) {
+  if (des_addr < 64 || des_addr * 4 + save_size > sizeof(host_rtc)) {
+    return false;
+  }
+  os_memcpy((uint8 *) host_rtc + des_addr * 4, src_addr, save_size);
+  return true;
+}
+
+// Deterministic pseudo random numbers (xorshift32), so that runs can be
+// reproduced
+unsigned long os_random(void) {
+  host_random_state ^= host_random_state << 13;
+  host_random_state ^= host_random_state >> 17;
+  host_random_state ^= host_random_state << 5;
+  return host_random_state;
+}
+
+uint32_t ipaddr_addr(const char *cp) {
+  return inet_addr(cp);
+}
+
+/*------------------------------------*/
+
+// GPIO:
+
+void gpio_init(void) {
+}
+
+void gpio_output_set(uint32 set_mask, uint32 clear_mask, uint32 enable_mask, uint32 disable_mask) {
+  host_gpio_out = (host_gpio_out | set_mask) & ~clear_mask;
+}
+
+void gpio_pin_intr_state_set(uint32 i, GPIO_INT_TYPE intr_state) {
+}
+
+/*------------------------------------*/
+
+// WiFi:
+
+uint8 wifi_get_opmode(void) {
+  return host_opmode;
+}
+
+// Network interfaces are (re-)created by the SDK, when they are enabled
+bool wifi_set_opmode(uint8 opmode) {
+  if ((opmode & STATION_MODE) && !(host_opmode & STATION_MODE)) {
+    host_netif_reset(STATION_IF);
+  }
+  if ((opmode & SOFTAP_MODE) && !(host_opmode & SOFTAP_MODE)) {
+    host_netif_reset(SOFTAP_IF);
+  }
+  host_opmode = opmode;
+  return true;
+}
+
+bool wifi_get_ip_info(uint8 if_index, struct ip_info *info) {
+  struct netif *nif = eagle_lwip_getif(if_index);
+
+  if (!nif || !info) {
+    return false;
+  }
+  info->ip = nif->ip_addr;
+  info->netmask = nif->netmask;
+  info->gw = nif->gw;
+  return true;
+}
+
+bool wifi_set_ip_info(uint8 if_index, struct ip_info *info) {
+  struct netif *nif = eagle_lwip_getif(if_index);
+
+  if (!nif || !info) {
+    return false;
+  }
+  nif->ip_addr = info->ip;
+  nif->netmask = info->netmask;
+  nif->gw = info->gw;
+  return true;
+}
+
+bool wifi_get_macaddr(uint8 if_index, uint8 *macaddr) {
+  if (if_index > SOFTAP_IF) {
+    return false;
+  }
+  os_memcpy(macaddr, host_macaddr[if_index], 6);
+  return true;
+}
+
+bool wifi_set_broadcast_if(uint8 interface) {
+  return true;
+}
+
+void wifi_set_event_handler_cb(wifi_event_handler_cb_t cb) {
+  host_event_cb = cb;
+}
+
+// Step of the connection to host_wifi_ap; the station joins the host access-
+// point, if the configuration matches, and retries every scan_ms otherwise
+// (just like the SDK does)
+static void host_station_timerfunc(void *arg) {
+  struct station_config *config = &host_station_config;
+  bool found = host_wifi_ap.up && !os_strncmp((char *) config->ssid, (char *) host_wifi_ap.ssid, 32) && (!config->bssid_set || !os_memcmp(config->bssid, host_wifi_ap.bssid, 6));
+
+  if (found && !os_strncmp((char *) config->password, (char *) host_wifi_ap.password, 64)) {
+    host_channel = host_wifi_ap.channel;
+    host_wifi_got_ip(host_wifi_ap.ip, host_wifi_ap.netmask, host_wifi_ap.gw);
+    return;
+  }
+  host_wifi_disconnected((found) ? REASON_AUTH_FAIL : REASON_NO_AP_FOUND);
+  host_station_status = (found) ? STATION_WRONG_PASSWORD : STATION_NO_AP_FOUND;
+  os_timer_setfn(&host_station_timer, (os_timer_func_t *) host_station_timerfunc, NULL);
+  os_timer_arm(&host_station_timer, host_wifi_ap.scan_ms + host_wifi_ap.join_ms, false);
+}
+
+// Without host_wifi_ap, the connection is established by the host-tools (cf.
+// host_wifi_got_ip)
+bool wifi_station_connect(void) {
+  bool direct = host_station_config.bssid_set && host_channel == host_wifi_ap.channel;
+
+  if (!(host_opmode & STATION_MODE)) {
+    return false;
+  }
+  if (host_wifi_ap.up) {
+    host_station_status = STATION_CONNECTING;
+    os_timer_setfn(&host_station_timer, (os_timer_func_t *) host_station_timerfunc, NULL);
+    os_timer_arm(&host_station_timer, ((direct) ? 0 : host_wifi_ap.scan_ms) + host_wifi_ap.join_ms, false);
+  }
+  return true;
+}
+
+bool wifi_station_disconnect(void) {
+  os_timer_disarm(&host_station_timer);
+  host_station_status = STATION_IDLE;
+  return true;
+}
+
+// The configuration is stored in the (emulated) flash and used after a power
+// loss
+bool wifi_station_set_config(struct station_config *config) {
+  host_station_config = *config;
+  host_station_config_default = *config;
+  return true;
+}
+
+bool wifi_station_set_config_current(struct station_config *config) {
+  host_station_config = *config;
+  return true;
+}
+
+// While connected, the BSSID of the host access-point is returned
+bool wifi_station_get_config(struct station_config *config) {
+  *config = host_station_config;
+  if (host_station_status == STATION_GOT_IP && host_wifi_ap.up) {
+    os_memcpy(config->bssid, host_wifi_ap.bssid, 6);
+  }
+  return true;
+}
+
+bool wifi_station_get_config_default(struct station_config *config) {
+  *config = host_station_config_default;
+  return true;
+}
+
+// The hostname isn't used by the host's WiFi-API itself, but by the host-tools
+// emulating the station's DHCP-client (cf. mesh_sim)
+bool wifi_station_set_hostname(char *name) {
+  if (!name || os_strlen(name) >= sizeof(host_station_hostname)) {
+    return false;
+  }
+  os_strcpy(host_station_hostname, name);
+  return true;
+}
+
+char *wifi_station_get_hostname(void) {
+  return host_station_hostname;
+}
+
+uint8 wifi_station_get_connect_status(void) {
+  return host_station_status;
+}
+
+uint8 wifi_get_channel(void) {
+  return host_channel;
+}
+
+bool wifi_set_channel(uint8 channel) {
+  host_channel = channel;
+  return true;
+}
+
+// Setting the configuration restarts the soft access-point, which disassociates
+// all stations
+bool wifi_softap_set_config(struct softap_config *config) {
+  uint8 mac[6];
+
+  if (!(host_opmode & SOFTAP_MODE)) {
+    return false;
+  }
+  while (host_stations_count) {
+    os_memcpy(mac, host_stations[0].bssid, 6);
+    host_wifi_sta_disconnected(mac);
+  }
+  os_memcpy(&host_softap_config, config, sizeof(struct softap_config));
+  return true;
+}
+
+bool wifi_softap_get_config(struct softap_config *config) {
+  os_memcpy(config, &host_softap_config, sizeof(struct softap_config));
+  return true;
+}
+
+bool wifi_softap_dhcps_stop(void) {
+  return true;
+}
+
+// The list of associated stations is kept by host_wifi_sta_connected resp.
+// host_wifi_sta_disconnected
+struct station_info *wifi_softap_get_station_info(void) {
+  return (host_stations_count) ? host_stations : NULL;
+}
+
+void wifi_softap_free_station_info(void) {
+}
+
+// Pass the given event to the registered event-handler
+void host_wifi_event(System_Event_t *evt) {
+  if (host_event_cb) {
+    host_event_cb(evt);
+  }
+}
+
+// Assign an IP-address to the station network interface and inject the
+// correlating event
+void host_wifi_got_ip(uint32 ip, uint32 netmask, uint32 gw) {
+  System_Event_t evt;
+  struct netif *nif = eagle_lwip_getif(STATION_IF);
+
+  host_station_status = STATION_GOT_IP;
+  if (nif) {
+    nif->ip_addr.addr = ip;
+    nif->netmask.addr = netmask;
+    nif->gw.addr = gw;
+  }
+  os_memset(&evt, 0, sizeof(evt));
+  evt.event = EVENT_STAMODE_GOT_IP;
+  evt.event_info.got_ip.ip.addr = ip;
+  evt.event_info.got_ip.mask.addr = netmask;
+  evt.event_info.got_ip.gw.addr = gw;
+  host_wifi_event(&evt);
+}
+
+// Remove the IP-address of the station network interface and inject the
+// correlating event
+void host_wifi_disconnected(uint8 reason) {
+  System_Event_t evt;
+  struct netif *nif = eagle_lwip_getif(STATION_IF);
+
+  host_station_status = STATION_IDLE;
+  if (nif) {
+    nif->ip_addr.addr = 0;
+  }
+  os_memset(&evt, 0, sizeof(evt));
+  evt.event = EVENT_STAMODE_DISCONNECTED;
+  evt.event_info.disconnected.reason = reason;
+  host_wifi_event(&evt);
+}
+
+// Associate a station to the soft access-point and inject the correlating
+// event; returns false, if the soft access-point is disabled or full
+bool host_wifi_sta_connected(const uint8 *mac) {
+  System_Event_t evt;
+  uint8 idx;
+
+  if (!(host_opmode & SOFTAP_MODE) || host_stations_count == HOST_STATIONS_MAX) {
+    return false;
+  }
+  idx = host_stations_count++;
+  os_memset(&host_stations[idx], 0, sizeof(struct station_info));
+  os_memcpy(host_stations[idx].bssid, mac, 6);
+  if (idx) {
+    host_stations[idx-1].next.stqe_next = &host_stations[idx];
+  }
+  os_memset(&evt, 0, sizeof(evt));
+  evt.event = EVENT_SOFTAPMODE_STACONNECTED;
+  os_memcpy(evt.event_info.sta_connected.mac, mac, 6);
+  evt.event_info.sta_connected.aid = idx + 1;
+  host_wifi_event(&evt);
+  return true;
+}
+
+// Emulate a power loss of the device: the connection and the RTC-memory are
+// lost; the station configuration stored in the flash is kept, if keep_config
+// is set
+void host_wifi_power_loss(bool keep_config) {
+  wifi_station_disconnect();
+  os_memset(host_rtc, 0xA5, sizeof(host_rtc));
+  os_memset(&host_station_config, 0, sizeof(host_station_config));
+  if (!keep_config) {
+    os_memset(&host_station_config_default, 0, sizeof(host_station_config_default));
+  }
+  host_channel = 1;
+}
+
+// Remove a station from the soft access-point and inject the correlating event
+void host_wifi_sta_disconnected(const uint8 *mac) {
+  System_Event_t evt;
+  uint8 idx;
+
+  for (idx = 0; idx < host_stations_count && os_memcmp(host_stations[idx].bssid, mac, 6); idx++);
+  if (idx == host_stations_count) {
+    return;
+  }
+  os_memmove(&host_stations[idx], &host_stations[idx+1], (host_stations_count - idx - 1) * sizeof(struct station_info));
+  host_stations_count--;
+  for (idx = 0; idx < host_stations_count; idx++) {
+    host_stations[idx].next.stqe_next = (idx + 1 < host_stations_count) ? &host_stations[idx+1] : NULL;
+  }
+  os_memset(&evt, 0, sizeof(evt));
+  evt.event = EVENT_SOFTAPMODE_STADISCONNECTED;
+  os_memcpy(evt.event_info.sta_disconnected.mac, mac, 6);
+  host_wifi_event(&evt);
+}
+
+/*------------------------------------*/
+
+// Flash:
+
+// Restore the erased state of the emulated flash
+void host_flash_erase(void) {
+  os_memset(host_flash, 0xFF, sizeof(host_flash));
+  host_flash_init = true;
+}
+
+SpiFlashOpResult spi_flash_erase_sector(uint16 sec) {
+  if (!host_flash_init) {
+    host_flash_erase();
+  }
+  if ((sec + 1) * SPI_FLASH_SEC_SIZE > HOST_FLASH_SIZE) {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  os_memset(host_flash + sec * SPI_FLASH_SEC_SIZE, 0xFF, SPI_FLASH_SEC_SIZE);
+  host_flash_stats.erases++;
+  return SPI_FLASH_RESULT_OK;
+}
+
+// Like the real flash, writing can only clear bits; the address and the size
+// must be 4 byte aligned
+SpiFlashOpResult spi_flash_write(uint32 des_addr, uint32 *src_addr, uint32 size) {
+  uint32 idx;
+
+  if (!host_flash_init) {
+    host_flash_erase();
+  }
+  if ((des_addr | size) & 3 || des_addr + size > HOST_FLASH_SIZE) {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  for (idx = 0; idx < size; idx++) {
+    host_flash[des_addr + idx] &= ((uint8 *) src_addr)[idx];
+  }
+  host_flash_stats.writes++;
+  return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult spi_flash_read(uint32 src_addr, uint32 *des_addr, uint32 size) {
+  if (!host_flash_init) {
+    host_flash_erase();
+  }
+  if ((src_addr | size) & 3 || src_addr + size > HOST_FLASH_SIZE) {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  os_memcpy(des_addr, host_flash + src_addr, size);
+  host_flash_stats.reads++;
+  return SPI_FLASH_RESULT_OK;
+}
+
+// Host-implementation of the application's choice of the RF-calibration-
+// sector (cf. user_rf_cal_sector_set in user_main.c) for the emulated flash
+uint32 user_rf_cal_sector_set(void) {
+  return 256 - 5;
+}
+
+/*------------------------------------*/
+
+// espconn:
+
+sint8 espconn_create(struct espconn *espconn) {
+  uint8 idx;
+
+  if (!espconn || !espconn->proto.udp) {
+    return ESPCONN_ARG;
+  }
+  for (idx = 0; idx < HOST_ESPCONN_MAX; idx++) {
+    if (host_espconns[idx] && host_espconns[idx]->proto.udp->local_port == espconn->proto.udp->local_port) {
+      return ESPCONN_ISCONN;
+    }
+  }
+  for (idx = 0; idx < HOST_ESPCONN_MAX; idx++) {
+    if (!host_espconns[idx]) {
+      host_espconns[idx] = espconn;
+      return ESPCONN_OK;
+    }
+  }
+  return ESPCONN_MEM;
+}
+
+sint8 espconn_delete(struct espconn *espconn) {
+  uint8 idx;
+
+  for (idx = 0; idx < HOST_ESPCONN_MAX; idx++) {
+    if (host_espconns[idx] == espconn) {
+      host_espconns[idx] = NULL;
+      return ESPCONN_OK;
+    }
+  }
+  return ESPCONN_ARG;
+}
+
+sint8 espconn_regist_recvcb(struct espconn *espconn, espconn_recv_callback recv_cb) {
+  espconn->recv_callback = recv_cb;
+  return ESPCONN_OK;
+}
+
+sint8 espconn_send(struct espconn *espconn, uint8 *psent, uint16 length) {
+  if (host_espconn_sent_cb) {
+    host_espconn_sent_cb(espconn, psent, length);
+  }
+  return ESPCONN_OK;
+}
+
+sint8 espconn_sendto(struct espconn *espconn, uint8 *psent, uint16 length) {
+  return espconn_send(espconn, psent, length);
+}
+
+// Return a free local port
+uint32 espconn_port(void) {
+  return host_espconn_port++;
+}
+
+sint8 espconn_get_connection_info(struct espconn *pespconn, remot_info **pcon_info, uint8 typeflags) {
+  *pcon_info = &host_remote_info;
+  return ESPCONN_OK;
+}
+
+// Number of the created sockets
+uint8 host_espconn_count(void) {
+  uint8 idx, count = 0;
+
+  for (idx = 0; idx < HOST_ESPCONN_MAX; idx++) {
+    count += (host_espconns[idx] != NULL);
+  }
+  return count;
+}
+
+// Deliver a datagram to the socket bound to local_port
+void host_espconn_recv(uint16 local_port, const uint8 *remote_ip, uint16 remote_port, char *data, unsigned short len) {
+  uint8 idx;
+  struct espconn *espconn;
+
+  for (idx = 0; idx < HOST_ESPCONN_MAX; idx++) {
+    espconn = host_espconns[idx];
+    if (espconn && espconn->proto.udp->local_port == local_port && espconn->recv_callback) {
+      os_memcpy(host_remote_info.remote_ip, remote_ip, 4);
+      host_remote_info.remote_port = remote_port;
+      espconn->recv_callback(espconn, data, len);
+      return;
+    }
+  }
+}
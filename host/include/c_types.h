@@ -0,0 +1,32 @@
+// c_types.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's c_types.h for compiling the firmware's modules
+// for the host (cf. Makefile).
+
+#ifndef __C_TYPES_H__
+#define __C_TYPES_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t uint8;
+typedef int8_t sint8;
+typedef uint16_t uint16;
+typedef int16_t sint16;
+typedef uint32_t uint32;
+typedef int32_t sint32;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RODATA_ATTR
+
+#define BIT(nr) (1UL << (nr))
+
+#endif
@@ -0,0 +1,89 @@
+// espconn.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's espconn.h for compiling the firmware's modules
+// for the host (cf. Makefile). Sent datagrams are handed to host_espconn_sent_cb.
+
+#ifndef __ESPCONN_H__
+#define __ESPCONN_H__
+
+#include "c_types.h"
+
+#define ESPCONN_OK 0
+#define ESPCONN_MEM -1
+#define ESPCONN_ARG -12
+#define ESPCONN_IF -14
+#define ESPCONN_ISCONN -15
+
+enum espconn_type {
+  ESPCONN_INVALID = 0,
+  ESPCONN_TCP = 0x10,
+  ESPCONN_UDP = 0x20
+};
+
+enum espconn_state {
+  ESPCONN_NONE,
+  ESPCONN_WAIT,
+  ESPCONN_LISTEN,
+  ESPCONN_CONNECT,
+  ESPCONN_WRITE,
+  ESPCONN_READ,
+  ESPCONN_CLOSE
+};
+
+typedef void (*espconn_recv_callback)(void *arg, char *pdata, unsigned short len);
+typedef void (*espconn_sent_callback)(void *arg);
+
+typedef struct _esp_udp {
+  int remote_port;
+  int local_port;
+  uint8 local_ip[4];
+  uint8 remote_ip[4];
+} esp_udp;
+
+typedef struct _esp_tcp {
+  int remote_port;
+  int local_port;
+  uint8 local_ip[4];
+  uint8 remote_ip[4];
+} esp_tcp;
+
+struct espconn {
+  enum espconn_type type;
+  enum espconn_state state;
+  union {
+    esp_tcp *tcp;
+    esp_udp *udp;
+  } proto;
+  espconn_recv_callback recv_callback;
+  espconn_sent_callback sent_callback;
+  uint8 link_cnt;
+  void *reverse;
+};
+
+typedef struct _remot_info {
+  enum espconn_state state;
+  int remote_port;
+  uint8 remote_ip[4];
+} remot_info;
+
+sint8 espconn_create(struct espconn *espconn);
+sint8 espconn_delete(struct espconn *espconn);
+sint8 espconn_regist_recvcb(struct espconn *espconn, espconn_recv_callback recv_cb);
+sint8 espconn_send(struct espconn *espconn, uint8 *psent, uint16 length);
+sint8 espconn_sendto(struct espconn *espconn, uint8 *psent, uint16 length);
+sint8 espconn_get_connection_info(struct espconn *pespconn, remot_info **pcon_info, uint8 typeflags);
+uint32 espconn_port(void);
+
+/*------------ host only -------------*/
+
+// Called for every datagram sent via espconn_send resp. espconn_sendto
+extern void (*host_espconn_sent_cb)(struct espconn *espconn, uint8 *data, uint16 len);
+
+uint8 host_espconn_count(void);
+void host_espconn_recv(uint16 local_port, const uint8 *remote_ip, uint16 remote_port, char *data, unsigned short len);
+
+#endif
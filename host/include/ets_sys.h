@@ -0,0 +1,20 @@
+// ets_sys.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's ets_sys.h for compiling the firmware's modules
+// for the host (cf. Makefile).
+
+#ifndef __ETS_SYS_H__
+#define __ETS_SYS_H__
+
+#include "c_types.h"
+#include "os_type.h"
+
+#define ETS_GPIO_INTR_ENABLE()
+#define ETS_GPIO_INTR_DISABLE()
+#define ETS_GPIO_INTR_ATTACH(func, arg)
+
+#endif
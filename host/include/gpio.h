@@ -0,0 +1,40 @@
+// gpio.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's gpio.h for compiling the firmware's modules for
+// the host (cf. Makefile). The GPIO-registers are emulated by a variable.
+
+#ifndef __GPIO_H__
+#define __GPIO_H__
+
+#include "c_types.h"
+
+typedef enum {
+  GPIO_PIN_INTR_DISABLE = 0,
+  GPIO_PIN_INTR_POSEDGE = 1,
+  GPIO_PIN_INTR_NEGEDGE = 2,
+  GPIO_PIN_INTR_ANYEDGE = 3,
+  GPIO_PIN_INTR_LOLEVEL = 4,
+  GPIO_PIN_INTR_HILEVEL = 5
+} GPIO_INT_TYPE;
+
+#define GPIO_OUT_ADDRESS 0x00
+#define GPIO_STATUS_W1TC_ADDRESS 0x24
+#define GPIO_ID_PIN(n) (n)
+
+extern uint32 host_gpio_out;
+
+#define GPIO_REG_READ(reg) (((reg) == GPIO_OUT_ADDRESS) ? host_gpio_out : 0)
+#define GPIO_REG_WRITE(reg, val) ((void) (reg), (void) (val))
+
+#define PIN_FUNC_SELECT(pin, func)
+#define PIN_PULLUP_EN(pin)
+
+void gpio_init(void);
+void gpio_output_set(uint32 set_mask, uint32 clear_mask, uint32 enable_mask, uint32 disable_mask);
+void gpio_pin_intr_state_set(uint32 i, GPIO_INT_TYPE intr_state);
+
+#endif
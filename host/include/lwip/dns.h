@@ -0,0 +1,15 @@
+// dns.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's dns.h for compiling the firmware's modules for the
+// host (cf. Makefile).
+
+#ifndef __LWIP_DNS_H__
+#define __LWIP_DNS_H__
+
+#include "lwip/ip_addr.h"
+
+#endif
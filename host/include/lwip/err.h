@@ -0,0 +1,26 @@
+// err.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's err.h for compiling the firmware's modules for the
+// host (cf. Makefile).
+
+#ifndef __LWIP_ERR_H__
+#define __LWIP_ERR_H__
+
+#include "c_types.h"
+
+typedef int8_t err_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_BUF -2
+#define ERR_TIMEOUT -3
+#define ERR_RTE -4
+#define ERR_VAL -6
+#define ERR_ARG -14
+#define ERR_IF -15
+
+#endif
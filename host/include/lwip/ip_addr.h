@@ -0,0 +1,42 @@
+// ip_addr.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's ip_addr.h for compiling the firmware's modules for
+// the host (cf. Makefile).
+
+#ifndef __LWIP_IP_ADDR_H__
+#define __LWIP_IP_ADDR_H__
+
+#include "c_types.h"
+
+struct ip_addr {
+  uint32_t addr;
+};
+
+typedef struct ip_addr ip_addr_t;
+
+#define IP4_ADDR(ipaddr, a, b, c, d) (ipaddr)->addr = ((uint32_t) ((d) & 0xFF) << 24) | ((uint32_t) ((c) & 0xFF) << 16) | ((uint32_t) ((b) & 0xFF) << 8) | (uint32_t) ((a) & 0xFF)
+
+#define ip4_addr1(ipaddr) (((uint8_t *) (ipaddr))[0])
+#define ip4_addr2(ipaddr) (((uint8_t *) (ipaddr))[1])
+#define ip4_addr3(ipaddr) (((uint8_t *) (ipaddr))[2])
+#define ip4_addr4(ipaddr) (((uint8_t *) (ipaddr))[3])
+
+#define ip4_addr1_16(ipaddr) ((uint16_t) ip4_addr1(ipaddr))
+#define ip4_addr2_16(ipaddr) ((uint16_t) ip4_addr2(ipaddr))
+#define ip4_addr3_16(ipaddr) ((uint16_t) ip4_addr3(ipaddr))
+#define ip4_addr4_16(ipaddr) ((uint16_t) ip4_addr4(ipaddr))
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) ip4_addr1_16(ipaddr), ip4_addr2_16(ipaddr), ip4_addr3_16(ipaddr), ip4_addr4_16(ipaddr)
+
+#define ip_addr_netcmp(addr1, addr2, mask) (((addr1)->addr & (mask)->addr) == ((addr2)->addr & (mask)->addr))
+
+#define IPADDR_NONE ((uint32_t) 0xFFFFFFFFUL)
+
+uint32_t ipaddr_addr(const char *cp);
+
+#endif
@@ -0,0 +1,65 @@
+// netif.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's netif.h for compiling the firmware's modules for
+// the host (cf. Makefile).
+
+#ifndef __LWIP_NETIF_H__
+#define __LWIP_NETIF_H__
+
+#include "c_types.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct netif;
+
+typedef err_t (*netif_input_fn)(struct pbuf *p, struct netif *inp);
+typedef err_t (*netif_output_fn)(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr);
+typedef err_t (*netif_linkoutput_fn)(struct netif *netif, struct pbuf *p);
+
+struct netif {
+  struct netif *next;
+  ip_addr_t ip_addr;
+  ip_addr_t netmask;
+  ip_addr_t gw;
+  netif_input_fn input;
+  netif_output_fn output;
+  netif_linkoutput_fn linkoutput;
+  void *state;
+  uint16_t mtu;
+  uint8_t hwaddr_len;
+  uint8_t hwaddr[6];
+  uint8_t flags;
+  char name[2];
+  uint8_t num;
+};
+
+extern struct netif *netif_list;
+
+/*------------ host only -------------*/
+
+// Counters of the emulated stack (cf. host_lwip.c)
+struct host_lwip_stats {
+  uint32_t pbuf_alloc;  // Allocated pbufs
+  uint32_t pbuf_free;   // Released pbufs
+  uint32_t pbuf_copy;   // Packets copied into a new pbuf
+  uint32_t forwarded;   // Packets forwarded between the network interfaces
+  uint32_t local;       // Packets delivered to the router itself
+  uint32_t dropped;     // Packets dropped by the stack
+  uint32_t pbuf_bytes;      // Memory currently held by pbufs
+  uint32_t pbuf_bytes_peak; // Maximum of the memory held by pbufs
+};
+
+extern struct host_lwip_stats host_lwip_stats;
+
+// Called for every frame sent on one of the network interfaces
+extern void (*host_netif_tx_cb)(uint8_t if_index, const uint8_t *frame, uint16_t len);
+
+struct netif *eagle_lwip_getif(uint8_t index);
+err_t host_netif_input(uint8_t if_index, const uint8_t *frame, uint16_t len);
+
+#endif
@@ -0,0 +1,47 @@
+// pbuf.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's pbuf.h for compiling the firmware's modules for
+// the host (cf. Makefile). Only single (unchained) pbufs are supported.
+
+#ifndef __LWIP_PBUF_H__
+#define __LWIP_PBUF_H__
+
+#include "c_types.h"
+#include "lwip/err.h"
+
+#define PBUF_LINK_HLEN 14
+
+typedef enum {
+  PBUF_TRANSPORT,
+  PBUF_IP,
+  PBUF_LINK,
+  PBUF_RAW
+} pbuf_layer;
+
+typedef enum {
+  PBUF_RAM,
+  PBUF_ROM,
+  PBUF_REF,
+  PBUF_POOL
+} pbuf_type;
+
+struct pbuf {
+  struct pbuf *next;
+  void *payload;
+  uint16_t tot_len;
+  uint16_t len;
+  uint8_t type;
+  uint8_t flags;
+  uint16_t ref;
+};
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type);
+uint8_t pbuf_free(struct pbuf *p);
+void pbuf_ref(struct pbuf *p);
+uint8_t pbuf_header(struct pbuf *p, int16_t header_size_increment);
+
+#endif
@@ -0,0 +1,34 @@
+// mem.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's mem.h for compiling the firmware's modules for
+// the host (cf. Makefile). Allocations are counted in host_heap_stats, so
+// that the host-tools can report the memory used by the router's logic.
+
+#ifndef __MEM_H__
+#define __MEM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define os_malloc(s) host_heap_malloc(s)
+#define os_zalloc(s) host_heap_zalloc(s)
+#define os_free(p) host_heap_free(p)
+
+struct host_heap_stats {
+  size_t used;      // Currently allocated bytes
+  size_t peak;      // Maximum of the allocated bytes
+  uint32_t allocs;  // Number of allocations
+};
+
+extern struct host_heap_stats host_heap_stats;
+
+void *host_heap_malloc(size_t size);
+void *host_heap_zalloc(size_t size);
+void host_heap_free(void *ptr);
+void host_heap_reset_peak(void);
+
+#endif
@@ -0,0 +1,41 @@
+// etharp.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of lwip's etharp.h for compiling the firmware's modules for
+// the host (cf. Makefile).
+
+#ifndef __NETIF_ETHARP_H__
+#define __NETIF_ETHARP_H__
+
+#include "c_types.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#define ETHARP_HWADDR_LEN 6
+#define SIZEOF_ETH_HDR 14
+
+#define ETHTYPE_ARP 0x0806
+#define ETHTYPE_IP 0x0800
+
+#define PP_HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) & 0xFF00) >> 8)))
+#define PP_NTOHS(x) PP_HTONS(x)
+
+struct eth_addr {
+  uint8_t addr[ETHARP_HWADDR_LEN];
+} __attribute__((packed));
+
+struct eth_hdr {
+  struct eth_addr dest;
+  struct eth_addr src;
+  uint16_t type;
+} __attribute__((packed));
+
+err_t etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr);
+int8_t etharp_find_addr(struct netif *netif, ip_addr_t *ipaddr, struct eth_addr **eth_ret, ip_addr_t **ip_ret);
+
+#endif
@@ -0,0 +1,36 @@
+// os_type.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's os_type.h for compiling the firmware's modules
+// for the host (cf. Makefile).
+
+#ifndef __OS_TYPE_H__
+#define __OS_TYPE_H__
+
+#include "c_types.h"
+
+typedef uint32_t os_signal_t;
+typedef uint32_t os_param_t;
+
+typedef struct ETSEventTag {
+  os_signal_t sig;
+  os_param_t par;
+} os_event_t;
+
+typedef void (*os_task_t)(os_event_t *e);
+
+typedef void os_timer_func_t(void *timer_arg);
+
+typedef struct _os_timer_t {
+  struct _os_timer_t *timer_next;
+  uint32_t timer_expire;
+  uint32_t timer_period;
+  os_timer_func_t *timer_func;
+  void *timer_arg;
+  bool timer_armed;
+} os_timer_t;
+
+#endif
@@ -0,0 +1,41 @@
+// osapi.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's osapi.h for compiling the firmware's modules
+// for the host (cf. Makefile). The firmware's log-output is suppressed unless
+// host_verbose is set.
+
+#ifndef __OSAPI_H__
+#define __OSAPI_H__
+
+#include <stdio.h>
+#include <string.h>
+#include "c_types.h"
+#include "os_type.h"
+
+extern bool host_verbose;
+
+#define os_printf(...) do { if (host_verbose) printf(__VA_ARGS__); } while (0)
+#define os_sprintf sprintf
+#define os_snprintf snprintf
+#define os_memcpy memcpy
+#define os_memmove memmove
+#define os_memset memset
+#define os_memcmp memcmp
+#define os_strlen strlen
+#define os_strcmp strcmp
+#define os_strncmp strncmp
+#define os_strcpy strcpy
+#define os_strncpy strncpy
+#define os_strstr strstr
+
+void os_timer_setfn(os_timer_t *ptimer, os_timer_func_t *pfunction, void *parg);
+void os_timer_arm(os_timer_t *ptimer, uint32_t msec, bool repeat_flag);
+void os_timer_disarm(os_timer_t *ptimer);
+
+unsigned long os_random(void);
+
+#endif
@@ -0,0 +1,16 @@
+// queue.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's queue.h (BSD singly-linked tail queues) for
+// compiling the firmware's modules for the host (cf. Makefile).
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#define STAILQ_ENTRY(type) struct { struct type *stqe_next; }
+#define STAILQ_NEXT(elm, field) ((elm)->field.stqe_next)
+
+#endif
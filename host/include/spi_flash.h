@@ -0,0 +1,41 @@
+// spi_flash.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's spi_flash.h for compiling the firmware's
+// modules for the host (cf. Makefile). The flash is emulated by an image in
+// memory, that keeps its content as long as the host-tool is running.
+
+#ifndef __SPI_FLASH_H__
+#define __SPI_FLASH_H__
+
+#include "c_types.h"
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+  SPI_FLASH_RESULT_OK,
+  SPI_FLASH_RESULT_ERR,
+  SPI_FLASH_RESULT_TIMEOUT
+} SpiFlashOpResult;
+
+SpiFlashOpResult spi_flash_erase_sector(uint16 sec);
+SpiFlashOpResult spi_flash_write(uint32 des_addr, uint32 *src_addr, uint32 size);
+SpiFlashOpResult spi_flash_read(uint32 src_addr, uint32 *des_addr, uint32 size);
+
+/*------------ host only -------------*/
+
+// Operations on the emulated flash
+struct host_flash_stats {
+  uint32 erases;
+  uint32 writes;
+  uint32 reads;
+};
+
+extern struct host_flash_stats host_flash_stats;
+
+void host_flash_erase(void);
+
+#endif
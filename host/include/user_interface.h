@@ -0,0 +1,228 @@
+// user_interface.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Stub of the SDK's user_interface.h for compiling the firmware's
+// modules for the host (cf. Makefile). The system time is a virtual clock, that
+// is advanced explicitly by the host-tools (cf. host_sdk.c); the WiFi-API keeps
+// its state in memory and events are injected via host_wifi_event.
+
+#ifndef __USER_INTERFACE_H__
+#define __USER_INTERFACE_H__
+
+#include "c_types.h"
+#include "os_type.h"
+#include "queue.h"
+#include "lwip/ip_addr.h"
+
+#define STATION_IF 0x00
+#define SOFTAP_IF 0x01
+
+#define NULL_MODE 0x00
+#define STATION_MODE 0x01
+#define SOFTAP_MODE 0x02
+#define STATIONAP_MODE 0x03
+
+#define USER_TASK_PRIO_0 0
+#define USER_TASK_PRIO_1 1
+#define USER_TASK_PRIO_2 2
+#define USER_TASK_PRIO_MAX 3
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+typedef enum _auth_mode {
+  AUTH_OPEN = 0,
+  AUTH_WEP,
+  AUTH_WPA_PSK,
+  AUTH_WPA2_PSK,
+  AUTH_WPA_WPA2_PSK,
+  AUTH_MAX
+} AUTH_MODE;
+
+enum flash_size_map {
+  FLASH_SIZE_4M_MAP_256_256 = 0,
+  FLASH_SIZE_2M,
+  FLASH_SIZE_8M_MAP_512_512,
+  FLASH_SIZE_16M_MAP_512_512,
+  FLASH_SIZE_32M_MAP_512_512,
+  FLASH_SIZE_16M_MAP_1024_1024,
+  FLASH_SIZE_32M_MAP_1024_1024
+};
+
+struct ip_info {
+  struct ip_addr ip;
+  struct ip_addr netmask;
+  struct ip_addr gw;
+};
+
+struct softap_config {
+  uint8 ssid[32];
+  uint8 password[64];
+  uint8 ssid_len;
+  uint8 channel;
+  AUTH_MODE authmode;
+  uint8 ssid_hidden;
+  uint8 max_connection;
+  uint16 beacon_interval;
+};
+
+enum {
+  STATION_IDLE = 0,
+  STATION_CONNECTING,
+  STATION_WRONG_PASSWORD,
+  STATION_NO_AP_FOUND,
+  STATION_CONNECT_FAIL,
+  STATION_GOT_IP
+};
+
+#define REASON_AUTH_FAIL 202
+#define REASON_NO_AP_FOUND 201
+#define REASON_BEACON_TIMEOUT 200
+
+struct station_config {
+  uint8 ssid[32];
+  uint8 password[64];
+  uint8 bssid_set;
+  uint8 bssid[6];
+};
+
+enum {
+  EVENT_STAMODE_CONNECTED = 0,
+  EVENT_STAMODE_DISCONNECTED,
+  EVENT_STAMODE_AUTHMODE_CHANGE,
+  EVENT_STAMODE_GOT_IP,
+  EVENT_STAMODE_DHCP_TIMEOUT,
+  EVENT_SOFTAPMODE_STACONNECTED,
+  EVENT_SOFTAPMODE_STADISCONNECTED,
+  EVENT_SOFTAPMODE_PROBEREQRECVED,
+  EVENT_MAX
+};
+
+struct station_info {
+  STAILQ_ENTRY(station_info) next;
+  uint8 bssid[6];
+  struct ip_addr ip;
+};
+
+typedef struct {
+  uint8 ssid[32];
+  uint8 ssid_len;
+  uint8 bssid[6];
+  uint8 channel;
+} Event_StaMode_Connected_t;
+
+typedef struct {
+  uint8 ssid[32];
+  uint8 ssid_len;
+  uint8 bssid[6];
+  uint8 reason;
+} Event_StaMode_Disconnected_t;
+
+typedef struct {
+  uint8 old_mode;
+  uint8 new_mode;
+} Event_StaMode_AuthMode_Change_t;
+
+typedef struct {
+  struct ip_addr ip;
+  struct ip_addr mask;
+  struct ip_addr gw;
+} Event_StaMode_Got_IP_t;
+
+typedef struct {
+  uint8 mac[6];
+  uint8 aid;
+} Event_SoftAPMode_StaConnected_t;
+
+typedef struct {
+  uint8 mac[6];
+  uint8 aid;
+} Event_SoftAPMode_StaDisconnected_t;
+
+typedef union {
+  Event_StaMode_Connected_t connected;
+  Event_StaMode_Disconnected_t disconnected;
+  Event_StaMode_AuthMode_Change_t auth_change;
+  Event_StaMode_Got_IP_t got_ip;
+  Event_SoftAPMode_StaConnected_t sta_connected;
+  Event_SoftAPMode_StaDisconnected_t sta_disconnected;
+} Event_Info_u;
+
+typedef struct _esp_event {
+  uint32 event;
+  Event_Info_u event_info;
+} System_Event_t;
+
+typedef void (*wifi_event_handler_cb_t)(System_Event_t *event);
+
+uint32 system_get_time(void);
+uint8 system_get_cpu_freq(void);
+uint32 system_get_free_heap_size(void);
+enum flash_size_map system_get_flash_size_map(void);
+bool system_rtc_mem_read(uint8 src_addr, void *des_addr, uint16 load_size);
+bool system_rtc_mem_write(uint8 des_addr, const void *src_addr, uint16 save_size);
+bool system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen);
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par);
+
+uint8 wifi_get_opmode(void);
+bool wifi_set_opmode(uint8 opmode);
+bool wifi_get_ip_info(uint8 if_index, struct ip_info *info);
+bool wifi_set_ip_info(uint8 if_index, struct ip_info *info);
+bool wifi_get_macaddr(uint8 if_index, uint8 *macaddr);
+bool wifi_set_broadcast_if(uint8 interface);
+void wifi_set_event_handler_cb(wifi_event_handler_cb_t cb);
+
+bool wifi_station_connect(void);
+bool wifi_station_disconnect(void);
+bool wifi_station_set_config(struct station_config *config);
+bool wifi_station_set_config_current(struct station_config *config);
+bool wifi_station_get_config(struct station_config *config);
+bool wifi_station_get_config_default(struct station_config *config);
+bool wifi_station_set_hostname(char *name);
+char *wifi_station_get_hostname(void);
+uint8 wifi_station_get_connect_status(void);
+uint8 wifi_get_channel(void);
+bool wifi_set_channel(uint8 channel);
+
+bool wifi_softap_set_config(struct softap_config *config);
+bool wifi_softap_get_config(struct softap_config *config);
+bool wifi_softap_dhcps_stop(void);
+struct station_info *wifi_softap_get_station_info(void);
+void wifi_softap_free_station_info(void);
+
+/*------------ host only -------------*/
+
+// Host access-point, that the station connects to with wifi_station_connect
+// (cf. host_sdk.c); the station gets its address join_ms after the call, if it
+// knows the BSSID and channel, resp. scan_ms + join_ms otherwise
+struct host_wifi_ap {
+  bool up;
+  uint8 ssid[32];
+  uint8 password[64];
+  uint8 bssid[6];
+  uint8 channel;
+  uint32 ip, netmask, gw;   // Address assigned to the station
+  uint32 scan_ms;
+  uint32 join_ms;
+};
+
+extern struct host_wifi_ap host_wifi_ap;
+
+void host_time_set(uint32 time_us);
+void host_time_advance(uint32 delta_us);
+uint64_t host_clock_ns(void);
+uint32 host_ccount(void);
+uint16 host_timers_armed(void);
+void host_os_run(void);
+
+void host_wifi_event(System_Event_t *evt);
+void host_wifi_got_ip(uint32 ip, uint32 netmask, uint32 gw);
+void host_wifi_disconnected(uint8 reason);
+bool host_wifi_sta_connected(const uint8 *mac);
+void host_wifi_sta_disconnected(const uint8 *mac);
+void host_wifi_power_loss(bool keep_config);
+
+#endif
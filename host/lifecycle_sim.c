@@ -0,0 +1,430 @@
+// lifecycle_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side event injector for the lifecycle state machine of the
+// router (cf. lifecycle.c) without the fast boot (cf. fastboot_sim). The hooks
+// emulate the actions of user_main.c (the router is initialized on the
+// actuation of the pushbutton, the services are started once it's online and
+// the device's initial state is restored on the return to IDLE, without any
+// socket or timer of the router's services left behind); ESP-TOUCH and
+// the host access-point are replaced by the events of a script. Once the soft
+// access-point is up, an emulated client associates, gets its address from the
+// DHCP-server and sends a datagram to the external network every millisecond.
+//
+// A script consists of lines '<ms> <event>' with the events
+//
+//  button            - actuation of the pushbutton
+//  got_ip            - the station network interface got its address
+//  disconnected      - the station network interface lost the connection
+//  esptouch_success  - ESP-TOUCH reported the established connection
+//  esptouch_fail     - ESP-TOUCH gave up
+//  hitless <0|1>     - disable resp. enable the hitless reconnect (cf.
+//                      router_set_hitless_reconnect)
+//  expect <state>    - check the state (idle, provisioning, connecting, online
+//                      or reconnecting)
+//
+// The time is relative to the previous line. Without a script-file (-s), a
+// built-in script runs through the provisioning, a failed ESP-TOUCH, a
+// reconnect, a timeout of the reconnect and a timeout of the reconnect with
+// the hitless reconnect disabled at runtime. Then -n provisionings with random
+// times (ESP-TOUCH receives the credentials after 1-5 s, its success is
+// reported 20-500 ms after the station got its address) are injected and the
+// time from the actuation of the pushbutton to the first forwarded datagram of
+// the client resp. to the start of the services is reported. For comparison,
+// the time to the start of the services is also given for the former check of
+// ESP-TOUCH every 500 ms, which was armed on the actuation of the pushbutton.
+//
+// Usage: lifecycle_sim [-v] [-n provisionings] [-s script]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "device_info.h"
+#include "lifecycle.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_POLL_MS 500   // Interval of the former check of ESP-TOUCH
+#define SIM_LINE_MAX 128
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static uint32_t sim_now_ms = 0;
+static uint32_t failures = 0;
+static uint32_t sim_rnd_state = 0x2545F491;
+
+static const uint8_t sim_client_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static uint32_t sim_client_ip = 0;      // Address of the client (0 = not associated)
+static uint32_t sim_forwarded_ms = 0;   // Time of the first forwarded datagram (0 = none)
+static uint32_t sim_online_ms = 0;      // Time of the start of the services (0 = not started)
+static uint16_t sim_enables = 0, sim_disables = 0;
+
+static const char sim_builtin_script[] =
+  "0 expect idle\n"
+  "0 got_ip\n"                    // Ignored while idle
+  "0 expect idle\n"
+  "0 button\n"
+  "0 expect provisioning\n"
+  "2400 got_ip\n"
+  "0 expect provisioning\n"
+  "150 esptouch_success\n"
+  "0 expect online\n"
+  "5000 disconnected\n"
+  "0 expect reconnecting\n"
+  "3000 got_ip\n"
+  "0 expect online\n"
+  "1000 disconnected\n"
+  "600001 expect idle\n"          // ROUTER_RECONNECT_TIMEOUT
+  "0 button\n"
+  "0 expect provisioning\n"
+  "30000 esptouch_fail\n"
+  "0 expect idle\n"
+  "0 button\n"
+  "1000 esptouch_success\n"       // The station hasn't got its address yet
+  "0 expect connecting\n"
+  "200 got_ip\n"
+  "0 expect online\n"
+  "0 hitless 0\n"
+  "0 disconnected\n"
+  "300001 expect idle\n"          // ROUTER_CONN_TIMEOUT
+  "0 hitless 1\n";
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t sim_rnd(void) {
+  sim_rnd_state ^= sim_rnd_state << 13;
+  sim_rnd_state ^= sim_rnd_state >> 17;
+  sim_rnd_state ^= sim_rnd_state << 5;
+  return sim_rnd_state;
+}
+
+static int sim_cmp(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+  return (x > y) - (x < y);
+}
+
+// The first datagram of the client, that leaves the station network interface,
+// marks the start of the forwarding
+static void sim_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  if (if_index == STATION_IF && !sim_forwarded_ms) {
+    sim_forwarded_ms = sim_now_ms;
+  }
+}
+
+// Let the client associate as soon as the soft access-point is up and send a
+// datagram
+static void sim_client_step(void) {
+  struct host_dhcp_reply reply;
+  uint8_t frame[128], softap_mac[6];
+  uint16_t len;
+
+  if (!(wifi_get_opmode() & SOFTAP_MODE)) {
+    sim_client_ip = 0;
+    return;
+  }
+  if (!sim_client_ip) {
+    if (!host_wifi_sta_connected(sim_client_mac)) {
+      return;
+    }
+    if (host_dhcp_exchange(HOST_DHCP_DISCOVER, sim_client_mac, 0, 0, 0, &reply) && reply.type == HOST_DHCP_OFFER && host_dhcp_exchange(HOST_DHCP_REQUEST, sim_client_mac, 0, reply.yiaddr, reply.server, &reply) && reply.type == HOST_DHCP_ACK) {
+      sim_client_ip = reply.yiaddr;
+    }
+    else {
+      host_wifi_sta_disconnected(sim_client_mac);
+      return;
+    }
+  }
+  wifi_get_macaddr(SOFTAP_IF, softap_mac);
+  len = host_packet_build(frame, softap_mac, NAPT_PROTO_UDP, sim_client_ip, 5683, IPADDR(198, 51, 100, 1), 5683, 0, 32);
+  host_netif_input(SOFTAP_IF, frame, len);
+}
+
+// Advance the time millisecond by millisecond, so that the timers and the
+// client run in between (once a datagram has been forwarded, the client is
+// idle and the time advances at once)
+static void sim_time_advance(uint32_t ms) {
+  if (sim_forwarded_ms) {
+    host_time_advance(ms * 1000);
+    sim_now_ms += ms;
+    return;
+  }
+  while (ms--) {
+    host_time_advance(1000);
+    sim_now_ms++;
+    sim_client_step();
+  }
+}
+
+/*------------------------------------*/
+
+// Hooks of the state machine (cf. user_main.c):
+
+static bool sim_enable(void) {
+  sim_enables++;
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  return true;
+}
+
+// ESP-TOUCH is emulated by the events of the script
+static bool sim_esptouch(void) {
+  return true;
+}
+
+static void sim_online(void) {
+  sim_online_ms = sim_now_ms;
+  device_info_init();
+  vital_sign_bcast_start();
+}
+
+static void sim_disable(void) {
+  sim_disables++;
+  device_info_disable();
+  router_disable();
+  host_wifi_sta_disconnected(sim_client_mac);
+  wifi_set_opmode(NULL_MODE);
+  wifi_set_event_handler_cb(NULL);
+
+  // No socket or timer of the router's services survives
+  CHECK(host_espconn_count() == 0 && host_timers_armed() == 0);
+}
+
+static const struct lifecycle_hooks sim_hooks = {sim_enable, NULL, sim_esptouch, sim_online, sim_disable};
+
+/*------------------------------------*/
+
+// Script:
+
+// Inject a single event; returns false on an unknown event
+static bool sim_inject(const char *event, const char *arg) {
+  enum lifecycle_state state = lifecycle_state_get();
+
+  if (!strcmp(event, "button")) {
+    lifecycle_event(LIFECYCLE_EVENT_BUTTON);
+  }
+  else if (!strcmp(event, "got_ip")) {
+    host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  }
+  else if (!strcmp(event, "disconnected")) {
+    host_wifi_disconnected(REASON_BEACON_TIMEOUT);
+  }
+  else if (!strcmp(event, "esptouch_success")) {
+    lifecycle_event(LIFECYCLE_EVENT_ESPTOUCH_SUCCESS);
+  }
+  else if (!strcmp(event, "esptouch_fail")) {
+    lifecycle_event(LIFECYCLE_EVENT_ESPTOUCH_FAIL);
+  }
+  else if (!strcmp(event, "hitless") && arg) {
+    router_set_hitless_reconnect(atoi(arg) != 0);
+  }
+  else if (!strcmp(event, "expect") && arg) {
+    if (strcmp(lifecycle_state_name(state), arg)) {
+      printf("FAIL at %u ms: expected %s, state is %s\n", sim_now_ms, arg, lifecycle_state_name(state));
+      failures++;
+    }
+    return true;
+  }
+  else {
+    return false;
+  }
+  if (host_verbose) {
+    printf("%8u ms %-16s %s -> %s\n", sim_now_ms, event, lifecycle_state_name(state), lifecycle_state_name(lifecycle_state_get()));
+  }
+  return true;
+}
+
+// Run a script line by line; returns false on a syntax error
+static bool sim_run_script(const char *script) {
+  char line[SIM_LINE_MAX], event[32], arg[32];
+  const char *next;
+  unsigned int delay;
+  int fields;
+  size_t len;
+
+  for (; *script; script = next) {
+    next = strchr(script, '\n');
+    next = (next) ? next + 1 : script + strlen(script);
+    len = (size_t) (next - script) < SIM_LINE_MAX ? (size_t) (next - script) : SIM_LINE_MAX - 1;
+    memcpy(line, script, len);
+    line[len] = '\0';
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\0') {
+      continue;
+    }
+    fields = sscanf(line, "%u %31s %31s", &delay, event, arg);
+    if (fields < 2) {
+      fprintf(stderr, "lifecycle_sim: Invalid line: %s", line);
+      return false;
+    }
+    sim_time_advance(delay);
+    if (!sim_inject(event, (fields == 3) ? arg : NULL)) {
+      fprintf(stderr, "lifecycle_sim: Unknown event: %s", line);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Read a script-file; returns NULL on an error
+static char *sim_read_script(const char *path) {
+  FILE *file = fopen(path, "r");
+  char *script;
+  long size;
+
+  if (!file) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  script = calloc(1, size + 1);
+  if (script && fread(script, 1, size, file) != (size_t) size) {
+    free(script);
+    script = NULL;
+  }
+  fclose(file);
+  return script;
+}
+
+/*------------------------------------*/
+
+// Provisionings:
+
+// Inject a provisioning with random times and return the time from the
+// actuation of the pushbutton to the first forwarded datagram, to the start of
+// the services and to the start of the services with the former check every
+// SIM_POLL_MS
+static void sim_provision(uint32_t *forward_ms, uint32_t *online_ms, uint32_t *polled_ms) {
+  uint32_t button_ms, credentials_ms = 1000 + sim_rnd() % 4000, report_ms = 20 + sim_rnd() % 480;
+
+  sim_forwarded_ms = 0;
+  sim_online_ms = 0;
+  button_ms = sim_now_ms;
+  sim_inject("button", NULL);
+  sim_time_advance(credentials_ms);
+  sim_inject("got_ip", NULL);
+  sim_time_advance(report_ms);
+  sim_inject("esptouch_success", NULL);
+  sim_time_advance(SIM_POLL_MS);
+  CHECK(lifecycle_state_get() == LIFECYCLE_ONLINE);
+  CHECK(sim_forwarded_ms && sim_online_ms);
+
+  *forward_ms = sim_forwarded_ms - button_ms;
+  *online_ms = sim_online_ms - button_ms;
+  *polled_ms = (credentials_ms + report_ms + SIM_POLL_MS - 1) / SIM_POLL_MS * SIM_POLL_MS;
+
+  // Back to idle for the next provisioning
+  sim_inject("disconnected", NULL);
+  sim_time_advance((ROUTER_HITLESS_RECONNECT) ? ROUTER_RECONNECT_TIMEOUT : ROUTER_CONN_TIMEOUT);
+  CHECK(lifecycle_state_get() == LIFECYCLE_IDLE);
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: lifecycle_sim [-v] [-n provisionings] [-s script]\n");
+}
+
+int main(int argc, char **argv) {
+  const char *script_path = NULL;
+  char *script;
+  uint32_t count = 100, idx, *forward, *online, *polled;
+  uint64_t sum_forward = 0, sum_online = 0, sum_polled = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vn:s:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': count = strtoul(optarg, NULL, 0); break;
+      case 's': script_path = optarg; break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!count) {
+    sim_usage();
+    return 1;
+  }
+  host_netif_tx_cb = sim_tx_cb;
+  lifecycle_init(&sim_hooks);
+
+  // Scripted events
+  if (script_path) {
+    script = sim_read_script(script_path);
+    if (!script) {
+      fprintf(stderr, "lifecycle_sim: Failed to read %s!\n", script_path);
+      return 1;
+    }
+    if (!sim_run_script(script)) {
+      free(script);
+      return 1;
+    }
+    free(script);
+  }
+  else {
+    if (!sim_run_script(sim_builtin_script)) {
+      return 1;
+    }
+    CHECK(sim_enables == 3 && sim_disables == 3);
+  }
+  printf("lifecycle_sim: %u enables, %u disables, final state %s\n", sim_enables, sim_disables, lifecycle_state_name(lifecycle_state_get()));
+
+  // Random provisionings
+  if (lifecycle_state_get() != LIFECYCLE_IDLE) {
+    sim_inject("disconnected", NULL);
+    sim_time_advance((router_get_hitless_reconnect()) ? ROUTER_RECONNECT_TIMEOUT : ROUTER_CONN_TIMEOUT);
+  }
+  forward = calloc(count, sizeof(uint32_t));
+  online = calloc(count, sizeof(uint32_t));
+  polled = calloc(count, sizeof(uint32_t));
+  for (idx = 0; idx < count; idx++) {
+    sim_provision(&forward[idx], &online[idx], &polled[idx]);
+    sum_forward += forward[idx];
+    sum_online += online[idx];
+    sum_polled += polled[idx];
+    // The services start right when ESP-TOUCH reports its success
+    CHECK(online[idx] <= polled[idx] && forward[idx] <= online[idx]);
+  }
+  qsort(forward, count, sizeof(uint32_t), sim_cmp);
+  qsort(online, count, sizeof(uint32_t), sim_cmp);
+  qsort(polled, count, sizeof(uint32_t), sim_cmp);
+
+  printf("%-16s %10s %10s %10s\n", "button_to", "mean_ms", "p50_ms", "p99_ms");
+  printf("%-16s %10.1f %10u %10u\n", "forwarding", (double) sum_forward / count, forward[count / 2], forward[(uint64_t) count * 99 / 100]);
+  printf("%-16s %10.1f %10u %10u\n", "online", (double) sum_online / count, online[count / 2], online[(uint64_t) count * 99 / 100]);
+  printf("%-16s %10.1f %10u %10u\n", "online_polled", (double) sum_polled / count, polled[count / 2], polled[(uint64_t) count * 99 / 100]);
+  CHECK(sum_online < sum_polled);
+
+  free(forward);
+  free(online);
+  free(polled);
+  if (failures) {
+    printf("lifecycle_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
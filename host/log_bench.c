@@ -0,0 +1,217 @@
+// log_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Benchmark of the latency of the router's callbacks with and
+// without logging (cf. log.c). The router is brought up like on the device and
+// the following callbacks are invoked -n times each:
+//
+//  - sta: a client associates with the soft access-point and disassociates
+//  - request: a NAPT_STATS-request on DEVICE_COM_PORT (its messages are on
+//    the debug level and compiled away with the default LOG_LEVEL)
+//  - reconnect: the station is disconnected and gets its address again
+//
+// with the messages written to no sink, to the ring buffer, to the UART and to
+// both. The host doesn't block on the UART; its time is emulated from the
+// characters printed per callback: at 115200 baud, each character beyond the
+// FIFO of 128 bytes (assumed to be empty at the start of the callback) blocks
+// for 86.8 us. Finally, the ring buffer is requested via DEVICE_COM_PORT and
+// checked, as well as the truncation of an overlong message.
+//
+// Usage: log_bench [-v] [-n calls]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "espconn.h"
+#include "user_interface.h"
+#include "router.h"
+#include "device_info.h"
+#include "uplink_sched.h"
+#define LOG_MODULE LOG_MODULE_LOG
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define BENCH_STATION_ADDR "10.0.0.42"
+#define BENCH_STATION_NETMASK "255.255.255.0"
+#define BENCH_STATION_GW "10.0.0.1"
+
+#define BENCH_UART_FIFO 128
+#define BENCH_UART_CHAR_NS 86806  // 10 bits at 115200 baud
+#define BENCH_REPLY_MAX 1500
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+struct bench_callback {
+  const char *name;
+  void (*invoke)(void);
+};
+
+// Declaration and initialization of variables:
+
+static void bench_sta(void);
+static void bench_request(void);
+static void bench_reconnect(void);
+
+static const struct bench_callback bench_callbacks[] = {
+  {"sta", bench_sta},
+  {"request", bench_request},
+  {"reconnect", bench_reconnect},
+};
+
+static const uint8_t bench_sinks[] = {0, LOG_SINK_RING, LOG_SINK_UART, LOG_SINK_UART | LOG_SINK_RING};
+
+static uint32_t failures = 0;
+static uint32_t bench_calls = 1000;
+
+static char bench_reply[BENCH_REPLY_MAX + 1];
+static uint16_t bench_reply_len = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static void bench_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  if (espconn->proto.udp->local_port == DEVICE_COM_PORT && len <= BENCH_REPLY_MAX) {
+    os_memcpy(bench_reply, data, len);
+    bench_reply[len] = '\0';
+    bench_reply_len = len;
+  }
+}
+
+static void bench_sta(void) {
+  uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+  host_wifi_sta_connected(mac);
+  host_wifi_sta_disconnected(mac);
+}
+
+static void bench_request(void) {
+  static const uint8_t remote_ip[4] = {192, 168, 4, 2};
+  char request[] = NAPT_STATS_REQUEST_STRING;
+
+  host_espconn_recv(DEVICE_COM_PORT, remote_ip, 50000, request, sizeof(request) - 1);
+}
+
+static void bench_reconnect(void) {
+  host_wifi_disconnected(REASON_BEACON_TIMEOUT);
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+}
+
+// Invoke the callback bench_calls times with the given sinks; returns the
+// mean latency (in us) including the emulated blocking on the UART and stores
+// the characters printed per call
+static double bench_run(const struct bench_callback *callback, uint8_t sinks, double *chars) {
+  const struct log_stats *stats = log_stats_get();
+  uint32_t call, before, printed, uart_chars = 0;
+  uint64_t start, ns = 0;
+
+  log_set_sinks(sinks);
+  for (call = 0; call < bench_calls; call++) {
+    before = stats->uart_bytes;
+    start = host_clock_ns();
+    callback->invoke();
+    ns += host_clock_ns() - start;
+    printed = stats->uart_bytes - before;
+    uart_chars += printed;
+    if (printed > BENCH_UART_FIFO) {
+      ns += (uint64_t) (printed - BENCH_UART_FIFO) * BENCH_UART_CHAR_NS;
+    }
+    host_time_advance(1000);
+  }
+  log_set_sinks(LOG_SINK_UART | LOG_SINK_RING);
+  *chars = (double) uart_chars / bench_calls;
+  return (double) ns / bench_calls / 1000;
+}
+
+/*------------------------------------*/
+
+static void bench_usage(void) {
+  fprintf(stderr, "Usage: log_bench [-v] [-n calls]\n");
+}
+
+int main(int argc, char **argv) {
+  static const uint8_t remote_ip[4] = {192, 168, 4, 2};
+  char request[] = LOG_REQUEST_STRING;
+  char long_msg[2 * LOG_LINE_MAX];
+  double us[sizeof(bench_sinks)], chars, uart_chars = 0;
+  uint32_t idx, sink;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vn:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': bench_calls = strtoul(optarg, NULL, 0); break;
+      default: bench_usage(); return 1;
+    }
+  }
+  if (!bench_calls) {
+    bench_usage();
+    return 1;
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "log_bench: Failed to bring up the router!\n");
+    return 1;
+  }
+  device_info_init();
+  host_espconn_sent_cb = bench_sent_cb;
+
+  printf("level %u, modules 0x%04X\n", LOG_LEVEL, LOG_MODULES);
+  printf("%-10s %7s %10s %10s %10s %10s\n", "callback", "chars", "none_us", "ring_us", "uart_us", "both_us");
+  for (idx = 0; idx < sizeof(bench_callbacks) / sizeof(bench_callbacks[0]); idx++) {
+    for (sink = 0; sink < sizeof(bench_sinks); sink++) {
+      us[sink] = bench_run(&bench_callbacks[idx], bench_sinks[sink], &chars);
+      if (bench_sinks[sink] & LOG_SINK_UART) {
+        uart_chars = chars;
+      }
+    }
+    printf("%-10s %7.1f %10.2f %10.2f %10.2f %10.2f\n", bench_callbacks[idx].name, uart_chars, us[0], us[1], us[2], us[3]);
+
+    // Without the UART, the logging mustn't block
+    CHECK(us[1] < us[2] || uart_chars <= BENCH_UART_FIFO);
+  }
+  CHECK(is_connected());
+
+  // The ring buffer holds the newest complete messages
+  bench_reply_len = 0;
+  host_espconn_recv(DEVICE_COM_PORT, remote_ip, 50000, request, sizeof(request) - 1);
+  printf("ring: %u bytes\n", bench_reply_len);
+#if LOG_RING && LOG_LEVEL >= LOG_LEVEL_INFO
+  CHECK(bench_reply_len > 0 && bench_reply[bench_reply_len - 1] == '\n');
+  CHECK(bench_reply_len > 0 && bench_reply[0] >= '0' && bench_reply[0] <= '9');
+  CHECK(strstr(bench_reply, " I wifi_handle_event_cb: ") != NULL);
+#endif
+
+  // An overlong message is truncated to LOG_LINE_MAX (and still ends with a
+  // newline)
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+  memset(long_msg, 'X', sizeof(long_msg) - 1);
+  long_msg[sizeof(long_msg) - 1] = '\0';
+  log_set_sinks(LOG_SINK_RING);
+  LOG_ERROR("%s\n", long_msg);
+  CHECK(strlen(log_line) == LOG_LINE_MAX - 1 && log_line[LOG_LINE_MAX - 2] == '\n');
+#endif
+
+  host_espconn_sent_cb = NULL;
+  device_info_disable();
+  if (failures) {
+    printf("log_bench: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
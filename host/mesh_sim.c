@@ -0,0 +1,836 @@
+// mesh_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-16
+//
+// Description: Simulation of chains of 2 to 5 routers (cf. mesh.c). Every
+// router runs in a process of its own (the emulated SDK keeps its state in
+// globals), which is connected to the routers above and below it by sockets
+// carrying the frames of the WiFi-links and the datagrams on MESH_PORT. The
+// topmost router (root) is connected to the host access-point 10.0.0.1, the
+// router k below it has the network 192.168.(15+k).0/24; its station gets its
+// address from the DHCP-server of the router above it (the routers are
+// brought up one after the other, from the top).
+//
+// Every chain is run in two modes: with nat, every router translates the
+// packets of the network below it (mesh 0); with routed, all routers are
+// mesh-nodes, which advertise their networks upstream and forward the packets
+// without translation once the routes have been installed; the root's
+// advertisements aren't acknowledged by the host access-point, so it keeps
+// translating. After the routes have converged (the root has to hold the
+// aggregated routes), a client of the lowest router sends -n UDP-datagrams of
+// -s bytes over 2 flows to a peer behind the host access-point, which answers
+// each of them. The answers have to arrive at the client with the original
+// addresses and ports and valid checksums. The lowest router has to ignore the
+// advertisements of the client, which isn't a mesh-node: without a MAC, with
+// a MAC under another key and with a valid MAC (as if the key had leaked). In
+// routed mode, a client of the root sends a datagram to the client of the
+// lowest router, which has to arrive without translation.
+//
+// SHA-256 and the HMAC of the advertisements are checked against the test-
+// vectors first.
+//
+// Both modes of a chain run side by side and their packets alternate, so that
+// the variations of the host's speed affect them alike. Every router measures
+// the real time spent on each frame it forwards; the mean time per hop and
+// direction, the sum over the path, the mean time per hop of the routers below
+// the root (node_ns; they translate resp. only route the packets, whereas the
+// root translates them in both modes), the translations per packet and the
+// throughput of the chain (the packets are pipelined over the routers, so it's
+// limited by the slowest hop upstream) are reported.
+//
+// Usage: mesh_sim [-v] [-n packets] [-s size]
+
+#include <getopt.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "uplink_sched.h"
+#include "config.h"
+#include "mesh.h"
+#include "user_config.h"
+#include "host_packet.h"
+#include "host_dhcp.h"
+#include "hmac_sha256.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+#define SIM_PEER_ADDR "93.184.216.34"
+#define SIM_PEER_PORT 5000
+#define SIM_CLIENT_HOST 10    // Host-part of the client's address
+#define SIM_CLIENT_PORT 40000
+
+#define SIM_NODES_MIN 2
+#define SIM_NODES_MAX 5
+#define SIM_FLOWS 2           // Flows of the client
+#define SIM_WARMUP 64         // Unmeasured packets opening the flows
+#define SIM_ROUNDS_MAX 12     // Advertisement intervals to converge
+#define SIM_TIMEOUT_MS 2000
+#define SIM_FRAME_MAX 1600
+#define SIM_OUTBOX 16
+#define SIM_MESH_KEY "mesh_sim shared key"
+#define SIM_MAC_LEN 16        // Transmitted bytes of the HMAC (cf. mesh.c)
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Message on the sockets between the routers
+enum sim_msg_type {
+  SIM_MSG_FRAME = 0,  // Frame on the WiFi-link
+  SIM_MSG_UDP,        // Datagram on MESH_PORT (from src)
+  SIM_MSG_CLIENT,     // Frame of a client of router arg (passed down the chain
+                      // to it)
+  SIM_MSG_READY,      // The routers above are up (passed down the chain)
+  SIM_MSG_DHCP,       // Address of the station (arg) requested from the router
+                      // above by the MAC-address and the hostname (data)
+  SIM_MSG_TICK,       // Advance the time by arg us (passed down the chain)
+  SIM_MSG_STATS,      // Append the statistics (passed down the chain)
+  SIM_MSG_QUIT        // Terminate (passed down the chain)
+};
+
+struct sim_msg {
+  uint8_t type;
+  uint8_t measure;    // Measure the processing time of the frame
+  uint16_t len;
+  uint32_t src;
+  uint32_t arg;
+  uint8_t data[SIM_FRAME_MAX];
+};
+
+// Message waiting to be sent after the processing of the current one
+struct sim_outbox {
+  int fd;
+  struct sim_msg msg;
+};
+
+// Statistics of a router
+struct sim_node_stats {
+  uint64_t ns[2];           // Processing time per direction (cf. NAPT_DIR_*)
+  uint32_t packets[2];
+  uint32_t translated;      // Packets translated by the NAPT-engine
+  uint32_t routed;          // Packets forwarded without translation
+  uint32_t lateral;         // Packets sent to downstream networks from the
+                            // soft access-point's side
+  uint8_t routing;          // Cf. mesh_is_routing
+  uint8_t routes;
+  uint32_t adverts_ignored;
+  uint32_t network[MESH_ROUTES_MAX];
+  uint32_t netmask[MESH_ROUTES_MAX];
+};
+
+// Results of a chain
+struct sim_result {
+  struct sim_node_stats nodes[SIM_NODES_MAX];
+  uint32_t packets;
+};
+
+// Chain of routers (cf. sim_chain_start)
+struct sim_chain {
+  uint8_t nodes;
+  bool routed;
+  bool ok;
+  int server_fd;    // Link of the root to the host access-point
+  int client_fd;    // Link of the lowest router to the client
+  pid_t pids[SIM_NODES_MAX];
+  struct sim_result result;
+};
+
+// Declaration and initialization of variables:
+
+static const char *sim_modes[] = {"nat", "routed"};
+static const uint8_t sim_routes_expected[SIM_NODES_MAX + 1] = {0, 0, 1, 1, 2, 1};
+
+static uint32_t failures = 0;
+static uint32_t sim_packets = 20000;
+static uint16_t sim_size = 1400;
+
+// State of a router process
+static int sim_up_fd = -1, sim_down_fd = -1;
+static struct sim_outbox sim_outbox[SIM_OUTBOX];
+static uint8_t sim_outbox_count = 0;
+static bool sim_measure = false;
+static netif_input_fn sim_hook[2];  // Input-hook of the router (cf. napt_netif.c)
+static uint64_t sim_rx_ns = 0;      // Time, the hook has been entered
+static uint64_t sim_tx_ns = 0;      // Time of the first sent frame
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t sim_ntohl(uint32_t ip) {
+  const uint8_t *bytes = (const uint8_t *) &ip;
+
+  return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Address of the given host in the network of router k
+static uint32_t sim_addr(uint8_t k, uint8_t host) {
+  char addr[16];
+
+  if (!k) {
+    snprintf(addr, sizeof(addr), "192.168.13.%u", host);
+  }
+  else {
+    snprintf(addr, sizeof(addr), "192.168.%u.%u", 15 + k, host);
+  }
+  return ipaddr_addr(addr);
+}
+
+static void sim_send(int fd, const struct sim_msg *msg) {
+  if (write(fd, msg, offsetof(struct sim_msg, data) + msg->len) < 0) {
+    perror("mesh_sim: write");
+  }
+}
+
+// Receive the next message within SIM_TIMEOUT_MS; returns false on a timeout
+// resp. the termination of the other side
+static bool sim_recv(int fd, struct sim_msg *msg) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+
+  return poll(&pfd, 1, SIM_TIMEOUT_MS) == 1 && (pfd.revents & POLLIN) && read(fd, msg, sizeof(struct sim_msg)) >= (ssize_t) offsetof(struct sim_msg, data);
+}
+
+// Queue a message of the router process; it's sent after the processing of
+// the current message, so that the measured time doesn't include the sockets
+static void sim_post(int fd, uint8_t type, uint32_t src, const uint8_t *data, uint16_t len) {
+  struct sim_outbox *out;
+
+  if (sim_outbox_count == SIM_OUTBOX || len > SIM_FRAME_MAX) {
+    return;
+  }
+  out = &sim_outbox[sim_outbox_count++];
+  out->fd = fd;
+  out->msg.type = type;
+  out->msg.measure = sim_measure;
+  out->msg.len = len;
+  out->msg.src = src;
+  out->msg.arg = 0;
+  memcpy(out->msg.data, data, len);
+}
+
+static void sim_flush(void) {
+  uint8_t idx;
+
+  for (idx = 0; idx < sim_outbox_count; idx++) {
+    sim_send(sim_outbox[idx].fd, &sim_outbox[idx].msg);
+  }
+  sim_outbox_count = 0;
+}
+
+// Input-function of the network interfaces, that starts the measurement
+// before the router's hook (after the emulated driver has copied the frame)
+static err_t sim_input(struct pbuf *p, struct netif *inp) {
+  sim_rx_ns = host_clock_ns();
+  return sim_hook[inp->num](p, inp);
+}
+
+// Frames of the station network interface go up, the others down the chain;
+// the time of the first frame ends the measurement of the received one
+static void sim_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  if (!sim_tx_ns) {
+    sim_tx_ns = host_clock_ns();
+  }
+  sim_post((if_index == STATION_IF) ? sim_up_fd : sim_down_fd, SIM_MSG_FRAME, 0, frame, len);
+}
+
+// Datagrams on MESH_PORT to the gateway of the station go up, the others down
+// the chain
+static void sim_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  struct ip_info station_info, softap_info;
+  uint32_t remote;
+
+  if (espconn->type != ESPCONN_UDP || espconn->proto.udp->local_port != MESH_PORT) {
+    return;
+  }
+  wifi_get_ip_info(STATION_IF, &station_info);
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  memcpy(&remote, espconn->proto.udp->remote_ip, 4);
+  if (remote == station_info.gw.addr) {
+    sim_post(sim_up_fd, SIM_MSG_UDP, station_info.ip.addr, data, len);
+  }
+  else {
+    sim_post(sim_down_fd, SIM_MSG_UDP, softap_info.ip.addr, data, len);
+  }
+}
+
+// Collect the statistics of the router process
+static void sim_node_stats(struct sim_node_stats *stats) {
+  const struct napt_stats *napt_stats = napt_stats_get();
+  const struct mesh_stats *mesh_stats = mesh_stats_get();
+  const struct mesh_route *route;
+  uint8_t idx;
+
+  stats->translated = napt_stats->packets[NAPT_DIR_OUT] + napt_stats->packets[NAPT_DIR_IN];
+  stats->routed = mesh_stats->routed[NAPT_DIR_OUT] + mesh_stats->routed[NAPT_DIR_IN];
+  stats->lateral = mesh_stats->lateral;
+  stats->routing = mesh_is_routing();
+  stats->adverts_ignored = mesh_stats->adverts_ignored;
+  stats->routes = 0;
+  for (idx = 0; idx < MESH_ROUTES_MAX; idx++) {
+    route = mesh_route_get(idx);
+    if (route->nexthop) {
+      stats->network[stats->routes] = route->network;
+      stats->netmask[stats->routes++] = route->netmask;
+    }
+  }
+}
+
+// Request the station's address from the DHCP-server of the router above;
+// returns 0 on failure
+static uint32_t sim_dhcp_request(void) {
+  struct sim_msg msg;
+  char *hostname = wifi_station_get_hostname();
+
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = SIM_MSG_DHCP;
+  wifi_get_macaddr(STATION_IF, msg.data);
+  msg.len = 6 + strlen(hostname) + 1;
+  memcpy(msg.data + 6, hostname, msg.len - 6);
+  sim_send(sim_up_fd, &msg);
+  return (sim_recv(sim_up_fd, &msg) && msg.type == SIM_MSG_DHCP) ? msg.arg : 0;
+}
+
+// Associate the station of the router below and lease it an address
+static void sim_dhcp_serve(struct sim_msg *msg) {
+  struct host_dhcp_reply offer, ack;
+
+  msg->arg = 0;
+  host_dhcp_hostname = (const char *) msg->data + 6;
+  if (host_wifi_sta_connected(msg->data) && host_dhcp_exchange(HOST_DHCP_DISCOVER, msg->data, 0, 0, 0, &offer) &&
+      host_dhcp_exchange(HOST_DHCP_REQUEST, msg->data, 0, offer.yiaddr, offer.server, &ack) && ack.type == HOST_DHCP_ACK) {
+    msg->arg = ack.yiaddr;
+  }
+  host_dhcp_hostname = NULL;
+  msg->len = 0;
+  sim_send(sim_down_fd, msg);
+}
+
+/*------------------------------------*/
+
+// Router process k of the chain of the given length
+static int sim_node(uint8_t k, bool routed) {
+  struct sim_node_stats stats;
+  struct pollfd pfds[2];
+  struct sim_msg msg;
+  struct netif *nif;
+  char value[16];
+  uint32_t addr;
+  uint64_t ns;
+  uint8_t idx, dir;
+
+  memset(&stats, 0, sizeof(stats));
+  // The root keeps the default network
+  if (k) {
+    snprintf(value, sizeof(value), "192.168.%u.1", 15 + k);
+    config_set("ap_addr", value);
+    config_set("ap_gw", value);
+    snprintf(value, sizeof(value), "192.168.%u.2", 15 + k);
+    config_set("dhcp_start", value);
+    snprintf(value, sizeof(value), "192.168.%u.64", 15 + k);
+    config_set("dhcp_stop", value);
+  }
+  config_set("mesh", (routed) ? "1" : "0");
+  config_set("mesh_key", SIM_MESH_KEY);
+  if (!config_save() || config_get()->ap_addr != sim_addr(k, 1)) {
+    return 1;
+  }
+
+  // Bring the router up like on the device
+  host_netif_tx_cb = sim_tx_cb;
+  host_espconn_sent_cb = sim_sent_cb;
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);  // Measure the forwarding itself (cf. uplink_sim)
+  if (!k) {
+    host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  }
+  else {
+    addr = (sim_recv(sim_up_fd, &msg) && msg.type == SIM_MSG_READY) ? sim_dhcp_request() : 0;
+    if (addr) {
+      host_wifi_got_ip(addr, ipaddr_addr("255.255.255.0"), sim_addr(k - 1, 1));
+    }
+  }
+  sim_flush();
+  if (!is_connected()) {
+    fprintf(stderr, "mesh_sim: Failed to bring up router %u!\n", k);
+    return 1;
+  }
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = SIM_MSG_READY;
+  sim_send(sim_down_fd, &msg);
+  for (idx = STATION_IF; idx <= SOFTAP_IF; idx++) {
+    nif = eagle_lwip_getif(idx);
+    sim_hook[idx] = nif->input;
+    nif->input = sim_input;
+  }
+
+  pfds[0].fd = sim_up_fd;
+  pfds[1].fd = sim_down_fd;
+  pfds[0].events = pfds[1].events = POLLIN;
+  while (poll(pfds, 2, -1) > 0) {
+    for (idx = 0; idx < 2; idx++) {
+      // The other side has terminated (the pending messages are read first)
+      if (!(pfds[idx].revents & POLLIN)) {
+        if (pfds[idx].revents & (POLLHUP | POLLERR)) {
+          return 1;
+        }
+        continue;
+      }
+      if (read(pfds[idx].fd, &msg, sizeof(msg)) < (ssize_t) offsetof(struct sim_msg, data)) {
+        return 1;
+      }
+      switch (msg.type) {
+        case SIM_MSG_FRAME:
+          dir = (idx) ? NAPT_DIR_OUT : NAPT_DIR_IN;
+          sim_measure = msg.measure;
+          sim_tx_ns = 0;
+          host_netif_input((idx) ? SOFTAP_IF : STATION_IF, msg.data, msg.len);
+          ns = ((sim_tx_ns) ? sim_tx_ns : host_clock_ns()) - sim_rx_ns;
+          if (msg.measure) {
+            stats.ns[dir] += ns;
+            stats.packets[dir]++;
+          }
+          sim_measure = false;
+          break;
+        case SIM_MSG_UDP:
+          host_espconn_recv(MESH_PORT, (uint8_t *) &msg.src, MESH_PORT, (char *) msg.data, msg.len);
+          break;
+        case SIM_MSG_DHCP:
+          sim_dhcp_serve(&msg);
+          break;
+        case SIM_MSG_CLIENT:
+          if (msg.arg == k) {
+            host_netif_input(SOFTAP_IF, msg.data, msg.len);
+          }
+          else {
+            sim_send(sim_down_fd, &msg);
+          }
+          break;
+        case SIM_MSG_TICK:
+          host_time_advance(msg.arg);
+          sim_flush();
+          sim_send(sim_down_fd, &msg);
+          break;
+        case SIM_MSG_STATS:
+          sim_node_stats(&stats);
+          memcpy(msg.data + msg.len, &stats, sizeof(stats));
+          msg.len += sizeof(stats);
+          sim_send(sim_down_fd, &msg);
+          break;
+        case SIM_MSG_QUIT:
+          sim_send(sim_down_fd, &msg);
+          return 0;
+      }
+      sim_flush();
+    }
+  }
+  return 1;
+}
+
+/*------------------------------------*/
+
+// Pass a message through the chain from the top (server_fd) to the bottom
+// (client_fd); the statistics of the routers are returned in result
+static bool sim_control(int server_fd, int client_fd, uint8_t type, uint32_t arg, struct sim_result *result) {
+  struct sim_msg msg;
+
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = type;
+  msg.arg = arg;
+  sim_send(server_fd, &msg);
+  do {
+    if (!sim_recv(client_fd, &msg)) {
+      return false;
+    }
+  } while (msg.type != type);
+  if (type == SIM_MSG_STATS && result) {
+    memcpy(result->nodes, msg.data, msg.len);
+  }
+  return true;
+}
+
+// Check, if the routes of the chain have converged: in routed mode, all
+// routers but the root route without translation and the root holds the
+// aggregated routes of the networks below it
+static bool sim_converged(const struct sim_result *result, uint8_t nodes, bool routed) {
+  uint8_t k;
+
+  if (!routed || result->nodes[0].routing) {
+    return !result->nodes[0].routing;
+  }
+  for (k = 1; k < nodes; k++) {
+    if (!result->nodes[k].routing) {
+      return false;
+    }
+  }
+  return result->nodes[0].routes == sim_routes_expected[nodes];
+}
+
+// Send a datagram of the client over the chain and answer it by the peer;
+// returns false, if a frame got lost
+static bool sim_exchange(int server_fd, int client_fd, uint8_t nodes, uint32_t seq, bool measure) {
+  struct sim_msg msg, reply;
+  uint32_t client = sim_addr(nodes - 1, SIM_CLIENT_HOST), peer = ipaddr_addr(SIM_PEER_ADDR), addr;
+  uint16_t sport = SIM_CLIENT_PORT + seq % SIM_FLOWS;
+  uint8_t mac[6], iphdr[SIM_FRAME_MAX];
+
+  wifi_get_macaddr(SOFTAP_IF, mac);
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = SIM_MSG_FRAME;
+  msg.measure = measure;
+  msg.len = host_packet_build(msg.data, mac, NAPT_PROTO_UDP, client, sport, peer, SIM_PEER_PORT, 0, sim_size);
+  msg.data[6] = 0x02;   // MAC-address of the client (cf. host_packet_build)
+  sim_send(client_fd, &msg);
+
+  // The peer sees the address of the root's station
+  do {
+    if (!sim_recv(server_fd, &msg)) {
+      return false;
+    }
+  } while (msg.type != SIM_MSG_FRAME);
+  memcpy(&addr, msg.data + 14 + 12, 4);
+  CHECK(addr == ipaddr_addr(SIM_STATION_ADDR));
+
+  reply = msg;
+  reply.len = host_packet_reply(msg.data, msg.len, reply.data);
+  sim_send(server_fd, &reply);
+
+  // The client gets the answer with its own address and port
+  do {
+    if (!sim_recv(client_fd, &msg)) {
+      return false;
+    }
+  } while (msg.type != SIM_MSG_FRAME);
+  memcpy(&addr, msg.data + 14 + 16, 4);
+  CHECK(addr == client && ((msg.data[14 + 20 + 2] << 8) | msg.data[14 + 20 + 3]) == sport);
+  memcpy(&addr, msg.data + 14 + 12, 4);
+  CHECK(addr == peer);
+
+  // The checksums, that have been updated incrementally on every hop, have to
+  // match the recomputed ones
+  memcpy(iphdr, msg.data + 14, msg.len - 14);
+  host_packet_chksum_fill(iphdr, msg.len - 14);
+  CHECK(!memcmp(iphdr, msg.data + 14, msg.len - 14));
+  return true;
+}
+
+// Send a datagram of a client of the root to the client of the lowest router
+// (in routed mode); it has to be sent down the chain by the routes without
+// translation instead of up to the host access-point. Returns false, if the
+// frame got lost.
+static bool sim_lateral(int server_fd, int client_fd, uint8_t nodes) {
+  struct sim_msg msg;
+  uint32_t src = sim_addr(0, SIM_CLIENT_HOST), dest = sim_addr(nodes - 1, SIM_CLIENT_HOST), addr;
+  uint8_t mac[6], iphdr[SIM_FRAME_MAX];
+
+  wifi_get_macaddr(SOFTAP_IF, mac);
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = SIM_MSG_CLIENT;
+  msg.arg = 0;
+  msg.len = host_packet_build(msg.data, mac, NAPT_PROTO_UDP, src, SIM_CLIENT_PORT, dest, SIM_PEER_PORT, 0, 64);
+  msg.data[6] = 0x02;   // MAC-address of the client (cf. host_packet_build)
+  sim_send(server_fd, &msg);
+
+  do {
+    if (!sim_recv(client_fd, &msg)) {
+      return false;
+    }
+  } while (msg.type != SIM_MSG_FRAME);
+  memcpy(&addr, msg.data + 14 + 12, 4);
+  CHECK(addr == src && ((msg.data[14 + 20] << 8) | msg.data[14 + 20 + 1]) == SIM_CLIENT_PORT);
+  memcpy(&addr, msg.data + 14 + 16, 4);
+  CHECK(addr == dest && ((msg.data[14 + 20 + 2] << 8) | msg.data[14 + 20 + 3]) == SIM_PEER_PORT);
+  memcpy(iphdr, msg.data + 14, msg.len - 14);
+  host_packet_chksum_fill(iphdr, msg.len - 14);
+  CHECK(!memcmp(iphdr, msg.data + 14, msg.len - 14));
+  return true;
+}
+
+// Send an advertisement of the client to the lowest router of a chain, signed
+// like by mesh.c under the given key (unsigned, if key is NULL)
+static void sim_advert(int client_fd, uint32_t src, const char *key, uint32_t seq) {
+  uint8_t data[4 + 64], mac[SHA256_DIGEST_LEN];
+  struct sim_msg msg;
+  uint8_t idx;
+
+  memset(&msg, 0, offsetof(struct sim_msg, data));
+  msg.type = SIM_MSG_UDP;
+  msg.src = src;
+  msg.len = sprintf((char *) msg.data, "MESH_ROUTES,10.99.0.0/16");
+  if (key) {
+    msg.len += sprintf((char *) msg.data + msg.len, "#%u#", seq);
+    memcpy(data, &src, 4);
+    memcpy(data + 4, msg.data, msg.len - 1);
+    hmac_sha256((const uint8_t *) key, strlen(key), data, 4 + msg.len - 1, mac);
+    for (idx = 0; idx < SIM_MAC_LEN; idx++) {
+      msg.len += sprintf((char *) msg.data + msg.len, "%02x", mac[idx]);
+    }
+  }
+  msg.data[msg.len++] = '\n';
+  sim_send(client_fd, &msg);
+}
+
+// Start the routers of a chain and let the routes converge; the routers don't
+// inherit the sockets of the other chain, if it's running. Returns false, if
+// the chain failed.
+static bool sim_chain_start(struct sim_chain *chain, const struct sim_chain *other) {
+  int links[SIM_NODES_MAX + 1][2];
+  struct sim_result *result = &chain->result;
+  struct sim_msg msg;
+  uint32_t round;
+  uint8_t nodes = chain->nodes, k, idx, converged = 0;
+  bool ok = true;
+
+  // Link k connects router k (below) with router k - 1 resp. the host
+  // access-point (above); link nodes connects the lowest router with the
+  // client
+  memset(result, 0, sizeof(struct sim_result));
+  chain->server_fd = chain->client_fd = -1;
+  chain->ok = false;
+  for (k = 0; k <= nodes; k++) {
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, links[k])) {
+      perror("mesh_sim: socketpair");
+      return false;
+    }
+  }
+  fflush(stdout);
+  for (k = 0; k < nodes; k++) {
+    chain->pids[k] = fork();
+    if (!chain->pids[k]) {
+      if (other && other->server_fd >= 0) {
+        close(other->server_fd);
+        close(other->client_fd);
+      }
+      for (idx = 0; idx <= nodes; idx++) {
+        if (idx != k) {
+          close(links[idx][1]);
+        }
+        if (idx != k + 1) {
+          close(links[idx][0]);
+        }
+      }
+      sim_up_fd = links[k][1];
+      sim_down_fd = links[k + 1][0];
+      _exit(sim_node(k, chain->routed));
+    }
+  }
+  for (k = 0; k <= nodes; k++) {
+    if (k) {
+      close(links[k][0]);
+    }
+    if (k != nodes) {
+      close(links[k][1]);
+    }
+  }
+  chain->server_fd = links[0][0];
+  chain->client_fd = links[nodes][1];
+
+  // Wait for the routers to come up; the client advertises a route unsigned,
+  // under another key and under the mesh-key, which the lowest router has to
+  // ignore all the same
+  do {
+    ok = sim_recv(chain->client_fd, &msg);
+  } while (ok && msg.type != SIM_MSG_READY);
+  sim_advert(chain->client_fd, sim_addr(nodes - 1, SIM_CLIENT_HOST), NULL, 0);
+  sim_advert(chain->client_fd, sim_addr(nodes - 1, SIM_CLIENT_HOST), "another key", 1);
+  sim_advert(chain->client_fd, sim_addr(nodes - 1, SIM_CLIENT_HOST), SIM_MESH_KEY, 2);
+
+  // Let the advertisements converge; the routes have to be stable for two
+  // intervals, since an advertisement may still be on its way up the chain,
+  // when the statistics pass
+  for (round = 0; ok && round < SIM_ROUNDS_MAX && converged < 2; round++) {
+    ok = sim_control(chain->server_fd, chain->client_fd, SIM_MSG_TICK, MESH_ADVERT_INTERVAL * 1000, NULL) &&
+         sim_control(chain->server_fd, chain->client_fd, SIM_MSG_STATS, 0, result);
+    converged = (ok && sim_converged(result, nodes, chain->routed)) ? converged + 1 : 0;
+  }
+  CHECK(ok && converged == 2);
+
+  // A client of the root reaches the network of the lowest router via the
+  // routes (the root itself doesn't route upstream)
+  if (ok && chain->routed) {
+    ok = sim_lateral(chain->server_fd, chain->client_fd, nodes);
+    CHECK(ok);
+  }
+  CHECK(result->nodes[nodes - 1].adverts_ignored == ((chain->routed) ? 3 : 0) && !result->nodes[nodes - 1].routes);
+  chain->ok = ok;
+  return ok;
+}
+
+// Collect the statistics of the routers of a chain and terminate them; returns
+// false, if the chain failed
+static bool sim_chain_stop(struct sim_chain *chain) {
+  int status;
+  uint8_t k;
+  bool ok = chain->ok;
+
+  if (chain->server_fd < 0) {
+    return false;
+  }
+  chain->result.packets = SIM_WARMUP + sim_packets;
+  ok = ok && sim_control(chain->server_fd, chain->client_fd, SIM_MSG_STATS, 0, &chain->result);
+
+  sim_control(chain->server_fd, chain->client_fd, SIM_MSG_QUIT, 0, NULL);
+  close(chain->server_fd);
+  close(chain->client_fd);
+  chain->server_fd = chain->client_fd = -1;
+  for (k = 0; k < chain->nodes; k++) {
+    if (waitpid(chain->pids[k], &status, 0) != chain->pids[k] || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Print the results of a chain
+static void sim_print(const struct sim_result *result, uint8_t nodes, bool routed) {
+  const struct sim_node_stats *node;
+  double up, down, path_up = 0, path_down = 0, max_up = 0, translated = 0, below = 0;
+  char hops[SIM_NODES_MAX * 24];
+  uint16_t len = 0;
+  uint8_t k;
+
+  for (k = 0; k < nodes; k++) {
+    node = &result->nodes[k];
+    up = (node->packets[NAPT_DIR_OUT]) ? (double) node->ns[NAPT_DIR_OUT] / node->packets[NAPT_DIR_OUT] : 0;
+    down = (node->packets[NAPT_DIR_IN]) ? (double) node->ns[NAPT_DIR_IN] / node->packets[NAPT_DIR_IN] : 0;
+    path_up += up;
+    path_down += down;
+    max_up = (up > max_up) ? up : max_up;
+    below += (k) ? (up + down) / (2 * (nodes - 1)) : 0;
+    translated += node->translated;
+    len += snprintf(hops + len, sizeof(hops) - len, " %u:%.0f/%.0f", k, up, down);
+  }
+  translated /= 2.0 * result->packets;
+  printf("%-7s %5u %6u %6.2f %9.1f %9.1f %9.1f %9.1f %8.1f %s\n", sim_modes[routed], nodes, result->nodes[0].routes, translated, path_up, path_down,
+         (path_up + path_down) / (2 * nodes), below, (max_up > 0) ? (20 + 8 + sim_size) * 8 * 1000.0 / max_up : 0, hops);
+}
+
+/*------------------------------------*/
+
+// Check SHA-256 and HMAC-SHA-256 against the test-vectors of FIPS 180-2 and
+// RFC 4231 (test case 2)
+static void sim_hmac_check(void) {
+  static const uint8_t abc[SHA256_DIGEST_LEN] = {
+    0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+    0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD,
+  };
+  static const uint8_t abc_long[SHA256_DIGEST_LEN] = {
+    0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+    0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1,
+  };
+  static const uint8_t jefe[SHA256_DIGEST_LEN] = {
+    0x5B, 0xDC, 0xC1, 0x46, 0xBF, 0x60, 0x75, 0x4E, 0x6A, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xC7,
+    0x5A, 0x00, 0x3F, 0x08, 0x9D, 0x27, 0x39, 0x83, 0x9D, 0xEC, 0x58, 0xB9, 0x64, 0xEC, 0x38, 0x43,
+  };
+  const char *long_msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  const char *jefe_msg = "what do ya want for nothing?";
+  uint8_t digest[SHA256_DIGEST_LEN];
+
+  sha256((const uint8_t *) "abc", 3, digest);
+  CHECK(!memcmp(digest, abc, sizeof(digest)));
+  sha256((const uint8_t *) long_msg, strlen(long_msg), digest);
+  CHECK(!memcmp(digest, abc_long, sizeof(digest)));
+  hmac_sha256((const uint8_t *) "Jefe", 4, (const uint8_t *) jefe_msg, strlen(jefe_msg), digest);
+  CHECK(!memcmp(digest, jefe, sizeof(digest)));
+}
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: mesh_sim [-v] [-n packets] [-s size]\n");
+}
+
+int main(int argc, char **argv) {
+  struct sim_chain chains[2];
+  const struct sim_result *result;
+  uint32_t network, seq;
+  uint8_t nodes, k, idx;
+  bool routed;
+  int opt, mode;
+
+  while ((opt = getopt(argc, argv, "vn:s:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'n': sim_packets = strtoul(optarg, NULL, 0); break;
+      case 's': sim_size = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!sim_packets || !sim_size || sim_size > 1472) {
+    sim_usage();
+    return 1;
+  }
+
+  sim_hmac_check();
+  printf("%-7s %5s %6s %6s %9s %9s %9s %9s %8s %s\n", "mode", "nodes", "routes", "xlat", "up_ns", "down_ns", "hop_ns", "node_ns", "mbps", "per-hop up/down ns");
+  for (nodes = SIM_NODES_MIN; nodes <= SIM_NODES_MAX; nodes++) {
+    // Both modes run side by side and their packets alternate, so that the
+    // variations of the host's speed affect them alike
+    for (mode = 0; mode < 2; mode++) {
+      chains[mode].nodes = nodes;
+      chains[mode].routed = mode;
+      sim_chain_start(&chains[mode], (mode) ? &chains[0] : NULL);
+    }
+    for (seq = 0; seq < SIM_WARMUP + sim_packets; seq++) {
+      for (mode = 0; mode < 2; mode++) {
+        if (chains[mode].ok) {
+          chains[mode].ok = sim_exchange(chains[mode].server_fd, chains[mode].client_fd, nodes, seq, seq >= SIM_WARMUP);
+        }
+      }
+    }
+
+    for (mode = 0; mode < 2; mode++) {
+      routed = mode;
+      result = &chains[mode].result;
+      if (!sim_chain_stop(&chains[mode])) {
+        printf("mesh_sim: Chain of %u routers (%s) failed\n", nodes, sim_modes[routed]);
+        failures++;
+        continue;
+      }
+      sim_print(result, nodes, routed);
+
+      // Every router translates resp. only the root does; the datagram of the
+      // root's client (cf. sim_lateral) is sent down by the root and routed by
+      // the others
+      CHECK(result->nodes[0].translated == 2 * result->packets);
+      CHECK(result->nodes[0].lateral == ((routed) ? 1 : 0));
+      for (k = 1; k < nodes; k++) {
+        CHECK(result->nodes[k].translated == ((routed) ? 0 : 2 * result->packets));
+        CHECK(result->nodes[k].routed == ((routed) ? 2 * sim_packets + 2 * SIM_WARMUP + 1 : 0));
+        CHECK(!result->nodes[k].lateral);
+      }
+      // The networks below the root are aggregated (e.g. 192.168.16.0/22 for
+      // five routers)
+      if (routed) {
+        for (idx = 0; idx < result->nodes[0].routes; idx++) {
+          network = sim_ntohl(result->nodes[0].network[idx]);
+          CHECK((network & sim_ntohl(result->nodes[0].netmask[idx])) == network && network >> 8 >= sim_ntohl(sim_addr(1, 0)) >> 8);
+        }
+        if (nodes == SIM_NODES_MAX) {
+          CHECK(result->nodes[0].network[0] == sim_addr(1, 0) && result->nodes[0].netmask[0] == ipaddr_addr("255.255.252.0"));
+        }
+      }
+    }
+  }
+
+  if (failures) {
+    printf("mesh_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,607 @@
+// napt_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side unit-test and benchmark of the NAPT-engine (cf.
+// napt.c). First, the translation of synthetic packets is verified (checksums,
+// reverse translation, TCP-state tracking, table consistency). Afterwards, synthetic flows are
+// replayed against the hash indexes of the engine as well as against a model of
+// the linked list (napt_list) walked by ip_napt_find resp. ip_napt_find_port in
+// liblwip.a, and the achieved lookups/s are reported. Likewise, the lookup of
+// portmap entries is compared with the scan of the fixed portmap array of
+// liblwip.a (ip_portmap_find).
+//
+// Usage: napt_bench [lookups per table size]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "napt.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define BENCH_LOOKUPS_DEFAULT 2000000
+
+#define HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) >> 8) & 0xFF)))
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+/*------------------------------------*/
+
+// Synthetic flow
+struct flow {
+  uint32_t src, dest;
+  uint16_t sport, dport, mport;
+  uint8_t proto;
+};
+
+// Model of the connection list of liblwip.a (most recently used first)
+struct legacy_entry {
+  struct legacy_entry *prev, *next;
+  uint32_t src, dest;
+  uint16_t sport, dport, mport;
+  uint8_t proto;
+};
+
+// Model of the portmap array of liblwip.a
+struct legacy_portmap {
+  uint32_t maddr, daddr;
+  uint16_t mport, dport;
+  uint8_t proto, valid;
+};
+
+static struct legacy_entry *legacy_list = NULL;
+static unsigned failures = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static uint32_t rnd_state = 0x12345678;
+
+static uint32_t rnd(void) {
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+// One's complement sum over the given data
+static uint32_t sum16(const uint8_t *data, uint16_t len, uint32_t sum) {
+  uint16_t idx;
+
+  for (idx = 0; idx + 1 < len; idx += 2) {
+    sum += (data[idx] << 8) | data[idx+1];
+  }
+  if (len & 1) {
+    sum += data[len-1] << 8;
+  }
+  return sum;
+}
+
+static uint16_t fold(uint32_t sum) {
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return (uint16_t) ~sum;
+}
+
+// Recompute the IP-header- and transport-layer-checksums of a packet
+static void chksum_fill(uint8_t *pkt, uint16_t len) {
+  uint8_t *l4 = pkt + 20, proto = pkt[9];
+  uint16_t l4len = len - 20, chksum_off = (proto == NAPT_PROTO_TCP) ? 16 : (proto == NAPT_PROTO_UDP) ? 6 : 2;
+  uint32_t sum = 0;
+  uint16_t chksum;
+
+  pkt[10] = pkt[11] = 0;
+  chksum = fold(sum16(pkt, 20, 0));
+  pkt[10] = chksum >> 8;
+  pkt[11] = chksum & 0xFF;
+
+  l4[chksum_off] = l4[chksum_off+1] = 0;
+  if (proto != NAPT_PROTO_ICMP) {
+    sum = sum16(pkt + 12, 8, 0) + proto + l4len;
+  }
+  chksum = fold(sum16(l4, l4len, sum));
+  l4[chksum_off] = chksum >> 8;
+  l4[chksum_off+1] = chksum & 0xFF;
+}
+
+// Verify the IP-header- and transport-layer-checksums of a packet
+static bool chksum_valid(const uint8_t *pkt, uint16_t len) {
+  uint8_t proto = pkt[9];
+  uint32_t sum = 0;
+
+  if (fold(sum16(pkt, 20, 0)) != 0) {
+    return false;
+  }
+  if (proto != NAPT_PROTO_ICMP) {
+    sum = sum16(pkt + 12, 8, 0) + proto + (len - 20);
+  }
+  return fold(sum16(pkt + 20, len - 20, sum)) == 0;
+}
+
+// Build an IPv4-packet with a TCP-, UDP- or ICMP-header and some payload
+static uint16_t packet_build(uint8_t *pkt, uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags) {
+  uint16_t len = 20 + ((proto == NAPT_PROTO_TCP) ? 20 : 8) + 32, idx;
+  uint8_t *l4 = pkt + 20;
+
+  os_memset(pkt, 0, len);
+  pkt[0] = 0x45;
+  pkt[2] = len >> 8;
+  pkt[3] = len & 0xFF;
+  pkt[8] = 64;
+  pkt[9] = proto;
+  os_memcpy(pkt + 12, &src, 4);
+  os_memcpy(pkt + 16, &dest, 4);
+  if (proto == NAPT_PROTO_ICMP) {
+    l4[0] = (tcp_flags) ? 8 : 0;  // Echo request resp. reply
+    os_memcpy(l4 + 4, (tcp_flags) ? &sport : &dport, 2);
+  }
+  else {
+    os_memcpy(l4, &sport, 2);
+    os_memcpy(l4 + 2, &dport, 2);
+    if (proto == NAPT_PROTO_TCP) {
+      l4[12] = 5 << 4;
+      l4[13] = tcp_flags;
+    }
+    else {
+      l4[4] = (len - 20) >> 8;
+      l4[5] = (len - 20) & 0xFF;
+    }
+  }
+  for (idx = len - 32; idx < len; idx++) {
+    pkt[idx] = rnd();
+  }
+  chksum_fill(pkt, len);
+  return len;
+}
+
+static void flows_generate(struct flow *flows, uint32_t count) {
+  static const uint16_t dports[] = {53, 80, 443, 8883, 123, 1883};
+  uint32_t idx;
+
+  for (idx = 0; idx < count; idx++) {
+    flows[idx].proto = (rnd() % 4) ? NAPT_PROTO_TCP : NAPT_PROTO_UDP;
+    flows[idx].src = IPADDR(192, 168, 13, 2 + rnd() % 62);
+    flows[idx].sport = HTONS(1024 + rnd() % 60000);
+    flows[idx].dest = rnd() | 0x01;
+    flows[idx].dport = HTONS(dports[rnd() % (sizeof(dports) / sizeof(dports[0]))]);
+  }
+}
+
+/*------------------------------------*/
+
+// Model of the list-based lookup of liblwip.a:
+
+static void legacy_reset(void) {
+  struct legacy_entry *entry;
+
+  while ((entry = legacy_list)) {
+    legacy_list = entry->next;
+    free(entry);
+  }
+}
+
+static void legacy_move_front(struct legacy_entry *entry) {
+  if (entry == legacy_list) {
+    return;
+  }
+  entry->prev->next = entry->next;
+  if (entry->next) {
+    entry->next->prev = entry->prev;
+  }
+  entry->prev = NULL;
+  entry->next = legacy_list;
+  legacy_list->prev = entry;
+  legacy_list = entry;
+}
+
+static void legacy_add(struct flow *flow) {
+  struct legacy_entry *entry = calloc(1, sizeof(struct legacy_entry));
+
+  entry->src = flow->src;
+  entry->dest = flow->dest;
+  entry->sport = flow->sport;
+  entry->dport = flow->dport;
+  entry->mport = flow->mport;
+  entry->proto = flow->proto;
+  entry->next = legacy_list;
+  if (legacy_list) {
+    legacy_list->prev = entry;
+  }
+  legacy_list = entry;
+}
+
+// Equivalent of ip_napt_find for packets from the internal network
+static struct legacy_entry *legacy_find_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport) {
+  struct legacy_entry *entry;
+
+  for (entry = legacy_list; entry; entry = entry->next) {
+    if (entry->proto == proto && entry->src == src && entry->sport == sport && entry->dest == dest && entry->dport == dport) {
+      legacy_move_front(entry);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Equivalent of ip_napt_find for packets from the external network
+static struct legacy_entry *legacy_find_inbound(uint8_t proto, uint16_t mport) {
+  struct legacy_entry *entry;
+
+  for (entry = legacy_list; entry; entry = entry->next) {
+    if (entry->proto == proto && entry->mport == mport) {
+      legacy_move_front(entry);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Equivalent of ip_portmap_find (scan of all IP_PORTMAP_MAX entries)
+static struct legacy_portmap *legacy_portmap_find(struct legacy_portmap *table, uint16_t size, uint8_t proto, uint16_t mport) {
+  uint16_t idx;
+
+  for (idx = 0; idx < size; idx++) {
+    if (table[idx].valid && table[idx].proto == proto && table[idx].mport == mport) {
+      return &table[idx];
+    }
+  }
+  return NULL;
+}
+
+/*------------------------------------*/
+
+// Tests:
+
+static void test_translation(void) {
+  uint8_t pkt[128], orig[128];
+  uint16_t len;
+  uint32_t ext_addr = IPADDR(10, 0, 0, 42), client = IPADDR(192, 168, 13, 37), peer = IPADDR(93, 184, 216, 34);
+  uint16_t mport;
+  struct napt_entry *entry;
+  static const uint8_t protos[] = {NAPT_PROTO_TCP, NAPT_PROTO_UDP, NAPT_PROTO_ICMP};
+  unsigned idx;
+
+  CHECK(napt_init(64));
+  napt_enable(IPADDR(192, 168, 13, 1), IPADDR(255, 255, 255, 0));
+
+  for (idx = 0; idx < sizeof(protos); idx++) {
+    // Outbound packet: the source has to be replaced by ext_addr:mport
+    len = packet_build(pkt, protos[idx], client, HTONS(40000 + idx), peer, (protos[idx] == NAPT_PROTO_ICMP) ? 0 : HTONS(443), 0x02);
+    os_memcpy(orig, pkt, len);
+    CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+    CHECK(os_memcmp(pkt + 12, &ext_addr, 4) == 0);
+    CHECK(chksum_valid(pkt, len));
+    entry = napt_find_outbound(protos[idx], client, HTONS(40000 + idx), peer, (protos[idx] == NAPT_PROTO_ICMP) ? 0 : HTONS(443));
+    CHECK(entry != NULL);
+    if (!entry) {
+      continue;
+    }
+    mport = entry->mport;
+    CHECK(napt_find_inbound(protos[idx], mport) == entry);
+
+    // Answer: the destination has to be restored
+    len = packet_build(pkt, protos[idx], peer, (protos[idx] == NAPT_PROTO_ICMP) ? 0 : HTONS(443), ext_addr, mport, (protos[idx] == NAPT_PROTO_TCP) ? 0x12 : 0);
+    CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+    CHECK(os_memcmp(pkt + 16, &client, 4) == 0);
+    CHECK(chksum_valid(pkt, len));
+
+    // Answers from other peers aren't translated
+    len = packet_build(pkt, protos[idx], peer ^ 0x01000000, HTONS(443), ext_addr, mport, 0x12);
+    CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_PASS);
+  }
+
+  // TCP-packets without a matching entry have to start a connection
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(41000), peer, HTONS(80), 0x10);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_DROP);
+
+  // Traffic within the soft access-point's network isn't translated
+  len = packet_build(pkt, NAPT_PROTO_UDP, client, HTONS(41000), IPADDR(192, 168, 13, 2), HTONS(53), 0);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_PASS);
+
+  // Portmap: static mapping in both directions
+  CHECK(napt_portmap_add(NAPT_PROTO_TCP, ext_addr, 8883, client, 1883, NAPT_PORTMAP_DIR_IN));
+  len = packet_build(pkt, NAPT_PROTO_TCP, peer, HTONS(50000), ext_addr, HTONS(8883), 0x02);
+  CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK(os_memcmp(pkt + 16, &client, 4) == 0 && pkt[22] == (1883 >> 8) && pkt[23] == (1883 & 0xFF));
+  CHECK(chksum_valid(pkt, len));
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(1883), peer, HTONS(50000), 0x12);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK(pkt[20] == (8883 >> 8) && pkt[21] == (8883 & 0xFF));
+  CHECK(chksum_valid(pkt, len));
+  CHECK(napt_portmap_remove(NAPT_PROTO_TCP, 8883));
+}
+
+static void test_tcp_state(void) {
+  uint8_t pkt[128];
+  uint16_t len, mport;
+  uint32_t ext_addr = IPADDR(10, 0, 0, 42), client = IPADDR(192, 168, 13, 37), peer = IPADDR(93, 184, 216, 34);
+  struct napt_entry *entry;
+
+  CHECK(napt_init(64));
+  napt_enable(IPADDR(192, 168, 13, 1), IPADDR(255, 255, 255, 0));
+
+  // Handshake
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(40100), peer, HTONS(80), 0x02);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  entry = napt_find_outbound(NAPT_PROTO_TCP, client, HTONS(40100), peer, HTONS(80));
+  CHECK(entry && (entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_SYN_SENT);
+  if (!entry) {
+    return;
+  }
+  mport = entry->mport;
+  len = packet_build(pkt, NAPT_PROTO_TCP, peer, HTONS(80), ext_addr, mport, 0x12);
+  CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK((entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_ESTABLISHED);
+
+  // Teardown: FIN from the client, FIN/ACK from the peer
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(40100), peer, HTONS(80), 0x11);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK((entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_FIN_WAIT);
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(40100), peer, HTONS(80), 0x11);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK((entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_FIN_WAIT);
+  len = packet_build(pkt, NAPT_PROTO_TCP, peer, HTONS(80), ext_addr, mport, 0x11);
+  CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK((entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_CLOSED);
+
+  // The closed connection is removed after NAPT_TIMEOUT_TCP_CLOSED, an
+  // established one is kept
+  len = packet_build(pkt, NAPT_PROTO_TCP, client, HTONS(40101), peer, HTONS(80), 0x02);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  entry = napt_find_outbound(NAPT_PROTO_TCP, client, HTONS(40101), peer, HTONS(80));
+  len = packet_build(pkt, NAPT_PROTO_TCP, peer, HTONS(80), ext_addr, (entry) ? entry->mport : 0, 0x12);
+  CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  host_time_advance(NAPT_TIMEOUT_TCP_CLOSED * 1000 + NAPT_EXPIRE_INTERVAL * 1000);
+  CHECK(napt_find_inbound(NAPT_PROTO_TCP, mport) == NULL);
+  CHECK(napt_find_outbound(NAPT_PROTO_TCP, client, HTONS(40101), peer, HTONS(80)) != NULL);
+  CHECK(napt_stats_get()->nr_active_napt_tcp == 1);
+
+  // A RST closes the connection immediately
+  len = packet_build(pkt, NAPT_PROTO_TCP, peer, HTONS(80), ext_addr, (entry) ? entry->mport : 0, 0x04);
+  CHECK(napt_inbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  CHECK(entry && (entry->state & NAPT_TCP_STATE_MASK) == NAPT_TCP_CLOSED);
+  napt_disable();
+}
+
+// The translation entries survive an outage of the station network interface,
+// that is longer than their timeout
+static void test_outage(void) {
+  uint8_t pkt[128];
+  uint16_t len;
+  uint32_t ext_addr = IPADDR(10, 0, 0, 42), client = IPADDR(192, 168, 13, 37), peer = IPADDR(198, 51, 100, 7);
+
+  CHECK(napt_init(64));
+  napt_enable(IPADDR(192, 168, 13, 1), IPADDR(255, 255, 255, 0));
+  napt_external_update(ext_addr);
+
+  len = packet_build(pkt, NAPT_PROTO_UDP, client, HTONS(5683), peer, HTONS(5683), 0);
+  CHECK(napt_outbound(pkt, len, ext_addr) == NAPT_FORWARD);
+  host_time_advance(NAPT_TIMEOUT_UDP * 1000 / 4);
+
+  napt_external_update(0);
+  host_time_advance(10 * NAPT_TIMEOUT_UDP * 1000);
+  CHECK(napt_find_outbound(NAPT_PROTO_UDP, client, HTONS(5683), peer, HTONS(5683)) != NULL);
+  napt_external_update(ext_addr);
+  host_time_advance(NAPT_EXPIRE_INTERVAL * 1000);
+  CHECK(napt_find_outbound(NAPT_PROTO_UDP, client, HTONS(5683), peer, HTONS(5683)) != NULL);
+
+  // The idle time continues after the outage
+  host_time_advance(NAPT_TIMEOUT_UDP * 1000);
+  CHECK(napt_find_outbound(NAPT_PROTO_UDP, client, HTONS(5683), peer, HTONS(5683)) == NULL);
+  napt_disable();
+}
+
+static void test_table(void) {
+  struct flow flows[512];
+  struct napt_entry *entry;
+  uint32_t idx;
+
+  CHECK(napt_init(512));
+  flows_generate(flows, 512);
+
+  for (idx = 0; idx < 512; idx++) {
+    entry = napt_add(flows[idx].proto, flows[idx].src, flows[idx].sport, flows[idx].dest, flows[idx].dport);
+    CHECK(entry != NULL);
+    if (entry) {
+      flows[idx].mport = entry->mport;
+    }
+  }
+  CHECK(napt_count() == 512);
+
+  // Remove every second entry and verify, that all others can still be found
+  for (idx = 0; idx < 512; idx += 2) {
+    napt_remove(napt_find_outbound(flows[idx].proto, flows[idx].src, flows[idx].sport, flows[idx].dest, flows[idx].dport));
+  }
+  CHECK(napt_count() == 256);
+  for (idx = 0; idx < 512; idx++) {
+    entry = napt_find_outbound(flows[idx].proto, flows[idx].src, flows[idx].sport, flows[idx].dest, flows[idx].dport);
+    CHECK((idx & 1) ? (entry != NULL && napt_find_inbound(flows[idx].proto, flows[idx].mport) == entry) : (entry == NULL));
+  }
+}
+
+static void test_portmap(void) {
+  const struct napt_portmap *next;
+  struct napt_portmap *portmap;
+  uint16_t idx, listed = 0;
+  bool consistent = true;
+
+  // Fill the table completely; further entries have to be rejected
+  for (idx = 0; idx < NAPT_PORTMAP_MAX; idx++) {
+    CHECK(napt_portmap_add((idx & 1) ? NAPT_PROTO_UDP : NAPT_PROTO_TCP, 0, 10000 + idx, IPADDR(192, 168, 13, 2 + idx % 60), 1000 + idx, NAPT_PORTMAP_DIR_IN));
+  }
+  CHECK(napt_portmap_count() == NAPT_PORTMAP_MAX);
+  CHECK(!napt_portmap_add(NAPT_PROTO_TCP, 0, 9999, IPADDR(192, 168, 13, 2), 80, NAPT_PORTMAP_DIR_IN));
+  CHECK(!napt_portmap_add(NAPT_PROTO_TCP, 0, 0, IPADDR(192, 168, 13, 2), 80, NAPT_PORTMAP_DIR_IN));
+
+  // Replacing an entry mustn't create a duplicate (even if the table is full)
+  CHECK(napt_portmap_add(NAPT_PROTO_TCP, 0, 10000, IPADDR(192, 168, 13, 99), 1000, NAPT_PORTMAP_DIR_OUT));
+  CHECK(napt_portmap_count() == NAPT_PORTMAP_MAX);
+  portmap = napt_portmap_find(NAPT_PROTO_TCP, HTONS(10000));
+  CHECK(portmap && portmap->daddr == IPADDR(192, 168, 13, 99) && portmap->dir == NAPT_PORTMAP_DIR_OUT);
+
+  // Remove every third entry; the remaining ones have to be found by mapping
+  // port and listed exactly once
+  for (idx = 0; idx < NAPT_PORTMAP_MAX; idx += 3) {
+    CHECK(napt_portmap_remove((idx & 1) ? NAPT_PROTO_UDP : NAPT_PROTO_TCP, 10000 + idx));
+  }
+  CHECK(!napt_portmap_remove(NAPT_PROTO_TCP, 10000));
+  CHECK(napt_portmap_count() == NAPT_PORTMAP_MAX - (NAPT_PORTMAP_MAX + 2) / 3);
+  for (idx = 0; idx < NAPT_PORTMAP_MAX; idx++) {
+    portmap = napt_portmap_find((idx & 1) ? NAPT_PROTO_UDP : NAPT_PROTO_TCP, HTONS(10000 + idx));
+    if ((idx % 3 == 0) ? (portmap != NULL) : (!portmap || portmap->dport != HTONS(1000 + idx))) {
+      consistent = false;
+    }
+    // The protocol is part of the key
+    if (napt_portmap_find((idx & 1) ? NAPT_PROTO_TCP : NAPT_PROTO_UDP, HTONS(10000 + idx))) {
+      consistent = false;
+    }
+  }
+  CHECK(consistent);
+
+  // The freed slots are reused
+  for (idx = 0; idx < NAPT_PORTMAP_MAX; idx += 3) {
+    CHECK(napt_portmap_add(NAPT_PROTO_TCP, 0, 20000 + idx, IPADDR(192, 168, 13, 2), 80, NAPT_PORTMAP_DIR_IN));
+  }
+  CHECK(napt_portmap_count() == NAPT_PORTMAP_MAX);
+
+  napt_external_update(IPADDR(10, 0, 0, 42));
+  for (next = napt_portmap_next(NULL); next; next = napt_portmap_next(next)) {
+    CHECK(next->maddr == IPADDR(10, 0, 0, 42));
+    listed++;
+  }
+  CHECK(listed == napt_portmap_count());
+
+  while ((next = napt_portmap_next(NULL))) {
+    CHECK(napt_portmap_remove(next->proto, HTONS(next->mport)));
+  }
+  CHECK(napt_portmap_count() == 0);
+}
+
+/*------------------------------------*/
+
+// Benchmark:
+
+static void bench(uint32_t flow_count, uint32_t lookups) {
+  struct flow *flows = calloc(flow_count, sizeof(struct flow));
+  struct napt_entry *entry;
+  struct legacy_entry *legacy;
+  uint64_t start, hash_ns, list_ns;
+  uint32_t idx, hits = 0, *order = calloc(lookups, sizeof(uint32_t));
+  struct flow *flow;
+
+  napt_init(flow_count);
+  legacy_reset();
+  flows_generate(flows, flow_count);
+  for (idx = 0; idx < flow_count; idx++) {
+    entry = napt_add(flows[idx].proto, flows[idx].src, flows[idx].sport, flows[idx].dest, flows[idx].dport);
+    flows[idx].mport = (entry) ? entry->mport : 0;
+    legacy_add(&flows[idx]);
+  }
+  for (idx = 0; idx < lookups; idx++) {
+    order[idx] = rnd() % flow_count;
+  }
+
+  // Every lookup consists of an outbound and an inbound lookup (request and
+  // answer of the same flow)
+  start = host_clock_ns();
+  for (idx = 0; idx < lookups; idx++) {
+    flow = &flows[order[idx]];
+    hits += napt_find_outbound(flow->proto, flow->src, flow->sport, flow->dest, flow->dport) != NULL;
+    hits += napt_find_inbound(flow->proto, flow->mport) != NULL;
+  }
+  hash_ns = host_clock_ns() - start;
+  CHECK(hits == 2 * lookups);
+
+  hits = 0;
+  start = host_clock_ns();
+  for (idx = 0; idx < lookups; idx++) {
+    flow = &flows[order[idx]];
+    legacy = legacy_find_outbound(flow->proto, flow->src, flow->sport, flow->dest, flow->dport);
+    hits += legacy != NULL;
+    hits += legacy_find_inbound(flow->proto, flow->mport) != NULL;
+  }
+  list_ns = host_clock_ns() - start;
+  CHECK(hits == 2 * lookups);
+
+  printf("%6u flows: hash %12.0f lookups/s | list %12.0f lookups/s | speedup %7.1fx\n", flow_count, 2e9 * lookups / hash_ns, 2e9 * lookups / list_ns, (double) list_ns / hash_ns);
+
+  legacy_reset();
+  free(order);
+  free(flows);
+}
+
+static void bench_portmap(uint16_t count, uint32_t lookups) {
+  struct legacy_portmap *legacy = calloc(count, sizeof(struct legacy_portmap));
+  uint16_t *mports = calloc(count, sizeof(uint16_t));
+  uint64_t start, hash_ns, array_ns;
+  uint32_t idx, hits = 0, *order = calloc(lookups, sizeof(uint32_t));
+
+  // Mapping ports are spread over the whole range, the legacy array is filled
+  // completely (IP_PORTMAP_MAX = count)
+  for (idx = 0; idx < count; idx++) {
+    mports[idx] = 1024 + idx * 61;
+    napt_portmap_add(NAPT_PROTO_TCP, 0, mports[idx], IPADDR(192, 168, 13, 2 + idx % 60), 8000 + idx, NAPT_PORTMAP_DIR_IN);
+    legacy[idx].proto = NAPT_PROTO_TCP;
+    legacy[idx].mport = HTONS(mports[idx]);
+    legacy[idx].valid = 1;
+  }
+  for (idx = 0; idx < lookups; idx++) {
+    order[idx] = rnd() % count;
+  }
+
+  start = host_clock_ns();
+  for (idx = 0; idx < lookups; idx++) {
+    hits += napt_portmap_find(NAPT_PROTO_TCP, HTONS(mports[order[idx]])) != NULL;
+  }
+  hash_ns = host_clock_ns() - start;
+  CHECK(hits == lookups);
+
+  hits = 0;
+  start = host_clock_ns();
+  for (idx = 0; idx < lookups; idx++) {
+    hits += legacy_portmap_find(legacy, count, NAPT_PROTO_TCP, HTONS(mports[order[idx]])) != NULL;
+  }
+  array_ns = host_clock_ns() - start;
+  CHECK(hits == lookups);
+
+  printf("%6u portmaps: hash %9.0f lookups/s | array %9.0f lookups/s | speedup %7.1fx\n", count, 1e9 * lookups / hash_ns, 1e9 * lookups / array_ns, (double) array_ns / hash_ns);
+
+  for (idx = 0; idx < count; idx++) {
+    napt_portmap_remove(NAPT_PROTO_TCP, mports[idx]);
+  }
+  free(order);
+  free(mports);
+  free(legacy);
+}
+
+int main(int argc, char **argv) {
+  static const uint32_t flow_counts[] = {16, 64, 256, 1024, 4096};
+  static const uint16_t portmap_counts[] = {8, 32, NAPT_PORTMAP_MAX};
+  uint32_t lookups = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_LOOKUPS_DEFAULT;
+  unsigned idx;
+
+  test_translation();
+  test_tcp_state();
+  test_outage();
+  test_table();
+  test_portmap();
+  printf("napt_bench: %s\n", failures ? "tests FAILED" : "tests passed");
+
+  for (idx = 0; idx < sizeof(flow_counts) / sizeof(flow_counts[0]); idx++) {
+    // The list-walk is O(n), so scale the number of lookups down accordingly
+    bench(flow_counts[idx], (flow_counts[idx] > 256) ? lookups / (flow_counts[idx] / 256) : lookups);
+  }
+  for (idx = 0; idx < sizeof(portmap_counts) / sizeof(portmap_counts[0]); idx++) {
+    bench_portmap(portmap_counts[idx], lookups);
+  }
+  return failures ? 1 : 0;
+}
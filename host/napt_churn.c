@@ -0,0 +1,319 @@
+// napt_churn.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side churn benchmark of the NAPT-engine (cf. napt.c). Eight
+// clients open many short-lived connections (DNS-lookups and HTTP-like TCP-
+// connections) next to one long-lived MQTT-connection each (port 8883, ping
+// every 30 s). The arrival rates are chosen so that, with the regular timeouts,
+// the connections would occupy load * NAPT_TABLE_SIZE entries (2x by default).
+// The packets are fed through napt_outbound resp. napt_inbound on the virtual
+// clock; a connection counts as successful, if all of its packets have been
+// translated. The run is repeated with fixed timeouts (only expired entries are
+// recycled, no tracking of the TCP-state) and with the adaptive timeouts, TCP-
+// state tracking and eviction order of the engine.
+//
+// Usage: napt_churn [-l load] [-t seconds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "napt.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define CHURN_CLIENTS 8
+#define CHURN_CONNS_MAX 4096
+#define CHURN_WARMUP_MS 30000   // Connections started earlier aren't counted
+#define CHURN_MQTT_PING_MS 30000
+
+#define HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) >> 8) & 0xFF)))
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define TCP_SYN 0x02
+#define TCP_ACK 0x10
+#define TCP_FIN 0x01
+
+/*------------------------------------*/
+
+enum churn_kind {
+  CHURN_DNS = 0,
+  CHURN_HTTP,
+  CHURN_MQTT,
+  CHURN_KINDS
+};
+
+// Single packet of a connection's script
+struct churn_step {
+  uint32_t delay_ms;  // Delay after the previous step
+  bool outbound;      // Client -> peer resp. peer -> client
+  uint8_t tcp_flags;
+};
+
+struct churn_conn {
+  uint8_t kind;
+  uint8_t step;
+  bool failed;
+  bool counted;
+  bool connected;   // MQTT: handshake completed, pings from now on
+  uint32_t src, dest;
+  uint16_t sport, dport, mport;
+  uint32_t due_ms;
+};
+
+struct churn_result {
+  uint32_t attempted[CHURN_KINDS];
+  uint32_t completed[CHURN_KINDS];
+  uint32_t peak;
+};
+
+/*------------------------------------*/
+
+static const struct churn_step churn_dns[] = {{0, true, 0}, {20, false, 0}};
+static const struct churn_step churn_http[] = {
+  {0, true, TCP_SYN}, {30, false, TCP_SYN | TCP_ACK}, {1, true, TCP_ACK}, {30, false, TCP_ACK},
+  {140, true, TCP_FIN | TCP_ACK}, {30, false, TCP_FIN | TCP_ACK}, {1, true, TCP_ACK}
+};
+static const struct churn_step churn_mqtt_connect[] = {{0, true, TCP_SYN}, {30, false, TCP_SYN | TCP_ACK}, {1, true, TCP_ACK}};
+static const struct churn_step churn_mqtt_ping[] = {{0, true, TCP_ACK}, {40, false, TCP_ACK}};
+
+static const char *churn_kind_names[CHURN_KINDS] = {"dns", "http", "mqtt-ping"};
+
+static struct churn_conn churn_conns[CHURN_CONNS_MAX];
+static uint16_t churn_conns_count = 0;
+static struct churn_conn churn_mqtt[CHURN_CLIENTS];
+
+static const uint32_t churn_ext_addr = IPADDR(10, 0, 0, 42);
+static uint32_t rnd_state = 0x12345678;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t rnd(void) {
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+// Build an IPv4-packet with a TCP- or UDP-header (the checksums are irrelevant
+// for the translation)
+static uint16_t packet_build(uint8_t *pkt, uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags) {
+  uint16_t len = 20 + ((proto == NAPT_PROTO_TCP) ? 20 : 8) + 32;
+
+  os_memset(pkt, 0, len);
+  pkt[0] = 0x45;
+  pkt[2] = len >> 8;
+  pkt[3] = len & 0xFF;
+  pkt[8] = 64;
+  pkt[9] = proto;
+  os_memcpy(pkt + 12, &src, 4);
+  os_memcpy(pkt + 16, &dest, 4);
+  os_memcpy(pkt + 20, &sport, 2);
+  os_memcpy(pkt + 22, &dport, 2);
+  if (proto == NAPT_PROTO_TCP) {
+    pkt[32] = 5 << 4;
+    pkt[33] = tcp_flags;
+  }
+  else {
+    pkt[25] = len - 20;
+  }
+  return len;
+}
+
+// Send the given step of a connection's script through the NAPT-engine; returns
+// false, if the packet hasn't been translated
+static bool churn_send(struct churn_conn *conn, const struct churn_step *step) {
+  uint8_t pkt[128], proto = (conn->kind == CHURN_DNS) ? NAPT_PROTO_UDP : NAPT_PROTO_TCP;
+  uint16_t len;
+  struct napt_entry *entry;
+
+  if (step->outbound) {
+    len = packet_build(pkt, proto, conn->src, conn->sport, conn->dest, conn->dport, step->tcp_flags);
+    if (napt_outbound(pkt, len, churn_ext_addr) != NAPT_FORWARD) {
+      return false;
+    }
+    // The mapped port may change, if the entry has been recycled meanwhile
+    entry = napt_find_outbound(proto, conn->src, conn->sport, conn->dest, conn->dport);
+    conn->mport = (entry) ? entry->mport : 0;
+    return true;
+  }
+  len = packet_build(pkt, proto, conn->dest, conn->dport, churn_ext_addr, conn->mport, step->tcp_flags);
+  return napt_inbound(pkt, len, churn_ext_addr) == NAPT_FORWARD && os_memcmp(pkt + 16, &conn->src, 4) == 0;
+}
+
+static void churn_conn_init(struct churn_conn *conn, uint8_t kind, uint8_t client, uint32_t now_ms) {
+  os_memset(conn, 0, sizeof(struct churn_conn));
+  conn->kind = kind;
+  conn->src = IPADDR(192, 168, 4, 2 + client);
+  conn->sport = HTONS(1024 + rnd() % 64000);
+  conn->dest = (kind == CHURN_DNS) ? IPADDR(8, 8, 8, 8) : IPADDR(93, 184, rnd() & 0xFF, 1 + rnd() % 254);
+  conn->dport = HTONS((kind == CHURN_DNS) ? 53 : (kind == CHURN_HTTP) ? 80 : 8883);
+  conn->due_ms = now_ms;
+  conn->counted = now_ms >= CHURN_WARMUP_MS;
+}
+
+// Advance a scripted connection; returns true, once the script has finished
+static bool churn_conn_run(struct churn_conn *conn, const struct churn_step *script, uint8_t steps, uint32_t now_ms, struct churn_result *result) {
+  while (conn->step < steps && conn->due_ms <= now_ms) {
+    if (!conn->failed && !churn_send(conn, &script[conn->step])) {
+      conn->failed = true;
+    }
+    conn->step++;
+    if (conn->step < steps) {
+      conn->due_ms += script[conn->step].delay_ms;
+    }
+  }
+  if (conn->step < steps) {
+    return false;
+  }
+  if (conn->counted) {
+    result->attempted[conn->kind]++;
+    result->completed[conn->kind] += !conn->failed;
+  }
+  return true;
+}
+
+/*------------------------------------*/
+
+// Simulation:
+
+static void churn_run(bool adaptive, double load, uint32_t duration_ms, struct churn_result *result) {
+  double dns_rate, http_rate, dns_credit = 0, http_credit = 0;
+  uint32_t now_ms, demand;
+  uint16_t idx;
+  struct churn_conn *conn;
+
+  os_memset(result, 0, sizeof(struct churn_result));
+  rnd_state = 0x12345678;
+  churn_conns_count = 0;
+  host_time_set(0);
+  napt_init(NAPT_TABLE_SIZE);
+  napt_set_adaptive(adaptive);
+  napt_set_tcp_tracking(adaptive);
+  napt_enable(IPADDR(192, 168, 4, 1), IPADDR(255, 255, 255, 0));
+
+  // With the regular timeouts, a DNS-lookup occupies its entry for about
+  // NAPT_TIMEOUT_UDP and a HTTP-connection for about NAPT_TIMEOUT_TCP_FIN_WAIT;
+  // both share the demand beyond the MQTT-connections equally
+  demand = (uint32_t) (load * NAPT_TABLE_SIZE) - CHURN_CLIENTS;
+  dns_rate = demand / 2.0 / (NAPT_TIMEOUT_UDP + 20) * 1000;
+  http_rate = demand / 2.0 / (NAPT_TIMEOUT_TCP_FIN_WAIT + 232) * 1000;
+
+  for (idx = 0; idx < CHURN_CLIENTS; idx++) {
+    churn_conn_init(&churn_mqtt[idx], CHURN_MQTT, idx, idx * 1000);
+  }
+
+  for (now_ms = 0; now_ms < duration_ms; now_ms++) {
+    host_time_set(now_ms * 1000);
+
+    // New short-lived connections
+    for (dns_credit += dns_rate / 1000; dns_credit >= 1 && churn_conns_count < CHURN_CONNS_MAX; dns_credit--) {
+      churn_conn_init(&churn_conns[churn_conns_count++], CHURN_DNS, rnd() % CHURN_CLIENTS, now_ms);
+    }
+    for (http_credit += http_rate / 1000; http_credit >= 1 && churn_conns_count < CHURN_CONNS_MAX; http_credit--) {
+      churn_conn_init(&churn_conns[churn_conns_count++], CHURN_HTTP, rnd() % CHURN_CLIENTS, now_ms);
+    }
+
+    for (idx = 0; idx < churn_conns_count;) {
+      conn = &churn_conns[idx];
+      if (churn_conn_run(conn, (conn->kind == CHURN_DNS) ? churn_dns : churn_http, (conn->kind == CHURN_DNS) ? 2 : 7, now_ms, result)) {
+        *conn = churn_conns[--churn_conns_count];
+      }
+      else {
+        idx++;
+      }
+    }
+
+    // Long-lived MQTT-connections: connect once, then ping periodically; each
+    // ping is counted as an attempt of its own
+    for (idx = 0; idx < CHURN_CLIENTS; idx++) {
+      conn = &churn_mqtt[idx];
+      if (conn->due_ms > now_ms) {
+        continue;
+      }
+      if (!conn->connected) {
+        conn->counted = false;
+        if (churn_conn_run(conn, churn_mqtt_connect, 3, now_ms, result)) {
+          // Retry with a new connection after the ping-interval on failure
+          if (conn->failed) {
+            churn_conn_init(conn, CHURN_MQTT, idx, now_ms + CHURN_MQTT_PING_MS);
+          }
+          else {
+            conn->connected = true;
+            conn->step = 0;
+            conn->due_ms = now_ms + CHURN_MQTT_PING_MS;
+          }
+        }
+        continue;
+      }
+      if (conn->step == 0) {
+        conn->counted = now_ms >= CHURN_WARMUP_MS;
+      }
+      if (churn_conn_run(conn, churn_mqtt_ping, 2, now_ms, result)) {
+        // The client reconnects immediately, if a ping fails
+        if (conn->failed) {
+          churn_conn_init(conn, CHURN_MQTT, idx, now_ms + 1);
+        }
+        else {
+          conn->step = 0;
+          conn->due_ms = now_ms + CHURN_MQTT_PING_MS;
+        }
+      }
+    }
+
+    if (napt_count() > result->peak) {
+      result->peak = napt_count();
+    }
+  }
+}
+
+static void churn_print(const char *policy, const struct churn_result *result) {
+  const struct napt_stats *stats = napt_stats_get();
+  uint8_t kind;
+
+  printf("%-9s", policy);
+  for (kind = 0; kind < CHURN_KINDS; kind++) {
+    printf(" | %s %6.2f%% of %6u", churn_kind_names[kind], result->attempted[kind] ? 100.0 * result->completed[kind] / result->attempted[kind] : 0.0, result->attempted[kind]);
+  }
+  printf(" | peak %u, active tcp/udp/icmp %u/%u/%u\n", result->peak, stats->nr_active_napt_tcp, stats->nr_active_napt_udp, stats->nr_active_napt_icmp);
+}
+
+int main(int argc, char **argv) {
+  double load = 2.0;
+  uint32_t duration_s = 180;
+  struct churn_result fixed, adaptive;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:t:")) != -1) {
+    switch (opt) {
+      case 'l':
+        load = strtod(optarg, NULL);
+        break;
+      case 't':
+        duration_s = strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "Usage: napt_churn [-l load] [-t seconds]\n");
+        return 2;
+    }
+  }
+  if (load * NAPT_TABLE_SIZE <= CHURN_CLIENTS || duration_s * 1000 <= CHURN_WARMUP_MS) {
+    fprintf(stderr, "napt_churn: Load resp. duration too small!\n");
+    return 2;
+  }
+
+  printf("napt_churn: %u entries, load %.1fx, %u s\n", NAPT_TABLE_SIZE, load, duration_s);
+  churn_run(false, load, duration_s * 1000, &fixed);
+  churn_print("fixed", &fixed);
+  churn_run(true, load, duration_s * 1000, &adaptive);
+  churn_print("adaptive", &adaptive);
+  return 0;
+}
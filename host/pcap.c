@@ -0,0 +1,114 @@
+// pcap.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Reader and writer for files in the classic libpcap-format (cf.
+// https://wiki.wireshark.org/Development/LibpcapFileFormat). Files of both byte
+// orders and with us- or ns-timestamps can be read; written files always use
+// the host's byte order and us-timestamps.
+
+#include <stdio.h>
+#include "c_types.h"
+#include "pcap.h"
+
+/*------------------------------------*/
+
+#define PCAP_MAGIC_USEC 0xA1B2C3D4
+#define PCAP_MAGIC_NSEC 0xA1B23C4D
+
+struct pcap_file_hdr {
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  int32_t thiszone;
+  uint32_t sigfigs;
+  uint32_t snaplen;
+  uint32_t linktype;
+};
+
+struct pcap_record_hdr {
+  uint32_t ts_sec;
+  uint32_t ts_frac;
+  uint32_t incl_len;
+  uint32_t orig_len;
+};
+
+/*------------------------------------*/
+
+static uint32_t pcap_swap32(const struct pcap_file *pcap, uint32_t val) {
+  return (pcap->swapped) ? __builtin_bswap32(val) : val;
+}
+
+// Open a pcap-file for reading and parse its header
+bool pcap_open_read(struct pcap_file *pcap, const char *path) {
+  struct pcap_file_hdr hdr;
+
+  pcap->file = fopen(path, "rb");
+  if (!pcap->file) {
+    return false;
+  }
+  if (fread(&hdr, sizeof(hdr), 1, pcap->file) != 1) {
+    pcap_close(pcap);
+    return false;
+  }
+
+  pcap->swapped = (hdr.magic == __builtin_bswap32(PCAP_MAGIC_USEC) || hdr.magic == __builtin_bswap32(PCAP_MAGIC_NSEC));
+  hdr.magic = pcap_swap32(pcap, hdr.magic);
+  if (hdr.magic != PCAP_MAGIC_USEC && hdr.magic != PCAP_MAGIC_NSEC) {
+    pcap_close(pcap);
+    return false;
+  }
+  pcap->nsec = (hdr.magic == PCAP_MAGIC_NSEC);
+  pcap->linktype = pcap_swap32(pcap, hdr.linktype);
+  return true;
+}
+
+// Read the next record; returns the number of bytes copied into buf, 0 at the
+// end of the file and -1 on errors
+int32_t pcap_read(struct pcap_file *pcap, uint8_t *buf, uint32_t buf_len, uint64_t *ts_us) {
+  struct pcap_record_hdr hdr;
+  uint32_t incl_len, len;
+
+  if (fread(&hdr, sizeof(hdr), 1, pcap->file) != 1) {
+    return 0;
+  }
+  incl_len = pcap_swap32(pcap, hdr.incl_len);
+  if (incl_len > PCAP_SNAPLEN) {
+    return -1;
+  }
+  len = (incl_len < buf_len) ? incl_len : buf_len;
+  if (fread(buf, 1, len, pcap->file) != len || fseek(pcap->file, incl_len - len, SEEK_CUR)) {
+    return -1;
+  }
+
+  *ts_us = (uint64_t) pcap_swap32(pcap, hdr.ts_sec) * 1000000 + pcap_swap32(pcap, hdr.ts_frac) / ((pcap->nsec) ? 1000 : 1);
+  return len;
+}
+
+// Create a pcap-file with the given link-type
+bool pcap_open_write(struct pcap_file *pcap, const char *path, uint32_t linktype) {
+  struct pcap_file_hdr hdr = {PCAP_MAGIC_USEC, 2, 4, 0, 0, PCAP_SNAPLEN, linktype};
+
+  pcap->file = fopen(path, "wb");
+  if (!pcap->file) {
+    return false;
+  }
+  pcap->linktype = linktype;
+  pcap->swapped = pcap->nsec = false;
+  return fwrite(&hdr, sizeof(hdr), 1, pcap->file) == 1;
+}
+
+bool pcap_write(struct pcap_file *pcap, const uint8_t *buf, uint32_t len, uint64_t ts_us) {
+  struct pcap_record_hdr hdr = {(uint32_t) (ts_us / 1000000), (uint32_t) (ts_us % 1000000), len, len};
+
+  return fwrite(&hdr, sizeof(hdr), 1, pcap->file) == 1 && fwrite(buf, 1, len, pcap->file) == len;
+}
+
+void pcap_close(struct pcap_file *pcap) {
+  if (pcap->file) {
+    fclose(pcap->file);
+    pcap->file = NULL;
+  }
+}
@@ -0,0 +1,38 @@
+// pcap.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __PCAP_H__
+#define __PCAP_H__
+
+#include <stdio.h>
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define PCAP_LINKTYPE_ETHERNET 1
+#define PCAP_LINKTYPE_RAW 101
+#define PCAP_LINKTYPE_IPV4 228
+
+#define PCAP_SNAPLEN 65535
+
+/*-------- structs and types ---------*/
+
+struct pcap_file {
+  FILE *file;
+  uint32_t linktype;
+  bool swapped; // File has been written with the opposite byte order
+  bool nsec;    // Timestamps are given in ns instead of us
+};
+
+/*------------ functions -------------*/
+
+bool pcap_open_read(struct pcap_file *pcap, const char *path);
+int32_t pcap_read(struct pcap_file *pcap, uint8_t *buf, uint32_t buf_len, uint64_t *ts_us);
+bool pcap_open_write(struct pcap_file *pcap, const char *path, uint32_t linktype);
+bool pcap_write(struct pcap_file *pcap, const uint8_t *buf, uint32_t len, uint64_t ts_us);
+void pcap_close(struct pcap_file *pcap);
+
+#endif
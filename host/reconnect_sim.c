@@ -0,0 +1,380 @@
+// reconnect_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side event simulation of an outage of the WAN-connection
+// (station network interface) as seen by the clients of the soft access-point.
+// The router is brought up like on the device and -c clients associate and get
+// their address from the DHCP-server. Every client keeps a TCP- and a UDP-flow
+// to a peer in the external network and sends a probe on one of them every
+// 10 ms; the peers answer every probe, as long as the WAN-connection is up.
+// Then the station network interface is disconnected for -d ms and
+// reconnected, either with the previous or with a new address.
+//
+// The client-visible outage is the longest gap between two answers received by
+// a client; the extra outage is the part of it exceeding the outage of the
+// WAN-connection. It's measured for three cases:
+//
+//  hitless  - the soft access-point, the DHCP-server and the NAPT-table are
+//             kept (cf. ROUTER_HITLESS_RECONNECT)
+//  readdr   - like hitless, but the station network interface gets a new
+//             address; the translations and the portmaps have to move to it
+//  legacy   - the soft access-point is reconfigured on the reconnect, which
+//             disassociates all clients; they re-associate after 1 s and
+//             re-request their address (INIT-REBOOT)
+//
+// Additionally, a peer in the external network opens a connection via a
+// portmap to the first client (port 1883) after the reconnect, which has to
+// reach the client at the current external address.
+//
+// Before the outage, the traffic of every client is checked in the counters
+// per client of the router (cf. client_stats.c).
+//
+// Usage: reconnect_sim [-v] [-c clients] [-d down_ms]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "dhcp_server.h"
+#include "client_stats.h"
+#include "uplink_sched.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_ADDR_NEW "10.0.0.77"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_CLIENTS_MAX 8
+#define SIM_FRAME_MAX 256
+#define SIM_REPLY_QUEUE 16
+#define SIM_PROBE_MS 10         // Interval of the probes of a client
+#define SIM_SETTLE_MS 2000      // Steady traffic before the outage
+#define SIM_RUN_MS 10000        // Traffic after the reconnect
+#define SIM_REASSOC_MS 1000     // Time of a client to re-associate (scan and authentication)
+#define SIM_PORTMAP_PORT 1883   // Mapped to the first client
+
+#define HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) >> 8) & 0xFF)))
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+struct sim_frame {
+  uint8_t data[SIM_FRAME_MAX];
+  uint16_t len;
+  uint8_t if_index;
+};
+
+// Emulated client of the soft access-point
+struct sim_client {
+  uint8_t mac[6];
+  uint32_t ip;
+  bool associated;
+  uint32_t reassoc_ms;      // Time of the re-association (0 = none pending)
+  uint32_t last_reply_ms;   // Time of the last answer received
+  uint32_t max_gap_ms;      // Longest gap between two answers
+  uint32_t probes;
+  uint16_t reassocs;
+};
+
+// Declaration and initialization of variables:
+
+static struct sim_client sim_clients[SIM_CLIENTS_MAX];
+static uint16_t sim_clients_count = 4;
+static uint32_t sim_now_ms = 0;
+static uint32_t failures = 0;
+
+static uint8_t sim_softap_mac[6], sim_station_mac[6];
+static bool sim_wan_up = false;
+static uint32_t sim_portmap_rx = 0;   // Frames delivered via the portmap
+
+static struct sim_frame sim_replies[SIM_REPLY_QUEUE];
+static uint16_t sim_replies_count = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static void sim_time_advance(uint32_t ms) {
+  host_time_advance(ms * 1000);
+  sim_now_ms += ms;
+}
+
+// Frames leaving the station network interface are answered by the peers (if
+// the WAN-connection is up), frames leaving the soft access-point are received
+// by the associated clients
+static void sim_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  struct sim_frame *reply;
+  struct sim_client *client;
+  uint32_t dest;
+
+  if (len < 34 || len > SIM_FRAME_MAX) {
+    return;
+  }
+  if (if_index == STATION_IF) {
+    if (sim_wan_up && sim_replies_count < SIM_REPLY_QUEUE) {
+      reply = &sim_replies[sim_replies_count];
+      reply->len = host_packet_reply(frame, len, reply->data);
+      reply->if_index = STATION_IF;
+      sim_replies_count += (reply->len != 0);
+    }
+    return;
+  }
+  os_memcpy(&dest, frame + 14 + 16, 4);
+  if (dest == sim_clients[0].ip && frame[14 + 9] == NAPT_PROTO_TCP && frame[14 + 20 + 2] == (SIM_PORTMAP_PORT >> 8) && frame[14 + 20 + 3] == (SIM_PORTMAP_PORT & 0xFF)) {
+    sim_portmap_rx++;
+    return;
+  }
+  for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+    if (client->associated && client->ip == dest) {
+      if (client->last_reply_ms) {
+        client->max_gap_ms = (sim_now_ms - client->last_reply_ms > client->max_gap_ms) ? sim_now_ms - client->last_reply_ms : client->max_gap_ms;
+      }
+      client->last_reply_ms = sim_now_ms;
+    }
+  }
+}
+
+// Inject a frame and the answers of the peers to the resulting frames
+static void sim_inject(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  struct sim_frame replies[SIM_REPLY_QUEUE];
+  uint16_t count, idx;
+
+  sim_replies_count = 0;
+  host_netif_input(if_index, frame, len);
+  count = sim_replies_count;
+  os_memcpy(replies, sim_replies, count * sizeof(struct sim_frame));
+  for (idx = 0; idx < count; idx++) {
+    sim_replies_count = SIM_REPLY_QUEUE;  // Don't answer the answers
+    host_netif_input(replies[idx].if_index, replies[idx].data, replies[idx].len);
+  }
+}
+
+// Return, if the station with the given MAC-address is associated with the
+// soft access-point
+static bool sim_station_associated(const uint8_t *mac) {
+  struct station_info *station;
+  bool found = false;
+
+  for (station = wifi_softap_get_station_info(); station && !found; station = STAILQ_NEXT(station, next)) {
+    found = os_memcmp(station->bssid, mac, 6) == 0;
+  }
+  wifi_softap_free_station_info();
+  return found;
+}
+
+// A frame of a peer in the external network to the portmap
+static void sim_portmap_connect(uint32_t ext_addr, uint8_t tcp_flags) {
+  uint8_t frame[SIM_FRAME_MAX];
+  uint16_t len = host_packet_build(frame, sim_station_mac, NAPT_PROTO_TCP, IPADDR(203, 0, 113, 7), 50000, ext_addr, SIM_PORTMAP_PORT, tcp_flags, 64);
+
+  sim_inject(STATION_IF, frame, len);
+}
+
+/*------------------------------------*/
+
+// Clients:
+
+// Associate the client and get its (previous) address from the DHCP-server
+static bool sim_client_associate(struct sim_client *client) {
+  struct host_dhcp_reply reply;
+
+  client->associated = host_wifi_sta_connected(client->mac);
+  if (!client->associated) {
+    return false;
+  }
+  client->reassoc_ms = 0;
+  if (client->ip && host_dhcp_exchange(HOST_DHCP_REQUEST, client->mac, 0, client->ip, 0, &reply) && reply.type == HOST_DHCP_ACK) {
+    return true;
+  }
+  if (!host_dhcp_exchange(HOST_DHCP_DISCOVER, client->mac, 0, 0, 0, &reply) || reply.type != HOST_DHCP_OFFER) {
+    return false;
+  }
+  if (!host_dhcp_exchange(HOST_DHCP_REQUEST, client->mac, 0, reply.yiaddr, reply.server, &reply) || reply.type != HOST_DHCP_ACK) {
+    return false;
+  }
+  client->ip = reply.yiaddr;
+  return true;
+}
+
+// Send the next probe of the client (alternating between its TCP- and its
+// UDP-flow); a client, that has been disassociated, re-associates after
+// SIM_REASSOC_MS
+static void sim_client_step(struct sim_client *client) {
+  uint8_t frame[SIM_FRAME_MAX];
+  uint16_t idx = client - sim_clients, len;
+
+  if (client->associated && !sim_station_associated(client->mac)) {
+    client->associated = false;
+  }
+  if (!client->associated) {
+    if (!client->reassoc_ms) {
+      client->reassoc_ms = sim_now_ms + SIM_REASSOC_MS;
+    }
+    else if ((int32_t) (sim_now_ms - client->reassoc_ms) >= 0) {
+      CHECK(sim_client_associate(client));
+      client->reassocs++;
+    }
+    return;
+  }
+  if (client->probes++ & 1) {
+    len = host_packet_build(frame, sim_softap_mac, NAPT_PROTO_UDP, client->ip, 5683, IPADDR(198, 51, 100, 1 + idx), 5683, 0, 32);
+  }
+  else {
+    len = host_packet_build(frame, sim_softap_mac, NAPT_PROTO_TCP, client->ip, 40000 + idx, IPADDR(93, 184, 216, 34), 443, (client->probes == 1) ? HOST_PACKET_TCP_SYN : HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, 64);
+  }
+  os_memcpy(frame + 6, client->mac, 6);
+  sim_inject(SOFTAP_IF, frame, len);
+}
+
+// Run the clients for the given time; every client sends a probe every
+// SIM_PROBE_MS (staggered by 1 ms)
+static void sim_clients_run(uint32_t ms) {
+  uint32_t end_ms = sim_now_ms + ms;
+  uint16_t idx;
+
+  while (sim_now_ms < end_ms) {
+    for (idx = 0; idx < sim_clients_count; idx++) {
+      if (sim_now_ms % SIM_PROBE_MS == idx % SIM_PROBE_MS) {
+        sim_client_step(&sim_clients[idx]);
+      }
+    }
+    sim_time_advance(1);
+  }
+}
+
+/*------------------------------------*/
+
+// Scenarios:
+
+// Bring the router up, let the clients associate and flap the WAN-connection;
+// returns the mean extra outage of the clients (in ms)
+static double sim_flap(const char *name, bool hitless, const char *new_addr, uint32_t down_ms) {
+  struct sim_client *client;
+  const struct client_stats *stats;
+  struct napt_entry *entry;
+  uint32_t mport[SIM_CLIENTS_MAX], sum_ms = 0, max_ms = 0, portmap_rx, ext_addr = ipaddr_addr(new_addr);
+  uint16_t kept = 0, reassocs = 0, idx;
+
+  // Start with a freshly initialized router and unassociated clients
+  for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+    host_wifi_sta_disconnected(client->mac);
+    os_memset(client, 0, sizeof(struct sim_client));
+    client->mac[0] = 0x02;
+    client->mac[5] = client - sim_clients + 1;
+  }
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  router_set_hitless_reconnect(hitless);
+  uplink_sched_set_rate(0);  // Replies follow each packet immediately (cf. uplink_sim)
+  sim_wan_up = true;
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  CHECK(is_connected());
+  wifi_get_macaddr(SOFTAP_IF, sim_softap_mac);
+  wifi_get_macaddr(STATION_IF, sim_station_mac);
+  for (client = sim_clients; client < sim_clients + sim_clients_count; client++) {
+    CHECK(sim_client_associate(client));
+  }
+  CHECK(napt_portmap_add(NAPT_PROTO_TCP, ipaddr_addr(SIM_STATION_ADDR), SIM_PORTMAP_PORT, sim_clients[0].ip, SIM_PORTMAP_PORT, NAPT_PORTMAP_DIR_IN));
+  sim_clients_run(SIM_SETTLE_MS);
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    entry = napt_find_outbound(NAPT_PROTO_TCP, sim_clients[idx].ip, HTONS(40000 + idx), IPADDR(93, 184, 216, 34), HTONS(443));
+    mport[idx] = (entry) ? entry->mport : 0;
+    CHECK(entry != NULL);
+
+    // Both flows of the client are accounted to it in both directions
+    stats = client_stats_lookup_mac(sim_clients[idx].mac);
+    CHECK(stats && stats->aid && stats->ip == sim_clients[idx].ip && stats == client_stats_lookup(sim_clients[idx].ip));
+    CHECK(stats && stats->napt_entries == 2 && stats->packets[NAPT_DIR_OUT] == stats->packets[NAPT_DIR_IN]);
+    CHECK(stats && stats->rate[NAPT_DIR_OUT] > 0 && stats->rate[NAPT_DIR_OUT] <= stats->bytes[NAPT_DIR_OUT]);
+  }
+
+  // Outage of the WAN-connection; the SDK retries every second
+  sim_wan_up = false;
+  host_wifi_disconnected(REASON_BEACON_TIMEOUT);
+  sim_clients_run(down_ms);
+  sim_wan_up = true;
+  host_wifi_got_ip(ext_addr, ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  CHECK(is_connected());
+  sim_clients_run(SIM_RUN_MS);
+
+  // A peer in the external network connects via the portmap
+  portmap_rx = sim_portmap_rx;
+  sim_portmap_connect(ext_addr, HOST_PACKET_TCP_SYN);
+  CHECK(sim_portmap_rx == portmap_rx + 1);
+
+  for (idx = 0; idx < sim_clients_count; idx++) {
+    client = &sim_clients[idx];
+    sum_ms += (client->max_gap_ms > down_ms) ? client->max_gap_ms - down_ms : 0;
+    max_ms = (client->max_gap_ms > max_ms) ? client->max_gap_ms : max_ms;
+    reassocs += client->reassocs;
+    entry = napt_find_outbound(NAPT_PROTO_TCP, client->ip, HTONS(40000 + idx), IPADDR(93, 184, 216, 34), HTONS(443));
+    kept += (entry && entry->mport == mport[idx]);
+    CHECK(sim_now_ms - client->last_reply_ms <= SIM_PROBE_MS);
+  }
+  if (hitless) {
+    // The clients neither re-associate nor lose their translations; they only
+    // miss the answers during the outage itself
+    CHECK(reassocs == 0);
+    CHECK(kept == sim_clients_count);
+    CHECK(max_ms <= down_ms + 2 * SIM_PROBE_MS);
+  }
+  else {
+    CHECK(reassocs == sim_clients_count);
+  }
+  printf("%-8s %6u %12.1f %10u %8u %6u/%u\n", name, down_ms, (double) sum_ms / sim_clients_count, max_ms, reassocs, kept, sim_clients_count);
+  return (double) sum_ms / sim_clients_count;
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: reconnect_sim [-v] [-c clients] [-d down_ms]\n");
+}
+
+int main(int argc, char **argv) {
+  uint32_t down_ms = 3000;
+  double hitless, legacy;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vc:d:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'c': sim_clients_count = strtoul(optarg, NULL, 0); break;
+      case 'd': down_ms = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!sim_clients_count || sim_clients_count > SIM_CLIENTS_MAX) {
+    sim_usage();
+    return 1;
+  }
+  host_netif_tx_cb = sim_tx_cb;
+
+  printf("%-8s %6s %12s %10s %8s %8s\n", "case", "down", "extra_ms", "max_gap", "reassoc", "flows");
+  hitless = sim_flap("hitless", true, SIM_STATION_ADDR, down_ms);
+  sim_flap("readdr", true, SIM_STATION_ADDR_NEW, down_ms);
+  legacy = sim_flap("legacy", false, SIM_STATION_ADDR, down_ms);
+  CHECK(hitless + SIM_REASSOC_MS <= legacy);
+
+  if (failures) {
+    printf("reconnect_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,348 @@
+// router_bench.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Regression benchmark of the router (run by 'make bench'). The
+// router's logic is brought up like in router_sim and driven through fixed,
+// deterministic traffic profiles:
+//
+//  bulk_tcp  - A single TCP-connection with full-sized segments
+//  small_udp - Many UDP-flows from all clients with small datagrams
+//  dns_storm - DNS-queries from all clients, each from a new source port
+//  mixed     - MAX_CLIENTS clients with HTTP-like connections, DNS-queries,
+//              pings, connections via a portmap and DHCP-broadcasts
+//
+// Every packet sent by the router is answered once by its receiver (the peer
+// in the external network resp. the client), so both directions of the NAPT-
+// engine and the portmaps are exercised. The virtual time advances by a fixed
+// interval per packet, so that the timers of the router run in between.
+// Between the profiles the NAPT-table is re-initialized.
+//
+// For each profile, the packets/s and the p50/p99-latency of the processing of
+// a packet (measured with the host's real clock), as well as the peak memory
+// (heap and memory pools of the firmware's modules, sampled after every
+// packet, pbufs and entries of the NAPT-table) are written as JSON to stdout
+// resp. the given file.
+//
+// Usage: router_bench [-v] [-s scale] [-o output.json]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "mem.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "netif/etharp.h"
+#include "napt.h"
+#include "napt_netif.h"
+#include "mem_pool.h"
+#include "router.h"
+#include "uplink_sched.h"
+#include "device_info.h"
+#include "user_config.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define BENCH_STATION_ADDR "10.0.0.42"
+#define BENCH_STATION_NETMASK "255.255.255.0"
+#define BENCH_STATION_GW "10.0.0.1"
+
+#define BENCH_FRAME_MAX 1600
+#define BENCH_REPLY_QUEUE 4
+#define BENCH_FLOWS_PER_CLIENT 24
+#define BENCH_PORTMAP_PORT 1883   // Mapped to the first client
+#define BENCH_HTTP_STEPS 7        // SYN, ACK, 3 requests, FIN, ACK
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+/*------------------------------------*/
+
+struct bench_frame {
+  uint8_t data[BENCH_FRAME_MAX];
+  uint16_t len;
+  uint8_t if_index;
+};
+
+struct bench_profile {
+  const char *name;
+  uint32_t packets;   // Generated packets (without the replies)
+  uint32_t interval;  // Virtual time between two packets (in us)
+  uint16_t (*generate)(uint32_t seq, struct bench_frame *frame);
+};
+
+struct bench_result {
+  uint32_t frames;
+  uint32_t sent;
+  uint32_t dropped;
+  double pps;
+  uint64_t p50_ns;
+  uint64_t p99_ns;
+  size_t peak_heap;
+  uint32_t peak_pbuf;
+  uint16_t peak_entries;
+};
+
+// Declaration and initialization of variables:
+
+static uint8_t bench_softap_mac[6], bench_station_mac[6];
+static uint32_t bench_station_addr, bench_softap_net;
+static uint32_t bench_rnd_state;
+
+static struct bench_frame bench_replies[BENCH_REPLY_QUEUE];
+static uint16_t bench_replies_count = 0;
+static bool bench_reflect = false;
+static uint32_t bench_sent = 0;
+
+static uint64_t *bench_latencies = NULL;
+static uint32_t bench_latencies_count = 0;
+static size_t bench_memory_peak = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Deterministic pseudo random numbers (xorshift32), so that every run sends the
+// same packets
+static uint32_t bench_rnd(void) {
+  bench_rnd_state ^= bench_rnd_state << 13;
+  bench_rnd_state ^= bench_rnd_state >> 17;
+  bench_rnd_state ^= bench_rnd_state << 5;
+  return bench_rnd_state;
+}
+
+static uint32_t bench_client(uint32_t idx) {
+  return bench_softap_net | ((2 + idx % MAX_CLIENTS) << 24);
+}
+
+static int bench_latency_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+// Answer every frame sent by the router once (but not the answers themselves)
+static void bench_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  struct bench_frame *reply;
+
+  bench_sent++;
+  if (!bench_reflect || bench_replies_count == BENCH_REPLY_QUEUE || len > BENCH_FRAME_MAX) {
+    return;
+  }
+  reply = &bench_replies[bench_replies_count];
+  reply->len = host_packet_reply(frame, len, reply->data);
+  reply->if_index = if_index;
+  if (reply->len) {
+    bench_replies_count++;
+  }
+}
+
+// Bytes occupied by the firmware's objects: the heap in use, where the storage
+// of the NAPT-table (preallocated by napt_init) only counts with its used
+// entries, and the used blocks of the other memory pools
+static size_t bench_memory(void) {
+  const struct mem_pool *pool;
+  size_t bytes = host_heap_stats.used;
+
+  for (pool = mem_pool_first(); pool; pool = pool->next) {
+    bytes += pool->used * pool->block_size;
+    if (!os_strcmp(pool->name, "napt_entries")) {
+      bytes -= pool->blocks * pool->block_size;
+    }
+  }
+  return bytes;
+}
+
+static void bench_inject(const struct bench_frame *frame, bool reflect) {
+  uint64_t start;
+  size_t memory;
+
+  bench_reflect = reflect;
+  start = host_clock_ns();
+  host_netif_input(frame->if_index, frame->data, frame->len);
+  bench_latencies[bench_latencies_count++] = host_clock_ns() - start;
+  memory = bench_memory();
+  if (memory > bench_memory_peak) {
+    bench_memory_peak = memory;
+  }
+}
+
+static uint16_t bench_outbound(struct bench_frame *frame, uint8_t proto, uint32_t client, uint16_t sport, uint32_t dest, uint16_t dport, uint8_t tcp_flags, uint16_t payload) {
+  frame->if_index = SOFTAP_IF;
+  frame->len = host_packet_build(frame->data, bench_softap_mac, proto, client, sport, dest, dport, tcp_flags, payload);
+  return frame->len;
+}
+
+/*------------------------------------*/
+
+// Traffic profiles:
+
+static uint16_t bench_bulk_tcp(uint32_t seq, struct bench_frame *frame) {
+  return bench_outbound(frame, NAPT_PROTO_TCP, bench_client(0), 40000, IPADDR(93, 184, 216, 34), 443, (seq) ? HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH : HOST_PACKET_TCP_SYN, (seq) ? 1460 : 0);
+}
+
+static uint16_t bench_small_udp(uint32_t seq, struct bench_frame *frame) {
+  uint32_t flow = seq % (MAX_CLIENTS * BENCH_FLOWS_PER_CLIENT);
+
+  return bench_outbound(frame, NAPT_PROTO_UDP, bench_client(flow), 41000 + flow / MAX_CLIENTS, IPADDR(198, 51, 100, 1 + flow % 200), 5683, 0, 64);
+}
+
+static uint16_t bench_dns_storm(uint32_t seq, struct bench_frame *frame) {
+  return bench_outbound(frame, NAPT_PROTO_UDP, bench_client(seq), 1024 + (seq / MAX_CLIENTS) % 60000, IPADDR(8, 8, 8, 8), 53, 0, 32 + bench_rnd() % 32);
+}
+
+// Every packet belongs to a randomly chosen client and kind of traffic; the
+// HTTP-like connections of each client advance by one step per packet
+static uint16_t bench_mixed(uint32_t seq, struct bench_frame *frame) {
+  static const uint8_t http_flags[BENCH_HTTP_STEPS] = {HOST_PACKET_TCP_SYN, HOST_PACKET_TCP_ACK, HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH, HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_FIN, HOST_PACKET_TCP_ACK};
+  static uint32_t http_step[MAX_CLIENTS], portmap_seq = 0;
+  uint32_t rnd = bench_rnd(), client = rnd % MAX_CLIENTS, kind = (rnd >> 8) % 16, step, src = 0, bcast = 0xFFFFFFFF;
+  uint8_t bcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+  if (seq == 0) {
+    os_memset(http_step, 0, sizeof(http_step));
+    portmap_seq = 0;
+  }
+
+  if (kind < 8) {
+    step = http_step[client]++;
+    return bench_outbound(frame, NAPT_PROTO_TCP, bench_client(client), 42000 + (step / BENCH_HTTP_STEPS) % 20000, IPADDR(93, 184, 1 + client, 80), 80, http_flags[step % BENCH_HTTP_STEPS], (http_flags[step % BENCH_HTTP_STEPS] & HOST_PACKET_TCP_PSH) ? 256 : 0);
+  }
+  if (kind < 11) {
+    return bench_outbound(frame, NAPT_PROTO_UDP, bench_client(client), 1024 + (rnd >> 12) % 60000, IPADDR(8, 8, 8, 8), 53, 0, 40);
+  }
+  if (kind < 13) {
+    return bench_outbound(frame, NAPT_PROTO_ICMP, bench_client(client), client + 1, IPADDR(1, 1, 1, 1), 0, 0, 56);
+  }
+  if (kind < 15) {
+    // Connection of a peer in the external network to the first client
+    frame->if_index = STATION_IF;
+    frame->len = host_packet_build(frame->data, bench_station_mac, NAPT_PROTO_TCP, IPADDR(203, 0, 113, 7), 50000, bench_station_addr, BENCH_PORTMAP_PORT, (portmap_seq++) ? HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH : HOST_PACKET_TCP_SYN, 128);
+    return frame->len;
+  }
+  // DHCP-DISCOVER of a client, which is handed to the stack
+  frame->if_index = SOFTAP_IF;
+  frame->len = host_packet_build(frame->data, bcast_mac, NAPT_PROTO_UDP, src, 68, bcast, 67, 0, 240);
+  return frame->len;
+}
+
+static const struct bench_profile bench_profiles[] = {
+  {"bulk_tcp", 20000, 100, bench_bulk_tcp},
+  {"small_udp", 20000, 50, bench_small_udp},
+  {"dns_storm", 20000, 200, bench_dns_storm},
+  {"mixed", 20000, 100, bench_mixed},
+};
+
+/*------------------------------------*/
+
+static void bench_run(const struct bench_profile *profile, uint32_t scale, struct bench_result *result) {
+  const struct mem_pool *pool;
+  struct bench_frame frame;
+  uint32_t packets = profile->packets * scale, seq, idx, dropped;
+  uint64_t total_ns = 0;
+
+  // Start with an empty NAPT-table and the peaks at the current usage
+  napt_init(NAPT_TABLE_SIZE);
+  napt_enable(ipaddr_addr(WIFI_AP_NETWORK_ADDR), ipaddr_addr(WIFI_AP_NETWORK_NETMASK));
+  bench_memory_peak = bench_memory();
+  host_lwip_stats.pbuf_bytes_peak = host_lwip_stats.pbuf_bytes;
+  bench_sent = 0;
+  dropped = napt_stats_get()->drops;
+  bench_rnd_state = 0x2545F491;
+
+  bench_latencies = realloc(bench_latencies, (uint64_t) packets * (1 + BENCH_REPLY_QUEUE) * sizeof(uint64_t));
+  bench_latencies_count = 0;
+  for (seq = 0; seq < packets; seq++) {
+    profile->generate(seq, &frame);
+    bench_replies_count = 0;
+    bench_inject(&frame, true);
+    for (idx = 0; idx < bench_replies_count; idx++) {
+      bench_inject(&bench_replies[idx], false);
+    }
+    host_time_advance(profile->interval);
+  }
+
+  for (idx = 0; idx < bench_latencies_count; idx++) {
+    total_ns += bench_latencies[idx];
+  }
+  qsort(bench_latencies, bench_latencies_count, sizeof(uint64_t), bench_latency_cmp);
+  result->frames = bench_latencies_count;
+  result->sent = bench_sent;
+  result->dropped = napt_stats_get()->drops - dropped;
+  result->pps = (total_ns) ? bench_latencies_count * 1e9 / total_ns : 0;
+  result->p50_ns = bench_latencies[bench_latencies_count / 2];
+  result->p99_ns = bench_latencies[(uint64_t) bench_latencies_count * 99 / 100];
+  result->peak_heap = bench_memory_peak;
+  result->peak_pbuf = host_lwip_stats.pbuf_bytes_peak;
+  result->peak_entries = 0;
+  for (pool = mem_pool_first(); pool; pool = pool->next) {
+    if (!os_strcmp(pool->name, "napt_entries")) {
+      result->peak_entries = pool->high_water;
+    }
+  }
+}
+
+static void bench_usage(void) {
+  fprintf(stderr, "Usage: router_bench [-v] [-s scale] [-o output.json]\n");
+}
+
+int main(int argc, char **argv) {
+  const char *output_path = NULL;
+  struct bench_result result;
+  struct ip_info softap_info;
+  uint32_t scale = 1, idx;
+  FILE *out = stdout;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vs:o:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 's': scale = strtoul(optarg, NULL, 0); break;
+      case 'o': output_path = optarg; break;
+      default: bench_usage(); return 1;
+    }
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  device_info_init();
+  uplink_sched_set_rate(0);  // Measure the forwarding itself (cf. uplink_sim)
+  host_wifi_got_ip(ipaddr_addr(BENCH_STATION_ADDR), ipaddr_addr(BENCH_STATION_NETMASK), ipaddr_addr(BENCH_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "router_bench: Failed to bring up the router!\n");
+    return 1;
+  }
+  wifi_get_macaddr(SOFTAP_IF, bench_softap_mac);
+  wifi_get_macaddr(STATION_IF, bench_station_mac);
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  bench_softap_net = softap_info.ip.addr & softap_info.netmask.addr;
+  bench_station_addr = ipaddr_addr(BENCH_STATION_ADDR);
+  if (!napt_portmap_add(NAPT_PROTO_TCP, bench_station_addr, BENCH_PORTMAP_PORT, bench_client(0), BENCH_PORTMAP_PORT, NAPT_PORTMAP_DIR_IN)) {
+    fprintf(stderr, "router_bench: Failed to add the portmap!\n");
+    return 1;
+  }
+  host_netif_tx_cb = bench_tx_cb;
+
+  if (output_path && !(out = fopen(output_path, "w"))) {
+    fprintf(stderr, "router_bench: Failed to create %s!\n", output_path);
+    return 1;
+  }
+  fprintf(out, "{\n  \"napt_table_size\": %u,\n  \"max_clients\": %u,\n  \"profiles\": [\n", NAPT_TABLE_SIZE, MAX_CLIENTS);
+  for (idx = 0; idx < sizeof(bench_profiles) / sizeof(bench_profiles[0]); idx++) {
+    bench_run(&bench_profiles[idx], (scale) ? scale : 1, &result);
+    fprintf(out, "    {\"name\": \"%s\", \"frames\": %u, \"sent\": %u, \"dropped\": %u, \"pps\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+            "\"peak_heap_bytes\": %zu, \"peak_pbuf_bytes\": %u, \"peak_memory_bytes\": %zu, \"peak_napt_entries\": %u}%s\n",
+            bench_profiles[idx].name, result.frames, result.sent, result.dropped, result.pps, (unsigned long long) result.p50_ns, (unsigned long long) result.p99_ns,
+            result.peak_heap, result.peak_pbuf, result.peak_heap + result.peak_pbuf, result.peak_entries, (idx + 1 < sizeof(bench_profiles) / sizeof(bench_profiles[0])) ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+  if (out != stdout) {
+    fclose(out);
+  }
+  free(bench_latencies);
+  return 0;
+}
@@ -0,0 +1,444 @@
+// router_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side packet simulator of the router. The router's logic
+// (router.c, napt.c, napt_netif.c, ...) is compiled against the stub SDK
+// headers in host/include and brought up just like on the device (router_init
+// and an EVENT_STAMODE_GOT_IP-event). Afterwards, the frames of a pcap-file are
+// fed into the network interfaces: packets with a source address in the soft
+// access-point's network are received on the soft access-point, all others on
+// the station network interface. All frames sent by the router are written to
+// the output pcap-file.
+//
+// Optionally, the peers in the external network can be emulated (-r): every
+// packet leaving the station network interface is answered with a reply, which
+// is then passed through the router again.
+//
+// The virtual system time follows the timestamps of the input, so the results
+// are deterministic; the processing time of each frame is measured with the
+// host's real clock and summarized as packets/s and latency per packet.
+// Finally, the counters of the NAPT-engine and of the clients are requested via
+// DEVICE_COM_PORT just like a monitoring client in the network would do.
+//
+// Translated packets are forwarded by the fast path of napt_netif.c, unless -s
+// is given (forwarding by the emulated ip_forward). The allocated and copied
+// pbufs are counted per forwarded packet. The occupancy of the NAPT-table is
+// sampled every millisecond of the virtual time; -T disables the tracking of
+// the TCP-state by the NAPT-engine for comparison.
+//
+// Synthetic input can be generated with -g: either a number of long flows per
+// client (-w bulk) or HTTP-like connections (-w http; handshake, -p requests
+// and a FIN from the client every 50 ms, to be replayed with -r).
+//
+// Usage: router_sim [-r] [-s] [-T] [-v] [-n repeat] [-o output.pcap] input.pcap
+//        router_sim -g output.pcap [-w bulk|http] [-c clients] [-f flows] [-p packets]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "lwip/netif.h"
+#include "netif/etharp.h"
+#include "napt.h"
+#include "napt_netif.h"
+#include "router.h"
+#include "device_info.h"
+#include "user_config.h"
+#include "pcap.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_FRAME_MAX 2048
+#define SIM_REPLY_QUEUE 64
+
+#define SIM_HTTP_INTERVAL_US 50000  // Interval between two HTTP-like connections
+#define SIM_HTTP_RTT_US 20000       // Delay of the handshake and between requests
+#define SIM_HTTP_CLOSE_US 100000    // Delay of the FIN after the last request
+
+/*------------------------------------*/
+
+struct sim_frame {
+  uint8_t data[SIM_FRAME_MAX];
+  uint16_t len;
+};
+
+// Packet of a generated connection
+struct sim_event {
+  uint64_t ts;
+  uint32_t flow;
+  uint8_t tcp_flags;
+  uint16_t payload;
+};
+
+// Declaration and initialization of variables:
+
+static struct pcap_file sim_output;
+static bool sim_reflect = false;
+static uint64_t sim_ts_us = 0;
+
+static struct sim_frame sim_replies[SIM_REPLY_QUEUE];
+static uint16_t sim_replies_head = 0, sim_replies_count = 0;
+
+static uint64_t *sim_latencies = NULL;
+static uint32_t sim_latencies_count = 0, sim_latencies_size = 0;
+
+static uint64_t sim_occupancy_sum = 0, sim_occupancy_ms = 0;
+static uint16_t sim_occupancy_peak = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static void sim_latency_record(uint64_t ns) {
+  if (sim_latencies_count == sim_latencies_size) {
+    sim_latencies_size = (sim_latencies_size) ? 2 * sim_latencies_size : 65536;
+    sim_latencies = realloc(sim_latencies, sim_latencies_size * sizeof(uint64_t));
+  }
+  sim_latencies[sim_latencies_count++] = ns;
+}
+
+static int sim_latency_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static int sim_event_cmp(const void *a, const void *b) {
+  const struct sim_event *x = (const struct sim_event *) a, *y = (const struct sim_event *) b;
+  return (x->ts > y->ts) - (x->ts < y->ts);
+}
+
+// Advance the virtual time in steps of 1 ms (so that the timers of the router
+// run in between) and sample the occupancy of the NAPT-table
+static void sim_time_advance(uint64_t ts_us) {
+  uint32_t step;
+
+  while (ts_us > sim_ts_us) {
+    step = (ts_us - sim_ts_us > 1000) ? 1000 : ts_us - sim_ts_us;
+    host_time_advance(step);
+    sim_ts_us += step;
+    if (step == 1000) {
+      sim_occupancy_sum += napt_count();
+      sim_occupancy_ms++;
+    }
+    if (napt_count() > sim_occupancy_peak) {
+      sim_occupancy_peak = napt_count();
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Emulation of the external network:
+
+// Turn a packet sent on the station network interface into the peer's reply
+static void sim_reply_queue(const uint8_t *frame, uint16_t len) {
+  struct sim_frame *reply;
+
+  if (sim_replies_count == SIM_REPLY_QUEUE) {
+    return;
+  }
+  reply = &sim_replies[(sim_replies_head + sim_replies_count) % SIM_REPLY_QUEUE];
+  reply->len = host_packet_reply(frame, len, reply->data);
+  if (!reply->len) {
+    return;
+  }
+  sim_replies_count++;
+}
+
+// Frames sent by the router
+static void sim_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  if (sim_output.file) {
+    pcap_write(&sim_output, frame, len, sim_ts_us);
+  }
+  if (sim_reflect && if_index == STATION_IF) {
+    sim_reply_queue(frame, len);
+  }
+}
+
+// Replies sent via DEVICE_COM_PORT
+static void sim_espconn_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  printf("%.*s", (int) len, (const char *) data);
+}
+
+/*------------------------------------*/
+
+// Simulation:
+
+// Pass a frame to the network interface it originates from and measure the
+// processing time
+static void sim_inject(uint8_t *frame, uint16_t len) {
+  struct ip_info softap_info;
+  uint32_t src;
+  uint8_t if_index = STATION_IF;
+  uint64_t start;
+
+  if (len >= SIZEOF_ETH_HDR + 20) {
+    wifi_get_ip_info(SOFTAP_IF, &softap_info);
+    os_memcpy(&src, frame + SIZEOF_ETH_HDR + 12, 4);
+    if ((src & softap_info.netmask.addr) == (softap_info.ip.addr & softap_info.netmask.addr)) {
+      if_index = SOFTAP_IF;
+    }
+  }
+
+  start = host_clock_ns();
+  host_netif_input(if_index, frame, len);
+  sim_latency_record(host_clock_ns() - start);
+}
+
+// Convert a record of the input file to an ethernet-frame
+static uint16_t sim_to_ethernet(uint32_t linktype, const uint8_t *buf, int32_t len, uint8_t *frame) {
+  if (linktype == PCAP_LINKTYPE_ETHERNET) {
+    os_memcpy(frame, buf, len);
+    return len;
+  }
+  if ((linktype == PCAP_LINKTYPE_RAW || linktype == PCAP_LINKTYPE_IPV4) && len + SIZEOF_ETH_HDR <= SIM_FRAME_MAX) {
+    os_memset(frame, 0, SIZEOF_ETH_HDR);
+    frame[12] = ETHTYPE_IP >> 8;
+    frame[13] = ETHTYPE_IP & 0xFF;
+    os_memcpy(frame + SIZEOF_ETH_HDR, buf, len);
+    return len + SIZEOF_ETH_HDR;
+  }
+  return 0;
+}
+
+static int sim_run(const char *input_path, uint32_t repeat) {
+  struct pcap_file input;
+  uint8_t buf[SIM_FRAME_MAX], frame[SIM_FRAME_MAX];
+  uint64_t ts_us, first_ts = 0, pass_offset = 0, total_ns = 0;
+  uint32_t pass, frames = 0, forwarded, idx;
+  int32_t len;
+  uint16_t frame_len;
+  bool first;
+  struct sim_frame *reply;
+
+  for (pass = 0; pass < repeat; pass++) {
+    if (!pcap_open_read(&input, input_path)) {
+      fprintf(stderr, "router_sim: Failed to open %s!\n", input_path);
+      return 1;
+    }
+    // The passes are appended to each other
+    pass_offset = (pass) ? sim_ts_us + 1 : 0;
+    first = true;
+    while ((len = pcap_read(&input, buf, sizeof(buf), &ts_us)) > 0) {
+      if (first) {
+        first_ts = ts_us;
+        first = false;
+      }
+      // Follow the timestamps of the input with the virtual system time
+      ts_us = ts_us - first_ts + pass_offset;
+      sim_time_advance(ts_us);
+
+      frame_len = sim_to_ethernet(input.linktype, buf, len, frame);
+      if (!frame_len) {
+        continue;
+      }
+      sim_inject(frame, frame_len);
+      frames++;
+
+      while (sim_replies_count) {
+        reply = &sim_replies[sim_replies_head];
+        sim_replies_head = (sim_replies_head + 1) % SIM_REPLY_QUEUE;
+        sim_replies_count--;
+        sim_inject(reply->data, reply->len);
+        frames++;
+      }
+    }
+    pcap_close(&input);
+  }
+
+  for (idx = 0; idx < sim_latencies_count; idx++) {
+    total_ns += sim_latencies[idx];
+  }
+  qsort(sim_latencies, sim_latencies_count, sizeof(uint64_t), sim_latency_cmp);
+
+  // Packets forwarded by the fast path don't pass the emulated ip_forward
+  forwarded = host_lwip_stats.forwarded + napt_stats_get()->fastpath;
+
+  printf("frames:      %u\n", frames);
+  printf("forwarded:   %u (fast path %u)\n", forwarded, napt_stats_get()->fastpath);
+  printf("local:       %u\n", host_lwip_stats.local);
+  printf("dropped:     %u\n", frames - forwarded - host_lwip_stats.local);
+  printf("napt:        %u entries\n", napt_count());
+  if (sim_occupancy_ms) {
+    printf("occupancy:   mean %.1f, peak %u entries\n", (double) sim_occupancy_sum / sim_occupancy_ms, sim_occupancy_peak);
+  }
+  if (forwarded) {
+    // The pbuf of every received frame is allocated by the (emulated) driver
+    printf("pbufs:       %.2f allocations, %.2f copies per forwarded packet\n", (double) (host_lwip_stats.pbuf_alloc - frames) / forwarded, (double) host_lwip_stats.pbuf_copy / forwarded);
+  }
+  if (sim_latencies_count) {
+    printf("packets/s:   %.0f\n", 1e9 * sim_latencies_count / (total_ns ? total_ns : 1));
+    printf("latency:     mean %.0f ns, p50 %llu ns, p99 %llu ns\n", (double) total_ns / sim_latencies_count, (unsigned long long) sim_latencies[sim_latencies_count / 2], (unsigned long long) sim_latencies[(uint64_t) sim_latencies_count * 99 / 100]);
+  }
+
+  // Request the counters of the NAPT-engine, the utilization of the memory
+  // pools and the counters of the clients from the router
+  host_espconn_sent_cb = sim_espconn_sent_cb;
+  host_espconn_recv(DEVICE_COM_PORT, (const uint8_t *) "\x0A\x00\x00\x01", DEVICE_COM_PORT, NAPT_STATS_REQUEST_STRING, sizeof(NAPT_STATS_REQUEST_STRING) - 1);
+  host_espconn_recv(DEVICE_COM_PORT, (const uint8_t *) "\x0A\x00\x00\x01", DEVICE_COM_PORT, MEM_STATS_REQUEST_STRING, sizeof(MEM_STATS_REQUEST_STRING) - 1);
+  host_espconn_recv(DEVICE_COM_PORT, (const uint8_t *) "\x0A\x00\x00\x01", DEVICE_COM_PORT, CLIENT_STATS_REQUEST_STRING, sizeof(CLIENT_STATS_REQUEST_STRING) - 1);
+  host_espconn_sent_cb = NULL;
+  return 0;
+}
+
+/*------------------------------------*/
+
+// Generation of synthetic traffic:
+
+// Write a frame of a flow from a client of the soft access-point to the external
+// network
+static void sim_generate_frame(struct pcap_file *pcap, uint32_t clients, uint32_t flow, uint8_t proto, uint8_t tcp_flags, uint16_t payload, uint64_t ts) {
+  uint8_t frame[SIM_FRAME_MAX], softap_mac[6];
+  uint32_t ip_src, ip_dest, rnd;
+  uint16_t len;
+
+  wifi_get_macaddr(SOFTAP_IF, softap_mac);
+  ip_src = ipaddr_addr(WIFI_AP_NETWORK_ADDR);
+  ((uint8_t *) &ip_src)[3] = 2 + flow % clients;
+  rnd = flow * 0x9E3779B1 + 0x7F4A7C15;
+  ip_dest = (rnd & 0xFFFFFF00) | 0x0A;
+  len = host_packet_build(frame, softap_mac, proto, ip_src, 30000 + flow % 30000, ip_dest, (proto == NAPT_PROTO_TCP) ? 443 : 53, tcp_flags, payload);
+  pcap_write(pcap, frame, len, ts);
+}
+
+// Write frames of flows from the clients of the soft access-point to the
+// external network; TCP-flows start with a SYN, followed by data-segments
+static void sim_generate_bulk(struct pcap_file *pcap, uint32_t clients, uint32_t flows, uint32_t packets) {
+  uint32_t flow, packet;
+  uint8_t proto;
+  uint64_t ts = 0;
+
+  for (packet = 0; packet < packets; packet++) {
+    for (flow = 0; flow < flows; flow++) {
+      proto = (flow % 4) ? NAPT_PROTO_TCP : NAPT_PROTO_UDP;
+      sim_generate_frame(pcap, clients, flow, proto, (packet) ? 0x18 : 0x02, (proto == NAPT_PROTO_TCP) ? ((packet) ? 512 : 0) : 64, ts);
+      ts += 100;
+    }
+  }
+}
+
+// Write the client's side of HTTP-like connections, which start every
+// SIM_HTTP_INTERVAL_US: SYN, ACK, the given number of requests and finally a
+// FIN and the ACK of the peer's FIN (the peer's side is emulated by -r)
+static void sim_generate_http(struct pcap_file *pcap, uint32_t clients, uint32_t flows, uint32_t requests) {
+  struct sim_event *events;
+  uint32_t flow, request, count = 0, steps = requests + 4;
+  uint64_t ts;
+
+  events = calloc((uint64_t) flows * steps, sizeof(struct sim_event));
+  if (!events) {
+    return;
+  }
+  for (flow = 0; flow < flows; flow++) {
+    ts = (uint64_t) flow * SIM_HTTP_INTERVAL_US;
+    events[count++] = (struct sim_event) {ts, flow, 0x02, 0};
+    ts += SIM_HTTP_RTT_US;
+    events[count++] = (struct sim_event) {ts, flow, 0x10, 0};
+    for (request = 0; request < requests; request++) {
+      events[count++] = (struct sim_event) {ts + request * SIM_HTTP_RTT_US, flow, 0x18, 256};
+    }
+    ts += requests * SIM_HTTP_RTT_US + SIM_HTTP_CLOSE_US;
+    events[count++] = (struct sim_event) {ts, flow, 0x11, 0};
+    events[count++] = (struct sim_event) {ts + SIM_HTTP_RTT_US, flow, 0x10, 0};
+  }
+  qsort(events, count, sizeof(struct sim_event), sim_event_cmp);
+  for (flow = 0; flow < count; flow++) {
+    sim_generate_frame(pcap, clients, events[flow].flow, NAPT_PROTO_TCP, events[flow].tcp_flags, events[flow].payload, events[flow].ts);
+  }
+  free(events);
+}
+
+static int sim_generate(const char *path, const char *workload, uint32_t clients, uint32_t flows, uint32_t packets) {
+  struct pcap_file pcap;
+  bool http = (os_strcmp(workload, "http") == 0);
+
+  if (!http && os_strcmp(workload, "bulk") != 0) {
+    fprintf(stderr, "router_sim: Unknown workload %s!\n", workload);
+    return 1;
+  }
+  if (!pcap_open_write(&pcap, path, PCAP_LINKTYPE_ETHERNET)) {
+    fprintf(stderr, "router_sim: Failed to create %s!\n", path);
+    return 1;
+  }
+  if (http) {
+    sim_generate_http(&pcap, clients, flows, packets);
+  }
+  else {
+    sim_generate_bulk(&pcap, clients, flows, packets);
+  }
+  pcap_close(&pcap);
+  printf("router_sim: Generated %u frames in %s\n", (http) ? flows * (packets + 4) : flows * packets, path);
+  return 0;
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: router_sim [-r] [-s] [-T] [-v] [-n repeat] [-o output.pcap] input.pcap\n");
+  fprintf(stderr, "       router_sim -g output.pcap [-w bulk|http] [-c clients] [-f flows] [-p packets]\n");
+}
+
+int main(int argc, char **argv) {
+  const char *output_path = NULL, *generate_path = NULL, *workload = "bulk";
+  uint32_t repeat = 1, clients = MAX_CLIENTS, flows = 64, packets = 16;
+  bool stack_forward = false, tcp_tracking = true;
+  int opt, ret;
+
+  while ((opt = getopt(argc, argv, "rsTvn:o:g:w:c:f:p:")) != -1) {
+    switch (opt) {
+      case 'r': sim_reflect = true; break;
+      case 'v': host_verbose = true; break;
+      case 's': stack_forward = true; break;
+      case 'T': tcp_tracking = false; break;
+      case 'n': repeat = strtoul(optarg, NULL, 0); break;
+      case 'o': output_path = optarg; break;
+      case 'g': generate_path = optarg; break;
+      case 'w': workload = optarg; break;
+      case 'c': clients = strtoul(optarg, NULL, 0); break;
+      case 'f': flows = strtoul(optarg, NULL, 0); break;
+      case 'p': packets = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+
+  // Bring the router up like on the device
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  device_info_init();
+  napt_netif_set_fastpath(!stack_forward);
+  napt_set_tcp_tracking(tcp_tracking);
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  if (!is_connected()) {
+    fprintf(stderr, "router_sim: Failed to bring up the router!\n");
+    return 1;
+  }
+
+  if (generate_path) {
+    return sim_generate(generate_path, workload, (clients) ? clients : 1, flows, packets);
+  }
+  if (optind >= argc) {
+    sim_usage();
+    return 1;
+  }
+
+  if (output_path && !pcap_open_write(&sim_output, output_path, PCAP_LINKTYPE_ETHERNET)) {
+    fprintf(stderr, "router_sim: Failed to create %s!\n", output_path);
+    return 1;
+  }
+  host_netif_tx_cb = sim_tx_cb;
+  ret = sim_run(argv[optind], (repeat) ? repeat : 1);
+  pcap_close(&sim_output);
+  free(sim_latencies);
+  return ret;
+}
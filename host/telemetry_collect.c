@@ -0,0 +1,418 @@
+// telemetry_collect.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Decoder and collector of the telemetry frames, that the routers
+// broadcast as vital sign on VITAL_SIGN_PORT (cf. telemetry.h). The frames are
+// aggregated per router (MAC-address): received and lost frames (by the
+// sequence number), restarts (by the uptime), the mean and peak rates per
+// direction, the peak occupancy of the NAPT-table, the minimum free heap, the
+// dropped packets and the last number of clients.
+//
+// With -l, the collector listens on the given UDP-port and prints the table of
+// the routers after every received frame. Otherwise, it tests itself:
+//
+//  - the router is brought up like on the device with -c clients, which send
+//    traffic, and the broadcasts of three intervals are captured and decoded
+//  - -n emulated routers send -f frames each, with lost frames and restarts,
+//    and the aggregation is checked
+//  - the time to build a vital sign as telemetry frame is compared with the
+//    former CSV-line (os_sprintf)
+//
+// Usage: telemetry_collect [-v] [-l port] [-c clients] [-n routers] [-f frames]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "espconn.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "device_info.h"
+#include "telemetry.h"
+#include "uplink_sched.h"
+#include "user_config.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define COLLECT_STATION_ADDR "10.0.0.42"
+#define COLLECT_STATION_NETMASK "255.255.255.0"
+#define COLLECT_STATION_GW "10.0.0.1"
+
+#define COLLECT_ROUTERS_MAX 1024
+#define COLLECT_FRAME_MAX 1500
+#define COLLECT_CAPTURE_MAX 8
+#define COLLECT_ENCODE_ROUNDS 100000
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Aggregate of the frames of a router
+struct collect_router {
+  uint8_t mac[6];
+  uint32_t frames;
+  uint32_t lost;          // Frames missing in the sequence
+  uint32_t restarts;      // Uptime decreased
+  uint16_t seq;           // Sequence number of the last frame
+  uint32_t uptime;        // Uptime of the last sample
+  uint32_t samples;
+  uint64_t rate_sum[2];
+  uint32_t rate_max[2];
+  uint16_t napt_max;
+  uint16_t napt_size;
+  uint32_t heap_min;
+  uint32_t drops;
+  uint8_t clients;        // Clients of the last sample
+  uint8_t flags;          // Flags of the last sample
+};
+
+struct collect_frame {
+  uint8_t data[COLLECT_FRAME_MAX];
+  uint16_t len;
+};
+
+// Declaration and initialization of variables:
+
+static uint32_t failures = 0;
+
+static struct collect_router collect_routers[COLLECT_ROUTERS_MAX];
+static uint32_t collect_routers_count = 0;
+static uint32_t collect_invalid = 0;
+
+static struct collect_frame collect_captured[COLLECT_CAPTURE_MAX];
+static uint8_t collect_captured_count = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Decode the given frame and add it to the aggregate of its router; returns
+// the router resp. NULL, if the frame is invalid
+static struct collect_router *collect_frame(const uint8_t *data, uint16_t len) {
+  struct telemetry_sample samples[TELEMETRY_SAMPLES_MAX];
+  struct telemetry_header header;
+  struct collect_router *router = NULL;
+  uint32_t idx;
+  uint8_t dir;
+
+  if (!telemetry_decode(data, len, &header, samples, TELEMETRY_SAMPLES_MAX)) {
+    collect_invalid++;
+    return NULL;
+  }
+  for (idx = 0; idx < collect_routers_count; idx++) {
+    if (os_memcmp(collect_routers[idx].mac, header.mac, 6) == 0) {
+      router = &collect_routers[idx];
+      break;
+    }
+  }
+  if (!router) {
+    if (collect_routers_count == COLLECT_ROUTERS_MAX) {
+      return NULL;
+    }
+    router = &collect_routers[collect_routers_count++];
+    os_memset(router, 0, sizeof(*router));
+    os_memcpy(router->mac, header.mac, 6);
+    router->heap_min = 0xFFFFFFFF;
+  }
+  else if (header.count && samples[0].uptime < router->uptime) {
+    router->restarts++; // The sequence starts again
+  }
+  else {
+    router->lost += (uint16_t) (header.seq - router->seq - 1);
+  }
+  router->frames++;
+  router->seq = header.seq;
+
+  for (idx = 0; idx < header.count && idx < TELEMETRY_SAMPLES_MAX; idx++) {
+    for (dir = 0; dir < 2; dir++) {
+      router->rate_sum[dir] += samples[idx].rate[dir];
+      if (samples[idx].rate[dir] > router->rate_max[dir]) {
+        router->rate_max[dir] = samples[idx].rate[dir];
+      }
+    }
+    if (samples[idx].napt_entries > router->napt_max) {
+      router->napt_max = samples[idx].napt_entries;
+    }
+    if (samples[idx].free_heap < router->heap_min) {
+      router->heap_min = samples[idx].free_heap;
+    }
+    router->napt_size = samples[idx].napt_size;
+    router->drops += samples[idx].drops;
+    router->uptime = samples[idx].uptime;
+    router->clients = samples[idx].clients;
+    router->flags = samples[idx].flags;
+    router->samples++;
+  }
+  return router;
+}
+
+static void collect_print(void) {
+  const struct collect_router *router;
+  uint32_t idx;
+
+  printf("%-17s %6s %5s %4s %9s %10s %10s %10s %10s %9s %8s %6s %3s\n", "mac", "frames", "lost", "rst", "uptime_s",
+         "rate_out", "max_out", "rate_in", "max_in", "napt_max", "heap_min", "drops", "cl");
+  for (idx = 0; idx < collect_routers_count; idx++) {
+    router = &collect_routers[idx];
+    printf(MACSTR " %6u %5u %4u %9u %10llu %10u %10llu %10u %4u/%-4u %8u %6u %3u\n", MAC2STR(router->mac), router->frames, router->lost,
+           router->restarts, router->uptime, (router->samples) ? (unsigned long long) (router->rate_sum[NAPT_DIR_OUT] / router->samples) : 0,
+           router->rate_max[NAPT_DIR_OUT], (router->samples) ? (unsigned long long) (router->rate_sum[NAPT_DIR_IN] / router->samples) : 0,
+           router->rate_max[NAPT_DIR_IN], router->napt_max, router->napt_size, router->heap_min, router->drops, router->clients);
+  }
+}
+
+// Receive the frames on the given UDP-port until the process is terminated
+static int collect_listen(uint16_t port) {
+  struct sockaddr_in addr;
+  uint8_t data[COLLECT_FRAME_MAX];
+  ssize_t len;
+  int sock;
+
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  os_memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (sock < 0 || bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    fprintf(stderr, "telemetry_collect: Failed to bind to port %u!\n", port);
+    return 1;
+  }
+  printf("telemetry_collect: Listening on port %u\n", port);
+  while ((len = recv(sock, data, sizeof(data), 0)) >= 0) {
+    if (collect_frame(data, len)) {
+      collect_print();
+    }
+    else {
+      printf("telemetry_collect: Ignored an invalid frame of %d bytes (%u so far)\n", (int) len, collect_invalid);
+    }
+    fflush(stdout);
+  }
+  close(sock);
+  return 1;
+}
+
+// Capture the broadcasts of the vital sign
+static void collect_sent_cb(struct espconn *espconn, uint8 *data, uint16 len) {
+  if (espconn->proto.udp->remote_port == VITAL_SIGN_PORT && collect_captured_count < COLLECT_CAPTURE_MAX && len <= COLLECT_FRAME_MAX) {
+    os_memcpy(collect_captured[collect_captured_count].data, data, len);
+    collect_captured[collect_captured_count++].len = len;
+  }
+}
+
+// Bring the router up with the given number of clients, let them send traffic
+// and decode the captured broadcasts of three intervals
+static void collect_test_router(uint8_t clients) {
+  struct telemetry_sample samples[TELEMETRY_SAMPLES_MAX];
+  struct telemetry_header header;
+  uint8_t softap_mac[6], station_mac[6], mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00}, frame[1600];
+  struct ip_info softap_info;
+  uint32_t step, idx, uptime = 0;
+  uint16_t len;
+
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(0);
+  host_wifi_got_ip(ipaddr_addr(COLLECT_STATION_ADDR), ipaddr_addr(COLLECT_STATION_NETMASK), ipaddr_addr(COLLECT_STATION_GW));
+  CHECK(is_connected());
+  wifi_get_macaddr(SOFTAP_IF, softap_mac);
+  wifi_get_macaddr(STATION_IF, station_mac);
+  wifi_get_ip_info(SOFTAP_IF, &softap_info);
+  for (idx = 0; idx < clients; idx++) {
+    mac[5] = 1 + idx;
+    host_wifi_sta_connected(mac);
+  }
+
+  device_info_init();
+  vital_sign_bcast_start();
+  host_espconn_sent_cb = collect_sent_cb;
+
+  // Every client sends a datagram of 1000 bytes per second
+  for (step = 0; step < 3 * VITAL_SIGN_TIME_INTERVAL / 1000; step++) {
+    for (idx = 0; idx < clients; idx++) {
+      len = host_packet_build(frame, softap_mac, NAPT_PROTO_UDP, (softap_info.ip.addr & softap_info.netmask.addr) | ((2 + idx) << 24), 41000,
+                              IPADDR(198, 51, 100, 1), 5683, 0, 1000 - 28);
+      host_netif_input(SOFTAP_IF, frame, len);
+    }
+    host_time_advance(1000000);
+  }
+  host_espconn_sent_cb = NULL;
+  vital_sign_bcast_stop();
+  device_info_disable();
+
+  printf("router: %u frames of %u bytes\n", collect_captured_count, (collect_captured_count) ? collect_captured[0].len : 0);
+  CHECK(collect_captured_count == 3);
+  for (idx = 0; idx < collect_captured_count; idx++) {
+    CHECK(collect_captured[idx].len == TELEMETRY_HEADER_LEN + VITAL_SIGN_SAMPLES * TELEMETRY_SAMPLE_LEN);
+    CHECK(telemetry_decode(collect_captured[idx].data, collect_captured[idx].len, &header, samples, TELEMETRY_SAMPLES_MAX));
+    CHECK(header.version == TELEMETRY_VERSION && header.count == VITAL_SIGN_SAMPLES && header.seq == idx);
+    CHECK(header.interval == VITAL_SIGN_TIME_INTERVAL / VITAL_SIGN_SAMPLES);
+    CHECK(os_memcmp(header.mac, station_mac, 6) == 0);
+    for (step = 0; step < header.count; step++) {
+      if (idx || step) {
+        CHECK(samples[step].uptime == uptime + header.interval / 1000);
+      }
+      uptime = samples[step].uptime;
+      CHECK(samples[step].clients == clients && samples[step].flags == (TELEMETRY_FLAG_CONNECTED | TELEMETRY_FLAG_NAPT));
+      CHECK(samples[step].napt_entries == clients && samples[step].napt_size == NAPT_TABLE_SIZE);
+      CHECK(samples[step].rate[NAPT_DIR_OUT] == clients * 1000 && samples[step].rate[NAPT_DIR_IN] == 0);
+      CHECK(samples[step].free_heap > 0 && samples[step].drops == 0);
+    }
+    collect_frame(collect_captured[idx].data, collect_captured[idx].len);
+  }
+
+  // Truncated and foreign frames are rejected
+  CHECK(!telemetry_decode(collect_captured[0].data, collect_captured[0].len - 1, &header, samples, TELEMETRY_SAMPLES_MAX));
+  CHECK(!telemetry_decode((const uint8_t *) "DEVICE_INFO\n", 12, &header, samples, TELEMETRY_SAMPLES_MAX));
+
+  // Intervals of fractions of a second are kept; the frames of version 1 are
+  // still decoded (their interval has whole seconds)
+  header.interval = 1400;
+  len = telemetry_encode(frame, sizeof(frame), &header, samples);
+  CHECK(telemetry_decode(frame, len, &header, samples, TELEMETRY_SAMPLES_MAX) && header.interval == 1400);
+  os_memmove(frame + TELEMETRY_HEADER_LEN_V1, frame + TELEMETRY_HEADER_LEN, len - TELEMETRY_HEADER_LEN);
+  frame[2] = 1;
+  frame[3] = TELEMETRY_HEADER_LEN_V1;
+  CHECK(telemetry_decode(frame, len - (TELEMETRY_HEADER_LEN - TELEMETRY_HEADER_LEN_V1), &header, samples, TELEMETRY_SAMPLES_MAX));
+  CHECK(header.version == 1 && header.interval == 1000 && samples[0].napt_size == NAPT_TABLE_SIZE);
+}
+
+// Let the given number of emulated routers send the given number of frames
+// each; every 7th frame is lost and the last router restarts halfway
+static void collect_test_routers(uint32_t routers, uint32_t frames) {
+  struct telemetry_sample samples[VITAL_SIGN_SAMPLES];
+  struct telemetry_header header;
+  const struct collect_router *router;
+  uint8_t data[COLLECT_FRAME_MAX];
+  uint32_t frame, idx, lost = 0, restart = frames / 2;
+  uint16_t len;
+
+  collect_routers_count = 0;
+  for (frame = 0; frame < frames; frame++) {
+    for (idx = 0; idx < routers; idx++) {
+      header.count = VITAL_SIGN_SAMPLES;
+      header.seq = (idx == routers - 1 && frame >= restart) ? frame - restart : frame;
+      header.interval = 60000;
+      header.mac[0] = 0x5C;
+      header.mac[1] = 0xCF;
+      header.mac[2] = 0x7F;
+      header.mac[3] = idx >> 16;
+      header.mac[4] = idx >> 8;
+      header.mac[5] = idx;
+      for (len = 0; len < VITAL_SIGN_SAMPLES; len++) {
+        os_memset(&samples[len], 0, sizeof(samples[len]));
+        samples[len].uptime = (header.seq * VITAL_SIGN_SAMPLES + len + 1) * 60;
+        samples[len].rate[NAPT_DIR_OUT] = 1000 * (idx + 1);
+        samples[len].napt_entries = len;
+        samples[len].napt_size = NAPT_TABLE_SIZE;
+        samples[len].free_heap = 20000 + idx;
+      }
+      len = telemetry_encode(data, sizeof(data), &header, samples);
+      if (frame % 7 == 3) {
+        lost++;
+        continue;
+      }
+      CHECK(collect_frame(data, len) != NULL);
+    }
+  }
+
+  printf("routers: %u routers, %u frames, %u lost\n", collect_routers_count, (frames * routers) - lost, lost);
+  CHECK(collect_routers_count == routers);
+  for (idx = 0; idx < collect_routers_count; idx++) {
+    router = &collect_routers[idx];
+    CHECK(router->frames + router->lost == frames || (idx == routers - 1 && router->restarts == (frames > restart + 4)));
+    CHECK(router->rate_max[NAPT_DIR_OUT] == 1000 * (idx + 1) && router->rate_sum[NAPT_DIR_OUT] / router->samples == 1000 * (idx + 1));
+    CHECK(router->napt_max == VITAL_SIGN_SAMPLES - 1 && router->heap_min == 20000 + idx);
+  }
+  if (routers <= 8) {
+    collect_print();
+  }
+}
+
+// Compare the time to build a vital sign as telemetry frame with the time to
+// print the same fields as CSV-line
+static void collect_bench(void) {
+  struct telemetry_sample samples[VITAL_SIGN_SAMPLES];
+  struct telemetry_header header = {0};
+  char csv[VITAL_SIGN_SAMPLES * 80];
+  uint8_t data[COLLECT_FRAME_MAX];
+  uint32_t round, idx;
+  uint16_t len = 0, csv_len = 0;
+  uint64_t start, ns[2];
+
+  header.count = VITAL_SIGN_SAMPLES;
+  for (idx = 0; idx < VITAL_SIGN_SAMPLES; idx++) {
+    telemetry_sample_take(&samples[idx], false);
+  }
+
+  start = host_clock_ns();
+  for (round = 0; round < COLLECT_ENCODE_ROUNDS; round++) {
+    header.seq = round;
+    len = telemetry_encode(data, sizeof(data), &header, samples);
+  }
+  ns[0] = host_clock_ns() - start;
+
+  start = host_clock_ns();
+  for (round = 0; round < COLLECT_ENCODE_ROUNDS; round++) {
+    csv_len = os_sprintf(csv, MACSTR ",%u", MAC2STR(header.mac), round);
+    for (idx = 0; idx < VITAL_SIGN_SAMPLES; idx++) {
+      csv_len += os_sprintf(csv + csv_len, ",%u,%u,%u,%u,%u,%u,%u,%u,%u", samples[idx].uptime, samples[idx].free_heap, samples[idx].napt_entries, samples[idx].napt_size,
+                            samples[idx].rate[NAPT_DIR_OUT], samples[idx].rate[NAPT_DIR_IN], samples[idx].clients, samples[idx].flags, samples[idx].drops);
+    }
+  }
+  ns[1] = host_clock_ns() - start;
+
+  printf("%-10s %6s %10s\n", "encoding", "bytes", "ns/frame");
+  printf("%-10s %6u %10.1f\n", "binary", len, (double) ns[0] / COLLECT_ENCODE_ROUNDS);
+  printf("%-10s %6u %10.1f\n", "csv", csv_len, (double) ns[1] / COLLECT_ENCODE_ROUNDS);
+}
+
+/*------------------------------------*/
+
+static void collect_usage(void) {
+  fprintf(stderr, "Usage: telemetry_collect [-v] [-l port] [-c clients] [-n routers] [-f frames]\n");
+}
+
+int main(int argc, char **argv) {
+  uint32_t port = 0, clients = 3, routers = 100, frames = 20;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vl:c:n:f:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'l': port = strtoul(optarg, NULL, 0); break;
+      case 'c': clients = strtoul(optarg, NULL, 0); break;
+      case 'n': routers = strtoul(optarg, NULL, 0); break;
+      case 'f': frames = strtoul(optarg, NULL, 0); break;
+      default: collect_usage(); return 1;
+    }
+  }
+  if (port > 0xFFFF || clients > MAX_CLIENTS || !routers || routers > COLLECT_ROUTERS_MAX || !frames || frames > 0xFFFF) {
+    collect_usage();
+    return 1;
+  }
+  if (port) {
+    return collect_listen(port);
+  }
+
+  collect_test_router(clients);
+  collect_test_routers(routers, frames);
+  collect_bench();
+
+  if (failures) {
+    printf("telemetry_collect: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,349 @@
+// uplink_sim.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Host-side simulation of the scheduler of the uplink (cf.
+// uplink_sched.c). The router is brought up like on the device and -c + 1
+// clients associate: the first -c ones upload in bulk (full-sized TCP-segments
+// offered at -b bytes/s each), the last one is a portmapped device, which
+// sends a small MQTT-message (TCP, port 8883) every 50 ms. The uplink behind the station network interface is emulated as
+// a FIFO, which sends -l bytes/s and holds up to -q packets (like the queue of
+// the WiFi-driver resp. the host access-point); packets arriving at a full
+// FIFO are dropped.
+//
+// The latency of the MQTT-messages (from the client until they have been sent
+// on the uplink), their loss and the throughput of the bulk upload are
+// measured for these cases:
+//
+//  fifo    - without the scheduler; the queue builds up in the uplink
+//  drr     - the uplink is shaped to -s bytes/s and the clients are
+//            served by deficit-round-robin (without the priority queue)
+//  prio    - like drr, but the portmapped device is sent with priority
+//  limited - like prio, but every bulk upload is limited to -r bytes/s
+//
+// Finally, a bulk client limited to -r bytes/s queues a burst of segments and
+// an unlimited client sends a few segments in between; the queue of the
+// limited client has to drain completely without any further traffic.
+//
+// Usage: uplink_sim [-v] [-b bulk_rate] [-c bulk_clients] [-l link_rate] [-q link_queue] [-r client_rate] [-s sched_rate] [-t duration_ms]
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "napt.h"
+#include "router.h"
+#include "uplink_sched.h"
+#include "user_config.h"
+#include "host_dhcp.h"
+#include "host_packet.h"
+
+/*------------------------------------*/
+
+#define SIM_STATION_ADDR "10.0.0.42"
+#define SIM_STATION_NETMASK "255.255.255.0"
+#define SIM_STATION_GW "10.0.0.1"
+
+#define SIM_FRAME_MAX 1600
+#define SIM_STEP_US 100
+#define SIM_BULK_PAYLOAD 1460
+#define SIM_MQTT_PAYLOAD 60
+#define SIM_MQTT_PORT 8883
+#define SIM_MQTT_INTERVAL_MS 50
+#define SIM_MQTT_MAX 4096
+#define SIM_LINK_QUEUE_MAX 256
+#define SIM_CLIENTS_MAX MAX_CLIENTS
+
+#define SIM_PAYLOAD_OFFSET (14 + 20 + 20)  // Ethernet-, IP- and TCP-header
+
+#define IPADDR(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/*------------------------------------*/
+
+// Emulated client of the soft access-point
+struct sim_client {
+  uint8_t mac[6];
+  uint32_t ip;
+  uint32_t sent;
+};
+
+// Results of a case
+struct sim_result {
+  double p50_ms;
+  double p99_ms;
+  double max_ms;
+  uint32_t mqtt_sent;
+  uint32_t mqtt_lost;
+  uint32_t bulk_rate;   // Throughput of the bulk upload on the uplink (bytes/s)
+};
+
+// Declaration and initialization of variables:
+
+static uint32_t failures = 0;
+static uint32_t sim_bulk_rate = 1000000;
+static uint32_t sim_link_rate = 625000;
+static uint32_t sim_link_queue = 32;
+static uint32_t sim_bulk_clients = 3;
+static uint32_t sim_client_rate = 100000;
+static uint32_t sim_sched_rate = 560000;  // Slightly below sim_link_rate
+static uint32_t sim_duration_ms = 10000;
+
+static struct sim_client sim_clients[SIM_CLIENTS_MAX];
+static struct sim_client *sim_mqtt_client;
+static uint8_t sim_softap_mac[6];
+static uint64_t sim_now_us = 0;
+static uint64_t sim_end_us = 0;         // End of the current case
+
+// Emulated uplink: the times at which the queued packets have been sent
+static uint64_t sim_link_done[SIM_LINK_QUEUE_MAX];
+static uint32_t sim_link_head = 0, sim_link_count = 0;
+static uint64_t sim_link_busy_us = 0;   // The uplink is busy until then
+static uint64_t sim_bulk_bytes = 0;     // Bulk bytes sent on the uplink (all clients)
+
+static double sim_mqtt_latency[SIM_MQTT_MAX];
+static uint32_t sim_mqtt_received = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Frames leaving the station network interface are queued by the emulated
+// uplink; the MQTT-messages carry the time of their transmission
+static void sim_tx_cb(uint8_t if_index, const uint8_t *frame, uint16_t len) {
+  uint64_t start, done, sent_us;
+  uint16_t dport;
+
+  if (if_index != STATION_IF || len < SIM_PAYLOAD_OFFSET + 8) {
+    return;
+  }
+  while (sim_link_count && sim_link_done[sim_link_head] <= sim_now_us) {
+    sim_link_head = (sim_link_head + 1) % SIM_LINK_QUEUE_MAX;
+    sim_link_count--;
+  }
+  dport = (frame[14 + 20 + 2] << 8) | frame[14 + 20 + 3];
+  if (sim_link_count >= sim_link_queue) {
+    return;
+  }
+
+  start = (sim_link_busy_us > sim_now_us) ? sim_link_busy_us : sim_now_us;
+  done = start + (uint64_t) (len - 14) * 1000000 / sim_link_rate;
+  sim_link_busy_us = done;
+  sim_link_done[(sim_link_head + sim_link_count) % SIM_LINK_QUEUE_MAX] = done;
+  sim_link_count++;
+
+  if (dport == SIM_MQTT_PORT) {
+    os_memcpy(&sent_us, frame + SIM_PAYLOAD_OFFSET, 8);
+    if (sent_us && sim_mqtt_received < SIM_MQTT_MAX) {
+      sim_mqtt_latency[sim_mqtt_received++] = (done - sent_us) / 1000.0;
+    }
+  }
+  else if (done <= sim_end_us) {
+    sim_bulk_bytes += len - 14;
+  }
+}
+
+// Send a TCP-segment of the given client from sport (the first one of a flow is
+// a SYN)
+static void sim_client_send(struct sim_client *client, uint16_t sport, uint16_t dport, uint16_t payload) {
+  uint8_t frame[SIM_FRAME_MAX];
+  uint16_t len;
+
+  len = host_packet_build(frame, sim_softap_mac, NAPT_PROTO_TCP, client->ip, sport, IPADDR(93, 184, 216, 34), dport,
+                          (client->sent) ? HOST_PACKET_TCP_ACK | HOST_PACKET_TCP_PSH : HOST_PACKET_TCP_SYN, (client->sent) ? payload : 0);
+  os_memcpy(frame + 6, client->mac, 6);
+  if (client->sent && len >= SIM_PAYLOAD_OFFSET + 8) {
+    os_memcpy(frame + SIM_PAYLOAD_OFFSET, &sim_now_us, 8);
+  }
+  client->sent++;
+  host_netif_input(SOFTAP_IF, frame, len);
+}
+
+static void sim_time_advance(uint32_t us) {
+  sim_now_us += us;
+  host_time_advance(us);
+}
+
+static int sim_latency_cmp(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+/*------------------------------------*/
+
+// Cases:
+
+// Bring a freshly initialized router up and let the clients associate; the
+// bulk uploads are limited to bulk_limit bytes/s
+static void sim_setup(uint32_t sched_rate, bool priority, uint32_t bulk_limit) {
+  struct host_dhcp_reply reply;
+  struct sim_client *client;
+
+  // Start with a freshly initialized router and uplink
+  sim_mqtt_client = &sim_clients[sim_bulk_clients];
+  for (client = sim_clients; client <= sim_mqtt_client; client++) {
+    host_wifi_sta_disconnected(client->mac);
+    os_memset(client, 0, sizeof(struct sim_client));
+    client->mac[0] = 0x02;
+    client->mac[5] = client - sim_clients + 1;
+  }
+  sim_link_head = sim_link_count = 0;
+  sim_link_busy_us = sim_bulk_bytes = 0;
+  sim_mqtt_received = 0;
+
+  wifi_set_opmode(STATION_MODE);
+  router_init();
+  uplink_sched_set_rate(sched_rate);
+  uplink_sched_set_priority(priority);
+  host_wifi_got_ip(ipaddr_addr(SIM_STATION_ADDR), ipaddr_addr(SIM_STATION_NETMASK), ipaddr_addr(SIM_STATION_GW));
+  CHECK(is_connected());
+  wifi_get_macaddr(SOFTAP_IF, sim_softap_mac);
+  for (client = sim_clients; client <= sim_mqtt_client; client++) {
+    CHECK(host_wifi_sta_connected(client->mac));
+    CHECK(host_dhcp_exchange(HOST_DHCP_DISCOVER, client->mac, 0, 0, 0, &reply) && reply.type == HOST_DHCP_OFFER);
+    CHECK(host_dhcp_exchange(HOST_DHCP_REQUEST, client->mac, 0, reply.yiaddr, reply.server, &reply) && reply.type == HOST_DHCP_ACK);
+    client->ip = reply.yiaddr;
+    if (client != sim_mqtt_client) {
+      uplink_sched_set_client_rate(client->mac, bulk_limit);
+    }
+  }
+  CHECK(napt_portmap_add(NAPT_PROTO_TCP, ipaddr_addr(SIM_STATION_ADDR), SIM_MQTT_PORT, sim_mqtt_client->ip, SIM_MQTT_PORT, NAPT_PORTMAP_DIR_OUT));
+}
+
+// Run the bulk upload and the MQTT-messages for the configured duration
+static void sim_run(const char *name, uint32_t sched_rate, bool priority, uint32_t bulk_limit, struct sim_result *result) {
+  struct sim_client *client;
+  uint64_t bulk_credit = 0;
+  uint32_t step;
+
+  sim_setup(sched_rate, priority, bulk_limit);
+  sim_end_us = sim_now_us + (uint64_t) sim_duration_ms * 1000;
+
+  // Every bulk upload offers sim_bulk_rate bytes/s, the portmapped device
+  // sends a message every SIM_MQTT_INTERVAL_MS
+  for (step = 0; step < sim_duration_ms * 1000 / SIM_STEP_US; step++) {
+    bulk_credit += (uint64_t) sim_bulk_rate * SIM_STEP_US;
+    while (bulk_credit >= (uint64_t) (SIM_BULK_PAYLOAD + 40) * 1000000) {
+      bulk_credit -= (uint64_t) (SIM_BULK_PAYLOAD + 40) * 1000000;
+      for (client = sim_clients; client < sim_mqtt_client; client++) {
+        sim_client_send(client, 40000, 443, SIM_BULK_PAYLOAD);
+      }
+    }
+    if (step % (SIM_MQTT_INTERVAL_MS * 1000 / SIM_STEP_US) == SIM_STEP_US / 2) {
+      sim_client_send(sim_mqtt_client, SIM_MQTT_PORT, SIM_MQTT_PORT, SIM_MQTT_PAYLOAD);
+    }
+    sim_time_advance(SIM_STEP_US);
+  }
+  for (client = sim_clients; client < sim_mqtt_client; client++) {
+    uplink_sched_set_client_rate(client->mac, 0);
+  }
+  napt_portmap_remove(NAPT_PROTO_TCP, SIM_MQTT_PORT);
+
+  // The first message of the MQTT-client is the SYN
+  qsort(sim_mqtt_latency, sim_mqtt_received, sizeof(double), sim_latency_cmp);
+  os_memset(result, 0, sizeof(struct sim_result));
+  result->mqtt_sent = sim_mqtt_client->sent - 1;
+  result->mqtt_lost = result->mqtt_sent - sim_mqtt_received;
+  if (sim_mqtt_received) {
+    result->p50_ms = sim_mqtt_latency[sim_mqtt_received / 2];
+    result->p99_ms = sim_mqtt_latency[(uint64_t) sim_mqtt_received * 99 / 100];
+    result->max_ms = sim_mqtt_latency[sim_mqtt_received - 1];
+  }
+  result->bulk_rate = sim_bulk_bytes * 1000 / sim_duration_ms;
+  printf("%-8s %8.2f %8.2f %8.2f %6u/%-6u %10u\n", name, result->p50_ms, result->p99_ms, result->max_ms, result->mqtt_lost, result->mqtt_sent, result->bulk_rate);
+}
+
+// Queue a burst of the first (limited) bulk client, let the second (unlimited)
+// one send a few segments in between and check, that the burst is sent
+// completely without any further traffic; returns the packets, that are still
+// queued
+static uint16_t sim_burst(void) {
+  const struct uplink_sched_stats *stats = uplink_sched_stats_get();
+  uint32_t idx, sent;
+
+  // The uplink refills its burst within a millisecond (the resolution of the
+  // timer), so that the segments of the unlimited client queued behind the
+  // first ones are sent together, once it resumes
+  sim_setup(UPLINK_SCHED_BURST * 1000, true, sim_client_rate);
+  uplink_sched_set_client_rate(sim_clients[1].mac, 0);
+  sent = stats->sent;
+  for (idx = 0; idx < UPLINK_SCHED_QUEUE_LEN; idx++) {
+    sim_client_send(&sim_clients[0], 40000, 443, SIM_BULK_PAYLOAD);
+  }
+  for (idx = 0; idx < 4; idx++) {
+    sim_client_send(&sim_clients[1], 40000, 443, SIM_BULK_PAYLOAD);
+  }
+  for (idx = 0; idx < 1000; idx++) {
+    sim_time_advance(1000);
+  }
+  uplink_sched_set_client_rate(sim_clients[0].mac, 0);
+  napt_portmap_remove(NAPT_PROTO_TCP, SIM_MQTT_PORT);
+
+  printf("%-8s %u of %u packets sent, %u queued\n", "burst", stats->sent - sent, UPLINK_SCHED_QUEUE_LEN + 4, stats->backlog);
+  CHECK(stats->sent - sent == UPLINK_SCHED_QUEUE_LEN + 4);
+  return stats->backlog;
+}
+
+/*------------------------------------*/
+
+static void sim_usage(void) {
+  fprintf(stderr, "Usage: uplink_sim [-v] [-b bulk_rate] [-c bulk_clients] [-l link_rate] [-q link_queue] [-r client_rate] [-s sched_rate] [-t duration_ms]\n");
+}
+
+int main(int argc, char **argv) {
+  struct sim_result fifo, drr, prio, limited;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "vb:c:l:q:r:s:t:")) != -1) {
+    switch (opt) {
+      case 'v': host_verbose = true; break;
+      case 'b': sim_bulk_rate = strtoul(optarg, NULL, 0); break;
+      case 'c': sim_bulk_clients = strtoul(optarg, NULL, 0); break;
+      case 'l': sim_link_rate = strtoul(optarg, NULL, 0); break;
+      case 'q': sim_link_queue = strtoul(optarg, NULL, 0); break;
+      case 'r': sim_client_rate = strtoul(optarg, NULL, 0); break;
+      case 's': sim_sched_rate = strtoul(optarg, NULL, 0); break;
+      case 't': sim_duration_ms = strtoul(optarg, NULL, 0); break;
+      default: sim_usage(); return 1;
+    }
+  }
+  if (!sim_bulk_rate || !sim_bulk_clients || sim_bulk_clients >= SIM_CLIENTS_MAX || !sim_link_rate || !sim_link_queue || sim_link_queue > SIM_LINK_QUEUE_MAX || !sim_client_rate || !sim_sched_rate || sim_duration_ms < 1000 || sim_duration_ms / SIM_MQTT_INTERVAL_MS >= SIM_MQTT_MAX) {
+    sim_usage();
+    return 1;
+  }
+  host_netif_tx_cb = sim_tx_cb;
+
+  printf("%-8s %8s %8s %8s %13s %10s\n", "case", "p50_ms", "p99_ms", "max_ms", "mqtt_lost", "bulk_B/s");
+  sim_run("fifo", 0, false, 0, &fifo);
+  sim_run("drr", sim_sched_rate, false, 0, &drr);
+  sim_run("prio", sim_sched_rate, true, 0, &prio);
+  sim_run("limited", sim_sched_rate, true, sim_client_rate, &limited);
+  CHECK(sim_burst() == 0);
+
+  // With the scheduler, the MQTT-messages neither wait behind the bulk uploads
+  // nor get lost, while the bulk uploads still get the rest of the uplink; with
+  // the priority queue, they don't wait for the round of the other clients
+  if (sim_bulk_rate * sim_bulk_clients > sim_link_rate && sim_sched_rate < sim_link_rate) {
+    CHECK(drr.mqtt_lost == 0 && prio.mqtt_lost == 0 && limited.mqtt_lost == 0);
+    CHECK(drr.p99_ms * 4 < fifo.p99_ms);
+    CHECK(prio.p99_ms <= drr.p99_ms);
+    CHECK(prio.p99_ms < 10.0);
+    CHECK(drr.bulk_rate > sim_sched_rate * 9 / 10 && prio.bulk_rate > sim_sched_rate * 9 / 10);
+  }
+  if (sim_client_rate * sim_bulk_clients < sim_sched_rate) {
+    CHECK(limited.bulk_rate <= sim_client_rate * sim_bulk_clients * 21 / 20 && limited.bulk_rate >= sim_client_rate * sim_bulk_clients * 9 / 10);
+  }
+
+  if (failures) {
+    printf("uplink_sim: %u check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+// addr_pool.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __ADDR_POOL_H__
+#define __ADDR_POOL_H__
+
+#include "c_types.h"
+#include "user_config.h"
+
+/*------------- defines --------------*/
+
+#define ADDR_POOL_WORDS (ADDR_POOL_MAX / 32)
+
+/*-------- structs and types ---------*/
+
+// Range of addresses of a network with a bitmap of the free ones; bit n of
+// summary is set, if word n of the bitmap has a free address
+struct addr_pool {
+  uint32_t start;                   // First address (host byte order)
+  uint16_t size;                    // Number of addresses (at most ADDR_POOL_MAX)
+  uint16_t used;
+  uint32_t summary;
+  uint32_t free[ADDR_POOL_WORDS];   // Bit set = free
+};
+
+/*------------ functions -------------*/
+
+bool addr_pool_init(struct addr_pool *pool, uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop);
+bool addr_pool_contains(const struct addr_pool *pool, uint32_t ip);
+bool addr_pool_is_free(const struct addr_pool *pool, uint32_t ip);
+bool addr_pool_take(struct addr_pool *pool, uint32_t ip);
+void addr_pool_release(struct addr_pool *pool, uint32_t ip);
+uint32_t addr_pool_alloc(struct addr_pool *pool);
+
+#endif
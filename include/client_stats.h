@@ -0,0 +1,46 @@
+// client_stats.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __CLIENT_STATS_H__
+#define __CLIENT_STATS_H__
+
+#include "c_types.h"
+
+/*-------- structs and types ---------*/
+
+// Counters of a client of the soft access-point (cf. client_stats_next); the
+// directions are the ones of the NAPT-engine (cf. NAPT_DIR_*)
+struct client_stats {
+  uint8_t mac[6];
+  uint8_t aid;              // Association-ID (0, if the station isn't associated)
+  uint8_t valid;            // Slot is in use
+  uint32_t ip;              // Address of the client in network byte order (0, if unknown)
+  uint32_t packets[2];      // Forwarded packets per direction
+  uint32_t bytes[2];        // Forwarded bytes per direction (IP-packets)
+  uint32_t rate[2];         // Rolling rate per direction (in bytes/s)
+  uint32_t window_bytes[2]; // Bytes forwarded in the current window of the rate
+  uint32_t window_start;    // Start of the current window (system time in us)
+  uint16_t napt_entries;    // Active translation entries of the client
+};
+
+/*------------ functions -------------*/
+
+uint8_t client_stats_count(void);
+uint8_t client_stats_slot(const struct client_stats *client);
+const struct client_stats *client_stats_lookup(uint32_t ip);
+const struct client_stats *client_stats_lookup_mac(const uint8_t *mac);
+const struct client_stats *client_stats_next(const struct client_stats *client);
+
+struct client_stats *client_stats_get(uint32_t ip, const uint8_t *mac);
+void client_stats_record(struct client_stats *client, uint8_t dir, uint16_t len);
+void client_stats_napt(uint32_t ip, int8_t delta);
+void client_stats_napt_reset(void);
+
+void client_stats_connect(const uint8_t *mac, uint8_t aid, uint32_t ip);
+void client_stats_disconnect(const uint8_t *mac);
+void client_stats_init(void);
+
+#endif
@@ -0,0 +1,92 @@
+// config.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define CONFIG_SSID_PREFIX_LEN 16 // Including the termination; at most 13
+                                  // characters are used, since the SSID (32
+                                  // bytes) gets "_" and the MAC-address
+                                  // attached
+#define CONFIG_PASSWORD_LEN 64    // Including the termination
+#define CONFIG_MESH_KEY_LEN 64    // Including the termination; at least 8
+                                  // characters, if mesh is set
+#define CONFIG_PORTMAPS_MAX 8
+#define CONFIG_CLIENT_RATES_MAX 4
+#define CONFIG_RATE_MIN 1500      // Minimum rate of the uplink resp. a client
+                                  // (in bytes/s; one packet of the MTU)
+
+/*-------- structs and types ---------*/
+
+// Portmap entry of the configuration (cf. PORTMAP_TABLE in user_config.h)
+struct config_portmap {
+  uint32_t daddr;         // Destination address in network byte order
+  uint16_t mport;
+  uint16_t dport;
+  uint8_t proto;          // 0, if the entry is unused
+  uint8_t dir;
+  uint16_t reserved;
+};
+
+// Rate limit of a client on the uplink (cf. uplink_sched_set_client_rate)
+struct config_client_rate {
+  uint8_t mac[6];
+  uint16_t reserved;
+  uint32_t rate;          // In bytes/s; 0, if the entry is unused
+};
+
+// Runtime configuration of the router; the defaults are taken from
+// user_config.h (addresses in network byte order, times in ms)
+struct config {
+  char ssid_prefix[CONFIG_SSID_PREFIX_LEN];
+  char password[CONFIG_PASSWORD_LEN];
+  uint8_t ap_open;
+  uint8_t ap_hidden;
+  uint8_t max_clients;    // At most MAX_CLIENTS
+  uint8_t mesh;           // 1 = mesh-node (cf. mesh.c)
+  char mesh_key[CONFIG_MESH_KEY_LEN]; // Shared key of the mesh-nodes
+  uint32_t ap_addr;
+  uint32_t ap_netmask;
+  uint32_t ap_gw;
+  uint32_t dhcp_start;
+  uint32_t dhcp_stop;
+  uint32_t dns_server;    // 0 = Google's DNS-server (8.8.8.8)
+  uint32_t conn_timeout;
+  uint32_t reconnect_timeout;
+  uint32_t vital_sign_interval;
+  uint32_t uplink_rate;   // Rate of the uplink's scheduler (in bytes/s; 0 =
+                          // disabled, cf. uplink_sched.c)
+  struct config_portmap portmap[CONFIG_PORTMAPS_MAX];
+  struct config_client_rate client_rate[CONFIG_CLIENT_RATES_MAX];
+};
+
+// Statistics of the configuration store (cf. config_stats_get)
+struct config_stats {
+  uint32_t load_us;       // Duration of the last config_load
+  uint32_t seq;           // Sequence number of the loaded resp. saved record
+  uint8_t slot;           // Sector (0 = A, 1 = B) of the loaded resp. saved
+                          // record; 0xFF, if the defaults are used
+  uint32_t saves;
+};
+
+/*------------ functions -------------*/
+
+const struct config *config_get(void);
+const struct config_stats *config_stats_get(void);
+uint32_t config_flash_sector(uint8_t below);
+bool config_check(const struct config *config);
+uint16_t config_print(char *buffer, uint16_t size);
+
+bool config_set(const char *key, const char *value);
+void config_reset(void);
+bool config_save(void);
+bool config_load(void);
+
+#endif
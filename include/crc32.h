@@ -0,0 +1,16 @@
+// crc32.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include "c_types.h"
+
+/*------------ functions -------------*/
+
+uint32_t crc32(const uint8_t *data, uint16_t len);
+
+#endif
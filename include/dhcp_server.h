@@ -0,0 +1,36 @@
+// dhcp_server.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __DHCP_SERVER_H__
+#define __DHCP_SERVER_H__
+
+#include "c_types.h"
+
+/*-------- structs and types ---------*/
+
+// Counters of the DHCP-server (cf. dhcp_server_stats_get)
+struct dhcp_server_stats {
+  uint32_t requests;  // Messages received from the clients
+  uint32_t offers;    // DHCPOFFERs sent
+  uint32_t acks;      // DHCPACKs sent
+  uint32_t naks;      // DHCPNAKs sent
+  uint32_t drops;     // Invalid messages resp. messages of unknown stations
+  uint32_t saves;     // Writes of the lease store to the flash
+};
+
+/*------------ functions -------------*/
+
+uint16_t dhcp_server_count(void);
+uint32_t dhcp_server_lookup(const uint8_t *mac);
+bool dhcp_server_is_mesh_node(uint32_t ip);
+const struct dhcp_server_stats *dhcp_server_stats_get(void);
+
+void dhcp_server_set_dns(uint32_t dns);
+void dhcp_server_flush(void);
+bool dhcp_server_start(uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop);
+void dhcp_server_stop(void);
+
+#endif
@@ -0,0 +1,33 @@
+// dns_proxy.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __DNS_PROXY_H__
+#define __DNS_PROXY_H__
+
+#include "c_types.h"
+
+/*-------- structs and types ---------*/
+
+// Counters of the DNS-proxy (cf. dns_proxy_stats_get)
+struct dns_proxy_stats {
+  uint32_t queries;   // Queries received from the clients
+  uint32_t hits;      // Queries answered from the cache
+  uint32_t coalesced; // Queries attached to a pending query to the upstream server
+  uint32_t upstream;  // Queries forwarded to the upstream server
+  uint32_t answers;   // Answers received from the upstream server
+  uint32_t drops;     // Invalid queries resp. answers and queries, that couldn't be forwarded
+};
+
+/*------------ functions -------------*/
+
+uint16_t dns_proxy_count(void);
+const struct dns_proxy_stats *dns_proxy_stats_get(void);
+
+void dns_proxy_flush(void);
+bool dns_proxy_enable(uint32_t upstream);
+void dns_proxy_disable(void);
+
+#endif
@@ -12,6 +12,7 @@
 typedef void (*esptouch_StartCallback)(void *arg);
 typedef void (*esptouch_FailCallback)(void *arg);
 typedef void (*esptouch_SuccessCallback)(void *arg);
+typedef void (*esptouch_DoneCallback)(bool success);
 
 struct esptouch_cb {
   esptouch_StartCallback esptouch_start_cb;
@@ -24,6 +25,6 @@ struct esptouch_cb {
 bool esptouch_is_running(void);
 bool esptouch_was_successful(void);
 void esptouch_disable(void);
-void esptouch_init(void);
+void esptouch_init(esptouch_DoneCallback done_cb);
 
 #endif
@@ -0,0 +1,18 @@
+// fast_boot.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __FAST_BOOT_H__
+#define __FAST_BOOT_H__
+
+#include "c_types.h"
+
+/*------------ functions -------------*/
+
+bool fast_boot_connect(void);
+void fast_boot_save(void);
+void fast_boot_stop(void);
+
+#endif
@@ -0,0 +1,60 @@
+// flow_cache.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __FLOW_CACHE_H__
+#define __FLOW_CACHE_H__
+
+#include "c_types.h"
+
+struct napt_entry;
+
+/*-------- structs and types ---------*/
+
+// 5-tuple of a received packet (addresses and ports in network byte order) and
+// the network interface, on which it has been received
+struct flow_cache_key {
+  uint32_t src;
+  uint32_t dest;
+  uint16_t sport;
+  uint16_t dport;
+  uint8_t proto;    // 0, if the packet can't be cached
+  uint8_t if_idx;
+};
+
+// Cached translation and next hop of a flow
+struct flow_cache_entry {
+  struct flow_cache_key key;
+  uint32_t addr;            // Translated address (source of outbound resp.
+  uint16_t port;            // destination of inbound packets) and port
+  uint8_t mac[6];           // MAC-address of the next hop
+  uint32_t nexthop;         // Next hop on the other network interface
+  uint32_t ip_delta;        // Checksum-deltas of the rewrite (address resp.
+  uint32_t l4_delta;        // pseudo-header and port; cf. napt_chksum.c)
+  uint32_t time;            // Time of the insertion (system time in ms)
+  struct napt_entry *entry; // Translation entry (NULL for portmaps)
+};
+
+// Counters of the cache (cf. flow_cache_stats_get)
+struct flow_cache_stats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t inserts;
+  uint32_t deferred;      // Insertions deferred until the second miss of a flow
+  uint32_t invalidations; // Entries removed by flow_cache_invalidate resp. flushes
+};
+
+/*------------ functions -------------*/
+
+struct flow_cache_entry *flow_cache_lookup(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, struct flow_cache_key *key);
+void flow_cache_apply(const struct flow_cache_entry *flow, uint8_t *iphdr);
+struct flow_cache_entry *flow_cache_insert(const struct flow_cache_key *key, struct napt_entry *entry, const uint8_t *iphdr, uint32_t nexthop, const uint8_t *mac);
+const struct flow_cache_stats *flow_cache_stats_get(void);
+
+void flow_cache_invalidate(const struct napt_entry *entry);
+void flow_cache_flush(void);
+void flow_cache_set_enabled(bool enabled);
+
+#endif
@@ -0,0 +1,19 @@
+// hmac_sha256.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-16
+
+#ifndef __HMAC_SHA256_H__
+#define __HMAC_SHA256_H__
+
+#include "c_types.h"
+
+#define SHA256_DIGEST_LEN 32
+
+/*------------ functions -------------*/
+
+void sha256(const uint8_t *data, uint16_t len, uint8_t *digest);
+void hmac_sha256(const uint8_t *key, uint16_t key_len, const uint8_t *data, uint16_t len, uint8_t *mac);
+
+#endif
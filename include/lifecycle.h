@@ -0,0 +1,62 @@
+// lifecycle.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __LIFECYCLE_H__
+#define __LIFECYCLE_H__
+
+#include "c_types.h"
+
+/*-------- structs and types ---------*/
+
+// States of the router (cf. lifecycle.c)
+enum lifecycle_state {
+  LIFECYCLE_IDLE,         // Waiting for the actuation of the pushbutton
+  LIFECYCLE_FAST_BOOT,    // Connecting with the cached credentials
+  LIFECYCLE_PROVISIONING, // ESP-TOUCH is running
+  LIFECYCLE_CONNECTING,   // ESP-TOUCH succeeded, the router isn't up yet
+  LIFECYCLE_ONLINE,       // Connected to the host access-point and forwarding
+  LIFECYCLE_RECONNECTING  // Disconnected from the host access-point
+};
+
+// Events driving the state machine
+enum lifecycle_event {
+  LIFECYCLE_EVENT_BUTTON,           // Pushbutton actuated
+  LIFECYCLE_EVENT_ESPTOUCH_SUCCESS, // ESP-TOUCH established the connection
+  LIFECYCLE_EVENT_ESPTOUCH_FAIL,    // ESP-TOUCH gave up
+  LIFECYCLE_EVENT_CONNECTED,        // Router set up on the host access-point (cf. router.c)
+  LIFECYCLE_EVENT_DISCONNECTED,     // Connection to the host access-point lost
+  LIFECYCLE_EVENT_TIMEOUT           // Connection not (re-)established in time
+};
+
+// Actions of the device on the transitions (cf. user_main.c)
+struct lifecycle_hooks {
+  bool (*enable)(void);     // Initialize the router
+  bool (*fast_boot)(void);  // Connect with the cached credentials (false, if there are none)
+  bool (*provision)(void);  // Start ESP-TOUCH
+  void (*online)(void);     // Start the services of the enabled router
+  void (*disable)(void);    // Restore the initial state of the device
+};
+
+// Counters of the state machine (cf. lifecycle_stats_get)
+struct lifecycle_stats {
+  uint32_t fast_boots;    // Activations with the cached credentials
+  uint32_t fallbacks;     // Fast boots, that fell back to ESP-TOUCH
+  uint32_t provisionings; // Activations via ESP-TOUCH (including the fallbacks)
+  uint32_t up_time;       // Time from the last actuation of the pushbutton
+                          // until the router came up (in ms)
+  bool up_fast;           // The router came up with the cached credentials
+};
+
+/*------------ functions -------------*/
+
+enum lifecycle_state lifecycle_state_get(void);
+const char *lifecycle_state_name(enum lifecycle_state state);
+const struct lifecycle_stats *lifecycle_stats_get(void);
+
+void lifecycle_event(enum lifecycle_event event);
+void lifecycle_init(const struct lifecycle_hooks *hooks);
+
+#endif
@@ -0,0 +1,105 @@
+// log.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Every module defines LOG_MODULE (one of LOG_MODULE_*) before including this
+// header; messages of levels above LOG_LEVEL resp. of modules missing from
+// LOG_MODULES (cf. user_config.h) compile away completely.
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+
+/*------------- defines --------------*/
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_MODULE_MAIN 0x0001        // user_main.c
+#define LOG_MODULE_ROUTER 0x0002      // router.c
+#define LOG_MODULE_DEVICE_INFO 0x0004 // device_info.c, telemetry.c
+#define LOG_MODULE_ESP_TOUCH 0x0008   // esp_touch.c
+#define LOG_MODULE_LIFECYCLE 0x0010   // lifecycle.c, fast_boot.c
+#define LOG_MODULE_DHCP 0x0020        // dhcp_server.c, addr_pool.c
+#define LOG_MODULE_DNS 0x0040         // dns_proxy.c
+#define LOG_MODULE_NAPT 0x0080        // napt.c, napt_netif.c, flow_cache.c
+#define LOG_MODULE_UPLINK 0x0100      // uplink_sched.c
+#define LOG_MODULE_MEM 0x0200         // mem_pool.c
+#define LOG_MODULE_LOG 0x0400         // log.c
+#define LOG_MODULE_CONFIG 0x0800      // config.c
+#define LOG_MODULE_MESH 0x1000        // mesh.c
+#define LOG_MODULE_CLIENTS 0x2000     // client_stats.c
+#define LOG_MODULE_ALL 0xFFFF
+
+#define LOG_SINK_UART 0x01  // os_printf
+#define LOG_SINK_RING 0x02  // RAM ring buffer (cf. log_dump; requires LOG_RING)
+
+#define LOG_LINE_MAX 192    // Maximum length of a formatted message
+
+/*-------- structs and types ---------*/
+
+// Counters of the logging (cf. log_stats_get)
+struct log_stats {
+  uint32_t messages;    // Messages written to any sink
+  uint32_t uart_bytes;  // Characters printed to the UART
+};
+
+/*------------ variables -------------*/
+
+extern uint8_t log_sinks;
+extern char log_line[LOG_LINE_MAX];
+
+/*------------ functions -------------*/
+
+void log_write(uint8_t level, uint16_t len);
+uint16_t log_dump(char *buffer, uint16_t size);
+const struct log_stats *log_stats_get(void);
+void log_set_sinks(uint8_t sinks);
+
+/*-------------- macros --------------*/
+
+#ifndef LOG_MODULE
+#error "Please define LOG_MODULE before including log.h!"
+#endif
+
+// The message is formatted once into log_line (truncated to LOG_LINE_MAX) and
+// handed to the enabled sinks
+#define LOG_WRITE(level, ...) do { if (log_sinks) { log_write(level, os_snprintf(log_line, LOG_LINE_MAX, __VA_ARGS__)); } } while (0)
+
+// Disabled messages are eliminated as dead code (their arguments stay
+// referenced, so that no variable becomes unused)
+#define LOG_NONE(...) do { if (0) { os_printf(__VA_ARGS__); } } while (0)
+
+#if (LOG_MODULES & LOG_MODULE) && LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_WRITE(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_NONE(__VA_ARGS__)
+#endif
+
+#if (LOG_MODULES & LOG_MODULE) && LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_WRITE(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_NONE(__VA_ARGS__)
+#endif
+
+#if (LOG_MODULES & LOG_MODULE) && LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_WRITE(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_NONE(__VA_ARGS__)
+#endif
+
+#if (LOG_MODULES & LOG_MODULE) && LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_WRITE(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_NONE(__VA_ARGS__)
+#endif
+
+#endif
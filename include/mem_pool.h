@@ -0,0 +1,55 @@
+// mem_pool.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define MEM_POOL_BLOCK_NONE 0xFFFF  // Marks the end of the free-list
+
+// Size of a block of the given object size (aligned to 4 bytes)
+#define MEM_POOL_BLOCK_SIZE(size) ((uint16_t) ((((size) + 3) / 4) * 4))
+
+// Define a pool with static storage for count objects of the given size
+#define MEM_POOL_DEFINE(pool, size, count) \
+  static uint32_t pool##_storage[MEM_POOL_BLOCK_SIZE(size) / 4 * (count)]; \
+  struct mem_pool pool = {#pool, (uint8_t *) pool##_storage, MEM_POOL_BLOCK_SIZE(size), (count)}
+
+/*-------- structs and types ---------*/
+
+// Pool of fixed-size blocks; the unused blocks are chained into a free-list by
+// their index (stored in the first two bytes of each unused block)
+struct mem_pool {
+  const char *name;
+  uint8_t *storage;     // blocks * block_size bytes
+  uint16_t block_size;
+  uint16_t blocks;
+  uint16_t used;        // Currently allocated blocks
+  uint16_t high_water;  // Maximum number of simultaneously allocated blocks
+  uint32_t failures;    // Allocations, that failed since the pool was empty
+  uint16_t free_head;
+  bool initialized;
+  struct mem_pool *next;  // Next registered pool (cf. mem_pool_first)
+};
+
+/*------------ variables -------------*/
+
+extern struct mem_pool mem_pool_timers;
+extern struct mem_pool mem_pool_espconn;
+extern struct mem_pool mem_pool_esp_udp;
+
+/*------------ functions -------------*/
+
+void mem_pool_init(struct mem_pool *pool);
+void *mem_pool_alloc(struct mem_pool *pool);
+void mem_pool_free(struct mem_pool *pool, void *block);
+uint16_t mem_pool_index(struct mem_pool *pool, const void *block);
+const struct mem_pool *mem_pool_first(void);
+
+#endif
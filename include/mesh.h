@@ -0,0 +1,61 @@
+// mesh.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-16
+
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include "c_types.h"
+
+/*-------- structs and types ---------*/
+
+// Route to the network of a downstream router (addresses in network byte
+// order)
+struct mesh_route {
+  uint32_t network;
+  uint32_t netmask;
+  uint32_t nexthop;   // Address of the downstream router on the soft access-
+                      // point's network; 0, if the slot is unused
+  uint32_t seq;       // Sequence number of the last advertisement of the
+                      // next hop
+  uint8_t ttl;        // Remaining intervals until the route expires
+};
+
+// Counters of the mesh-routing (cf. mesh_stats_get)
+struct mesh_stats {
+  uint32_t routed[2];       // Packets forwarded without translation per
+                            // direction (cf. NAPT_DIR_*)
+  uint32_t lateral;         // Packets from the soft access-point's side to
+                            // downstream networks (cf. mesh_lateral_lookup)
+  uint32_t adverts_sent;
+  uint32_t adverts_recv;
+  uint32_t adverts_ignored; // Advertisements of other clients than mesh-nodes,
+                            // without a valid MAC resp. replayed ones
+  uint32_t acks_ignored;    // Acknowledgements without a valid MAC resp. of an
+                            // older advertisement
+  uint32_t acks_recv;
+  uint32_t routes_added;
+  uint32_t routes_expired;  // Without advertisements resp. with the lease of
+                            // the next hop
+  uint32_t routes_rejected; // Invalid resp. overlapping routes or full table
+};
+
+/*------------ functions -------------*/
+
+uint32_t mesh_route_lookup(uint32_t addr);
+uint32_t mesh_lateral_lookup(const uint8_t *iphdr, uint16_t len);
+bool mesh_is_routed(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, uint32_t ext_addr, uint32_t downstream);
+
+bool mesh_is_routing(void);
+uint8_t mesh_route_count(void);
+const struct mesh_route *mesh_route_get(uint8_t idx);
+const struct mesh_stats *mesh_stats_get(void);
+
+void mesh_advertise(void);
+void mesh_upstream_lost(void);
+bool mesh_enable(uint32_t addr, uint32_t netmask, const char *key);
+void mesh_disable(void);
+
+#endif
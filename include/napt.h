@@ -0,0 +1,131 @@
+// napt.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __NAPT_H__
+#define __NAPT_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+#define NAPT_PROTO_ICMP 1
+#define NAPT_PROTO_TCP 6
+#define NAPT_PROTO_UDP 17
+
+#define NAPT_ENTRY_NONE 0xFFFF  // Marks an empty slot resp. the end of a list
+
+// State of a TCP-connection (lower nibble of napt_entry.state); only the
+// packets passing the router are evaluated, so the states are approximations
+#define NAPT_TCP_SYN_SENT 1     // A SYN has been seen, but no answer yet
+#define NAPT_TCP_ESTABLISHED 2  // The SYN has been acknowledged
+#define NAPT_TCP_FIN_WAIT 3     // A FIN has been seen in one direction
+#define NAPT_TCP_CLOSED 4       // FINs have been seen in both directions or a RST
+#define NAPT_TCP_STATE_MASK 0x0F
+#define NAPT_TCP_FIN_OUT 0x10   // A FIN has been sent by the client
+#define NAPT_TCP_FIN_IN 0x20    // A FIN has been sent by the peer
+
+#define NAPT_DIR_OUT 0  // Soft access-point -> station
+#define NAPT_DIR_IN 1   // Station -> soft access-point
+
+#define NAPT_STATS_LATENCY_BUCKETS 13 // Buckets of the latency-histogram; bucket
+                                      // n counts the packets forwarded in less
+                                      // than 2^n us (the last one all others)
+
+#define NAPT_PORTMAP_DIR_IN 1   // Connections are initiated from the station
+                                // network interface (station -> access-point)
+#define NAPT_PORTMAP_DIR_OUT 2  // Connections are initiated from the soft
+                                // access-point (access-point -> station)
+
+/*-------- structs and types ---------*/
+
+// Translation entry of a single connection; all addresses and ports are stored
+// in network byte order
+struct napt_entry {
+  uint32_t src;   // Address of the client in the internal network
+  uint32_t dest;  // Address of the peer in the external network
+  uint16_t sport; // Port resp. ICMP-identifier used by the client
+  uint16_t dport; // Port of the peer (0 for ICMP)
+  uint16_t mport; // Port resp. ICMP-identifier on the station network interface
+  uint8_t proto;  // Protocol (cf. NAPT_PROTO_*)
+  uint8_t state;  // TCP-state and FIN-directions (cf. NAPT_TCP_*)
+  uint32_t last;  // Time of the last packet (in ms)
+  uint16_t prev;  // Previous entry in the LRU-list (more recently used)
+  uint16_t next;  // Next entry in the LRU-list (less recently used)
+};
+
+// Static portmap entry; all addresses and ports are stored in network byte
+// order (cf. user_config.h for a description of the fields)
+struct napt_portmap {
+  uint32_t maddr;
+  uint32_t daddr;
+  uint16_t mport;
+  uint16_t dport;
+  uint8_t proto;
+  uint8_t dir;
+  uint8_t valid;  // Entry is in use (cf. napt_portmap_next)
+};
+
+// Counters of the NAPT-engine (cf. napt_stats_get)
+struct napt_stats {
+  uint32_t packets[2];  // Translated packets per direction (cf. NAPT_DIR_*)
+  uint32_t bytes[2];    // Translated bytes per direction (IP-packets)
+  uint32_t hits;        // Lookups, that found a translation entry or portmap
+  uint32_t misses;      // Lookups, that didn't find a translation entry
+  uint32_t allocs;      // Newly created translation entries
+  uint32_t evictions;   // Entries recycled to make room for new connections
+  uint32_t drops;       // Dropped packets (e.g. because the table is full)
+  uint16_t nr_active_napt_tcp;  // Active translation entries per protocol
+  uint16_t nr_active_napt_udp;
+  uint16_t nr_active_napt_icmp;
+  uint32_t fastpath;    // Packets forwarded by the fast path (cf. napt_netif.c)
+  uint32_t latency_cycles;  // CPU-cycles spent on the last forwarded packet
+  uint32_t latency_max;     // Maximum latency of a forwarded packet (in us)
+  uint32_t latency_sum;     // Sum of the latencies of all forwarded packets (in us)
+  uint32_t latency[NAPT_STATS_LATENCY_BUCKETS]; // Histogram of the latencies
+};
+
+// Result of the translation of a packet
+typedef enum {
+  NAPT_PASS = 0,  // Packet isn't subject to NAPT; hand it to the stack unchanged
+  NAPT_FORWARD,   // Packet has been translated and can be forwarded
+  NAPT_DROP       // Packet must be dropped
+} napt_verdict;
+
+/*------------ functions -------------*/
+
+struct napt_entry *napt_find_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport);
+struct napt_entry *napt_find_inbound(uint8_t proto, uint16_t mport);
+struct napt_entry *napt_add(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport);
+void napt_remove(struct napt_entry *entry);
+uint16_t napt_count(void);
+
+bool napt_portmap_add(uint8_t proto, uint32_t maddr, uint16_t mport, uint32_t daddr, uint16_t dport, uint8_t dir);
+bool napt_portmap_remove(uint8_t proto, uint16_t mport);
+void napt_portmap_clear(void);
+struct napt_portmap *napt_portmap_find(uint8_t proto, uint16_t mport);
+uint16_t napt_portmap_count(void);
+const struct napt_portmap *napt_portmap_next(const struct napt_portmap *portmap);
+
+napt_verdict napt_outbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr);
+napt_verdict napt_inbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr);
+struct napt_entry *napt_translated_entry(void);
+void napt_flow_hit(struct napt_entry *entry, uint8_t dir, const uint8_t *iphdr);
+
+uint32_t napt_ccount(void);
+void napt_stats_record_forward(uint32_t cycles, bool fastpath);
+const struct napt_stats *napt_stats_get(void);
+
+void napt_expire(void);
+
+bool napt_is_enabled(void);
+void napt_external_update(uint32_t addr);
+void napt_set_adaptive(bool enabled);
+void napt_set_tcp_tracking(bool enabled);
+void napt_enable(uint32_t addr, uint32_t netmask);
+void napt_disable(void);
+bool napt_init(uint16_t max_entries);
+
+#endif
@@ -0,0 +1,18 @@
+// napt_chksum.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __NAPT_CHKSUM_H__
+#define __NAPT_CHKSUM_H__
+
+#include "c_types.h"
+
+/*------------ functions -------------*/
+
+uint32_t napt_chksum_delta(uint32_t delta, const uint8_t *optr, const uint8_t *nptr, uint8_t len);
+void napt_chksum_apply(uint8_t *chksum, uint32_t delta);
+bool napt_chksum_valid(const uint8_t *data, uint16_t len);
+
+#endif
@@ -0,0 +1,19 @@
+// napt_netif.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __NAPT_NETIF_H__
+#define __NAPT_NETIF_H__
+
+#include "c_types.h"
+
+/*------------ functions -------------*/
+
+void napt_netif_set_fastpath(bool enable);
+void napt_netif_set_batch(uint8_t size);
+void napt_netif_detach(void);
+bool napt_netif_attach(void);
+
+#endif
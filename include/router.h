@@ -12,6 +12,11 @@
 /*------------ functions -------------*/
 
 bool is_connected(void);
+uint32_t router_outage_time(void);
+void router_set_hitless_reconnect(bool enabled);
+bool router_get_hitless_reconnect(void);
 void esptouch_enable(void);
+void router_init(void);
+void router_disable(void);
 
 #endif
@@ -0,0 +1,68 @@
+// telemetry.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "c_types.h"
+
+/*------------- defines --------------*/
+
+// Wire format of a telemetry frame (all fields in network byte order):
+//
+//  header (20 bytes): MAGIC (2), VERSION (1), HEADER_LEN (1), SAMPLE_LEN (1),
+//                     COUNT (1), SEQ (2), MAC (6), INTERVAL (2, in s,
+//                     saturated), INTERVAL_MS (4, since version 2)
+//  COUNT samples of SAMPLE_LEN bytes each: UPTIME (4, in s), FREE_HEAP (4),
+//                     NAPT_ENTRIES (2), NAPT_SIZE (2), RATE_OUT (4, in bytes/s),
+//                     RATE_IN (4, in bytes/s), CLIENTS (1), FLAGS (1), DROPS (2)
+//
+// Later versions only append fields to the header resp. the samples; decoders
+// skip the unknown fields by HEADER_LEN resp. SAMPLE_LEN. INTERVAL only holds
+// whole seconds, so the samples of intervals, that aren't, are timed by
+// INTERVAL_MS; for frames of version 1, it's derived from INTERVAL.
+#define TELEMETRY_MAGIC 0x4E54  // "NT"
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_HEADER_LEN 20
+#define TELEMETRY_HEADER_LEN_V1 16
+#define TELEMETRY_SAMPLE_LEN 24
+#define TELEMETRY_SAMPLES_MAX 16  // Samples per frame
+
+#define TELEMETRY_FLAG_CONNECTED 0x01 // Station is connected (sample flags)
+#define TELEMETRY_FLAG_NAPT 0x02      // NAPT-engine is enabled (sample flags)
+
+/*-------- structs and types ---------*/
+
+// A sample of the router's state
+struct telemetry_sample {
+  uint32_t uptime;        // Time since the start (in s)
+  uint32_t free_heap;
+  uint16_t napt_entries;  // Occupancy of the NAPT-table
+  uint16_t napt_size;
+  uint32_t rate[2];       // Forwarded bytes/s since the previous sample per
+                          // direction (cf. NAPT_DIR_*)
+  uint8_t clients;        // Associated clients of the soft access-point
+  uint8_t flags;          // TELEMETRY_FLAG_*
+  uint16_t drops;         // Packets dropped by the NAPT-engine since the
+                          // previous sample (saturated)
+};
+
+// Header of a telemetry frame
+struct telemetry_header {
+  uint8_t version;
+  uint8_t count;
+  uint16_t seq;           // Sequence number of the frame (reveals lost frames)
+  uint8_t mac[6];
+  uint32_t interval;      // Time between the samples (in ms)
+};
+
+/*------------ functions -------------*/
+
+void telemetry_sample_take(struct telemetry_sample *sample, bool commit);
+uint16_t telemetry_encode(uint8_t *buffer, uint16_t size, const struct telemetry_header *header, const struct telemetry_sample *samples);
+bool telemetry_decode(const uint8_t *buffer, uint16_t len, struct telemetry_header *header, struct telemetry_sample *samples, uint8_t max);
+
+#endif
@@ -0,0 +1,39 @@
+// uplink_sched.h
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+
+#ifndef __UPLINK_SCHED_H__
+#define __UPLINK_SCHED_H__
+
+#include "c_types.h"
+
+struct pbuf;
+struct netif;
+struct client_stats;
+
+/*-------- structs and types ---------*/
+
+// Counters of the scheduler (cf. uplink_sched_stats_get)
+struct uplink_sched_stats {
+  uint32_t enqueued;    // Packets queued for the station network interface
+  uint32_t sent;        // Packets sent on the station network interface
+  uint32_t drops;       // Packets dropped, since the queues were full
+  uint32_t priority;    // Packets queued with priority (cf. uplink_sched_set_priority)
+  uint16_t backlog;     // Currently queued packets
+  uint16_t backlog_max; // Maximum number of simultaneously queued packets
+};
+
+/*------------ functions -------------*/
+
+bool uplink_sched_enqueue(struct pbuf *p, struct netif *outp, uint32_t nexthop, const struct client_stats *client);
+const struct uplink_sched_stats *uplink_sched_stats_get(void);
+
+void uplink_sched_set_priority(bool enabled);
+bool uplink_sched_set_client_rate(const uint8_t *mac, uint32_t rate);
+void uplink_sched_clear_client_rates(void);
+void uplink_sched_set_rate(uint32_t rate);
+void uplink_sched_flush(void);
+
+#endif
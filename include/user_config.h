@@ -11,6 +11,12 @@
 
 // Router settings:
 
+// Annotation: The settings of the soft access-point, the DHCP-range, the DNS-
+// server, the portmap entries, the mesh-mode and the timeouts of the router and
+// the vital sign are only the defaults of the configuration, which is loaded
+// from the flash at start-up and can be changed via DEVICE_COM_PORT (cf.
+// config.c).
+
 #define WIFI_AP_SSID_PREFIX "ESP_ROUTER"  // SSID-prefix of the router; the full
                                           // SSID consists of this prefix with
                                           // the soft access-point's MAC-address
@@ -27,20 +33,22 @@
                                                             // router
 
 #define MAX_CLIENTS 8 // Maximum number of clients allowed to connect to the
-                      // router at once (limited at 8)
+                      // router at once (limited at 8); the configuration can
+                      // only lower it, since the tables are sized by it
 
 #define WIFI_AP_OPEN 0  // If set to 1, the access-point is open and no password
                         // is needed to connect to it. Per default, the router
                         // is WPA/WPA2-secured and can only be connected to with
                         // WIFI_AP_PASSWORD.
 
-#define WIFI_AP_HIDDEN 0; // If set to 1, the access-point is hidden (the SSID
+#define WIFI_AP_HIDDEN 0  // If set to 1, the access-point is hidden (the SSID
                           // isn't broadcasted)
                           // Annotation: This doesn't add any security to the
                           // access-point at all!)
 
 #define WIFI_AP_NETWORK_ADDR "192.168.13.1" // IP-address of the router in the
-                                            // access-point's sub-network
+                                            // access-point's sub-network (any
+                                            // host address of the network)
 
 #define WIFI_AP_NETWORK_NETMASK "255.255.255.0" // All devices with IP-addresses
                                                 // within the range of
@@ -65,30 +73,74 @@
                                         // the range of WIFI_AP_NETWORK_ADDR &
                                         // WIFI_AP_NETWORK_NETMASK, or the
                                         // devices won't be reachable from the
-                                        // router! Furthermore, DHCP_START_ADDR
-                                        // must be AT MAX 100 addresses away
-                                        // from DHCP_STOP_ADDR
+                                        // router!
 
-#define DHCP_STOP_ADDR  "192.168.13.64" // Start IP-address assigned by the DHCP-
+#define DHCP_STOP_ADDR  "192.168.13.64" // Stop IP-address assigned by the DHCP-
                                         // server
                                         // Attention: DHCP_STOP_ADDR must be in
                                         // the range of WIFI_AP_NETWORK_ADDR &
                                         // WIFI_AP_NETWORK_NETMASK, or the
                                         // devices won't be reachable from the
-                                        // router! Furthermore, DHCP_STOP_ADDR
-                                        // must be AT MAX 100 addresses away
-                                        // from DHCP_START_ADDR
+                                        // router! At most ADDR_POOL_MAX
+                                        // addresses from DHCP_START_ADDR on
+                                        // are used
+
+#define ADDR_POOL_MAX 1024  // Maximum number of addresses of the DHCP-range
+                            // (multiple of 32, at most 1024; each address
+                            // occupies one bit of the pool's bitmap, cf.
+                            // addr_pool.c)
+
+#define DHCP_LEASE_TIME 7200  // Lifetime of a lease handed to a client (in s)
+
+#define DHCP_LEASES_MAX 32  // Maximum number of stored bindings of clients to
+                            // addresses (the bindings are kept in the flash
+                            // sector below the RF-calibration-sector, cf.
+                            // dhcp_server.c)
+
+#define DHCP_LEASE_SAVE_DELAY 5000  // Time to collect changes of the bindings
+                                    // before writing them to the flash (in ms)
 
 // DNS-server:
 
 #define DNS_SERVER_IP 0 // IP-address of the DNS-server to use for domain name
                         // resolution (0 = use Google's DNS-server (8.8.8.8))
 
+#define DNS_PROXY 1 // If set to 1, the router hands its own address to the
+                    // clients as DNS-server and answers their queries from a
+                    // cache resp. forwards them to DNS_SERVER_IP (cf.
+                    // dns_proxy.c); otherwise, the clients are handed
+                    // DNS_SERVER_IP directly
+
+#define DNS_PROXY_CACHE_SIZE 16 // Number of cached answers (each entry
+                                // occupies DNS_PROXY_MSG_MAX + 16 bytes)
+
+#define DNS_PROXY_MSG_MAX 256 // Maximum size of a cached answer (in bytes);
+                              // larger answers are forwarded, but not cached
+
+#define DNS_PROXY_PENDING 8 // Maximum number of simultaneously pending queries
+                            // to the upstream server
+
+#define DNS_PROXY_WAITERS 4 // Maximum number of clients waiting for the answer
+                            // to the same pending query
+
+#define DNS_PROXY_QUESTION_MAX 128  // Maximum size of the question (name, type
+                                    // and class) of a forwarded query
+
+#define DNS_PROXY_TIMEOUT 2000  // Time after which a pending query is
+                                // discarded, if no answer has been received
+                                // (in ms)
+
+#define DNS_PROXY_TTL_MAX 3600  // Maximum time an answer is cached (in s)
+
+#define DNS_PROXY_TTL_NEGATIVE 60 // Maximum time a negative answer (NXDOMAIN
+                                  // resp. no data) is cached (in s)
+
 // Port mapping:
 
-// Annotation: The following section allows to define up to eight portmap entries,
-// which are then automatically loaded when the router is enabled. Each portmap
-// entry consists of six parts:
+// Annotation: The following section allows to pre-define portmap entries,
+// which are then automatically loaded when the router is enabled. Further
+// entries can be added resp. removed at runtime (cf. napt_portmap_add and
+// napt_portmap_remove in napt.h). Each portmap entry consists of six parts:
 //
 //  Protocol            - Communication protocol, which the packages have to be
 //                        in to be mapped (cf. lwip/ip.h)
@@ -113,75 +165,207 @@
 //                        around (1 = station -> access-point; 2 = access-point
 //                        -> station)
 //
-// If one of the elements is set to 0, the whole entry will not be loaded.
-// Furthermore, each entry can be enabled or disabled seperately by setting
-// PORTMAP_ENABLE_X to 1 resp. 0.
+// PORTMAP_TABLE lists the pre-defined entries in the order protocol, mapping
+// port, destination address, destination port and direction (the mapping
+// address is omitted).
 //
 // Attention: Broadcasted messages won't be mapped!
 
-#define PORTMAP_ENABLE_1 1
-
-  #define PORTMAP_PROTO_1 6
-  #define PORTMAP_MPORT_1 8883
-  #define PORTMAP_DADDR_1 "192.168.13.37"
-  #define PORTMAP_DPORT_1 8883
-  #define PORTMAP_DIR_1 2
-
-#define PORTMAP_ENABLE_2 0
-
-  #define PORTMAP_PROTO_2 0
-  #define PORTMAP_MPORT_2 0
-  #define PORTMAP_DADDR_2 0
-  #define PORTMAP_DPORT_2 0
-  #define PORTMAP_DIR_2 0
-
-#define PORTMAP_ENABLE_3 0
-
-  #define PORTMAP_PROTO_3 0
-  #define PORTMAP_MPORT_3 0
-  #define PORTMAP_DADDR_3 0
-  #define PORTMAP_DPORT_3 0
-  #define PORTMAP_DIR_3 0
-
-#define PORTMAP_ENABLE_4 0
-
-  #define PORTMAP_PROTO_4 0
-  #define PORTMAP_MPORT_4 0
-  #define PORTMAP_DADDR_4 0
-  #define PORTMAP_DPORT_4 0
-  #define PORTMAP_DIR_4 0
-
-#define PORTMAP_ENABLE_5 0
-
-  #define PORTMAP_PROTO_5 0
-  #define PORTMAP_MPORT_5 0
-  #define PORTMAP_DADDR_5 0
-  #define PORTMAP_DPORT_5 0
-  #define PORTMAP_DIR_5 0
-
-#define PORTMAP_ENABLE_6 0
-
-  #define PORTMAP_PROTO_6 0
-  #define PORTMAP_MPORT_6 0
-  #define PORTMAP_DADDR_6 0
-  #define PORTMAP_DPORT_6 0
-  #define PORTMAP_DIR_6 0
-
-#define PORTMAP_ENABLE_7 0
-
-  #define PORTMAP_PROTO_7 0
-  #define PORTMAP_MPORT_7 0
-  #define PORTMAP_DADDR_7 0
-  #define PORTMAP_DPORT_7 0
-  #define PORTMAP_DIR_7 0
-
-#define PORTMAP_ENABLE_8 0
-
-  #define PORTMAP_PROTO_8 0
-  #define PORTMAP_MPORT_8 0
-  #define PORTMAP_DADDR_8 0
-  #define PORTMAP_DPORT_8 0
-  #define PORTMAP_DIR_8 0
+#define PORTMAP_TABLE { \
+  {6, 8883, "192.168.13.37", 8883, 2}, \
+}
+
+// NAPT:
+
+#define NAPT_TABLE_SIZE 256 // Maximum number of simultaneous connections, that
+                            // can be translated by the router (each entry
+                            // occupies 28 bytes plus 8 bytes for the hash
+                            // indexes)
+
+#define NAPT_PORTMAP_MAX 128 // Maximum number of portmap entries; the table
+                             // is allocated statically (each entry occupies
+                             // 16 bytes plus 8 bytes for the hash indexes)
+
+#define NAPT_FASTPATH 1  // Forward translated packets directly to the other
+                         // network interface instead of passing them through
+                         // lwip's ip_forward (1 = enabled, 0 = disabled)
+
+#define NAPT_BATCH_SIZE 1 // Number of received frames, that are translated and
+                          // forwarded together (1 = every frame on its own; at
+                          // most 16; cf. napt_netif.c). Disabled by default,
+                          // since it doesn't pay off: batch_bench measures
+                          // 1.00/1.01/1.05/1.00x the packets/s of the
+                          // unbatched processing for 1/4/8/16 frames (within
+                          // its noise), and frames wait for their batch
+
+#define FLOW_CACHE 0  // Translate the packets of established flows by a cache
+                      // of their translation and next hop instead of the
+                      // NAPT-engine (1 = enabled, 0 = disabled; cf.
+                      // flow_cache.c). Disabled by default, since it only
+                      // pays off for few concurrent flows: flow_bench saves
+                      // ~6% per packet with up to 4 connections, but loses
+                      // ~11% with 64 ones, whose flows don't fit the cache
+
+#define FLOW_CACHE_SIZE 32  // Number of cached flows (power of two, at most
+                            // 256; each entry occupies 48 bytes plus 4 bytes
+                            // for the hash of a missed flow)
+
+#define FLOW_CACHE_WAYS 4 // Number of entries per set of the cache (power of
+                          // two, at most FLOW_CACHE_SIZE)
+
+#define FLOW_CACHE_TIMEOUT 1000 // Time after which a cached flow is resolved
+                                // again by the NAPT-engine and the ARP-table
+                                // (in ms)
+
+#define NAPT_PORT_RANGE_START 20000 // Range of the ports resp. ICMP-identifiers,
+#define NAPT_PORT_RANGE_END 39999   // that are assigned to translated
+                                    // connections on the station network
+                                    // interface
+                                    // Attention: The range mustn't overlap
+                                    // with the local ports used by the router
+                                    // itself (49152 and above)!
+
+#define NAPT_TIMEOUT_TCP 1800000  // Time after which an idle TCP-connection is
+                                  // removed from the NAPT-table (in ms)
+
+#define NAPT_TIMEOUT_TCP_SYN 20000  // Time after which a TCP-connection is
+                                    // removed from the NAPT-table, if its SYN
+                                    // isn't answered (in ms)
+
+#define NAPT_TIMEOUT_TCP_FIN_WAIT 20000 // Time after which a TCP-connection is
+                                        // removed from the NAPT-table once a
+                                        // FIN has been seen in one direction
+                                        // (in ms)
+
+#define NAPT_TIMEOUT_TCP_CLOSED 2000  // Time after which a TCP-connection is
+                                      // removed from the NAPT-table once FINs
+                                      // have been seen in both directions or a
+                                      // RST has been seen; covers retransmits
+                                      // of the last ACK (in ms)
+
+#define NAPT_TCP_TRACKING 1 // Track the state of TCP-connections to remove
+                            // finished connections early (1 = enabled, 0 = all
+                            // TCP-connections use NAPT_TIMEOUT_TCP)
+
+#define NAPT_TIMEOUT_UDP 2000 // Time after which an idle UDP-connection is
+                              // removed from the NAPT-table (in ms)
+
+#define NAPT_TIMEOUT_ICMP 2000  // Time after which an idle ICMP-echo-request is
+                                // removed from the NAPT-table (in ms)
+
+#define NAPT_ADAPTIVE_TIMEOUTS 1  // Shrink the timeouts with the occupancy of the
+                                  // NAPT-table and recycle active entries, if
+                                  // the table is full (1 = enabled, 0 = only
+                                  // expired entries are recycled)
+
+#define NAPT_TIMEOUT_PRESSURE 50  // Occupancy of the NAPT-table (in percent),
+                                  // above which the timeouts shrink linearly
+                                  // down to the following minimums, which
+                                  // apply to a full table
+
+#define NAPT_TIMEOUT_TCP_MIN 30000  // Minimum timeout of an idle TCP-
+                                    // connection (in ms)
+
+#define NAPT_TIMEOUT_TCP_SYN_MIN 5000 // Minimum timeout of an unanswered SYN
+                                      // (in ms)
+
+#define NAPT_TIMEOUT_TCP_FIN_WAIT_MIN 1000  // Minimum timeout of a TCP-
+                                            // connection once a FIN has been
+                                            // seen in one direction (in ms)
+
+#define NAPT_TIMEOUT_TCP_CLOSED_MIN 500 // Minimum timeout of a closed TCP-
+                                        // connection (in ms)
+
+#define NAPT_TIMEOUT_UDP_MIN 500  // Minimum timeout of an idle UDP-connection
+                                  // (in ms)
+
+#define NAPT_TIMEOUT_ICMP_MIN 500 // Minimum timeout of an idle ICMP-echo-request
+                                  // (in ms)
+
+#define NAPT_EXPIRE_INTERVAL 1000 // Interval, in which expired entries are
+                                  // removed from the NAPT-table (in ms)
+
+#define NAPT_EVICT_SCAN 32  // Number of least recently used entries searched
+                            // for closed TCP-connections resp. idle UDP- and
+                            // ICMP-entries, if the table is full; otherwise the
+                            // least recently used entry is recycled
+
+#define CLIENT_STATS_RATE_INTERVAL 1000 // Window, over which the rolling
+                                        // rates of the clients are computed
+                                        // (in ms; cf. client_stats.c)
+
+#define UPLINK_SCHED_RATE 0 // Rate, to which the packets forwarded to the
+                            // station network interface are shaped (in
+                            // bytes/s; 0 disables the scheduler); it should be
+                            // slightly below the throughput of the uplink
+                            // (e.g. 560000 for ~5 Mbps), so that the packets
+                            // are queued per client by the router instead of
+                            // the WiFi-driver (cf. uplink_sched.c). Disabled by
+                            // default, since the throughput of the uplink
+                            // isn't known in advance and every queued packet
+                            // holds one of the WiFi-driver's scarce receive-
+                            // buffers; can be set via uplink_rate (cf.
+                            // config.c)
+
+#define UPLINK_SCHED_CLIENT_RATE 0  // Rate limit of every client on the uplink
+                                    // (in bytes/s; 0 = unlimited); can be set
+                                    // per client via client_rateN (cf.
+                                    // config.c)
+
+#define UPLINK_SCHED_BURST 3000 // Size of the token-buckets of the uplink and
+                                // of the clients (in bytes; at least one
+                                // packet of the MTU)
+
+#define UPLINK_SCHED_QUANTUM 1500 // Bytes, that every backlogged client may
+                                  // send per round of the scheduler (at least
+                                  // the MTU)
+
+#define UPLINK_SCHED_QUEUE_LEN 8  // Maximum number of queued packets per client
+
+#define UPLINK_SCHED_PRIORITY 1  // Send the packets of portmapped devices and
+                                 // the control traffic (DHCP, DNS,
+                                 // DEVICE_COM_PORT) ahead of the clients'
+                                 // queues (1 = enabled, 0 = disabled)
+
+#define UPLINK_SCHED_BACKLOG 12 // Maximum number of queued packets in total;
+                                // every queued packet keeps its receive-
+                                // buffer, so this bounds the memory used
+
+// Mesh:
+
+#define ROUTER_MESH 0 // If set to 1, the router is a mesh-node: its station is
+                      // connected to the soft access-point of another router,
+                      // to which it advertises its networks, and its packets
+                      // are routed without translation, once the upstream
+                      // router has installed the routes; only mesh-nodes
+                      // install the routes of the routers below them (default
+                      // of the configuration; cf. mesh.c)
+
+#define MESH_HOSTNAME "ESP_MESH_NODE" // Hostname, by which the station of a
+                                      // mesh-node identifies itself to the
+                                      // DHCP-server of the upstream router;
+                                      // only the advertisements of such
+                                      // clients are accepted
+
+#define MESH_KEY "" // Key shared by the mesh-nodes of a chain, which
+                    // authenticates their advertisements (default of the
+                    // configuration; at least 8 characters, if the router is
+                    // a mesh-node; cf. mesh.c)
+
+#define MESH_PORT 49154 // Third non-well-known nor registered port; the
+                        // routes are advertised to the upstream router on
+                        // this port
+
+#define MESH_ADVERT_INTERVAL 10000  // Interval, in which the routes are
+                                    // advertised to the upstream router (in
+                                    // ms)
+
+#define MESH_ROUTE_TIMEOUT 3  // Number of intervals without an advertisement
+                              // resp. acknowledgement, after which a route
+                              // expires resp. the mesh-node falls back to NAPT
+
+#define MESH_ROUTES_MAX 8 // Maximum number of routes to the networks of
+                          // downstream routers (after the aggregation)
 
 /*------------------------------------*/
 
@@ -191,13 +375,28 @@
 // in gpio_pins_init (cf. user_main.c) if the addresses of the GPIO-pins are
 // modified!
 
-#define ROUTER_CONN_TIMEOUT_WDT_INTERVAL 300000 // Time-interval, in which the
-                                                // router's connection state is
-                                                // checked by a software-watchdog-
-                                                // timer, which restores the
-                                                // device's initial state, if no
-                                                // connection to the host access-
-                                                // point is established (in ms)
+#define ROUTER_CONN_TIMEOUT 300000 // Time, within which the router has to
+                                   // (re-)establish the connection to the
+                                   // host access-point after ESP-TOUCH resp.
+                                   // a disconnection, before the device's
+                                   // initial state is restored (in ms; cf.
+                                   // lifecycle.c)
+
+#define ROUTER_HITLESS_RECONNECT 1  // If set to 1, the soft access-point, the
+                                    // DHCP-server and the NAPT-table are kept,
+                                    // while the station network interface is
+                                    // disconnected from the host access-point,
+                                    // and the translations continue with the
+                                    // new address after the reconnect (cf.
+                                    // router.c); otherwise, the soft
+                                    // access-point is restarted on every
+                                    // reconnect
+
+#define ROUTER_RECONNECT_TIMEOUT 600000 // Maximum duration of a disconnection,
+                                        // that is bridged with
+                                        // ROUTER_HITLESS_RECONNECT, before the
+                                        // router is disabled (in ms; cf.
+                                        // lifecycle.c)
 
 #define OUTPUT_POWER_RELAY_GPIO 12  // GPIO-pin, that is connected to the red LED
                                     // as well as to the relay, which controls
@@ -217,6 +416,35 @@
                                 // signalize, that the node is currently in
                                 // smartconfiguration-mode (in ms)
 
+#define MEM_POOL_TIMERS 8 // Number of timers, that can be allocated at the
+                          // same time from the statically allocated timer-pool
+                          // (cf. mem_pool.h)
+
+#define MEM_POOL_ESPCONN 5  // Number of espconn control blocks (and UDP-
+                            // configurations), that can be allocated at the
+                            // same time from the statically allocated pools
+                            // (device_info, the DNS-proxy, the DHCP-server
+                            // and the mesh-routing need five)
+
+// Logging:
+
+#define LOG_LEVEL 3 // Highest level of the messages, that are compiled in (0:
+                    // none, 1: errors, 2: warnings, 3: info, 4: debug; cf.
+                    // log.h); the others compile away completely
+
+#define LOG_MODULES 0xFFFF  // Mask of the modules, whose messages are compiled
+                            // in (cf. LOG_MODULE_* in log.h)
+
+#define LOG_UART 1  // If set to 1, the messages are printed via the UART (at
+                    // 115200 baud, each character blocks for about 87 us, once
+                    // the UART's FIFO is full)
+
+#define LOG_RING 1  // If set to 1, the messages are additionally kept in a ring
+                    // buffer in the RAM, which can be requested via
+                    // DEVICE_COM_PORT (cf. LOG_REQUEST_STRING)
+
+#define LOG_RING_SIZE 1024  // Size of the ring buffer (in bytes; power of two)
+
 /*------------------------------------*/
 
 // Meta-data:
@@ -228,6 +456,64 @@
                                                   // this String is received via
                                                   // an UDP-message
 
+#define NAPT_STATS_REQUEST_STRING "NAPT_STATS\n" // The device will return the
+                                                // counters of the NAPT-engine
+                                                // to the sender if this String
+                                                // is received via an
+                                                // UDP-message
+
+#define MEM_STATS_REQUEST_STRING "MEM_STATS\n" // The device will return the
+                                              // utilization of the memory
+                                              // pools to the sender if this
+                                              // String is received via an
+                                              // UDP-message
+
+#define DNS_STATS_REQUEST_STRING "DNS_STATS\n" // The device will return the
+                                              // counters of the DNS-proxy to
+                                              // the sender if this String is
+                                              // received via an UDP-message
+
+#define CLIENT_STATS_REQUEST_STRING "CLIENT_STATS\n" // The device will return
+                                                    // the counters of the
+                                                    // clients of the soft
+                                                    // access-point to the
+                                                    // sender if this String is
+                                                    // received via an
+                                                    // UDP-message
+
+#define LOG_REQUEST_STRING "LOG\n" // The device will return the newest
+                                  // messages of the log's ring buffer (cf.
+                                  // LOG_RING) to the sender if this String is
+                                  // received via an UDP-message
+
+#define CONFIG_REQUEST_STRING "CONFIG\n" // The device will return its
+                                        // configuration (without the
+                                        // password; cf. config.c) to the
+                                        // sender if this String is received
+                                        // via an UDP-message
+
+#define CONFIG_SET_REQUEST_STRING "CONFIG_SET " // Followed by "<key> <value>\n";
+                                                // the device will set the
+                                                // value in its configuration
+                                                // and reply "OK\n" resp.
+                                                // "ERROR\n"
+
+#define CONFIG_SAVE_REQUEST_STRING "CONFIG_SAVE\n" // The device will store its
+                                                  // configuration in the flash
+                                                  // (it takes effect, when the
+                                                  // router is enabled the next
+                                                  // time)
+
+#define CONFIG_RESET_REQUEST_STRING "CONFIG_RESET\n" // The device will restore
+                                                    // the defaults of its
+                                                    // configuration (they're
+                                                    // stored with the next
+                                                    // CONFIG_SAVE)
+                                                    // Annotation: The CONFIG-
+                                                    // requests are only
+                                                    // answered to clients of
+                                                    // the soft access-point!
+
 /*------------------------------------*/
 
 // Communication and interaction:
@@ -245,7 +531,13 @@
                               // this port
 
 #define VITAL_SIGN_TIME_INTERVAL 300000 // Time-interval, in which the vital
-                                        // sign is broadcasted (in ms)
+                                        // sign is broadcasted (in ms; default
+                                        // of the configuration, cf. config.c)
+
+#define VITAL_SIGN_SAMPLES 5  // Number of samples of the router's state (taken
+                              // evenly over VITAL_SIGN_TIME_INTERVAL), that are
+                              // broadcasted together in one telemetry frame
+                              // (at most TELEMETRY_SAMPLES_MAX)
 
 /*------------------------------------*/
 
@@ -266,4 +558,25 @@
                                                       // obtaining SSID & PSWD
                                                       // via ESP-TOUCH
 
+// Fast boot:
+
+#define FAST_BOOT 1 // If set to 1, the station first tries to connect with the
+                    // credentials of the last successful activation (stored by
+                    // the SDK) and ESP-TOUCH is only started, if this fails
+                    // (cf. fast_boot.c)
+
+#define FAST_BOOT_TIMEOUT 10000 // Time limit to connect with the cached
+                                // credentials before falling back to ESP-TOUCH
+                                // (in ms)
+
+#define FAST_BOOT_HINT_TIMEOUT 2000 // Time limit to connect to the cached
+                                    // BSSID and channel of the host access-
+                                    // point, before they are discarded and the
+                                    // station scans for the SSID (in ms)
+
+#define FAST_BOOT_RTC_BLOCK 64  // First block of the RTC-memory, that holds the
+                                // cached BSSID and channel (blocks 64 to 191
+                                // are available to the user; the hint occupies
+                                // four blocks)
+
 #endif
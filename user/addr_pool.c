@@ -0,0 +1,159 @@
+// addr_pool.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Allocator of the addresses of a range within a network of any
+// prefix length (cf. the pool of the DHCP-server in dhcp_server.c). The free
+// addresses are kept in a bitmap of ADDR_POOL_MAX bits with a summary word,
+// whose bit n is set, if word n of the bitmap has a free address, so that the
+// lowest free address is found with two count-trailing-zeros instead of a scan
+// of the range, and taking, releasing and testing an address are a single bit
+// operation.
+//
+// The network's and broadcast address are never part of the pool; the given
+// address of the router is taken on initialization. Ranges of more than
+// ADDR_POOL_MAX addresses are cut.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "addr_pool.h"
+#define LOG_MODULE LOG_MODULE_DHCP
+#include "log.h"
+#include "user_config.h"
+
+#if ADDR_POOL_MAX % 32 || ADDR_POOL_MAX > 1024
+#error "ADDR_POOL_MAX has to be a multiple of 32 and at most 1024!"
+#endif
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t addr_pool_ntohl(uint32_t ip);
+static void addr_pool_mark(struct addr_pool *pool, uint16_t idx, bool free);
+
+// Allocation:
+bool addr_pool_init(struct addr_pool *pool, uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop);
+bool addr_pool_contains(const struct addr_pool *pool, uint32_t ip);
+bool addr_pool_is_free(const struct addr_pool *pool, uint32_t ip);
+bool addr_pool_take(struct addr_pool *pool, uint32_t ip);
+void addr_pool_release(struct addr_pool *pool, uint32_t ip);
+uint32_t addr_pool_alloc(struct addr_pool *pool);
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Convert an address from network to host byte order resp. vice versa
+static uint32_t ICACHE_FLASH_ATTR addr_pool_ntohl(uint32_t ip) {
+  const uint8_t *bytes = (const uint8_t *) &ip;
+
+  return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Mark the address with the given index as free resp. used
+static void ICACHE_FLASH_ATTR addr_pool_mark(struct addr_pool *pool, uint16_t idx, bool free) {
+  uint8_t word = idx >> 5;
+
+  if (free) {
+    pool->free[word] |= 1UL << (idx & 31);
+    pool->summary |= 1UL << word;
+  }
+  else {
+    pool->free[word] &= ~(1UL << (idx & 31));
+    if (!pool->free[word]) {
+      pool->summary &= ~(1UL << word);
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Allocation:
+
+// Initialize the pool with the addresses start to stop of the router's network
+// (all in network byte order); returns false, if the range isn't part of the
+// network or doesn't hold a usable address
+bool ICACHE_FLASH_ATTR addr_pool_init(struct addr_pool *pool, uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop) {
+  uint32_t mask = addr_pool_ntohl(netmask);
+  uint32_t net = addr_pool_ntohl(ip) & mask;
+  uint32_t first = addr_pool_ntohl(start), last = addr_pool_ntohl(stop);
+  uint16_t idx;
+
+  os_memset(pool, 0, sizeof(struct addr_pool));
+  if ((first & mask) != net || (last & mask) != net || first > last) {
+    return false;
+  }
+  // Exclude the network's and broadcast address
+  if (first == net) {
+    first++;
+  }
+  if (last == (net | ~mask)) {
+    last--;
+  }
+  if (first > last) {
+    return false;
+  }
+  if (last - first >= ADDR_POOL_MAX) {
+    LOG_WARN("addr_pool_init: Range cut to %u addresses!\n", ADDR_POOL_MAX);
+    last = first + ADDR_POOL_MAX - 1;
+  }
+
+  pool->start = first;
+  pool->size = last - first + 1;
+  for (idx = 0; idx < pool->size; idx++) {
+    addr_pool_mark(pool, idx, true);
+  }
+  addr_pool_take(pool, ip);
+  return true;
+}
+
+// Check, if the address (network byte order) is part of the pool
+bool ICACHE_FLASH_ATTR addr_pool_contains(const struct addr_pool *pool, uint32_t ip) {
+  return addr_pool_ntohl(ip) - pool->start < pool->size;
+}
+
+// Check, if the address (network byte order) is part of the pool and free
+bool ICACHE_FLASH_ATTR addr_pool_is_free(const struct addr_pool *pool, uint32_t ip) {
+  uint32_t idx = addr_pool_ntohl(ip) - pool->start;
+
+  return idx < pool->size && (pool->free[idx >> 5] & (1UL << (idx & 31)));
+}
+
+// Take the given address (network byte order); returns false, if it isn't free
+bool ICACHE_FLASH_ATTR addr_pool_take(struct addr_pool *pool, uint32_t ip) {
+  if (!addr_pool_is_free(pool, ip)) {
+    return false;
+  }
+  addr_pool_mark(pool, addr_pool_ntohl(ip) - pool->start, false);
+  pool->used++;
+  return true;
+}
+
+// Return the given address (network byte order) to the pool
+void ICACHE_FLASH_ATTR addr_pool_release(struct addr_pool *pool, uint32_t ip) {
+  if (addr_pool_contains(pool, ip) && !addr_pool_is_free(pool, ip)) {
+    addr_pool_mark(pool, addr_pool_ntohl(ip) - pool->start, true);
+    pool->used--;
+  }
+}
+
+// Take the lowest free address; returns it in network byte order resp. 0, if
+// the pool is exhausted
+uint32_t ICACHE_FLASH_ATTR addr_pool_alloc(struct addr_pool *pool) {
+  uint8_t word;
+  uint16_t idx;
+
+  if (!pool->summary) {
+    return 0;
+  }
+  word = __builtin_ctz(pool->summary);
+  idx = (word << 5) | __builtin_ctz(pool->free[word]);
+  addr_pool_mark(pool, idx, false);
+  pool->used++;
+  return addr_pool_ntohl(pool->start + idx);
+}
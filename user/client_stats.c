@@ -0,0 +1,355 @@
+// client_stats.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Traffic accounting per client of the soft access-point. The
+// table holds one slot per client (MAX_CLIENTS), keyed on the MAC-address and
+// the association-ID of the station (cf. the soft access-point events in
+// router.c) and on its IP-address. The forwarding path (cf. napt_netif.c)
+// looks the client up by the address of the packet in a small open-addressing
+// hash index, so that the accounting costs the same for every packet:
+//
+//  - forwarded packets and bytes per direction
+//  - a rolling rate per direction (bytes/s), computed over windows of
+//    CLIENT_STATS_RATE_INTERVAL ms and smoothed with a weight of 1/4 per window
+//  - the number of active translation entries (cf. napt_add resp. napt_remove)
+//
+// The address of a client is taken from its DHCP-lease on the association; if
+// there's none (e.g. static configuration), it's learned from the first packet
+// forwarded from the soft access-point. After the disassociation, the counters
+// are kept until the slot is needed for another client.
+//
+// The table can be requested via DEVICE_COM_PORT (cf. device_info.c).
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "client_stats.h"
+#define LOG_MODULE LOG_MODULE_CLIENTS
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define CLIENT_STATS_HASH_SIZE 16 // Power of two >= 2 * MAX_CLIENTS
+#define CLIENT_STATS_SLOT_NONE 0xFF
+#define CLIENT_STATS_RATE_WINDOWS 16  // Windows, after which a rate has decayed
+                                      // to (almost) 0
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint8_t client_stats_hash(uint32_t ip);
+static void client_stats_index_rebuild(void);
+static struct client_stats *client_stats_find(uint32_t ip);
+static struct client_stats *client_stats_find_mac(const uint8_t *mac);
+static struct client_stats *client_stats_alloc(const uint8_t *mac);
+static void client_stats_bind(struct client_stats *client, uint32_t ip);
+static void client_stats_roll(struct client_stats *client, uint32_t now);
+
+// Status-functions:
+uint8_t client_stats_count(void);
+uint8_t client_stats_slot(const struct client_stats *client);
+const struct client_stats *client_stats_lookup(uint32_t ip);
+const struct client_stats *client_stats_lookup_mac(const uint8_t *mac);
+const struct client_stats *client_stats_next(const struct client_stats *client);
+
+// Accounting:
+struct client_stats *client_stats_get(uint32_t ip, const uint8_t *mac);
+void client_stats_record(struct client_stats *client, uint8_t dir, uint16_t len);
+void client_stats_napt(uint32_t ip, int8_t delta);
+void client_stats_napt_reset(void);
+
+// Initialization and configuration:
+void client_stats_connect(const uint8_t *mac, uint8_t aid, uint32_t ip);
+void client_stats_disconnect(const uint8_t *mac);
+void client_stats_init(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct client_stats client_stats_table[MAX_CLIENTS];
+static uint8_t client_stats_index[CLIENT_STATS_HASH_SIZE];  // Slots by IP-address
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Hash of an IP-address (Fibonacci-hashing; the host-part of the address is
+// stored in the upper bits in network byte order)
+static uint8_t ICACHE_FLASH_ATTR client_stats_hash(uint32_t ip) {
+  return ((ip * 2654435761UL) >> 24) & (CLIENT_STATS_HASH_SIZE - 1);
+}
+
+// Rebuild the hash index from the table (on changes of the addresses only, so
+// the index doesn't need a deletion-strategy)
+static void ICACHE_FLASH_ATTR client_stats_index_rebuild(void) {
+  uint8_t slot, pos;
+
+  os_memset(client_stats_index, CLIENT_STATS_SLOT_NONE, sizeof(client_stats_index));
+  for (slot = 0; slot < MAX_CLIENTS; slot++) {
+    if (!client_stats_table[slot].valid || !client_stats_table[slot].ip) {
+      continue;
+    }
+    pos = client_stats_hash(client_stats_table[slot].ip);
+    while (client_stats_index[pos] != CLIENT_STATS_SLOT_NONE) {
+      pos = (pos + 1) & (CLIENT_STATS_HASH_SIZE - 1);
+    }
+    client_stats_index[pos] = slot;
+  }
+}
+
+// Look up the client with the given address (linear probing; the index is at
+// most half full once client_stats_init has been called)
+static struct client_stats * ICACHE_FLASH_ATTR client_stats_find(uint32_t ip) {
+  uint8_t pos = client_stats_hash(ip), slot, probes;
+
+  for (probes = 0; probes < CLIENT_STATS_HASH_SIZE; probes++) {
+    slot = client_stats_index[pos];
+    if (slot >= MAX_CLIENTS) {
+      break;
+    }
+    if (client_stats_table[slot].valid && client_stats_table[slot].ip == ip) {
+      return &client_stats_table[slot];
+    }
+    pos = (pos + 1) & (CLIENT_STATS_HASH_SIZE - 1);
+  }
+  return NULL;
+}
+
+// Look up the client with the given MAC-address
+static struct client_stats * ICACHE_FLASH_ATTR client_stats_find_mac(const uint8_t *mac) {
+  uint8_t slot;
+
+  for (slot = 0; slot < MAX_CLIENTS; slot++) {
+    if (client_stats_table[slot].valid && os_memcmp(client_stats_table[slot].mac, mac, 6) == 0) {
+      return &client_stats_table[slot];
+    }
+  }
+  return NULL;
+}
+
+// Assign a slot to a new client; an unused slot is preferred over one of a
+// disassociated client without translation entries, which is preferred over
+// any other disassociated client. Returns NULL, if all clients are associated.
+static struct client_stats * ICACHE_FLASH_ATTR client_stats_alloc(const uint8_t *mac) {
+  struct client_stats *client = NULL;
+  uint8_t slot;
+
+  for (slot = 0; slot < MAX_CLIENTS; slot++) {
+    if (!client_stats_table[slot].valid) {
+      client = &client_stats_table[slot];
+      break;
+    }
+    if (client_stats_table[slot].aid) {
+      continue;
+    }
+    if (!client || (client->napt_entries && !client_stats_table[slot].napt_entries)) {
+      client = &client_stats_table[slot];
+    }
+  }
+  if (!client) {
+    return NULL;
+  }
+
+  if (client->valid && client->ip) {
+    client->ip = 0;
+    client_stats_index_rebuild();
+  }
+  os_memset(client, 0, sizeof(struct client_stats));
+  os_memcpy(client->mac, mac, 6);
+  client->valid = 1;
+  client->window_start = system_get_time();
+  return client;
+}
+
+// Bind the given address to the client (an other client with the same address
+// loses it)
+static void ICACHE_FLASH_ATTR client_stats_bind(struct client_stats *client, uint32_t ip) {
+  struct client_stats *other;
+
+  if (client->ip == ip) {
+    return;
+  }
+  other = (ip) ? client_stats_find(ip) : NULL;
+  if (other) {
+    other->ip = 0;
+    other->napt_entries = 0;
+  }
+  client->ip = ip;
+  client->napt_entries = 0;
+  client_stats_index_rebuild();
+}
+
+// Close the windows of the rates, that have passed until now (in us)
+static void ICACHE_FLASH_ATTR client_stats_roll(struct client_stats *client, uint32_t now) {
+  uint32_t interval = CLIENT_STATS_RATE_INTERVAL * 1000, elapsed = now - client->window_start, rate;
+  uint8_t dir, windows, idx;
+
+  if (elapsed < interval) {
+    return;
+  }
+  windows = (elapsed >= CLIENT_STATS_RATE_WINDOWS * interval) ? CLIENT_STATS_RATE_WINDOWS : elapsed / interval;
+
+  for (dir = 0; dir < 2; dir++) {
+    // The first window contains the forwarded bytes, all others are empty
+    rate = 0;
+    if (windows < CLIENT_STATS_RATE_WINDOWS) {
+      rate = (client->rate[dir] * 3 + client->window_bytes[dir] * 1000 / CLIENT_STATS_RATE_INTERVAL) / 4;
+    }
+    for (idx = 1; idx < windows && rate; idx++) {
+      rate = rate * 3 / 4;
+    }
+    client->rate[dir] = rate;
+    client->window_bytes[dir] = 0;
+  }
+  client->window_start = (windows == CLIENT_STATS_RATE_WINDOWS) ? now : client->window_start + windows * interval;
+}
+
+/*------------------------------------*/
+
+// Status-functions:
+
+// Return the number of clients in the table
+uint8_t ICACHE_FLASH_ATTR client_stats_count(void) {
+  uint8_t slot, count = 0;
+
+  for (slot = 0; slot < MAX_CLIENTS; slot++) {
+    count += client_stats_table[slot].valid;
+  }
+  return count;
+}
+
+// Return the index of the slot of the given client (0 to MAX_CLIENTS - 1), e.g.
+// to keep per-client state in other modules (cf. uplink_sched.c)
+uint8_t ICACHE_FLASH_ATTR client_stats_slot(const struct client_stats *client) {
+  return client - client_stats_table;
+}
+
+// Return the counters of the client with the given address (in network byte
+// order) resp. NULL
+const struct client_stats * ICACHE_FLASH_ATTR client_stats_lookup(uint32_t ip) {
+  return (ip) ? client_stats_find(ip) : NULL;
+}
+
+// Return the counters of the client with the given MAC-address resp. NULL
+const struct client_stats * ICACHE_FLASH_ATTR client_stats_lookup_mac(const uint8_t *mac) {
+  return client_stats_find_mac(mac);
+}
+
+// Iterate over the clients in the table (pass NULL to get the first one);
+// returns NULL after the last one. The rates of the returned client are
+// brought up to date.
+const struct client_stats * ICACHE_FLASH_ATTR client_stats_next(const struct client_stats *client) {
+  uint8_t slot = (client) ? (client - client_stats_table) + 1 : 0;
+
+  for (; slot < MAX_CLIENTS; slot++) {
+    if (client_stats_table[slot].valid) {
+      client_stats_roll(&client_stats_table[slot], system_get_time());
+      return &client_stats_table[slot];
+    }
+  }
+  return NULL;
+}
+
+/*------------------------------------*/
+
+// Accounting:
+
+// Return the client with the given address, to which the packet is accounted
+// after its translation (cf. client_stats_record); for packets from the soft
+// access-point, the MAC-address of the sender is given, so that the address of
+// an unknown client is learned (before the translation creates its entry)
+struct client_stats * ICACHE_FLASH_ATTR client_stats_get(uint32_t ip, const uint8_t *mac) {
+  struct client_stats *client = client_stats_find(ip);
+
+  if (client || !mac || !ip) {
+    return client;
+  }
+  client = client_stats_find_mac(mac);
+  if (!client) {
+    client = client_stats_alloc(mac);
+    if (!client) {
+      return NULL;
+    }
+  }
+  client_stats_bind(client, ip);
+  return client;
+}
+
+// Account a forwarded IP-packet of len bytes to the given client (NULL, if it
+// isn't known)
+void ICACHE_FLASH_ATTR client_stats_record(struct client_stats *client, uint8_t dir, uint16_t len) {
+  if (!client) {
+    return;
+  }
+  client_stats_roll(client, system_get_time());
+  client->packets[dir]++;
+  client->bytes[dir] += len;
+  client->window_bytes[dir] += len;
+}
+
+// Account a created (delta 1) resp. removed (delta -1) translation entry to
+// the client with the given address (cf. napt.c)
+void ICACHE_FLASH_ATTR client_stats_napt(uint32_t ip, int8_t delta) {
+  struct client_stats *client = client_stats_find(ip);
+
+  if (client && (delta > 0 || client->napt_entries)) {
+    client->napt_entries += delta;
+  }
+}
+
+// Reset the counters of the translation entries (the NAPT-table has been
+// cleared)
+void ICACHE_FLASH_ATTR client_stats_napt_reset(void) {
+  uint8_t slot;
+
+  for (slot = 0; slot < MAX_CLIENTS; slot++) {
+    client_stats_table[slot].napt_entries = 0;
+  }
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration:
+
+// A station associated with the soft access-point; ip is the address leased
+// to it by the DHCP-server (0, if unknown). The counters of a station, that
+// has been associated before, are continued.
+void ICACHE_FLASH_ATTR client_stats_connect(const uint8_t *mac, uint8_t aid, uint32_t ip) {
+  struct client_stats *client = client_stats_find_mac(mac);
+
+  if (!client) {
+    client = client_stats_alloc(mac);
+    if (!client) {
+      LOG_WARN("client_stats_connect: No free slot for " MACSTR "!\n", MAC2STR(mac));
+      return;
+    }
+  }
+  client->aid = aid;
+  if (ip) {
+    client_stats_bind(client, ip);
+  }
+}
+
+// A station disassociated from the soft access-point; its counters are kept
+// until the slot is needed for another client
+void ICACHE_FLASH_ATTR client_stats_disconnect(const uint8_t *mac) {
+  struct client_stats *client = client_stats_find_mac(mac);
+
+  if (client) {
+    client->aid = 0;
+  }
+}
+
+// Clear the table
+void ICACHE_FLASH_ATTR client_stats_init(void) {
+  os_memset(client_stats_table, 0, sizeof(client_stats_table));
+  os_memset(client_stats_index, CLIENT_STATS_SLOT_NONE, sizeof(client_stats_index));
+}
@@ -0,0 +1,573 @@
+// config.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Runtime configuration of the router (cf. config.h). The
+// settings, that used to be fixed at compile time (SSID-prefix, password,
+// network of the soft access-point, DHCP-range, DNS-server, portmap entries,
+// number of clients, mesh-mode and -key, rates of the uplink and the
+// timeouts), are
+// kept in a record, which is loaded from the flash at start-up; user_config.h
+// only provides the defaults.
+//
+// The record is protected by a CRC-32 and written alternately to two sectors
+// below the lease store of the DHCP-server (A: user_rf_cal_sector_set() - 2,
+// B: user_rf_cal_sector_set() - 3) with an increasing sequence number. A save
+// only ever erases the sector of the older record, so that a power failure
+// while writing leaves the previous record intact; config_load takes the
+// valid record with the highest sequence number resp. the defaults, if there's
+// none.
+//
+// The configuration can be changed via DEVICE_COM_PORT (cf. device_info.c);
+// config_set and config_reset only modify a staged copy, which config_print
+// shows. config_set only checks the single value, the consistency of the whole
+// copy is checked by config_save, before it's stored and becomes visible via
+// config_get. The changes take effect, when the router is enabled the next
+// time.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "spi_flash.h"
+#include "user_interface.h"
+#include "lwip/ip_addr.h"
+#include "config.h"
+#include "crc32.h"
+#define LOG_MODULE LOG_MODULE_CONFIG
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define CONFIG_MAGIC 0x52474643 // "CFGR"
+#define CONFIG_VERSION 3
+#define CONFIG_SLOT_NONE 0xFF
+#define CONFIG_SSID_PREFIX_MAX 13
+
+// Pre-defined portmap entry (cf. PORTMAP_TABLE in user_config.h)
+struct config_portmap_default {
+  uint8_t proto;
+  uint16_t mport;
+  const char *daddr;
+  uint16_t dport;
+  uint8_t dir;
+};
+
+// Record in the flash
+struct config_record {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t len;       // sizeof(struct config)
+  uint32_t seq;
+  uint32_t crc;       // CRC-32 of config
+  struct config config;
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t config_sector(uint8_t slot);
+static uint32_t config_ntohl(uint32_t addr);
+static bool config_parse_uint(const char *str, uint32_t max, uint32_t *val);
+static bool config_parse_addr(const char *str, uint32_t *addr);
+static bool config_parse_portmap(const char *str, struct config_portmap *portmap);
+static bool config_parse_client_rate(const char *str, struct config_client_rate *client_rate);
+static bool config_string_valid(const char *str, uint16_t size, uint16_t min, uint16_t max);
+static void config_defaults(struct config *config);
+static struct config *config_staged_get(void);
+
+// Access:
+const struct config *config_get(void);
+const struct config_stats *config_stats_get(void);
+uint32_t config_flash_sector(uint8_t below);
+bool config_check(const struct config *config);
+uint16_t config_print(char *buffer, uint16_t size);
+
+// Modification and storage:
+bool config_set(const char *key, const char *value);
+void config_reset(void);
+bool config_save(void);
+bool config_load(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+uint32 user_rf_cal_sector_set(void);
+
+static struct config config;
+static struct config config_staged;         // Modified by config_set resp. config_reset
+static bool config_pending = false;         // config_staged differs from config
+static struct config_record config_record;  // Buffer of the flash operations
+static struct config_stats config_stats = {0, 0, CONFIG_SLOT_NONE, 0};
+static bool config_loaded = false;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Return the sector of the given slot (0 = A, 1 = B) resp. 0, if the flash
+// layout doesn't leave room for it
+static uint32_t ICACHE_FLASH_ATTR config_sector(uint8_t slot) {
+  return config_flash_sector(2 + slot);
+}
+
+// Convert an address from network to host byte order
+static uint32_t ICACHE_FLASH_ATTR config_ntohl(uint32_t addr) {
+  const uint8_t *bytes = (const uint8_t *) &addr;
+
+  return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Parse a decimal number of at most max; returns false, if the string isn't one
+static bool ICACHE_FLASH_ATTR config_parse_uint(const char *str, uint32_t max, uint32_t *val) {
+  uint32_t result = 0;
+
+  if (!*str) {
+    return false;
+  }
+  for (; *str; str++) {
+    if (*str < '0' || *str > '9' || (uint32_t) (*str - '0') > max || result > (max - (*str - '0')) / 10) {
+      return false;
+    }
+    result = result * 10 + (*str - '0');
+  }
+  *val = result;
+  return true;
+}
+
+// Parse an IP-address in dotted decimal notation (network byte order)
+static bool ICACHE_FLASH_ATTR config_parse_addr(const char *str, uint32_t *addr) {
+  uint32_t result = ipaddr_addr(str);
+
+  if (result == IPADDR_NONE) {
+    return false;
+  }
+  *addr = result;
+  return true;
+}
+
+// Parse a portmap entry in the form "proto:mport:daddr:dport:dir" resp. "0"
+// to clear it
+static bool ICACHE_FLASH_ATTR config_parse_portmap(const char *str, struct config_portmap *portmap) {
+  char fields[5][16];
+  uint32_t proto, mport, dport, dir;
+  uint8_t field = 0, len = 0;
+
+  if (!os_strcmp(str, "0")) {
+    os_memset(portmap, 0, sizeof(struct config_portmap));
+    return true;
+  }
+  for (; *str; str++) {
+    if (*str == ':') {
+      fields[field++][len] = '\0';
+      len = 0;
+      if (field == 5) {
+        return false;
+      }
+    }
+    else if (len < sizeof(fields[0]) - 1) {
+      fields[field][len++] = *str;
+    }
+    else {
+      return false;
+    }
+  }
+  fields[field][len] = '\0';
+  if (field != 4 || !config_parse_uint(fields[0], 255, &proto) || !config_parse_uint(fields[1], 65535, &mport) ||
+      !config_parse_addr(fields[2], &portmap->daddr) || !config_parse_uint(fields[3], 65535, &dport) || !config_parse_uint(fields[4], 2, &dir)) {
+    return false;
+  }
+  portmap->proto = proto;
+  portmap->mport = mport;
+  portmap->dport = dport;
+  portmap->dir = dir;
+  portmap->reserved = 0;
+  return true;
+}
+
+// Parse the rate limit of a client in the form "xx:xx:xx:xx:xx:xx:rate" (the
+// MAC-address in hexadecimal notation) resp. "0" to clear it
+static bool ICACHE_FLASH_ATTR config_parse_client_rate(const char *str, struct config_client_rate *client_rate) {
+  uint8_t mac[6], field = 0, digits = 0, nibble;
+  uint32_t rate;
+
+  if (!os_strcmp(str, "0")) {
+    os_memset(client_rate, 0, sizeof(struct config_client_rate));
+    return true;
+  }
+  os_memset(mac, 0, sizeof(mac));
+  for (; field < 6; str++) {
+    if (*str == ':' && digits == 2) {
+      field++;
+      digits = 0;
+      continue;
+    }
+    if (*str >= '0' && *str <= '9') {
+      nibble = *str - '0';
+    }
+    else if ((*str | 0x20) >= 'a' && (*str | 0x20) <= 'f') {
+      nibble = (*str | 0x20) - 'a' + 10;
+    }
+    else {
+      return false;
+    }
+    if (digits == 2) {
+      return false;
+    }
+    mac[field] = (mac[field] << 4) | nibble;
+    digits++;
+  }
+  if (!config_parse_uint(str, 0xFFFFFFFF, &rate) || !rate) {
+    return false;
+  }
+  os_memcpy(client_rate->mac, mac, 6);
+  client_rate->reserved = 0;
+  client_rate->rate = rate;
+  return true;
+}
+
+// Check, if the string is terminated within size and has between min and max
+// characters
+static bool ICACHE_FLASH_ATTR config_string_valid(const char *str, uint16_t size, uint16_t min, uint16_t max) {
+  uint16_t len = 0;
+
+  while (len < size && str[len]) {
+    len++;
+  }
+  return len < size && len >= min && len <= max;
+}
+
+// Fill the configuration with the defaults of user_config.h
+static void ICACHE_FLASH_ATTR config_defaults(struct config *config) {
+  const struct config_portmap_default portmap_table[] = PORTMAP_TABLE;
+  uint16_t idx;
+
+  os_memset(config, 0, sizeof(struct config));
+  os_strncpy(config->ssid_prefix, WIFI_AP_SSID_PREFIX, CONFIG_SSID_PREFIX_MAX);
+  os_strncpy(config->password, WIFI_AP_PASSWORD, CONFIG_PASSWORD_LEN - 1);
+  config->ap_open = WIFI_AP_OPEN;
+  config->ap_hidden = WIFI_AP_HIDDEN;
+  config->max_clients = MAX_CLIENTS;
+  config->mesh = ROUTER_MESH;
+  os_strncpy(config->mesh_key, MESH_KEY, CONFIG_MESH_KEY_LEN - 1);
+  config->ap_addr = ipaddr_addr(WIFI_AP_NETWORK_ADDR);
+  config->ap_netmask = ipaddr_addr(WIFI_AP_NETWORK_NETMASK);
+  config->ap_gw = ipaddr_addr(WIFI_AP_NETWORK_GW);
+  config->dhcp_start = ipaddr_addr(DHCP_START_ADDR);
+  config->dhcp_stop = ipaddr_addr(DHCP_STOP_ADDR);
+  config->dns_server = (DNS_SERVER_IP) ? ipaddr_addr(DNS_SERVER_IP) : 0;
+  config->conn_timeout = ROUTER_CONN_TIMEOUT;
+  config->reconnect_timeout = ROUTER_RECONNECT_TIMEOUT;
+  config->vital_sign_interval = VITAL_SIGN_TIME_INTERVAL;
+  config->uplink_rate = UPLINK_SCHED_RATE;
+  for (idx = 0; idx < sizeof(portmap_table) / sizeof(portmap_table[0]) && idx < CONFIG_PORTMAPS_MAX; idx++) {
+    config->portmap[idx].proto = portmap_table[idx].proto;
+    config->portmap[idx].mport = portmap_table[idx].mport;
+    config->portmap[idx].daddr = ipaddr_addr(portmap_table[idx].daddr);
+    config->portmap[idx].dport = portmap_table[idx].dport;
+    config->portmap[idx].dir = portmap_table[idx].dir;
+  }
+}
+
+// Return the staged copy of the configuration, which is taken from the
+// current one, if there are no pending modifications
+static struct config * ICACHE_FLASH_ATTR config_staged_get(void) {
+  if (!config_pending) {
+    os_memcpy(&config_staged, config_get(), sizeof(struct config));
+    config_pending = true;
+  }
+  return &config_staged;
+}
+
+/*------------------------------------*/
+
+// Access:
+
+// Return the configuration; the defaults are used, if it hasn't been loaded
+const struct config * ICACHE_FLASH_ATTR config_get(void) {
+  if (!config_loaded) {
+    config_defaults(&config);
+    config_loaded = true;
+  }
+  return &config;
+}
+
+const struct config_stats * ICACHE_FLASH_ATTR config_stats_get(void) {
+  return &config_stats;
+}
+
+// Return the sector, that lies the given number of sectors below the
+// RF-calibration-sector, resp. 0, if the flash layout doesn't leave room for
+// it (user_rf_cal_sector_set returns 0 for unknown flash maps)
+uint32_t ICACHE_FLASH_ATTR config_flash_sector(uint8_t below) {
+  uint32_t sector = user_rf_cal_sector_set();
+
+  return (sector > below) ? sector - below : 0;
+}
+
+// Check the consistency of the configuration: the router's address and the
+// DHCP-range have to be within the soft access-point's network, the strings
+// have to fit into the WiFi-configuration, the timeouts mustn't be 0 and the
+// rates have to allow a packet of the MTU per second
+bool ICACHE_FLASH_ATTR config_check(const struct config *config) {
+  const struct config_client_rate *client_rate;
+  uint32_t addr = config_ntohl(config->ap_addr);
+  uint32_t netmask = config_ntohl(config->ap_netmask);
+  uint32_t start = config_ntohl(config->dhcp_start);
+  uint32_t stop = config_ntohl(config->dhcp_stop);
+  const struct config_portmap *portmap;
+
+  if (!config_string_valid(config->ssid_prefix, CONFIG_SSID_PREFIX_LEN, 1, CONFIG_SSID_PREFIX_MAX) ||
+      !config_string_valid(config->password, CONFIG_PASSWORD_LEN, (config->ap_open) ? 0 : 8, CONFIG_PASSWORD_LEN - 1) ||
+      !config_string_valid(config->mesh_key, CONFIG_MESH_KEY_LEN, (config->mesh) ? 8 : 0, CONFIG_MESH_KEY_LEN - 1)) {
+    return false;
+  }
+  if (config->ap_open > 1 || config->ap_hidden > 1 || !config->max_clients || config->max_clients > MAX_CLIENTS || config->mesh > 1) {
+    return false;
+  }
+  // The netmask has to be contiguous and leave room for hosts; the router
+  // mustn't take the network's or broadcast address (the DHCP-server skips
+  // them and the router's address, cf. addr_pool.c)
+  if (!netmask || (~netmask & (~netmask + 1)) || ~netmask < 2) {
+    return false;
+  }
+  if (!(addr & ~netmask) || (addr & ~netmask) == ~netmask || start > stop || (start & netmask) != (addr & netmask) ||
+      (stop & netmask) != (addr & netmask)) {
+    return false;
+  }
+  if (config->conn_timeout < 1000 || config->reconnect_timeout < 1000 || config->vital_sign_interval < VITAL_SIGN_SAMPLES * 1000) {
+    return false;
+  }
+  for (portmap = config->portmap; portmap < config->portmap + CONFIG_PORTMAPS_MAX; portmap++) {
+    if (portmap->proto && (!portmap->mport || !portmap->dport || !portmap->dir)) {
+      return false;
+    }
+  }
+  if (config->uplink_rate && config->uplink_rate < CONFIG_RATE_MIN) {
+    return false;
+  }
+  for (client_rate = config->client_rate; client_rate < config->client_rate + CONFIG_CLIENT_RATES_MAX; client_rate++) {
+    if (client_rate->rate && client_rate->rate < CONFIG_RATE_MIN) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Print the staged configuration (without the password and the mesh-key) as "CONFIG,<seq>,<slot>,
+// <load_us>,<key>=<value>,...\n" into the buffer (of the given size); returns
+// the length resp. 0, if it doesn't fit
+uint16_t ICACHE_FLASH_ATTR config_print(char *buffer, uint16_t size) {
+  const struct config *current = (config_pending) ? &config_staged : config_get();
+  const struct config_client_rate *client_rate;
+  const struct config_portmap *portmap;
+  uint16_t len;
+  uint8_t idx;
+
+  // The fixed part takes at most 416, every portmap resp. rate limit entry at
+  // most 48 bytes
+  if (!buffer || size < 416 + (CONFIG_PORTMAPS_MAX + CONFIG_CLIENT_RATES_MAX) * 48) {
+    LOG_ERROR("config_print: Invalid transfer parameters!\n");
+    return 0;
+  }
+  len = os_sprintf(buffer, "CONFIG,%u,%c,%u,ssid_prefix=%.13s,ap_open=%u,ap_hidden=%u,max_clients=%u,mesh=%u,", config_stats.seq,
+                   (config_stats.slot == CONFIG_SLOT_NONE) ? '-' : 'A' + config_stats.slot, config_stats.load_us,
+                   current->ssid_prefix, current->ap_open, current->ap_hidden, current->max_clients, current->mesh);
+  len += os_sprintf(buffer + len, "ap_addr=" IPSTR ",ap_netmask=" IPSTR ",ap_gw=" IPSTR ",", IP2STR(&current->ap_addr),
+                    IP2STR(&current->ap_netmask), IP2STR(&current->ap_gw));
+  len += os_sprintf(buffer + len, "dhcp_start=" IPSTR ",dhcp_stop=" IPSTR ",dns_server=" IPSTR ",", IP2STR(&current->dhcp_start),
+                    IP2STR(&current->dhcp_stop), IP2STR(&current->dns_server));
+  len += os_sprintf(buffer + len, "conn_timeout=%u,reconnect_timeout=%u,vital_sign_interval=%u,uplink_rate=%u", current->conn_timeout,
+                    current->reconnect_timeout, current->vital_sign_interval, current->uplink_rate);
+  for (idx = 0; idx < CONFIG_PORTMAPS_MAX; idx++) {
+    portmap = &current->portmap[idx];
+    if (portmap->proto) {
+      len += os_sprintf(buffer + len, ",portmap%u=%u:%u:" IPSTR ":%u:%u", idx, portmap->proto, portmap->mport,
+                        IP2STR(&portmap->daddr), portmap->dport, portmap->dir);
+    }
+  }
+  for (idx = 0; idx < CONFIG_CLIENT_RATES_MAX; idx++) {
+    client_rate = &current->client_rate[idx];
+    if (client_rate->rate) {
+      len += os_sprintf(buffer + len, ",client_rate%u=" MACSTR ":%u", idx, MAC2STR(client_rate->mac), client_rate->rate);
+    }
+  }
+  buffer[len++] = '\n';
+  return len;
+}
+
+/*------------------------------------*/
+
+// Modification and storage:
+
+// Set the value of the given key in the staged copy (cf. the keys printed by
+// config_print, password, mesh_key, portmap0 to portmap7 and client_rate0 to
+// client_rate3); returns false, if the key is unknown or the value is invalid
+bool ICACHE_FLASH_ATTR config_set(const char *key, const char *value) {
+  struct config *current = config_staged_get();
+  uint32_t val;
+
+  if (!key || !value) {
+    return false;
+  }
+  if (!os_strcmp(key, "ssid_prefix")) {
+    if (!config_string_valid(value, CONFIG_SSID_PREFIX_MAX + 1, 1, CONFIG_SSID_PREFIX_MAX)) {
+      return false;
+    }
+    os_memset(current->ssid_prefix, 0, CONFIG_SSID_PREFIX_LEN);
+    os_strcpy(current->ssid_prefix, value);
+  }
+  else if (!os_strcmp(key, "password")) {
+    if (!config_string_valid(value, CONFIG_PASSWORD_LEN, 0, CONFIG_PASSWORD_LEN - 1)) {
+      return false;
+    }
+    os_memset(current->password, 0, CONFIG_PASSWORD_LEN);
+    os_strcpy(current->password, value);
+  }
+  else if (!os_strcmp(key, "ap_open") && config_parse_uint(value, 1, &val)) {
+    current->ap_open = val;
+  }
+  else if (!os_strcmp(key, "ap_hidden") && config_parse_uint(value, 1, &val)) {
+    current->ap_hidden = val;
+  }
+  else if (!os_strcmp(key, "max_clients") && config_parse_uint(value, MAX_CLIENTS, &val) && val) {
+    current->max_clients = val;
+  }
+  else if (!os_strcmp(key, "mesh") && config_parse_uint(value, 1, &val)) {
+    current->mesh = val;
+  }
+  else if (!os_strcmp(key, "mesh_key")) {
+    if (!config_string_valid(value, CONFIG_MESH_KEY_LEN, 0, CONFIG_MESH_KEY_LEN - 1)) {
+      return false;
+    }
+    os_memset(current->mesh_key, 0, CONFIG_MESH_KEY_LEN);
+    os_strcpy(current->mesh_key, value);
+  }
+  else if (!os_strcmp(key, "ap_addr")) {
+    return config_parse_addr(value, &current->ap_addr);
+  }
+  else if (!os_strcmp(key, "ap_netmask")) {
+    return config_parse_addr(value, &current->ap_netmask);
+  }
+  else if (!os_strcmp(key, "ap_gw")) {
+    return config_parse_addr(value, &current->ap_gw);
+  }
+  else if (!os_strcmp(key, "dhcp_start")) {
+    return config_parse_addr(value, &current->dhcp_start);
+  }
+  else if (!os_strcmp(key, "dhcp_stop")) {
+    return config_parse_addr(value, &current->dhcp_stop);
+  }
+  else if (!os_strcmp(key, "dns_server")) {
+    return config_parse_addr(value, &current->dns_server);
+  }
+  else if (!os_strcmp(key, "conn_timeout")) {
+    return config_parse_uint(value, 0xFFFFFFFF, &current->conn_timeout);
+  }
+  else if (!os_strcmp(key, "reconnect_timeout")) {
+    return config_parse_uint(value, 0xFFFFFFFF, &current->reconnect_timeout);
+  }
+  else if (!os_strcmp(key, "vital_sign_interval")) {
+    return config_parse_uint(value, 0xFFFFFFFF, &current->vital_sign_interval);
+  }
+  else if (!os_strcmp(key, "uplink_rate")) {
+    return config_parse_uint(value, 0xFFFFFFFF, &current->uplink_rate);
+  }
+  else if (!os_strncmp(key, "client_rate", 11) && config_parse_uint(key + 11, CONFIG_CLIENT_RATES_MAX - 1, &val)) {
+    return config_parse_client_rate(value, &current->client_rate[val]);
+  }
+  else if (!os_strncmp(key, "portmap", 7) && config_parse_uint(key + 7, CONFIG_PORTMAPS_MAX - 1, &val)) {
+    return config_parse_portmap(value, &current->portmap[val]);
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// Restore the defaults in the staged copy (they're stored and applied with the
+// next config_save)
+void ICACHE_FLASH_ATTR config_reset(void) {
+  config_defaults(&config_staged);
+  config_pending = true;
+}
+
+// Write the staged configuration to the sector of the older record and make it
+// the current one; returns false, if it's inconsistent or couldn't be written
+bool ICACHE_FLASH_ATTR config_save(void) {
+  const struct config *staged = config_staged_get();
+  uint8_t slot = (config_stats.slot == 0) ? 1 : 0;
+  uint32_t sector = config_sector(slot);
+
+  if (!config_check(staged)) {
+    LOG_ERROR("config_save: Inconsistent configuration!\n");
+    return false;
+  }
+  if (!sector) {
+    LOG_ERROR("config_save: No sector available!\n");
+    return false;
+  }
+
+  os_memcpy(&config_record.config, staged, sizeof(struct config));
+  config_record.magic = CONFIG_MAGIC;
+  config_record.version = CONFIG_VERSION;
+  config_record.len = sizeof(struct config);
+  config_record.seq = config_stats.seq + 1;
+  config_record.crc = crc32((uint8_t *) &config_record.config, sizeof(struct config));
+  if (spi_flash_erase_sector(sector) != SPI_FLASH_RESULT_OK || spi_flash_write(sector * SPI_FLASH_SEC_SIZE, (uint32 *) &config_record, sizeof(config_record)) != SPI_FLASH_RESULT_OK) {
+    LOG_ERROR("config_save: Failed to write the configuration!\n");
+    return false;
+  }
+  os_memcpy(&config, staged, sizeof(struct config));
+  config_pending = false;
+  config_stats.seq = config_record.seq;
+  config_stats.slot = slot;
+  config_stats.saves++;
+  LOG_INFO("config_save: Saved record %u to sector %c!\n", config_stats.seq, 'A' + slot);
+  return true;
+}
+
+// Load the valid record with the highest sequence number; the defaults are
+// used, if there's none (pending modifications are discarded)
+bool ICACHE_FLASH_ATTR config_load(void) {
+  uint32_t start = system_get_time();
+  uint32_t sector;
+  uint8_t slot;
+
+  config_stats.slot = CONFIG_SLOT_NONE;
+  config_stats.seq = 0;
+  for (slot = 0; slot < 2; slot++) {
+    sector = config_sector(slot);
+    if (!sector || spi_flash_read(sector * SPI_FLASH_SEC_SIZE, (uint32 *) &config_record, sizeof(config_record)) != SPI_FLASH_RESULT_OK) {
+      continue;
+    }
+    if (config_record.magic != CONFIG_MAGIC || config_record.version != CONFIG_VERSION || config_record.len != sizeof(struct config) ||
+        config_record.crc != crc32((uint8_t *) &config_record.config, sizeof(struct config)) || !config_check(&config_record.config)) {
+      continue;
+    }
+    // Take the newer record (the sequence numbers may wrap around)
+    if (config_stats.slot == CONFIG_SLOT_NONE || (int32_t) (config_record.seq - config_stats.seq) > 0) {
+      os_memcpy(&config, &config_record.config, sizeof(struct config));
+      config_stats.seq = config_record.seq;
+      config_stats.slot = slot;
+    }
+  }
+  if (config_stats.slot == CONFIG_SLOT_NONE) {
+    config_defaults(&config);
+  }
+  config_loaded = true;
+  config_pending = false;
+  config_stats.load_us = system_get_time() - start;
+
+  if (config_stats.slot == CONFIG_SLOT_NONE) {
+    LOG_INFO("config_load: No valid record found, using the defaults (%u us)!\n", config_stats.load_us);
+    return false;
+  }
+  LOG_INFO("config_load: Loaded record %u from sector %c (%u us)!\n", config_stats.seq, 'A' + config_stats.slot, config_stats.load_us);
+  return true;
+}
@@ -9,7 +9,15 @@
 // to it. Other members of the same network can request this information via UDP.
 // Furthermore, the possibility to periodically broadcast a vital sign is
 // implemented, thus allowing an automated availability-monitoring of the mesh-
-// nodes.
+// nodes. The vital sign is a binary telemetry frame (cf. telemetry.c) carrying
+// the samples of the last VITAL_SIGN_TIME_INTERVAL.
+//
+// Additionally, the counters of the NAPT-engine (cf. napt.c), of the DNS-proxy
+// (cf. dns_proxy.c) and of the clients of the soft access-point (cf.
+// client_stats.c) can be requested via the same socket to monitor the
+// forwarding performance of the router, as well as the ring buffer of the log
+// (cf. log.c). The clients of the soft access-point can read, change and store
+// the configuration of the router (cf. config.c) via the same socket.
 //
 // This class is based on https://github.com/espressif/ESP8266_MESH_DEMO/tree/master/mesh_performance/scenario/devicefind.c
 
@@ -20,6 +28,14 @@
 #include "espconn.h"
 #include "user_interface.h"
 #include "device_info.h"
+#include "mem_pool.h"
+#include "napt.h"
+#include "dns_proxy.h"
+#include "client_stats.h"
+#include "telemetry.h"
+#include "config.h"
+#define LOG_MODULE LOG_MODULE_DEVICE_INFO
+#include "log.h"
 #include "user_config.h"
 
 /*------------------------------------*/
@@ -27,6 +43,15 @@
 // Definition of functions (so there won't be any complications because the
 // compiler resolves the scope top-down):
 
+// Helper-functions:
+static void udp_info_reply(char *msg, uint16_t msg_len);
+static bool udp_info_from_softap(void);
+static bool config_request_handle(char *data, unsigned short len);
+static uint16_t napt_stats_print(char *buffer);
+static uint16_t mem_stats_print(char *buffer, uint16_t size);
+static uint16_t dns_stats_print(char *buffer);
+static uint16_t client_stats_print(char *buffer, uint16_t size);
+
 // Callback-functions:
 static void udp_info_recv_cb(void *arg, char *data, unsigned short len);
 
@@ -36,7 +61,7 @@ static void vital_sign_broadcast(void);
 // Initialization and configuration resp. termination:
 void vital_sign_bcast_stop(void);
 void vital_sign_bcast_start(void);
-void device_info_init(void);
+void device_info_disable(void);
 void device_info_init(void);
 
 /*------------------------------------*/
@@ -44,34 +69,208 @@ void device_info_init(void);
 // Declaration and initialization of variables:
 
 const static char *meta_data_request_string = META_DATA_REQUEST_STRING; // Local copy of META_DATA_REQUEST_STRING
+const static char *napt_stats_request_string = NAPT_STATS_REQUEST_STRING; // Local copy of NAPT_STATS_REQUEST_STRING
+const static char *mem_stats_request_string = MEM_STATS_REQUEST_STRING; // Local copy of MEM_STATS_REQUEST_STRING
+const static char *dns_stats_request_string = DNS_STATS_REQUEST_STRING; // Local copy of DNS_STATS_REQUEST_STRING
+const static char *client_stats_request_string = CLIENT_STATS_REQUEST_STRING; // Local copy of CLIENT_STATS_REQUEST_STRING
+const static char *log_request_string = LOG_REQUEST_STRING; // Local copy of LOG_REQUEST_STRING
+const static char *config_request_string = CONFIG_REQUEST_STRING; // Local copy of CONFIG_REQUEST_STRING
+const static char *config_set_request_string = CONFIG_SET_REQUEST_STRING; // Local copy of CONFIG_SET_REQUEST_STRING
+const static char *config_save_request_string = CONFIG_SAVE_REQUEST_STRING; // Local copy of CONFIG_SAVE_REQUEST_STRING
+const static char *config_reset_request_string = CONFIG_RESET_REQUEST_STRING; // Local copy of CONFIG_RESET_REQUEST_STRING
 
 static struct espconn *udp_com_socket = NULL;
 
 static os_timer_t *vital_sign_timer = NULL;
+static struct telemetry_sample vital_sign_samples[VITAL_SIGN_SAMPLES];  // Samples of the current interval
+static uint8_t vital_sign_count = 0;
+static uint16_t vital_sign_seq = 0;
 
 static char msg_buffer[64]; // Buffer to store the device info
+static uint8_t telemetry_buffer[TELEMETRY_HEADER_LEN + VITAL_SIGN_SAMPLES * TELEMETRY_SAMPLE_LEN]; // Buffer to store the vital sign
+static char stats_buffer[1024];  // Buffer to store the NAPT-, memory- resp. client-statistics
+                                // (the counters of MAX_CLIENTS clients fit)
+                                // resp. the configuration
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Return the given message to the sender of the last received UDP-message
+static void ICACHE_FLASH_ATTR udp_info_reply(char *msg, uint16_t msg_len) {
+  remot_info *con_info = NULL;
+
+  // Get the connection information
+  if (espconn_get_connection_info(udp_com_socket, &con_info, 0) == ESPCONN_OK) {
+    os_memcpy(udp_com_socket->proto.udp->remote_ip, con_info->remote_ip, sizeof(struct ip_addr));
+    udp_com_socket->proto.udp->remote_port = con_info->remote_port;
+
+    // Return the message to the sender
+    if (espconn_sendto(udp_com_socket, msg, msg_len) == ESPCONN_OK) {
+      LOG_DEBUG("udp_info_reply: Sent reply to " IPSTR ":%d!\n", IP2STR(udp_com_socket->proto.udp->remote_ip), udp_com_socket->proto.udp->remote_port);
+    }
+    else {
+      LOG_ERROR("udp_info_reply: Error while sending the reply!\n");
+    }
+  }
+  else {
+    LOG_ERROR("udp_info_reply: Failed to retrieve connection info!\n");
+  }
+}
+
+// Check, if the sender of the last received UDP-message is in the soft
+// access-point's network
+static bool ICACHE_FLASH_ATTR udp_info_from_softap(void) {
+  remot_info *con_info = NULL;
+  struct ip_info softap_info;
+  uint32_t remote_ip;
+
+  if (espconn_get_connection_info(udp_com_socket, &con_info, 0) != ESPCONN_OK || !wifi_get_ip_info(SOFTAP_IF, &softap_info) || !softap_info.ip.addr) {
+    return false;
+  }
+  os_memcpy(&remote_ip, con_info->remote_ip, sizeof(remote_ip));
+  return ip_addr_netcmp((ip_addr_t *) &remote_ip, &softap_info.ip, &softap_info.netmask);
+}
+
+// Handle the requests concerning the configuration (cf. CONFIG_*_REQUEST_STRING
+// in user_config.h); returns false, if the message isn't one
+static bool ICACHE_FLASH_ATTR config_request_handle(char *data, unsigned short len) {
+  uint16_t prefix_len = os_strlen(config_set_request_string);
+  bool ok;
+  char *key, *value;
+
+  if (len == os_strlen(config_request_string) && os_memcmp(data, config_request_string, len) == 0) {
+    if (udp_info_from_softap()) {
+      udp_info_reply(stats_buffer, config_print(stats_buffer, sizeof(stats_buffer)));
+    }
+  }
+  else if (len > prefix_len && len < sizeof(stats_buffer) && os_memcmp(data, config_set_request_string, prefix_len) == 0) {
+    // Split "<key> <value>\n" at the first space
+    os_memcpy(stats_buffer, data + prefix_len, len - prefix_len);
+    stats_buffer[len - prefix_len] = '\0';
+    key = stats_buffer;
+    value = (char *) os_strstr(key, " ");
+    ok = (value && stats_buffer[len - prefix_len - 1] == '\n' && udp_info_from_softap());
+    if (ok) {
+      *value++ = '\0';
+      stats_buffer[len - prefix_len - 1] = '\0';
+      ok = config_set(key, value);
+      LOG_INFO("config_request_handle: %s %.32s!\n", (ok) ? "Set" : "Failed to set", key);
+    }
+    udp_info_reply((ok) ? "OK\n" : "ERROR\n", (ok) ? 3 : 6);
+  }
+  else if (len == os_strlen(config_save_request_string) && os_memcmp(data, config_save_request_string, len) == 0) {
+    ok = udp_info_from_softap() && config_save();
+    udp_info_reply((ok) ? "OK\n" : "ERROR\n", (ok) ? 3 : 6);
+  }
+  else if (len == os_strlen(config_reset_request_string) && os_memcmp(data, config_reset_request_string, len) == 0) {
+    ok = udp_info_from_softap();
+    if (ok) {
+      config_reset();
+    }
+    udp_info_reply((ok) ? "OK\n" : "ERROR\n", (ok) ? 3 : 6);
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// Print the counters of the NAPT-engine into the given buffer and return the
+// length of the resulting String
+// Structure: NAPT,TIMESTAMP,ENTRIES,ACTIVE_TCP,ACTIVE_UDP,ACTIVE_ICMP,PACKETS_OUT,BYTES_OUT,PACKETS_IN,BYTES_IN,
+// HITS,MISSES,ALLOCS,EVICTIONS,DROPS,FASTPATH,LATENCY_SUM_US,LATENCY_MAX_US,
+// HISTOGRAM...
+// (allows easy CSV-parsing; bucket n of the histogram counts the packets
+// forwarded in less than 2^n us)
+static uint16_t ICACHE_FLASH_ATTR napt_stats_print(char *buffer) {
+  const struct napt_stats *stats = napt_stats_get();
+  uint16_t len;
+  uint8_t bucket;
+
+  len = os_sprintf(buffer, "NAPT,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", system_get_time(), napt_count(),
+                   stats->nr_active_napt_tcp, stats->nr_active_napt_udp, stats->nr_active_napt_icmp,
+                   stats->packets[NAPT_DIR_OUT], stats->bytes[NAPT_DIR_OUT], stats->packets[NAPT_DIR_IN], stats->bytes[NAPT_DIR_IN],
+                   stats->hits, stats->misses, stats->allocs, stats->evictions, stats->drops, stats->fastpath, stats->latency_sum, stats->latency_max);
+  for (bucket = 0; bucket < NAPT_STATS_LATENCY_BUCKETS; bucket++) {
+    len += os_sprintf(buffer + len, ",%u", stats->latency[bucket]);
+  }
+  len += os_sprintf(buffer + len, "\n");
+  return len;
+}
+
+// Print the utilization of the memory pools into the given buffer (of the given
+// size) and return the length of the resulting String
+// Structure: MEM,TIMESTAMP,FREE_HEAP,NAME,USED,BLOCKS,HIGH_WATER,FAILURES,...
+// (one group of five fields per pool; pools, that don't fit into the buffer,
+// are omitted)
+static uint16_t ICACHE_FLASH_ATTR mem_stats_print(char *buffer, uint16_t size) {
+  const struct mem_pool *pool;
+  uint16_t len;
+
+  len = os_sprintf(buffer, "MEM,%u,%u", system_get_time(), system_get_free_heap_size());
+  for (pool = mem_pool_first(); pool; pool = pool->next) {
+    if (len + os_strlen(pool->name) + 4 * 11 + 2 >= size) {
+      break;
+    }
+    len += os_sprintf(buffer + len, ",%s,%u,%u,%u,%u", pool->name, pool->used, pool->blocks, pool->high_water, pool->failures);
+  }
+  len += os_sprintf(buffer + len, "\n");
+  return len;
+}
+
+// Print the counters of the DNS-proxy into the given buffer and return the
+// length of the resulting String
+// Structure: DNS,TIMESTAMP,ENTRIES,QUERIES,HITS,COALESCED,UPSTREAM,ANSWERS,DROPS
+// (allows easy CSV-parsing)
+static uint16_t ICACHE_FLASH_ATTR dns_stats_print(char *buffer) {
+  const struct dns_proxy_stats *stats = dns_proxy_stats_get();
+
+  return os_sprintf(buffer, "DNS,%u,%u,%u,%u,%u,%u,%u,%u\n", system_get_time(), dns_proxy_count(),
+                    stats->queries, stats->hits, stats->coalesced, stats->upstream, stats->answers, stats->drops);
+}
+
+// Print the counters of the clients of the soft access-point into the given
+// buffer (of the given size) and return the length of the resulting String
+// Structure: CLIENTS,TIMESTAMP,COUNT,MAC,AID,IP,PACKETS_OUT,BYTES_OUT,PACKETS_IN,
+// BYTES_IN,NAPT_ENTRIES,RATE_OUT,RATE_IN,...
+// (one group of ten fields per client; AID 0 marks a disassociated client,
+// the rates are given in bytes/s)
+static uint16_t ICACHE_FLASH_ATTR client_stats_print(char *buffer, uint16_t size) {
+  const struct client_stats *client;
+  uint16_t len;
+
+  len = os_sprintf(buffer, "CLIENTS,%u,%u", system_get_time(), client_stats_count());
+  for (client = client_stats_next(NULL); client; client = client_stats_next(client)) {
+    if (len + 18 + 4 + 16 + 7 * 11 + 2 >= size) {
+      break;
+    }
+    len += os_sprintf(buffer + len, "," MACSTR ",%u," IPSTR ",%u,%u,%u,%u,%u,%u,%u", MAC2STR(client->mac), client->aid, IP2STR(&client->ip),
+                      client->packets[NAPT_DIR_OUT], client->bytes[NAPT_DIR_OUT], client->packets[NAPT_DIR_IN], client->bytes[NAPT_DIR_IN],
+                      client->napt_entries, client->rate[NAPT_DIR_OUT], client->rate[NAPT_DIR_IN]);
+  }
+  len += os_sprintf(buffer + len, "\n");
+  return len;
+}
 
 /*------------------------------------*/
 
 // Callback-functions:
 
-// Check the content of the received UDP-message and forward the nodes meta-data
-// to the sender in case of a valid request
+// Check the content of the received UDP-message and forward the nodes meta-data,
+// the NAPT-, memory-, DNS- or client-statistics, the newest messages of the
+// log resp. the configuration to the sender in case of a valid request
 static void ICACHE_FLASH_ATTR udp_info_recv_cb(void *arg, char *data, unsigned short len) {
   if (!arg || !data || len == 0) {
-    os_printf("udp_info_recv_cb: Invalid transfer parameters!\n");
+    LOG_ERROR("udp_info_recv_cb: Invalid transfer parameters!\n");
     return;
   }
 
-  // Print the received message
-  os_printf("udp_info_recv_cb: %s\n", data);
-
   // Check, if the message is a valid information-request
   if (len == os_strlen(meta_data_request_string) && os_memcmp(data, meta_data_request_string, len) == 0) {
     uint8_t resp_len = 0, op_mode = 0;
     struct ip_info ipconfig;
     uint8_t mac_addr[6];  // Refrain from using mesh_device_mac_type from mesh_device.h at this point to keep this class seperated from the mesh-application and therewith independent
-    remot_info *con_info = NULL;
 
     // Check for the operation-mode of the device and get the respective IP- and
     // MAC-address
@@ -94,38 +293,57 @@ static void ICACHE_FLASH_ATTR udp_info_recv_cb(void *arg, char *data, unsigned s
       // Structure: PURPOSE,MAC,IP (allows easy CSV-parsing)
       resp_len = os_sprintf(msg_buffer, "%s," MACSTR "," IPSTR "\n", DEVICE_PURPOSE, MAC2STR(mac_addr), IP2STR(&ipconfig.ip));
 
-      // Get the connection information
-      if (espconn_get_connection_info(udp_com_socket, &con_info, 0) == ESPCONN_OK) {
-        os_memcpy(udp_com_socket->proto.udp->remote_ip, con_info->remote_ip, sizeof(struct ip_addr));
-        udp_com_socket->proto.udp->remote_port = con_info->remote_port;
-
-        // Return the devices meta-data to the sender
-        if (espconn_sendto(udp_com_socket, msg_buffer, resp_len) == ESPCONN_OK) {
-          os_printf("udp_info_recv_cb: Sent meta-data to " IPSTR ":%d!\n", IP2STR(udp_com_socket->proto.udp->remote_ip), udp_com_socket->proto.udp->remote_port);
-        }
-        else {
-          os_printf("udp_info_recv_cb: Error while sending meta-data!\n");
-        }
-      }
-      else {
-        os_printf("udp_info_recv_cb: Failed to retrieve connection info!\n");
-      }
+      // Return the devices meta-data to the sender
+      udp_info_reply(msg_buffer, resp_len);
     }
     else {
-      os_printf("udp_info_recv_cb: Wrong WiFi-operation-mode!\n");
+      LOG_ERROR("udp_info_recv_cb: Wrong WiFi-operation-mode!\n");
     }
   }
+  // Check, if the message is a request for the NAPT-statistics
+  else if (len == os_strlen(napt_stats_request_string) && os_memcmp(data, napt_stats_request_string, len) == 0) {
+    udp_info_reply(stats_buffer, napt_stats_print(stats_buffer));
+  }
+  // Check, if the message is a request for the utilization of the memory pools
+  else if (len == os_strlen(mem_stats_request_string) && os_memcmp(data, mem_stats_request_string, len) == 0) {
+    udp_info_reply(stats_buffer, mem_stats_print(stats_buffer, sizeof(stats_buffer)));
+  }
+  // Check, if the message is a request for the counters of the DNS-proxy
+  else if (len == os_strlen(dns_stats_request_string) && os_memcmp(data, dns_stats_request_string, len) == 0) {
+    udp_info_reply(stats_buffer, dns_stats_print(stats_buffer));
+  }
+  // Check, if the message is a request for the counters of the clients
+  else if (len == os_strlen(client_stats_request_string) && os_memcmp(data, client_stats_request_string, len) == 0) {
+    udp_info_reply(stats_buffer, client_stats_print(stats_buffer, sizeof(stats_buffer)));
+  }
+  // Check, if the message is a request for the log's ring buffer
+  else if (len == os_strlen(log_request_string) && os_memcmp(data, log_request_string, len) == 0) {
+    udp_info_reply(stats_buffer, log_dump(stats_buffer, sizeof(stats_buffer)));
+  }
+  // Check, if the message is a request concerning the configuration
+  else if (config_request_handle(data, len)) {
+    LOG_DEBUG("udp_info_recv_cb: Handled a configuration request!\n");
+  }
 }
 
 /*------------------------------------*/
 
 // Timer-functions:
 
-// Broadcasts a vital sign to all other devices in the network
+// Take a sample of the router's state and broadcast the samples of the last
+// vital sign interval (cf. config.c) as a telemetry frame (cf. telemetry.h) to all other
+// devices in the network, once VITAL_SIGN_SAMPLES have been taken
 static void ICACHE_FLASH_ATTR vital_sign_broadcast(void) {
-  uint8_t msg_len = 0, op_mode = 0;
+  struct telemetry_header header;
+  uint8_t op_mode = 0;
+  uint16_t msg_len;
   struct ip_info ipconfig;
-  uint8_t mac_addr[6];  // Refrain from using mesh_device_mac_type from mesh_device.h at this point to keep this class seperated from the mesh-application and therewith independent
+
+  telemetry_sample_take(&vital_sign_samples[vital_sign_count++], true);
+  if (vital_sign_count < VITAL_SIGN_SAMPLES) {
+    return;
+  }
+  vital_sign_count = 0;
 
   // Check for the operation-mode of the device and get the respective IP- and
   // MAC-address
@@ -133,46 +351,44 @@ static void ICACHE_FLASH_ATTR vital_sign_broadcast(void) {
   if (op_mode == SOFTAP_MODE || op_mode == STATION_MODE || op_mode == STATIONAP_MODE) { // Prevent errors resulting from runtime-conditions concerning the WiFi-operation-mode (e.g. if the device is switched into sleep-mode)
     if (op_mode == SOFTAP_MODE) {
       wifi_get_ip_info(SOFTAP_IF, &ipconfig);
-      wifi_get_macaddr(SOFTAP_IF, mac_addr);
+      wifi_get_macaddr(SOFTAP_IF, header.mac);
     }
     else {
       wifi_get_ip_info(STATION_IF, &ipconfig);
-      wifi_get_macaddr(STATION_IF, mac_addr);
+      wifi_get_macaddr(STATION_IF, header.mac);
     }
 
-    // Clear the Buffer
-    os_memset(msg_buffer, 0, sizeof(msg_buffer));
-
-    // Print the devices meta-data into the buffer and obtain the actual length
-    // of the resulting String
-    // Structure: MAC,TIMESTAMP (allows easy CSV-parsing)
-    msg_len = os_sprintf(msg_buffer, MACSTR ",%d\n", MAC2STR(mac_addr), system_get_time());
+    // Encode the samples into a single frame
+    header.count = VITAL_SIGN_SAMPLES;
+    header.seq = vital_sign_seq++;
+    header.interval = config_get()->vital_sign_interval / VITAL_SIGN_SAMPLES;
+    msg_len = telemetry_encode(telemetry_buffer, sizeof(telemetry_buffer), &header, vital_sign_samples);
 
     // Set broadcast-IP and port
     os_memcpy(udp_com_socket->proto.udp->remote_ip, &ipconfig, sizeof(struct ip_addr)-1);
     os_memset(udp_com_socket->proto.udp->remote_ip+sizeof(struct ip_addr)-1, 255, 1);
     udp_com_socket->proto.udp->remote_port = VITAL_SIGN_PORT;
 
-    // Return the devices meta-data to the sender
-    if (espconn_send(udp_com_socket, msg_buffer, msg_len) == ESPCONN_OK) {
-      os_printf("vital_sign_broadcast: Broadcasting vital sign message!\n", IP2STR(udp_com_socket->proto.udp->remote_ip), udp_com_socket->proto.udp->remote_port);
+    // Broadcast the telemetry frame
+    if (msg_len && espconn_send(udp_com_socket, telemetry_buffer, msg_len) == ESPCONN_OK) {
+      LOG_DEBUG("vital_sign_broadcast: Broadcasting vital sign message to " IPSTR ":%d!\n", IP2STR(udp_com_socket->proto.udp->remote_ip), udp_com_socket->proto.udp->remote_port);
     }
     else {
-      os_printf("vital_sign_broadcast: Error while broadcasting the vital sign!\n");
+      LOG_ERROR("vital_sign_broadcast: Error while broadcasting the vital sign!\n");
     }
   }
   else {
-    os_printf("vital_sign_broadcast: Wrong WiFi-operation-mode!\n");
+    LOG_ERROR("vital_sign_broadcast: Wrong WiFi-operation-mode!\n");
   }
 }
 
 // Disable the periodical vital sign broadcasts
 void ICACHE_FLASH_ATTR vital_sign_bcast_stop(void) {
-  os_printf("vital_sign_bcast_stop: Disabling periodical vital sign broadcasts!\n");
+  LOG_INFO("vital_sign_bcast_stop: Disabling periodical vital sign broadcasts!\n");
 
   if (vital_sign_timer) {
     os_timer_disarm(vital_sign_timer);  // Disarm the timer for the periodical vital sign broadcasts
-    os_free(vital_sign_timer);  // Free the occupied resources
+    mem_pool_free(&mem_pool_timers, vital_sign_timer);  // Free the occupied resources
     vital_sign_timer = NULL;
   }
 }
@@ -184,21 +400,21 @@ void ICACHE_FLASH_ATTR vital_sign_bcast_stop(void) {
 // Initialize a periodical vital sign broadcast
 void ICACHE_FLASH_ATTR vital_sign_bcast_start(void) {
   if (!udp_com_socket) {
-    os_printf("vital_sign_bcast_start: Please call device_info_init first!\n");
+    LOG_ERROR("vital_sign_bcast_start: Please call device_info_init first!\n");
     return;
   }
 
-  os_printf("vital_sign_bcast_start: Enabling periodical vital sign broadcasts!\n");
+  LOG_INFO("vital_sign_bcast_start: Enabling periodical vital sign broadcasts!\n");
 
   // Allow broadcasts from all network-interfaces
   wifi_set_broadcast_if(STATIONAP_MODE);
 
   // Initialize the timer
   if (!vital_sign_timer) {
-    vital_sign_timer = (os_timer_t *) os_zalloc(sizeof(os_timer_t));
+    vital_sign_timer = (os_timer_t *) mem_pool_alloc(&mem_pool_timers);
   }
   if (!vital_sign_timer) {
-    os_printf("vital_sign_init: Failed to initialize the timer for the periodical vital sign broadcasts!\n");
+    LOG_ERROR("vital_sign_init: Failed to initialize the timer for the periodical vital sign broadcasts!\n");
     return;
   }
 
@@ -206,43 +422,49 @@ void ICACHE_FLASH_ATTR vital_sign_bcast_start(void) {
   // vital sign
   os_timer_disarm(vital_sign_timer);
   os_timer_setfn(vital_sign_timer, (os_timer_func_t *) vital_sign_broadcast, NULL);
-  os_timer_arm(vital_sign_timer, VITAL_SIGN_TIME_INTERVAL, true);
+  vital_sign_count = 0;
+  os_timer_arm(vital_sign_timer, config_get()->vital_sign_interval / VITAL_SIGN_SAMPLES, true);
 }
 
 // Disable the possibility to request the device's meta-data as well as the
 // periodical vital sign broadcasts and free all occupied resources
 void ICACHE_FLASH_ATTR device_info_disable(void) {
-  os_printf("device_info_disable: Disabling device_info!\n");
+  LOG_INFO("device_info_disable: Disabling device_info!\n");
 
   // Stop the periodical vital sign broadcasts
   vital_sign_bcast_stop();
 
   // Free the occupied resources
   if (udp_com_socket) {
-    os_free(udp_com_socket);
+    espconn_delete(udp_com_socket);
+    if (udp_com_socket->proto.udp) {
+      mem_pool_free(&mem_pool_esp_udp, udp_com_socket->proto.udp);
+    }
+    mem_pool_free(&mem_pool_espconn, udp_com_socket);
     udp_com_socket = NULL;
   }
 }
 
 // Initialize the UDP-socket and set up it's configuration
 void ICACHE_FLASH_ATTR device_info_init(void) {
-  os_printf("device_info_init: Initializing device_info!\n");
+  LOG_INFO("device_info_init: Initializing device_info!\n");
 
   // Initialize the UDP-socket
   if (!udp_com_socket) {
-    udp_com_socket = (struct espconn *) os_zalloc(sizeof(struct espconn));
+    udp_com_socket = (struct espconn *) mem_pool_alloc(&mem_pool_espconn);
     if (!udp_com_socket) {
-      os_printf("device_info_init: Failed to initialize the UDP-socket!\n");
+      LOG_ERROR("device_info_init: Failed to initialize the UDP-socket!\n");
       return;
     }
   }
 
   // Initialize the socket's communication-protocol-configuration
   if (!udp_com_socket->proto.udp) {
-    udp_com_socket->proto.udp = (esp_udp *) os_zalloc(sizeof(esp_udp));
+    udp_com_socket->proto.udp = (esp_udp *) mem_pool_alloc(&mem_pool_esp_udp);
     if (!udp_com_socket->proto.udp) {
-      os_printf("device_info_init: Failed to initialize udp_com_socket->proto.udp!\n");
+      LOG_ERROR("device_info_init: Failed to initialize udp_com_socket->proto.udp!\n");
       device_info_disable();  // Free all occupied resources
+      return;
     }
   }
 
@@ -256,6 +478,6 @@ void ICACHE_FLASH_ATTR device_info_init(void) {
     espconn_regist_recvcb(udp_com_socket, udp_info_recv_cb);
   }
   else {
-    os_printf("device_info_init: Error while creating the UDP-socket!\n");
+    LOG_ERROR("device_info_init: Error while creating the UDP-socket!\n");
   }
 }
@@ -0,0 +1,638 @@
+// dhcp_server.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: DHCP-server of the soft access-point with a persistent lease
+// store. It replaces the SDK's DHCP-server, which forgets all bindings when it
+// is restarted (e.g. on every reconnect of the station network interface, cf.
+// softap_network_config in router.c) and thus makes returning clients fall
+// back from re-requesting their previous address to a complete discovery.
+//
+// Each client is bound to an address of the configured range (cf. config.c) by
+// its MAC-address; the free addresses of the range are kept in a bitmap (cf.
+// addr_pool.c), so that the range may span any part of a network of any prefix
+// length. The binding is kept after the lease has expired, so that a client
+// gets the same address again, as long as the pool isn't exhausted (in which
+// case the least recently used binding of an inactive client is reassigned).
+// The bindings are stored in the flash sector below the RF-calibration-sector
+// (cf. user_rf_cal_sector_set in user_main.c) and loaded, when the server is
+// started. Since a binding only changes, if a new client is assigned an
+// address, the sector is written rarely; changes are collected for
+// DHCP_LEASE_SAVE_DELAY ms and written at once.
+//
+// Only stations associated to the soft access-point are served, so that
+// broadcasts received on the station network interface aren't answered.
+// Clients, that send MESH_HOSTNAME as their hostname, are marked as mesh-nodes
+// (cf. dhcp_server_is_mesh_node), whose route advertisements are accepted
+// (cf. mesh.c).
+// Replies to clients without an address are sent to the broadcast address of
+// the soft access-point's network.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "espconn.h"
+#include "spi_flash.h"
+#include "user_interface.h"
+#include "mem_pool.h"
+#include "dhcp_server.h"
+#include "addr_pool.h"
+#include "crc32.h"
+#include "config.h"
+#define LOG_MODULE LOG_MODULE_DHCP
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define DHCP_SERVER_PORT 67
+#define DHCP_CLIENT_PORT 68
+#define DHCP_HDR_LEN 240  // BOOTP-header including the magic cookie
+#define DHCP_REPLY_LEN 300  // Minimal size of a BOOTP-message
+#define DHCP_MAGIC_COOKIE 0x63825363
+
+#define DHCP_OP_REQUEST 1
+#define DHCP_OP_REPLY 2
+
+#define DHCP_DISCOVER 1
+#define DHCP_OFFER 2
+#define DHCP_REQUEST 3
+#define DHCP_DECLINE 4
+#define DHCP_ACK 5
+#define DHCP_NAK 6
+#define DHCP_RELEASE 7
+#define DHCP_INFORM 8
+
+#define DHCP_OPTION_PAD 0
+#define DHCP_OPTION_SUBNET_MASK 1
+#define DHCP_OPTION_ROUTER 3
+#define DHCP_OPTION_DNS 6
+#define DHCP_OPTION_HOSTNAME 12
+#define DHCP_OPTION_BROADCAST 28
+#define DHCP_OPTION_REQUESTED_IP 50
+#define DHCP_OPTION_LEASE_TIME 51
+#define DHCP_OPTION_MSG_TYPE 53
+#define DHCP_OPTION_SERVER_ID 54
+#define DHCP_OPTION_END 255
+
+#define DHCP_LEASE_MAGIC 0x4C504844 // "DHPL"
+#define DHCP_LEASE_VERSION 1
+
+/*------------------------------------*/
+
+// Binding of a client to an address
+struct dhcp_lease {
+  uint32_t ip;            // Bound address (0 = unused entry)
+  uint32_t expires;       // Time of expiry of the lease (in ms, cf. dhcp_server_now)
+  uint32_t last;          // Time of the last assignment (in ms)
+  uint8_t mac[6];
+  bool active;            // Lease granted since the last start of the server
+  bool mesh_node;         // Client identified itself by MESH_HOSTNAME
+};
+
+// Binding as stored in the flash
+struct dhcp_lease_binding {
+  uint32_t ip;
+  uint8_t mac[6];
+  uint16_t reserved;
+};
+
+// Content of the flash sector of the lease store
+struct dhcp_lease_record {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint32_t crc;           // CRC-32 of the bindings
+  struct dhcp_lease_binding binding[DHCP_LEASES_MAX];
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t dhcp_server_now(void);
+static uint32_t dhcp_get32(const uint8_t *ptr);
+static void dhcp_put32(uint8_t *ptr, uint32_t val);
+static bool dhcp_server_station(const uint8_t *mac);
+
+// Lease store:
+static struct dhcp_lease *dhcp_lease_find(const uint8_t *mac);
+static struct dhcp_lease *dhcp_lease_bind(const uint8_t *mac, uint32_t requested, uint32_t now);
+static void dhcp_lease_load(void);
+static void dhcp_lease_save(void *arg);
+static void dhcp_lease_changed(void);
+
+// Messages:
+static uint8_t *dhcp_option_put(uint8_t *opt, uint8_t code, uint8_t len, uint32_t val);
+static void dhcp_server_reply(const uint8_t *msg, uint8_t type, uint32_t yiaddr);
+
+// Callback-functions:
+static void dhcp_server_recv_cb(void *arg, char *data, unsigned short len);
+
+// Status-functions:
+uint16_t dhcp_server_count(void);
+uint32_t dhcp_server_lookup(const uint8_t *mac);
+bool dhcp_server_is_mesh_node(uint32_t ip);
+const struct dhcp_server_stats *dhcp_server_stats_get(void);
+
+// Initialization and configuration resp. termination:
+void dhcp_server_set_dns(uint32_t dns);
+void dhcp_server_flush(void);
+bool dhcp_server_start(uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop);
+void dhcp_server_stop(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct dhcp_lease dhcp_leases[DHCP_LEASES_MAX];
+static struct dhcp_lease_record dhcp_lease_record;  // Buffer for the flash (4 byte aligned)
+static uint8_t dhcp_server_buffer[DHCP_REPLY_LEN + 64];
+static bool dhcp_leases_loaded = false, dhcp_leases_dirty = false;
+static os_timer_t dhcp_lease_save_timer;
+
+static struct espconn *dhcp_server_socket = NULL;
+
+static uint32_t dhcp_server_ip = 0, dhcp_server_netmask = 0, dhcp_server_dns = 0;
+static struct addr_pool dhcp_pool;  // Free addresses of the range
+static uint32_t dhcp_server_clock_us = 0, dhcp_server_clock_ms = 0;
+
+static struct dhcp_server_stats dhcp_server_stats;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Return the time in ms; unlike system_get_time, this doesn't overflow after
+// 71 minutes, as long as it's called at least once in that period
+static uint32_t ICACHE_FLASH_ATTR dhcp_server_now(void) {
+  uint32_t now_us = system_get_time();
+  uint32_t elapsed_ms = (now_us - dhcp_server_clock_us) / 1000;
+
+  dhcp_server_clock_ms += elapsed_ms;
+  dhcp_server_clock_us += elapsed_ms * 1000;
+  return dhcp_server_clock_ms;
+}
+
+// Read resp. write a 32 bit value in network byte order
+static uint32_t ICACHE_FLASH_ATTR dhcp_get32(const uint8_t *ptr) {
+  return ((uint32_t) ptr[0] << 24) | ((uint32_t) ptr[1] << 16) | ((uint32_t) ptr[2] << 8) | ptr[3];
+}
+
+static void ICACHE_FLASH_ATTR dhcp_put32(uint8_t *ptr, uint32_t val) {
+  ptr[0] = val >> 24;
+  ptr[1] = (val >> 16) & 0xFF;
+  ptr[2] = (val >> 8) & 0xFF;
+  ptr[3] = val & 0xFF;
+}
+
+// Check, if the station with the given MAC-address is associated to the soft
+// access-point
+static bool ICACHE_FLASH_ATTR dhcp_server_station(const uint8_t *mac) {
+  struct station_info *station, *list = wifi_softap_get_station_info();
+  bool found = false;
+
+  for (station = list; station && !found; station = STAILQ_NEXT(station, next)) {
+    found = os_memcmp(station->bssid, mac, 6) == 0;
+  }
+  if (list) {
+    wifi_softap_free_station_info();
+  }
+  return found;
+}
+
+/*------------------------------------*/
+
+// Lease store:
+
+static struct dhcp_lease * ICACHE_FLASH_ATTR dhcp_lease_find(const uint8_t *mac) {
+  struct dhcp_lease *lease;
+
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    if (lease->ip && os_memcmp(lease->mac, mac, 6) == 0) {
+      return lease;
+    }
+  }
+  return NULL;
+}
+
+// Return the binding of the given client; a new client is bound to the
+// requested address, if it's free, resp. to the lowest free address of the
+// pool. If the pool or the store is exhausted, the least recently used binding
+// of a client without a valid lease is reassigned. Returns NULL, if all
+// bindings are in use.
+static struct dhcp_lease * ICACHE_FLASH_ATTR dhcp_lease_bind(const uint8_t *mac, uint32_t requested, uint32_t now) {
+  struct dhcp_lease *lease = dhcp_lease_find(mac), *slot = NULL, *oldest = NULL;
+  uint32_t ip;
+
+  if (lease) {
+    return lease;
+  }
+
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    if (!lease->ip) {
+      slot = (slot) ? slot : lease;
+    }
+    else if (!(lease->active && (int32_t) (lease->expires - now) > 0) && (!oldest || (int32_t) (oldest->last - lease->last) > 0)) {
+      oldest = lease;
+    }
+  }
+  if (!slot && !oldest) {
+    return NULL;
+  }
+
+  ip = (requested && addr_pool_take(&dhcp_pool, requested)) ? requested : addr_pool_alloc(&dhcp_pool);
+
+  // Reassign the least recently used binding; if there's a free address,
+  // only its entry is reused and its address is returned to the pool
+  if (!slot || !ip) {
+    slot = (slot) ? slot : oldest;
+    if (!ip) {
+      if (!oldest) {
+        return NULL;
+      }
+      ip = oldest->ip;
+      oldest->ip = 0;
+    }
+    else {
+      addr_pool_release(&dhcp_pool, slot->ip);
+    }
+  }
+  os_memset(slot, 0, sizeof(struct dhcp_lease));
+  os_memcpy(slot->mac, mac, 6);
+  slot->ip = ip;
+  slot->last = now;
+  dhcp_lease_changed();
+  return slot;
+}
+
+// Load the bindings from the flash; bindings outside of the current pool resp.
+// of taken addresses are discarded
+static void ICACHE_FLASH_ATTR dhcp_lease_load(void) {
+  uint32_t sector = config_flash_sector(1);
+  struct dhcp_lease *lease = dhcp_leases;
+  uint16_t idx;
+
+  os_memset(dhcp_leases, 0, sizeof(dhcp_leases));
+  dhcp_leases_loaded = true;
+  if (!sector || spi_flash_read(sector * SPI_FLASH_SEC_SIZE, (uint32 *) &dhcp_lease_record, sizeof(dhcp_lease_record)) != SPI_FLASH_RESULT_OK) {
+    LOG_ERROR("dhcp_lease_load: Failed to read the lease store!\n");
+    return;
+  }
+  if (dhcp_lease_record.magic != DHCP_LEASE_MAGIC || dhcp_lease_record.version != DHCP_LEASE_VERSION || dhcp_lease_record.count > DHCP_LEASES_MAX || dhcp_lease_record.crc != crc32((uint8_t *) dhcp_lease_record.binding, dhcp_lease_record.count * sizeof(struct dhcp_lease_binding))) {
+    LOG_ERROR("dhcp_lease_load: No valid lease store found!\n");
+    return;
+  }
+  for (idx = 0; idx < dhcp_lease_record.count; idx++) {
+    if (addr_pool_take(&dhcp_pool, dhcp_lease_record.binding[idx].ip)) {
+      lease->ip = dhcp_lease_record.binding[idx].ip;
+      os_memcpy(lease->mac, dhcp_lease_record.binding[idx].mac, 6);
+      lease++;
+    }
+  }
+  LOG_INFO("dhcp_lease_load: Loaded %d bindings!\n", (int) (lease - dhcp_leases));
+}
+
+// Write the bindings to the flash
+static void ICACHE_FLASH_ATTR dhcp_lease_save(void *arg) {
+  uint32_t sector = config_flash_sector(1);
+  struct dhcp_lease *lease;
+  uint16_t count = 0, len;
+
+  if (!dhcp_leases_dirty || !sector) {
+    return;
+  }
+  dhcp_leases_dirty = false;
+
+  os_memset(&dhcp_lease_record, 0, sizeof(dhcp_lease_record));
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    if (lease->ip) {
+      dhcp_lease_record.binding[count].ip = lease->ip;
+      os_memcpy(dhcp_lease_record.binding[count].mac, lease->mac, 6);
+      count++;
+    }
+  }
+  dhcp_lease_record.magic = DHCP_LEASE_MAGIC;
+  dhcp_lease_record.version = DHCP_LEASE_VERSION;
+  dhcp_lease_record.count = count;
+  dhcp_lease_record.crc = crc32((uint8_t *) dhcp_lease_record.binding, count * sizeof(struct dhcp_lease_binding));
+  len = sizeof(dhcp_lease_record) - sizeof(dhcp_lease_record.binding) + count * sizeof(struct dhcp_lease_binding);
+
+  if (spi_flash_erase_sector(sector) != SPI_FLASH_RESULT_OK || spi_flash_write(sector * SPI_FLASH_SEC_SIZE, (uint32 *) &dhcp_lease_record, len) != SPI_FLASH_RESULT_OK) {
+    LOG_ERROR("dhcp_lease_save: Failed to write the lease store!\n");
+    return;
+  }
+  dhcp_server_stats.saves++;
+}
+
+// Schedule writing the bindings to the flash
+static void ICACHE_FLASH_ATTR dhcp_lease_changed(void) {
+  if (!dhcp_leases_dirty) {
+    dhcp_leases_dirty = true;
+    os_timer_disarm(&dhcp_lease_save_timer);
+    os_timer_setfn(&dhcp_lease_save_timer, (os_timer_func_t *) dhcp_lease_save, NULL);
+    os_timer_arm(&dhcp_lease_save_timer, DHCP_LEASE_SAVE_DELAY, false);
+  }
+}
+
+/*------------------------------------*/
+
+// Messages:
+
+static uint8_t * ICACHE_FLASH_ATTR dhcp_option_put(uint8_t *opt, uint8_t code, uint8_t len, uint32_t val) {
+  opt[0] = code;
+  opt[1] = len;
+  if (len == 1) {
+    opt[2] = val;
+  }
+  else {
+    os_memcpy(opt + 2, &val, 4);  // Addresses are given in network byte order
+  }
+  return opt + 2 + len;
+}
+
+// Send a reply of the given type to the client of the given message
+static void ICACHE_FLASH_ATTR dhcp_server_reply(const uint8_t *msg, uint8_t type, uint32_t yiaddr) {
+  uint8_t *reply = dhcp_server_buffer, *opt;
+  uint32_t dest, ciaddr, lease_time;
+
+  os_memset(reply, 0, sizeof(dhcp_server_buffer));
+  reply[0] = DHCP_OP_REPLY;
+  os_memcpy(reply + 1, msg + 1, 11);  // htype, hlen, hops, xid, secs, flags
+  os_memcpy(reply + 24, msg + 24, 20);  // giaddr, chaddr
+  os_memcpy(&ciaddr, msg + 12, 4);
+  if (type == DHCP_ACK && !yiaddr) {
+    os_memcpy(reply + 12, &ciaddr, 4);  // DHCPINFORM
+  }
+  os_memcpy(reply + 16, &yiaddr, 4);
+  dhcp_put32(reply + 236, DHCP_MAGIC_COOKIE);
+
+  opt = dhcp_option_put(reply + DHCP_HDR_LEN, DHCP_OPTION_MSG_TYPE, 1, type);
+  opt = dhcp_option_put(opt, DHCP_OPTION_SERVER_ID, 4, dhcp_server_ip);
+  if (type != DHCP_NAK) {
+    if (yiaddr) {
+      dhcp_put32((uint8_t *) &lease_time, DHCP_LEASE_TIME);
+      opt = dhcp_option_put(opt, DHCP_OPTION_LEASE_TIME, 4, lease_time);
+    }
+    opt = dhcp_option_put(opt, DHCP_OPTION_SUBNET_MASK, 4, dhcp_server_netmask);
+    opt = dhcp_option_put(opt, DHCP_OPTION_ROUTER, 4, dhcp_server_ip);
+    opt = dhcp_option_put(opt, DHCP_OPTION_BROADCAST, 4, dhcp_server_ip | ~dhcp_server_netmask);
+    if (dhcp_server_dns) {
+      opt = dhcp_option_put(opt, DHCP_OPTION_DNS, 4, dhcp_server_dns);
+    }
+  }
+  *opt = DHCP_OPTION_END;
+
+  // Clients in the states RENEWING resp. REBINDING and INFORM-requests are
+  // answered directly, all others via broadcast
+  dest = (ciaddr && type != DHCP_NAK) ? ciaddr : dhcp_server_ip | ~dhcp_server_netmask;
+  os_memcpy(dhcp_server_socket->proto.udp->remote_ip, &dest, 4);
+  dhcp_server_socket->proto.udp->remote_port = DHCP_CLIENT_PORT;
+  if (espconn_sendto(dhcp_server_socket, reply, DHCP_REPLY_LEN) != ESPCONN_OK) {
+    LOG_ERROR("dhcp_server_reply: Error while sending to " IPSTR "!\n", IP2STR(&dest));
+  }
+}
+
+/*------------------------------------*/
+
+// Callback-functions:
+
+// Handle a message of a client (cf. RFC 2131, section 4.3)
+static void ICACHE_FLASH_ATTR dhcp_server_recv_cb(void *arg, char *data, unsigned short len) {
+  uint8_t *msg = (uint8_t *) data, *opt, type = 0;
+  uint32_t requested = 0, server_id = 0, ciaddr, now;
+  struct dhcp_lease *lease;
+  bool mesh_node = false;
+
+  if (!data) {
+    return;
+  }
+  dhcp_server_stats.requests++;
+
+  if (len < DHCP_HDR_LEN || msg[0] != DHCP_OP_REQUEST || msg[1] != 1 || msg[2] != 6 || dhcp_get32(msg + 236) != DHCP_MAGIC_COOKIE || !dhcp_server_station(msg + 28)) {
+    dhcp_server_stats.drops++;
+    return;
+  }
+  opt = msg + DHCP_HDR_LEN;
+  while (opt < msg + len && *opt != DHCP_OPTION_END) {
+    if (*opt == DHCP_OPTION_PAD) {
+      opt++;
+      continue;
+    }
+    if (opt + 2 > msg + len || opt + 2 + opt[1] > msg + len) {
+      break;
+    }
+    if (*opt == DHCP_OPTION_MSG_TYPE && opt[1] == 1) {
+      type = opt[2];
+    }
+    else if (*opt == DHCP_OPTION_REQUESTED_IP && opt[1] == 4) {
+      os_memcpy(&requested, opt + 2, 4);
+    }
+    else if (*opt == DHCP_OPTION_SERVER_ID && opt[1] == 4) {
+      os_memcpy(&server_id, opt + 2, 4);
+    }
+    else if (*opt == DHCP_OPTION_HOSTNAME && opt[1] == sizeof(MESH_HOSTNAME) - 1) {
+      mesh_node = os_memcmp(opt + 2, MESH_HOSTNAME, opt[1]) == 0;
+    }
+    opt += 2 + opt[1];
+  }
+  os_memcpy(&ciaddr, msg + 12, 4);
+  now = dhcp_server_now();
+
+  switch (type) {
+    case DHCP_DISCOVER:
+      lease = dhcp_lease_bind(msg + 28, requested, now);
+      if (!lease) {
+        LOG_ERROR("dhcp_server_recv_cb: Address pool exhausted!\n");
+        dhcp_server_stats.drops++;
+        return;
+      }
+      dhcp_server_reply(msg, DHCP_OFFER, lease->ip);
+      dhcp_server_stats.offers++;
+      return;
+    case DHCP_REQUEST:
+      // SELECTING: only the client's choice of this server is answered;
+      // INIT-REBOOT, RENEWING, REBINDING: a client without binding is only
+      // answered, if its address isn't part of the network
+      if (server_id && server_id != dhcp_server_ip) {
+        return;
+      }
+      requested = (requested) ? requested : ciaddr;
+      lease = (server_id) ? dhcp_lease_bind(msg + 28, requested, now) : dhcp_lease_find(msg + 28);
+      if (lease && lease->ip == requested) {
+        lease->expires = now + DHCP_LEASE_TIME * 1000;
+        lease->last = now;
+        lease->active = true;
+        lease->mesh_node = mesh_node;
+        dhcp_server_reply(msg, DHCP_ACK, lease->ip);
+        dhcp_server_stats.acks++;
+      }
+      else if (lease || (requested & dhcp_server_netmask) != (dhcp_server_ip & dhcp_server_netmask)) {
+        dhcp_server_reply(msg, DHCP_NAK, 0);
+        dhcp_server_stats.naks++;
+      }
+      return;
+    case DHCP_DECLINE:
+      // The address is in use by another device; drop the binding, so that the
+      // client is assigned another address (the address stays taken until the
+      // server is restarted)
+      lease = dhcp_lease_find(msg + 28);
+      if (lease && lease->ip == requested) {
+        LOG_WARN("dhcp_server_recv_cb: " IPSTR " declined!\n", IP2STR(&requested));
+        lease->ip = 0;
+        dhcp_lease_changed();
+      }
+      return;
+    case DHCP_RELEASE:
+      // The binding is kept for the client's return
+      lease = dhcp_lease_find(msg + 28);
+      if (lease) {
+        lease->active = false;
+      }
+      return;
+    case DHCP_INFORM:
+      dhcp_server_reply(msg, DHCP_ACK, 0);
+      dhcp_server_stats.acks++;
+      return;
+    default:
+      dhcp_server_stats.drops++;
+      return;
+  }
+}
+
+/*------------------------------------*/
+
+// Status-functions:
+
+// Return the number of clients with a valid lease
+uint16_t ICACHE_FLASH_ATTR dhcp_server_count(void) {
+  struct dhcp_lease *lease;
+  uint32_t now = dhcp_server_now();
+  uint16_t count = 0;
+
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    if (lease->ip && lease->active && (int32_t) (lease->expires - now) > 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Return the address bound to the client with the given MAC-address resp. 0
+uint32_t ICACHE_FLASH_ATTR dhcp_server_lookup(const uint8_t *mac) {
+  struct dhcp_lease *lease = dhcp_lease_find(mac);
+
+  return (lease) ? lease->ip : 0;
+}
+
+// Check, if the address is leased to an associated station, that identified
+// itself as mesh-node (cf. MESH_HOSTNAME) in its last request
+bool ICACHE_FLASH_ATTR dhcp_server_is_mesh_node(uint32_t ip) {
+  struct dhcp_lease *lease;
+  uint32_t now = dhcp_server_now();
+
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    if (ip && lease->ip == ip) {
+      return lease->mesh_node && lease->active && (int32_t) (lease->expires - now) > 0 && dhcp_server_station(lease->mac);
+    }
+  }
+  return false;
+}
+
+const struct dhcp_server_stats * ICACHE_FLASH_ATTR dhcp_server_stats_get(void) {
+  return &dhcp_server_stats;
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration resp. termination:
+
+// Set the DNS-server handed to the clients
+void ICACHE_FLASH_ATTR dhcp_server_set_dns(uint32_t dns) {
+  dhcp_server_dns = dns;
+}
+
+// Discard all bindings (including the ones stored in the flash)
+void ICACHE_FLASH_ATTR dhcp_server_flush(void) {
+  struct dhcp_lease *lease;
+
+  for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+    addr_pool_release(&dhcp_pool, lease->ip);
+  }
+  os_memset(dhcp_leases, 0, sizeof(dhcp_leases));
+  dhcp_lease_changed();
+}
+
+// Start serving the clients of the soft access-point with the given address
+// and the pool start to stop (all in network byte order; the address of the
+// router may be any host address of the network, even within the pool); the
+// bindings are loaded from the flash on the first start and kept, if the
+// server is already running
+bool ICACHE_FLASH_ATTR dhcp_server_start(uint32_t ip, uint32_t netmask, uint32_t start, uint32_t stop) {
+  struct dhcp_lease *lease;
+
+  if (!ip || !addr_pool_init(&dhcp_pool, ip, netmask, start, stop)) {
+    LOG_ERROR("dhcp_server_start: Invalid transfer parameter!\n");
+    return false;
+  }
+
+  LOG_INFO("dhcp_server_start: Starting the DHCP-server!\n");
+
+  dhcp_server_ip = ip;
+  dhcp_server_netmask = netmask;
+  dhcp_server_now();
+
+  if (!dhcp_leases_loaded) {
+    dhcp_lease_load();
+  }
+  else {
+    // Take the addresses of the bindings again and discard the ones, that
+    // aren't part of a changed pool
+    for (lease = dhcp_leases; lease < dhcp_leases + DHCP_LEASES_MAX; lease++) {
+      if (lease->ip && !addr_pool_take(&dhcp_pool, lease->ip)) {
+        lease->ip = 0;
+        dhcp_lease_changed();
+      }
+    }
+  }
+
+  if (!dhcp_server_socket) {
+    dhcp_server_socket = (struct espconn *) mem_pool_alloc(&mem_pool_espconn);
+    if (dhcp_server_socket) {
+      dhcp_server_socket->proto.udp = (esp_udp *) mem_pool_alloc(&mem_pool_esp_udp);
+      if (dhcp_server_socket->proto.udp) {
+        dhcp_server_socket->type = ESPCONN_UDP;
+        dhcp_server_socket->state = ESPCONN_NONE;
+        dhcp_server_socket->proto.udp->local_port = DHCP_SERVER_PORT;
+        if (espconn_create(dhcp_server_socket) == ESPCONN_OK) {
+          espconn_regist_recvcb(dhcp_server_socket, dhcp_server_recv_cb);
+          return true;
+        }
+        mem_pool_free(&mem_pool_esp_udp, dhcp_server_socket->proto.udp);
+      }
+      mem_pool_free(&mem_pool_espconn, dhcp_server_socket);
+      dhcp_server_socket = NULL;
+    }
+    LOG_ERROR("dhcp_server_start: Failed to create the UDP-socket!\n");
+    return false;
+  }
+  return true;
+}
+
+// Stop serving the clients; pending changes of the bindings are written to the
+// flash and the bindings are reloaded on the next start
+void ICACHE_FLASH_ATTR dhcp_server_stop(void) {
+  if (dhcp_server_socket) {
+    espconn_delete(dhcp_server_socket);
+    mem_pool_free(&mem_pool_esp_udp, dhcp_server_socket->proto.udp);
+    mem_pool_free(&mem_pool_espconn, dhcp_server_socket);
+    dhcp_server_socket = NULL;
+  }
+  os_timer_disarm(&dhcp_lease_save_timer);
+  dhcp_lease_save(NULL);
+  dhcp_leases_loaded = false;
+}
@@ -0,0 +1,629 @@
+// dns_proxy.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Caching DNS-proxy of the router. The clients of the soft access-
+// point are handed the router's own address as DNS-server (cf. dns_set in
+// router.c); their queries are received on port 53 and answered from a small
+// cache, if possible. Otherwise, they are forwarded to the upstream server by
+// the router itself, so that they don't occupy translation entries of the NAPT-
+// engine. Queries with the same question, that arrive while a query is pending,
+// are attached to it and answered together with it. Answers are only accepted
+// from port 53 of the upstream server; the local port of the queries is
+// changed, whenever no other query is pending, so that forged answers have to
+// guess it as well as the random ID.
+//
+// The cache holds complete answers (up to DNS_PROXY_MSG_MAX bytes) of
+// successful queries as well as negative answers (NXDOMAIN resp. no data) for
+// the smallest TTL of their resource records (limited to DNS_PROXY_TTL_MAX
+// resp. DNS_PROXY_TTL_NEGATIVE); cached answers are returned with the remaining
+// TTL. If the cache is full, the least recently used entry is replaced.
+
+#include "c_types.h"
+#include "mem.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "espconn.h"
+#include "user_interface.h"
+#include "mem_pool.h"
+#include "dns_proxy.h"
+#define LOG_MODULE LOG_MODULE_DNS
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define DNS_PORT 53
+#define DNS_HDR_LEN 12
+#define DNS_NAME_MAX 255
+
+#define DNS_FLAG_QR 0x8000
+#define DNS_FLAG_OPCODE 0x7800
+#define DNS_FLAG_TC 0x0200
+#define DNS_FLAG_RCODE 0x000F
+
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_NXDOMAIN 3
+
+#define DNS_TYPE_OPT 41 // Pseudo-record of EDNS; its TTL-field holds flags
+
+/*------------------------------------*/
+
+// Cached answer; the question is part of the message (at DNS_HDR_LEN)
+struct dns_proxy_entry {
+  uint32_t hash;          // Hash of the question (0 = unused entry)
+  uint32_t expires;       // Time of expiry (in ms, cf. dns_proxy_now)
+  uint32_t last;          // Time of the last use (in ms)
+  uint16_t len;           // Length of the message
+  uint16_t question_len;
+  uint8_t msg[DNS_PROXY_MSG_MAX];
+};
+
+// Client waiting for the answer to a pending query
+struct dns_proxy_waiter {
+  uint8_t ip[4];
+  uint16_t port;
+  uint16_t id;            // ID of the client's query
+};
+
+// Query forwarded to the upstream server
+struct dns_proxy_query {
+  uint32_t hash;          // Hash of the question (0 = unused slot)
+  uint32_t sent;          // Time the query has been forwarded (in ms)
+  uint16_t id;            // ID of the forwarded query
+  uint8_t question_len;
+  uint8_t waiters;
+  struct dns_proxy_waiter waiter[DNS_PROXY_WAITERS];
+  uint8_t question[DNS_PROXY_QUESTION_MAX];
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t dns_proxy_now(void);
+static uint16_t dns_get16(const uint8_t *ptr);
+static void dns_put16(uint8_t *ptr, uint16_t val);
+static uint16_t dns_proxy_question(const uint8_t *msg, uint16_t len);
+static uint32_t dns_proxy_hash(const uint8_t *question, uint16_t len);
+static bool dns_proxy_question_equal(const uint8_t *a, const uint8_t *b, uint16_t len);
+static uint16_t dns_proxy_skip_name(const uint8_t *msg, uint16_t len, uint16_t off);
+static bool dns_proxy_ttl(uint8_t *msg, uint16_t len, uint16_t question_len, uint32_t *ttl, bool set);
+static void dns_proxy_send(struct espconn *conn, const uint8_t *ip, uint16_t port, uint8_t *msg, uint16_t len);
+
+// Cache and pending queries:
+static struct dns_proxy_entry *dns_proxy_lookup(uint32_t hash, const uint8_t *question, uint16_t question_len, uint32_t now);
+static void dns_proxy_store(uint8_t *msg, uint16_t len, uint16_t question_len, uint32_t hash, uint32_t now);
+static struct dns_proxy_query *dns_proxy_pending(uint32_t hash, const uint8_t *question, uint16_t question_len, uint32_t now);
+static struct dns_proxy_query *dns_proxy_query_alloc(uint32_t now);
+static void dns_proxy_upstream_rotate(const struct dns_proxy_query *slot, uint32_t now);
+
+// Callback-functions:
+static void dns_proxy_client_recv_cb(void *arg, char *data, unsigned short len);
+static void dns_proxy_upstream_recv_cb(void *arg, char *data, unsigned short len);
+
+// Sockets:
+static struct espconn *dns_proxy_socket(uint16_t local_port, espconn_recv_callback recv_cb);
+static void dns_proxy_socket_free(struct espconn *conn);
+
+// Status-functions:
+uint16_t dns_proxy_count(void);
+const struct dns_proxy_stats *dns_proxy_stats_get(void);
+
+// Initialization and configuration resp. termination:
+void dns_proxy_flush(void);
+bool dns_proxy_enable(uint32_t upstream);
+void dns_proxy_disable(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct dns_proxy_entry dns_proxy_cache[DNS_PROXY_CACHE_SIZE];
+static struct dns_proxy_query dns_proxy_queries[DNS_PROXY_PENDING];
+static uint8_t dns_proxy_buffer[DNS_PROXY_MSG_MAX];  // Answers from the cache
+
+static struct espconn *dns_proxy_client_socket = NULL;    // Port 53 for the clients
+static struct espconn *dns_proxy_upstream_socket = NULL;  // Queries to the upstream server
+
+static uint32_t dns_proxy_upstream = 0;
+static uint32_t dns_proxy_network = 0, dns_proxy_netmask = 0;
+static uint32_t dns_proxy_clock_us = 0, dns_proxy_clock_ms = 0;
+
+static struct dns_proxy_stats dns_proxy_stats;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Return the time in ms; unlike system_get_time, this doesn't overflow after
+// 71 minutes, as long as it's called at least once in that period
+static uint32_t ICACHE_FLASH_ATTR dns_proxy_now(void) {
+  uint32_t now_us = system_get_time();
+  uint32_t elapsed_ms = (now_us - dns_proxy_clock_us) / 1000;
+
+  dns_proxy_clock_ms += elapsed_ms;
+  dns_proxy_clock_us += elapsed_ms * 1000;
+  return dns_proxy_clock_ms;
+}
+
+static uint16_t ICACHE_FLASH_ATTR dns_get16(const uint8_t *ptr) {
+  return (ptr[0] << 8) | ptr[1];
+}
+
+static void ICACHE_FLASH_ATTR dns_put16(uint8_t *ptr, uint16_t val) {
+  ptr[0] = val >> 8;
+  ptr[1] = val & 0xFF;
+}
+
+// Return the length of the (single) question of the given message including
+// its type and class, resp. 0, if it's malformed or the name is compressed
+static uint16_t ICACHE_FLASH_ATTR dns_proxy_question(const uint8_t *msg, uint16_t len) {
+  uint16_t off = DNS_HDR_LEN;
+
+  while (off < len && msg[off]) {
+    if (msg[off] & 0xC0) {
+      return 0;
+    }
+    off += msg[off] + 1;
+  }
+  if (off + 5 > len || off + 1 - DNS_HDR_LEN > DNS_NAME_MAX) {
+    return 0;
+  }
+  return off + 5 - DNS_HDR_LEN;
+}
+
+// FNV-1a-hash of the question; names are case-insensitive
+static uint32_t ICACHE_FLASH_ATTR dns_proxy_hash(const uint8_t *question, uint16_t len) {
+  uint32_t hash = 2166136261u;
+  uint16_t idx;
+  uint8_t c;
+
+  for (idx = 0; idx < len; idx++) {
+    c = question[idx];
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';
+    }
+    hash = (hash ^ c) * 16777619u;
+  }
+  return (hash) ? hash : 1;
+}
+
+static bool ICACHE_FLASH_ATTR dns_proxy_question_equal(const uint8_t *a, const uint8_t *b, uint16_t len) {
+  uint16_t idx;
+  uint8_t x, y;
+
+  for (idx = 0; idx < len; idx++) {
+    x = (a[idx] >= 'A' && a[idx] <= 'Z') ? a[idx] + 'a' - 'A' : a[idx];
+    y = (b[idx] >= 'A' && b[idx] <= 'Z') ? b[idx] + 'a' - 'A' : b[idx];
+    if (x != y) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Return the offset behind the (possibly compressed) name at the given offset
+// resp. 0, if it's malformed
+static uint16_t ICACHE_FLASH_ATTR dns_proxy_skip_name(const uint8_t *msg, uint16_t len, uint16_t off) {
+  while (off < len) {
+    if (msg[off] == 0) {
+      return off + 1;
+    }
+    if ((msg[off] & 0xC0) == 0xC0) {
+      return (off + 2 <= len) ? off + 2 : 0;
+    }
+    if (msg[off] & 0xC0) {
+      return 0;
+    }
+    off += msg[off] + 1;
+  }
+  return 0;
+}
+
+// Determine the smallest TTL of the resource records of the given message
+// (ttl has to be initialized by the caller and is left unchanged, if there are
+// none) resp. set the TTL of all resource records to the given value; returns
+// false, if the message is malformed
+static bool ICACHE_FLASH_ATTR dns_proxy_ttl(uint8_t *msg, uint16_t len, uint16_t question_len, uint32_t *ttl, bool set) {
+  uint16_t off = DNS_HDR_LEN + question_len, count, idx;
+  uint32_t rr_ttl;
+
+  count = dns_get16(msg + 6) + dns_get16(msg + 8) + dns_get16(msg + 10);
+  for (idx = 0; idx < count; idx++) {
+    off = dns_proxy_skip_name(msg, len, off);
+    if (!off || off + 10 > len) {
+      return false;
+    }
+    if (dns_get16(msg + off) != DNS_TYPE_OPT) {
+      if (set) {
+        dns_put16(msg + off + 4, *ttl >> 16);
+        dns_put16(msg + off + 6, *ttl & 0xFFFF);
+      }
+      else {
+        rr_ttl = ((uint32_t) dns_get16(msg + off + 4) << 16) | dns_get16(msg + off + 6);
+        if (rr_ttl < *ttl) {
+          *ttl = rr_ttl;
+        }
+      }
+    }
+    off += 10 + dns_get16(msg + off + 8);
+    if (off > len) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ICACHE_FLASH_ATTR dns_proxy_send(struct espconn *conn, const uint8_t *ip, uint16_t port, uint8_t *msg, uint16_t len) {
+  os_memcpy(conn->proto.udp->remote_ip, ip, 4);
+  conn->proto.udp->remote_port = port;
+  if (espconn_sendto(conn, msg, len) != ESPCONN_OK) {
+    LOG_ERROR("dns_proxy_send: Error while sending to " IPSTR ":%d!\n", IP2STR(conn->proto.udp->remote_ip), port);
+  }
+}
+
+/*------------------------------------*/
+
+// Cache and pending queries:
+
+// Return the valid cache entry with the given question resp. NULL
+static struct dns_proxy_entry * ICACHE_FLASH_ATTR dns_proxy_lookup(uint32_t hash, const uint8_t *question, uint16_t question_len, uint32_t now) {
+  struct dns_proxy_entry *entry;
+
+  for (entry = dns_proxy_cache; entry < dns_proxy_cache + DNS_PROXY_CACHE_SIZE; entry++) {
+    if (entry->hash == hash && entry->question_len == question_len && (int32_t) (entry->expires - now) > 0 && dns_proxy_question_equal(entry->msg + DNS_HDR_LEN, question, question_len)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Cache the given answer of the upstream server; an entry with the same
+// question resp. an unused or expired entry is preferred over the least
+// recently used one
+static void ICACHE_FLASH_ATTR dns_proxy_store(uint8_t *msg, uint16_t len, uint16_t question_len, uint32_t hash, uint32_t now) {
+  struct dns_proxy_entry *entry, *victim = NULL;
+  uint32_t ttl = 0xFFFFFFFF;
+  uint8_t rank, victim_rank = 0;
+
+  if (len > DNS_PROXY_MSG_MAX || !dns_proxy_ttl(msg, len, question_len, &ttl, false)) {
+    return;
+  }
+  if ((dns_get16(msg + 2) & DNS_FLAG_RCODE) == DNS_RCODE_NXDOMAIN || dns_get16(msg + 6) == 0) {
+    ttl = (ttl < DNS_PROXY_TTL_NEGATIVE) ? ttl : DNS_PROXY_TTL_NEGATIVE;
+  }
+  else {
+    ttl = (ttl < DNS_PROXY_TTL_MAX) ? ttl : DNS_PROXY_TTL_MAX;
+  }
+  if (ttl == 0) {
+    return;
+  }
+
+  for (entry = dns_proxy_cache; entry < dns_proxy_cache + DNS_PROXY_CACHE_SIZE; entry++) {
+    if (entry->hash == hash && entry->question_len == question_len && dns_proxy_question_equal(entry->msg + DNS_HDR_LEN, msg + DNS_HDR_LEN, question_len)) {
+      victim = entry;
+      break;
+    }
+    rank = (!entry->hash) ? 0 : ((int32_t) (entry->expires - now) <= 0) ? 1 : 2;
+    if (!victim || rank < victim_rank || (rank == victim_rank && (int32_t) (entry->last - victim->last) < 0)) {
+      victim = entry;
+      victim_rank = rank;
+    }
+  }
+  victim->hash = hash;
+  victim->expires = now + ttl * 1000;
+  victim->last = now;
+  victim->len = len;
+  victim->question_len = question_len;
+  os_memcpy(victim->msg, msg, len);
+}
+
+// Return the pending query with the given question resp. NULL
+static struct dns_proxy_query * ICACHE_FLASH_ATTR dns_proxy_pending(uint32_t hash, const uint8_t *question, uint16_t question_len, uint32_t now) {
+  struct dns_proxy_query *query;
+
+  for (query = dns_proxy_queries; query < dns_proxy_queries + DNS_PROXY_PENDING; query++) {
+    if (query->hash == hash && query->question_len == question_len && now - query->sent < DNS_PROXY_TIMEOUT && dns_proxy_question_equal(query->question, question, question_len)) {
+      return query;
+    }
+  }
+  return NULL;
+}
+
+// Return an unused slot for a query resp. one, whose answer is overdue, with
+// a new random ID
+static struct dns_proxy_query * ICACHE_FLASH_ATTR dns_proxy_query_alloc(uint32_t now) {
+  struct dns_proxy_query *query, *slot = NULL;
+  uint16_t id;
+  bool unique;
+
+  for (query = dns_proxy_queries; query < dns_proxy_queries + DNS_PROXY_PENDING; query++) {
+    if (!query->hash || now - query->sent >= DNS_PROXY_TIMEOUT) {
+      slot = query;
+      break;
+    }
+  }
+  if (!slot) {
+    return NULL;
+  }
+
+  // Random IDs make it harder to inject forged answers into the cache
+  do {
+    id = os_random() & 0xFFFF;
+    unique = true;
+    for (query = dns_proxy_queries; query < dns_proxy_queries + DNS_PROXY_PENDING; query++) {
+      if (query != slot && query->hash && query->id == id) {
+        unique = false;
+      }
+    }
+  } while (!unique);
+
+  slot->hash = 0;
+  slot->id = id;
+  slot->sent = now;
+  slot->waiters = 0;
+  return slot;
+}
+
+// Move the upstream socket to a new local port, unless a query other than
+// slot is pending (its answer would be lost otherwise)
+static void ICACHE_FLASH_ATTR dns_proxy_upstream_rotate(const struct dns_proxy_query *slot, uint32_t now) {
+  struct dns_proxy_query *query;
+
+  for (query = dns_proxy_queries; query < dns_proxy_queries + DNS_PROXY_PENDING; query++) {
+    if (query != slot && query->hash && now - query->sent < DNS_PROXY_TIMEOUT) {
+      return;
+    }
+  }
+  dns_proxy_socket_free(dns_proxy_upstream_socket);
+  dns_proxy_upstream_socket = dns_proxy_socket(espconn_port(), dns_proxy_upstream_recv_cb);
+}
+
+/*------------------------------------*/
+
+// Callback-functions:
+
+// Answer a query of a client from the cache, attach it to a pending query with
+// the same question or forward it to the upstream server
+static void ICACHE_FLASH_ATTR dns_proxy_client_recv_cb(void *arg, char *data, unsigned short len) {
+  uint8_t *msg = (uint8_t *) data;
+  remot_info *con_info = NULL;
+  struct dns_proxy_entry *entry;
+  struct dns_proxy_query *query;
+  struct dns_proxy_waiter *waiter;
+  uint16_t question_len, id;
+  uint32_t hash, now, ttl, remote;
+
+  if (!data || espconn_get_connection_info(dns_proxy_client_socket, &con_info, 0) != ESPCONN_OK) {
+    return;
+  }
+  dns_proxy_stats.queries++;
+
+  // Only standard queries of the clients of the soft access-point are served
+  os_memcpy(&remote, con_info->remote_ip, 4);
+  if ((remote & dns_proxy_netmask) != dns_proxy_network || len < DNS_HDR_LEN || (dns_get16(msg + 2) & (DNS_FLAG_QR | DNS_FLAG_OPCODE)) || dns_get16(msg + 4) != 1) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+  question_len = dns_proxy_question(msg, len);
+  if (!question_len) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+  id = dns_get16(msg);
+  hash = dns_proxy_hash(msg + DNS_HDR_LEN, question_len);
+  now = dns_proxy_now();
+
+  // Answer from the cache with the remaining TTL
+  entry = dns_proxy_lookup(hash, msg + DNS_HDR_LEN, question_len, now);
+  if (entry) {
+    entry->last = now;
+    os_memcpy(dns_proxy_buffer, entry->msg, entry->len);
+    dns_put16(dns_proxy_buffer, id);
+    ttl = (entry->expires - now + 999) / 1000;
+    dns_proxy_ttl(dns_proxy_buffer, entry->len, entry->question_len, &ttl, true);
+    dns_proxy_send(dns_proxy_client_socket, con_info->remote_ip, con_info->remote_port, dns_proxy_buffer, entry->len);
+    dns_proxy_stats.hits++;
+    return;
+  }
+
+  // Attach the client to a pending query with the same question (a
+  // retransmission of the client just refreshes its entry)
+  query = dns_proxy_pending(hash, msg + DNS_HDR_LEN, question_len, now);
+  if (query) {
+    for (waiter = query->waiter; waiter < query->waiter + query->waiters; waiter++) {
+      if (os_memcmp(waiter->ip, con_info->remote_ip, 4) == 0 && waiter->port == con_info->remote_port) {
+        break;
+      }
+    }
+    if (waiter == query->waiter + DNS_PROXY_WAITERS) {
+      dns_proxy_stats.drops++;
+      return;
+    }
+    if (waiter == query->waiter + query->waiters) {
+      query->waiters++;
+    }
+    os_memcpy(waiter->ip, con_info->remote_ip, 4);
+    waiter->port = con_info->remote_port;
+    waiter->id = id;
+    dns_proxy_stats.coalesced++;
+    return;
+  }
+
+  // Forward the query to the upstream server with a new ID
+  query = (question_len <= DNS_PROXY_QUESTION_MAX) ? dns_proxy_query_alloc(now) : NULL;
+  if (query) {
+    dns_proxy_upstream_rotate(query, now);
+  }
+  if (!query || !dns_proxy_upstream_socket) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+  query->hash = hash;
+  query->question_len = question_len;
+  os_memcpy(query->question, msg + DNS_HDR_LEN, question_len);
+  os_memcpy(query->waiter[0].ip, con_info->remote_ip, 4);
+  query->waiter[0].port = con_info->remote_port;
+  query->waiter[0].id = id;
+  query->waiters = 1;
+  dns_put16(msg, query->id);
+  dns_proxy_send(dns_proxy_upstream_socket, (uint8_t *) &dns_proxy_upstream, DNS_PORT, msg, len);
+  dns_proxy_stats.upstream++;
+}
+
+// Cache the answer of the upstream server and return it to all clients
+// waiting for it
+static void ICACHE_FLASH_ATTR dns_proxy_upstream_recv_cb(void *arg, char *data, unsigned short len) {
+  uint8_t *msg = (uint8_t *) data;
+  remot_info *con_info = NULL;
+  struct dns_proxy_query *query;
+  uint16_t question_len, id, flags;
+  uint8_t idx;
+
+  // Only answers of the upstream server's port 53 are accepted
+  if (!data || espconn_get_connection_info(dns_proxy_upstream_socket, &con_info, 0) != ESPCONN_OK || os_memcmp(con_info->remote_ip, &dns_proxy_upstream, 4) != 0 || con_info->remote_port != DNS_PORT) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+  if (len < DNS_HDR_LEN || !(dns_get16(msg + 2) & DNS_FLAG_QR) || dns_get16(msg + 4) != 1 || !(question_len = dns_proxy_question(msg, len))) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+
+  // The ID and the question have to match a pending query
+  id = dns_get16(msg);
+  for (query = dns_proxy_queries; query < dns_proxy_queries + DNS_PROXY_PENDING; query++) {
+    if (query->hash && query->id == id && query->question_len == question_len && dns_proxy_question_equal(query->question, msg + DNS_HDR_LEN, question_len)) {
+      break;
+    }
+  }
+  if (query == dns_proxy_queries + DNS_PROXY_PENDING) {
+    dns_proxy_stats.drops++;
+    return;
+  }
+  dns_proxy_stats.answers++;
+
+  // Truncated answers and errors of the server aren't cached
+  flags = dns_get16(msg + 2);
+  if (!(flags & DNS_FLAG_TC) && ((flags & DNS_FLAG_RCODE) == DNS_RCODE_NOERROR || (flags & DNS_FLAG_RCODE) == DNS_RCODE_NXDOMAIN)) {
+    dns_proxy_store(msg, len, question_len, query->hash, dns_proxy_now());
+  }
+
+  for (idx = 0; idx < query->waiters; idx++) {
+    dns_put16(msg, query->waiter[idx].id);
+    dns_proxy_send(dns_proxy_client_socket, query->waiter[idx].ip, query->waiter[idx].port, msg, len);
+  }
+  query->hash = 0;
+}
+
+/*------------------------------------*/
+
+// Sockets:
+
+static struct espconn * ICACHE_FLASH_ATTR dns_proxy_socket(uint16_t local_port, espconn_recv_callback recv_cb) {
+  struct espconn *conn = (struct espconn *) mem_pool_alloc(&mem_pool_espconn);
+
+  if (!conn) {
+    return NULL;
+  }
+  conn->proto.udp = (esp_udp *) mem_pool_alloc(&mem_pool_esp_udp);
+  if (!conn->proto.udp) {
+    mem_pool_free(&mem_pool_espconn, conn);
+    return NULL;
+  }
+  conn->type = ESPCONN_UDP;
+  conn->state = ESPCONN_NONE;
+  conn->proto.udp->local_port = local_port;
+  if (espconn_create(conn) != ESPCONN_OK) {
+    mem_pool_free(&mem_pool_esp_udp, conn->proto.udp);
+    mem_pool_free(&mem_pool_espconn, conn);
+    return NULL;
+  }
+  espconn_regist_recvcb(conn, recv_cb);
+  return conn;
+}
+
+static void ICACHE_FLASH_ATTR dns_proxy_socket_free(struct espconn *conn) {
+  if (conn) {
+    espconn_delete(conn);
+    mem_pool_free(&mem_pool_esp_udp, conn->proto.udp);
+    mem_pool_free(&mem_pool_espconn, conn);
+  }
+}
+
+/*------------------------------------*/
+
+// Status-functions:
+
+// Return the number of valid entries of the cache
+uint16_t ICACHE_FLASH_ATTR dns_proxy_count(void) {
+  struct dns_proxy_entry *entry;
+  uint32_t now = dns_proxy_now();
+  uint16_t count = 0;
+
+  for (entry = dns_proxy_cache; entry < dns_proxy_cache + DNS_PROXY_CACHE_SIZE; entry++) {
+    if (entry->hash && (int32_t) (entry->expires - now) > 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+const struct dns_proxy_stats * ICACHE_FLASH_ATTR dns_proxy_stats_get(void) {
+  return &dns_proxy_stats;
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration resp. termination:
+
+// Discard all cached answers
+void ICACHE_FLASH_ATTR dns_proxy_flush(void) {
+  os_memset(dns_proxy_cache, 0, sizeof(dns_proxy_cache));
+}
+
+// Start serving the clients of the soft access-point (call after its network
+// configuration has been set) with the given upstream server; the cache is
+// kept, if the proxy is already enabled
+bool ICACHE_FLASH_ATTR dns_proxy_enable(uint32_t upstream) {
+  struct ip_info softap_info;
+
+  if (!upstream || !wifi_get_ip_info(SOFTAP_IF, &softap_info)) {
+    LOG_ERROR("dns_proxy_enable: Invalid transfer parameter!\n");
+    return false;
+  }
+
+  LOG_INFO("dns_proxy_enable: Enabling the DNS-proxy!\n");
+
+  dns_proxy_upstream = upstream;
+  dns_proxy_network = softap_info.ip.addr & softap_info.netmask.addr;
+  dns_proxy_netmask = softap_info.netmask.addr;
+  os_memset(dns_proxy_queries, 0, sizeof(dns_proxy_queries));
+  dns_proxy_now();
+
+  if (!dns_proxy_client_socket) {
+    dns_proxy_client_socket = dns_proxy_socket(DNS_PORT, dns_proxy_client_recv_cb);
+  }
+  if (!dns_proxy_upstream_socket) {
+    dns_proxy_upstream_socket = dns_proxy_socket(espconn_port(), dns_proxy_upstream_recv_cb);
+  }
+  if (!dns_proxy_client_socket || !dns_proxy_upstream_socket) {
+    LOG_ERROR("dns_proxy_enable: Failed to create the UDP-sockets!\n");
+    dns_proxy_disable();
+    return false;
+  }
+  return true;
+}
+
+// Stop serving the clients and free the sockets
+void ICACHE_FLASH_ATTR dns_proxy_disable(void) {
+  dns_proxy_socket_free(dns_proxy_client_socket);
+  dns_proxy_socket_free(dns_proxy_upstream_socket);
+  dns_proxy_client_socket = dns_proxy_upstream_socket = NULL;
+  os_memset(dns_proxy_queries, 0, sizeof(dns_proxy_queries));
+}
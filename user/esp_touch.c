@@ -18,6 +18,9 @@
 #include "user_interface.h"
 #include "smartconfig.h"
 #include "esp_touch.h"
+#include "mem_pool.h"
+#define LOG_MODULE LOG_MODULE_ESP_TOUCH
+#include "log.h"
 #include "user_config.h"
 
 /*------------------------------------*/
@@ -41,7 +44,7 @@ static void esptouch_fail_cb(void *arg);
 
 // Initialization and configuration resp. termination:
 void esptouch_disable(void);
-void esptouch_init(void);
+void esptouch_init(esptouch_DoneCallback done_cb);
 
 /*------------------------------------*/
 
@@ -49,6 +52,7 @@ void esptouch_init(void);
 
 static sc_type smartconfig_type;
 struct esptouch_cb esptouch_func;
+static esptouch_DoneCallback esptouch_done_cb = NULL;
 
 static bool esptouch_running = false, esptouch_success = false;
 static uint8_t esptouch_attempt_count = 1;
@@ -76,22 +80,27 @@ bool ICACHE_FLASH_ATTR esptouch_was_successful(void) {
 // Callback-function, that is executed on successful establishing a connection
 // to the router via ESP-TOUCH
 static void ICACHE_FLASH_ATTR esptouch_success_cb(void *arg) {
-  os_printf("esptouch_success_cb: Success! Stopping ESP-TOUCH now!\n");
+  LOG_INFO("esptouch_success_cb: Success! Stopping ESP-TOUCH now!\n");
 
   if (esptouch_timeout_timer) {
     os_timer_disarm(esptouch_timeout_timer);
-    os_free(esptouch_timeout_timer);  // Free occupied resources
+    mem_pool_free(&mem_pool_timers, esptouch_timeout_timer);  // Free occupied resources
     esptouch_timeout_timer = 0;
   }
 
   esptouch_running = false;
   esptouch_success = true;
+
+  // Report the success (cf. lifecycle.c)
+  if (esptouch_done_cb) {
+    esptouch_done_cb(true);
+  }
 }
 
 // Callback-function, that is executed on the start of ESP-TOUCH; increase the
 // attempt-count, print out the current status
 static void ICACHE_FLASH_ATTR esptouch_start_cb(void *arg) {
-  os_printf("esptouch_start_cb: Starting ESP-TOUCH!\n");
+  LOG_INFO("esptouch_start_cb: Starting ESP-TOUCH!\n");
 }
 
 // Callback-function, that is executed on status-changes of ESP-TOUCH
@@ -99,11 +108,11 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
   switch (status) {
     // Waiting for a connection to the intermediary-device
     case SC_STATUS_WAIT:
-      os_printf("esptouch_status_cb: Waiting...\n");
+      LOG_DEBUG("esptouch_status_cb: Waiting...\n");
       break;
     // Scanning channels to communicate with the intermediary-device
     case SC_STATUS_FIND_CHANNEL:
-      os_printf("esptouch_status_cb: Searching channel!\n");
+      LOG_DEBUG("esptouch_status_cb: Searching channel!\n");
 
       // Execute the start-callback
       if (esptouch_func.esptouch_start_cb) {
@@ -112,7 +121,7 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
       break;
     // Receiving SSID and password from the intermediary-device
     case SC_STATUS_GETTING_SSID_PSWD:
-      os_printf("esptouch_status_cb: Receiving SSID and PSWD!\n");
+      LOG_INFO("esptouch_status_cb: Receiving SSID and PSWD!\n");
 
       // Arm the timer that executes the timeout-callback, if the station-
       // configuration couldn't be obtained until the defined threshold (cf.
@@ -126,7 +135,7 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
     // Connecting to the router whose SSID and password have been obtained from
     // the intermediary-device
     case SC_STATUS_LINK:
-      os_printf("esptouch_status_cb: Setting station_config and trying to connect to the router!\n");
+      LOG_INFO("esptouch_status_cb: Setting station_config and trying to connect to the router!\n");
 
       // Connect to the router whose station_config has been obtained
       struct station_config *station_conf = arg;
@@ -138,8 +147,12 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
         wifi_station_connect(); // Try to connect to the access-point
       }
       else {
-        os_printf("esptouch_status_cb: Error while setting station-configuration! Aborting ESP-TOUCH!");
+        LOG_ERROR("esptouch_status_cb: Error while setting station-configuration! Aborting ESP-TOUCH!\n");
         esptouch_disable();
+        if (esptouch_done_cb) {
+          esptouch_done_cb(false);
+        }
+        break;
       }
 
       // Arm the timer that executes the timeout-callback, if no connection to the
@@ -154,7 +167,7 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
     // Connection successfully established; stopping smartconfiguration-mode and
     // executing success-callback
     case SC_STATUS_LINK_OVER:
-      os_printf("esptouch_status_cb: Connection to the router established!\n");
+      LOG_INFO("esptouch_status_cb: Connection to the router established!\n");
 
       // Stop the smartconfiguration-mode and execute the success-callback (if
       // existing)
@@ -174,7 +187,7 @@ void ICACHE_FLASH_ATTR esptouch_status_cb(sc_status status, void *arg) {
 // Callback-function, that is executed on a timeout; print out the current status
 // and restart ESP-TOUCH until the defined limit of attempts has been reached
 static void ICACHE_FLASH_ATTR esptouch_fail_cb(void *arg) {
-  os_printf("esptouch_fail_cb: Timeout occured at the %d. attempt!\n", esptouch_attempt_count);
+  LOG_WARN("esptouch_fail_cb: Timeout occured at the %d. attempt!\n", esptouch_attempt_count);
 
   // Stop ESP-TOUCH, disable WiFi and disarm the timeout-timer
   smartconfig_stop();
@@ -184,7 +197,7 @@ static void ICACHE_FLASH_ATTR esptouch_fail_cb(void *arg) {
   }
 
   if (esptouch_attempt_count < ESP_TOUCH_ATTEMPTS_LIMIT) {
-    os_printf("esptouch_fail_cb: Retrying...\n");
+    LOG_WARN("esptouch_fail_cb: Retrying...\n");
 
     // Increase the attempt-count
     esptouch_attempt_count++;
@@ -201,14 +214,19 @@ static void ICACHE_FLASH_ATTR esptouch_fail_cb(void *arg) {
     smartconfig_start(esptouch_status_cb);
   }
   else {
-    os_printf("esptouch_fail_cb: Reached attempt-limit! Aborting ESP-TOUCH!\n");
+    LOG_ERROR("esptouch_fail_cb: Reached attempt-limit! Aborting ESP-TOUCH!\n");
 
     if (esptouch_timeout_timer) {
-      os_free(esptouch_timeout_timer);  // Free occupied resources
+      mem_pool_free(&mem_pool_timers, esptouch_timeout_timer);  // Free occupied resources
       esptouch_timeout_timer = 0;
     }
 
     esptouch_running = false;
+
+    // Report the failure (cf. lifecycle.c)
+    if (esptouch_done_cb) {
+      esptouch_done_cb(false);
+    }
   }
 }
 
@@ -218,23 +236,24 @@ static void ICACHE_FLASH_ATTR esptouch_fail_cb(void *arg) {
 
 // Stop the smartconfiguration-mode and free all occupied resources
 void ICACHE_FLASH_ATTR esptouch_disable(void) {
-  os_printf("esptouch_disable: Disabling ESP-TOUCH!\n");
+  LOG_INFO("esptouch_disable: Disabling ESP-TOUCH!\n");
 
   // Stop the smartconfiguration-mode
   smartconfig_stop();
 
   if (esptouch_timeout_timer) {
     os_timer_disarm(esptouch_timeout_timer);  // Disarm timeout-timer
-    os_free(esptouch_timeout_timer);  // Free occupied resouces
+    mem_pool_free(&mem_pool_timers, esptouch_timeout_timer);  // Free occupied resouces
     esptouch_timeout_timer = NULL;
   }
 
   esptouch_running = false;
 }
 
-// Set callbacks, initialize timer and start ESP-TOUCH
-void ICACHE_FLASH_ATTR esptouch_init(void) {
-  os_printf("esptouch_init: Initializing ESP-TOUCH!\n");
+// Set callbacks, initialize timer and start ESP-TOUCH; done_cb is executed,
+// once ESP-TOUCH succeeded resp. finally failed
+void ICACHE_FLASH_ATTR esptouch_init(esptouch_DoneCallback done_cb) {
+  LOG_INFO("esptouch_init: Initializing ESP-TOUCH!\n");
 
   // Set ESP-TOUCH to running and not (yet) successful and initialize the
   // attempt-count
@@ -247,7 +266,7 @@ void ICACHE_FLASH_ATTR esptouch_init(void) {
 
   // Set WiFi to station mode to be able to receive the router's SSID and
   // password from the intermediary-device
-  os_printf("esptouch_init: Set WiFi to station mode!\n");
+  LOG_INFO("esptouch_init: Set WiFi to station mode!\n");
   wifi_set_opmode(STATION_MODE);
 
   // Assign callback-functions and set the smartconfiguration-type to
@@ -255,12 +274,13 @@ void ICACHE_FLASH_ATTR esptouch_init(void) {
   esptouch_func.esptouch_fail_cb = esptouch_fail_cb;
   esptouch_func.esptouch_start_cb = esptouch_start_cb;
   esptouch_func.esptouch_suc_cb = esptouch_success_cb;
+  esptouch_done_cb = done_cb;
   smartconfig_type = SC_TYPE_ESPTOUCH;
 
   // Initialize the timeout-timer
-  esptouch_timeout_timer = (os_timer_t *) os_zalloc(sizeof(os_timer_t));
+  esptouch_timeout_timer = (os_timer_t *) mem_pool_alloc(&mem_pool_timers);
   if (!esptouch_timeout_timer) {
-    os_printf("Failed to initialize the timeout-timer! Continuing without!\n");
+    LOG_WARN("Failed to initialize the timeout-timer! Continuing without!\n");
   }
 
   // Configure and arm the timer that executes the timeout-callback, if no
@@ -277,7 +297,10 @@ void ICACHE_FLASH_ATTR esptouch_init(void) {
     smartconfig_start(esptouch_status_cb);
   }
   else {
-    os_printf("esptouch_init: Failed to start smartconfiguration-mode!\n");
+    LOG_ERROR("esptouch_init: Failed to start smartconfiguration-mode!\n");
     esptouch_disable(); // Free all occupied resources and set esptouch_running to false
+    if (esptouch_done_cb) {
+      esptouch_done_cb(false);
+    }
   }
 }
@@ -0,0 +1,187 @@
+// fast_boot.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Fast activation of the router with the credentials of the last
+// successful activation instead of ESP-TOUCH (cf. lifecycle.c). The SDK stores
+// the station configuration set by ESP-TOUCH in the flash, so it's still
+// available after a power loss. Additionally, the BSSID and channel of the
+// host access-point are cached in the RTC-memory (which survives resets, but
+// not a power loss): with them, the station joins the host access-point
+// directly instead of scanning all channels for the SSID. If the station
+// doesn't get its address within FAST_BOOT_HINT_TIMEOUT, the hint is discarded
+// and it falls back to the scan; if it isn't connected within
+// FAST_BOOT_TIMEOUT, the lifecycle state machine falls back to ESP-TOUCH.
+
+#include "osapi.h"
+#include "user_interface.h"
+#include "fast_boot.h"
+#define LOG_MODULE LOG_MODULE_LIFECYCLE
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define FAST_BOOT_MAGIC 0x54534146  // "FAST"
+
+/*------------------------------------*/
+
+// Cached BSSID and channel of the host access-point (stored in the RTC-memory;
+// the size has to be a multiple of four bytes)
+struct fast_boot_hint {
+  uint32_t magic;     // FAST_BOOT_MAGIC
+  uint32_t ssid_hash; // Hash of the SSID, that the hint belongs to
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Hint:
+static uint32_t fast_boot_ssid_hash(const uint8_t *ssid);
+static bool fast_boot_hint_load(const struct station_config *config, struct fast_boot_hint *hint);
+static void fast_boot_hint_clear(void);
+
+// Timer-functions:
+static void fast_boot_hint_timerfunc(void *arg);
+
+// Connection:
+bool fast_boot_connect(void);
+void fast_boot_save(void);
+void fast_boot_stop(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static os_timer_t fast_boot_hint_timer;
+
+/*------------------------------------*/
+
+// Hint:
+
+// Hash of an SSID (FNV-1a)
+static uint32_t ICACHE_FLASH_ATTR fast_boot_ssid_hash(const uint8_t *ssid) {
+  uint32_t hash = 2166136261UL;
+  uint8_t idx;
+
+  for (idx = 0; idx < 32 && ssid[idx]; idx++) {
+    hash = (hash ^ ssid[idx]) * 16777619UL;
+  }
+  return hash;
+}
+
+// Load the hint for the SSID of the given configuration; returns false, if
+// there's none
+static bool ICACHE_FLASH_ATTR fast_boot_hint_load(const struct station_config *config, struct fast_boot_hint *hint) {
+  if (!system_rtc_mem_read(FAST_BOOT_RTC_BLOCK, hint, sizeof(struct fast_boot_hint))) {
+    return false;
+  }
+  return hint->magic == FAST_BOOT_MAGIC && hint->ssid_hash == fast_boot_ssid_hash(config->ssid) && hint->channel >= 1 && hint->channel <= 14;
+}
+
+// Discard the hint
+static void ICACHE_FLASH_ATTR fast_boot_hint_clear(void) {
+  struct fast_boot_hint hint;
+
+  os_memset(&hint, 0, sizeof(hint));
+  system_rtc_mem_write(FAST_BOOT_RTC_BLOCK, &hint, sizeof(hint));
+}
+
+/*------------------------------------*/
+
+// Timer-functions:
+
+// Timer-function, that is executed, if the station couldn't join the cached
+// BSSID in time (e.g. because the host access-point has been replaced); discard
+// the hint and scan for the SSID
+static void ICACHE_FLASH_ATTR fast_boot_hint_timerfunc(void *arg) {
+  struct station_config config;
+
+  if (wifi_station_get_connect_status() == STATION_GOT_IP || !wifi_station_get_config_default(&config)) {
+    return;
+  }
+
+  LOG_WARN("fast_boot_hint_timerfunc: Failed to join the cached BSSID! Scanning for %.32s!\n", config.ssid);
+
+  fast_boot_hint_clear();
+  config.bssid_set = 0;
+  wifi_station_disconnect();
+  wifi_station_set_config_current(&config);
+  wifi_station_connect();
+}
+
+/*------------------------------------*/
+
+// Connection:
+
+// Connect the station with the cached credentials (and the cached BSSID and
+// channel, if available); returns false, if FAST_BOOT is disabled or there are
+// no credentials
+bool ICACHE_FLASH_ATTR fast_boot_connect(void) {
+  struct station_config config;
+  struct fast_boot_hint hint;
+
+  if (!FAST_BOOT || !wifi_station_get_config_default(&config) || !config.ssid[0]) {
+    return false;
+  }
+
+  // Set WiFi to station mode (cf. esptouch_init)
+  wifi_station_disconnect();
+  wifi_set_opmode(STATION_MODE);
+
+  os_timer_disarm(&fast_boot_hint_timer);
+  config.bssid_set = 0;
+  if (fast_boot_hint_load(&config, &hint)) {
+    LOG_INFO("fast_boot_connect: Connecting to %.32s (" MACSTR ", channel %d)!\n", config.ssid, MAC2STR(hint.bssid), hint.channel);
+
+    config.bssid_set = 1;
+    os_memcpy(config.bssid, hint.bssid, 6);
+    wifi_set_channel(hint.channel);
+    os_timer_setfn(&fast_boot_hint_timer, (os_timer_func_t *) fast_boot_hint_timerfunc, NULL);
+    os_timer_arm(&fast_boot_hint_timer, FAST_BOOT_HINT_TIMEOUT, false);
+  }
+  else {
+    LOG_INFO("fast_boot_connect: Connecting to %.32s!\n", config.ssid);
+  }
+
+  // The configuration with the BSSID isn't stored in the flash, so that the
+  // station isn't bound to it permanently
+  if (!wifi_station_set_config_current(&config) || !wifi_station_connect()) {
+    LOG_ERROR("fast_boot_connect: Failed to connect the station!\n");
+    fast_boot_stop();
+    return false;
+  }
+  return true;
+}
+
+// Cache the BSSID and channel of the host access-point, that the station is
+// connected to (once the router is online)
+void ICACHE_FLASH_ATTR fast_boot_save(void) {
+  struct station_config config;
+  struct fast_boot_hint hint;
+
+  os_timer_disarm(&fast_boot_hint_timer);
+  if (!FAST_BOOT || wifi_station_get_connect_status() != STATION_GOT_IP || !wifi_station_get_config(&config)) {
+    return;
+  }
+  os_memset(&hint, 0, sizeof(hint));
+  hint.magic = FAST_BOOT_MAGIC;
+  hint.ssid_hash = fast_boot_ssid_hash(config.ssid);
+  os_memcpy(hint.bssid, config.bssid, 6);
+  hint.channel = wifi_get_channel();
+  if (!system_rtc_mem_write(FAST_BOOT_RTC_BLOCK, &hint, sizeof(hint))) {
+    LOG_ERROR("fast_boot_save: Failed to write the RTC-memory!\n");
+  }
+}
+
+// Stop the fast boot (e.g. on the fallback to ESP-TOUCH)
+void ICACHE_FLASH_ATTR fast_boot_stop(void) {
+  os_timer_disarm(&fast_boot_hint_timer);
+}
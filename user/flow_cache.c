@@ -0,0 +1,329 @@
+// flow_cache.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Set-associative cache of the translations of established flows
+// in front of the NAPT-engine (cf. napt_netif.c). Every packet of a flow pays
+// the parsing and the lookup in the NAPT-table, the incremental update of the
+// checksums, the routing decision and the lookup of the next hop in the ARP-
+// table otherwise. The cache holds FLOW_CACHE_SIZE entries in sets of
+// FLOW_CACHE_WAYS keyed on the 5-tuple and the network interface, on which the
+// packet has been received; an entry stores the complete rewrite (translated
+// address and port and the precomputed checksum-deltas), the next hop and its
+// MAC-address, so that a hit only writes the new values and applies the
+// deltas.
+//
+// A flow is only inserted, when it misses the cache for the second time (the
+// hashes of the recently missed flows are kept per set), so that more flows
+// than the cache can hold don't evict each other on every packet; a full set
+// replaces its oldest entry. The insertion takes the translation entry and the
+// next hop from the full path, which has just resolved them.
+//
+// Only TCP- and UDP-packets are cached; TCP-packets with a SYN, FIN or RST
+// always take the full path, so that the state of the connection is tracked
+// by the engine, and TCP-connections are only cached once they are
+// established. An entry is removed, when its translation entry is removed
+// from the NAPT-table (expiry resp. eviction; cf. napt_remove), and the whole
+// cache is flushed on changes of the portmaps, of the address of the station
+// network interface (napt_external_update) and of the associated clients. The
+// ARP-table of lwip doesn't report changes, so every entry is re-resolved by
+// the full path after FLOW_CACHE_TIMEOUT ms.
+//
+// The class operates on plain IPv4-packets and doesn't depend on lwip, so that
+// it can also be compiled for the host (cf. Makefile).
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "napt.h"
+#include "napt_chksum.h"
+#include "flow_cache.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Byte-offsets of the header-fields used by the cache (cf. napt.c)
+
+#define IP_HLEN_MIN 20
+#define IP_OFFSET_FRAG 6
+#define IP_OFFSET_PROTO 9
+#define IP_OFFSET_CHKSUM 10
+#define IP_OFFSET_SRC 12
+#define IP_OFFSET_DEST 16
+
+#define L4_OFFSET_SPORT 0
+#define L4_OFFSET_DPORT 2
+
+#define TCP_HLEN_MIN 20
+#define TCP_OFFSET_FLAGS 13
+#define TCP_OFFSET_CHKSUM 16
+#define TCP_FLAGS_UNCACHED 0x07 // FIN, SYN and RST
+
+#define UDP_HLEN 8
+#define UDP_OFFSET_CHKSUM 6
+
+#define FLOW_CACHE_SETS (FLOW_CACHE_SIZE / FLOW_CACHE_WAYS)
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t flow_cache_now(void);
+static uint32_t flow_cache_hash(const struct flow_cache_key *key);
+static struct flow_cache_entry *flow_cache_set(uint32_t hash);
+static bool flow_cache_match(const struct flow_cache_key *a, const struct flow_cache_key *b);
+
+// Lookup and insertion:
+struct flow_cache_entry *flow_cache_lookup(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, struct flow_cache_key *key);
+void flow_cache_apply(const struct flow_cache_entry *flow, uint8_t *iphdr);
+struct flow_cache_entry *flow_cache_insert(const struct flow_cache_key *key, struct napt_entry *entry, const uint8_t *iphdr, uint32_t nexthop, const uint8_t *mac);
+const struct flow_cache_stats *flow_cache_stats_get(void);
+
+// Invalidation and configuration:
+void flow_cache_invalidate(const struct napt_entry *entry);
+void flow_cache_flush(void);
+void flow_cache_set_enabled(bool enabled);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct flow_cache_entry flow_cache_table[FLOW_CACHE_SIZE];  // Sets of FLOW_CACHE_WAYS entries
+static uint32_t flow_cache_missed[FLOW_CACHE_SIZE]; // Hashes of the recently missed flows per set (0 = none)
+static struct flow_cache_stats flow_cache_stats;
+static bool flow_cache_enabled = FLOW_CACHE;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint32_t ICACHE_FLASH_ATTR flow_cache_now(void) {
+  return system_get_time() / 1000;
+}
+
+// Multiplicative hash of the 5-tuple and the network interface (never 0)
+static uint32_t ICACHE_FLASH_ATTR flow_cache_hash(const struct flow_cache_key *key) {
+  uint32_t h = key->src ^ (key->dest * 31) ^ (((uint32_t) key->sport << 16) | key->dport) ^ (key->proto << 8) ^ key->if_idx;
+
+  h = (h ^ (h >> 16)) * 0x9E3779B1;
+  return h | 1;
+}
+
+// First entry of the set of the given hash
+static struct flow_cache_entry * ICACHE_FLASH_ATTR flow_cache_set(uint32_t hash) {
+  return &flow_cache_table[((hash >> 16) & (FLOW_CACHE_SETS - 1)) * FLOW_CACHE_WAYS];
+}
+
+static bool ICACHE_FLASH_ATTR flow_cache_match(const struct flow_cache_key *a, const struct flow_cache_key *b) {
+  return a->src == b->src && a->dest == b->dest && a->sport == b->sport && a->dport == b->dport && a->proto == b->proto && a->if_idx == b->if_idx;
+}
+
+/*------------------------------------*/
+
+// Lookup and insertion:
+
+// Look up the flow of an IPv4-packet (of len bytes), that has been received on
+// the network interface if_idx; on a miss, its key is returned in key for the
+// insertion of the translation (key->proto is 0, if the packet can't be
+// cached)
+struct flow_cache_entry * ICACHE_FLASH_ATTR flow_cache_lookup(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, struct flow_cache_key *key) {
+  struct flow_cache_entry *flow;
+  const uint8_t *l4hdr;
+  uint16_t hlen;
+  uint8_t way;
+
+  key->proto = 0;
+  if (!flow_cache_enabled || len < IP_HLEN_MIN || (iphdr[0] >> 4) != 4) {
+    return NULL;
+  }
+  hlen = (iphdr[0] & 0x0F) * 4;
+  if (hlen < IP_HLEN_MIN || (iphdr[IP_OFFSET_FRAG] & 0x3F) || iphdr[IP_OFFSET_FRAG + 1]) {
+    return NULL;
+  }
+  l4hdr = iphdr + hlen;
+  switch (iphdr[IP_OFFSET_PROTO]) {
+    case NAPT_PROTO_TCP:
+      if (len < hlen + TCP_HLEN_MIN || (l4hdr[TCP_OFFSET_FLAGS] & TCP_FLAGS_UNCACHED)) {
+        return NULL;
+      }
+      break;
+    case NAPT_PROTO_UDP:
+      if (len < hlen + UDP_HLEN) {
+        return NULL;
+      }
+      break;
+    default:
+      return NULL;
+  }
+
+  os_memcpy(&key->src, iphdr + IP_OFFSET_SRC, 4);
+  os_memcpy(&key->dest, iphdr + IP_OFFSET_DEST, 4);
+  os_memcpy(&key->sport, l4hdr + L4_OFFSET_SPORT, 2);
+  os_memcpy(&key->dport, l4hdr + L4_OFFSET_DPORT, 2);
+  key->proto = iphdr[IP_OFFSET_PROTO];
+  key->if_idx = if_idx;
+
+  flow = flow_cache_set(flow_cache_hash(key));
+  for (way = 0; way < FLOW_CACHE_WAYS; way++, flow++) {
+    if (flow->key.proto && flow_cache_match(&flow->key, key)) {
+      if (flow_cache_now() - flow->time >= FLOW_CACHE_TIMEOUT) {
+        break;
+      }
+      flow_cache_stats.hits++;
+      return flow;
+    }
+  }
+  flow_cache_stats.misses++;
+  return NULL;
+}
+
+// Rewrite the packet of the given flow (the packet must have been looked up
+// with flow_cache_lookup); the checksums are updated by the precomputed deltas
+// just like napt_rewrite of the NAPT-engine does
+void ICACHE_FLASH_ATTR flow_cache_apply(const struct flow_cache_entry *flow, uint8_t *iphdr) {
+  uint8_t *l4hdr = iphdr + (iphdr[0] & 0x0F) * 4, *chksum;
+
+  if (flow->key.if_idx == SOFTAP_IF) {
+    os_memcpy(iphdr + IP_OFFSET_SRC, &flow->addr, 4);
+    os_memcpy(l4hdr + L4_OFFSET_SPORT, &flow->port, 2);
+  }
+  else {
+    os_memcpy(iphdr + IP_OFFSET_DEST, &flow->addr, 4);
+    os_memcpy(l4hdr + L4_OFFSET_DPORT, &flow->port, 2);
+  }
+  napt_chksum_apply(iphdr + IP_OFFSET_CHKSUM, flow->ip_delta);
+
+  // A checksum of 0 means "no checksum" for UDP; 0xFFFF is equivalent in the
+  // one's complement arithmetic
+  chksum = l4hdr + ((flow->key.proto == NAPT_PROTO_TCP) ? TCP_OFFSET_CHKSUM : UDP_OFFSET_CHKSUM);
+  if (flow->key.proto == NAPT_PROTO_TCP || chksum[0] || chksum[1]) {
+    napt_chksum_apply(chksum, flow->l4_delta);
+    if (!chksum[0] && !chksum[1]) {
+      chksum[0] = chksum[1] = 0xFF;
+    }
+  }
+}
+
+// Insert the translation of a packet, that missed the cache with the given key
+// and has been translated to iphdr by the translation entry entry (as returned
+// by napt_translated_entry; NULL for portmaps), together with its next hop. A
+// flow is only inserted on its second miss and TCP-connections only once they
+// are established. Returns NULL, if the flow isn't cached.
+struct flow_cache_entry * ICACHE_FLASH_ATTR flow_cache_insert(const struct flow_cache_key *key, struct napt_entry *entry, const uint8_t *iphdr, uint32_t nexthop, const uint8_t *mac) {
+  const uint8_t *l4hdr = iphdr + (iphdr[0] & 0x0F) * 4;
+  struct flow_cache_entry *set, *flow = NULL;
+  uint32_t hash, *missed;
+  uint32_t addr;
+  uint16_t port;
+  uint8_t way;
+
+  if (!flow_cache_enabled || !key->proto) {
+    return NULL;
+  }
+
+  // The translation entry has to belong to the flow (within a batch, it may
+  // have been evicted by the translation of a later packet)
+  if (entry && (entry->proto != key->proto || ((key->if_idx == SOFTAP_IF) ? (entry->src != key->src || entry->sport != key->sport || entry->dest != key->dest || entry->dport != key->dport) : (entry->dest != key->src || entry->dport != key->sport || entry->mport != key->dport)))) {
+    return NULL;
+  }
+  if (entry && entry->proto == NAPT_PROTO_TCP && (entry->state & NAPT_TCP_STATE_MASK) != NAPT_TCP_ESTABLISHED) {
+    return NULL;
+  }
+
+  // An expired entry of the flow is renewed; otherwise, the flow is inserted
+  // on its second miss in place of an unused resp. the oldest entry of its set
+  hash = flow_cache_hash(key);
+  set = flow_cache_set(hash);
+  for (way = 0; way < FLOW_CACHE_WAYS; way++) {
+    if (set[way].key.proto && flow_cache_match(&set[way].key, key)) {
+      flow = &set[way];
+      break;
+    }
+  }
+  if (!flow) {
+    missed = &flow_cache_missed[set - flow_cache_table];
+    for (way = 0; way < FLOW_CACHE_WAYS && missed[way] != hash; way++);
+    if (way == FLOW_CACHE_WAYS) {
+      os_memmove(missed + 1, missed, (FLOW_CACHE_WAYS - 1) * sizeof(uint32_t));
+      missed[0] = hash;
+      flow_cache_stats.deferred++;
+      return NULL;
+    }
+    missed[way] = 0;
+    flow = set;
+    for (way = 0; way < FLOW_CACHE_WAYS && flow->key.proto; way++) {
+      if (!set[way].key.proto || (int32_t) (set[way].time - flow->time) < 0) {
+        flow = &set[way];
+      }
+    }
+  }
+
+  if (key->if_idx == SOFTAP_IF) {
+    os_memcpy(&addr, iphdr + IP_OFFSET_SRC, 4);
+    os_memcpy(&port, l4hdr + L4_OFFSET_SPORT, 2);
+  }
+  else {
+    os_memcpy(&addr, iphdr + IP_OFFSET_DEST, 4);
+    os_memcpy(&port, l4hdr + L4_OFFSET_DPORT, 2);
+  }
+  flow->key = *key;
+  flow->addr = addr;
+  flow->port = port;
+  os_memcpy(flow->mac, mac, 6);
+  flow->nexthop = nexthop;
+  if (key->if_idx == SOFTAP_IF) {
+    flow->ip_delta = napt_chksum_delta(0, (const uint8_t *) &key->src, (const uint8_t *) &addr, 4);
+    flow->l4_delta = napt_chksum_delta(flow->ip_delta, (const uint8_t *) &key->sport, (const uint8_t *) &port, 2);
+  }
+  else {
+    flow->ip_delta = napt_chksum_delta(0, (const uint8_t *) &key->dest, (const uint8_t *) &addr, 4);
+    flow->l4_delta = napt_chksum_delta(flow->ip_delta, (const uint8_t *) &key->dport, (const uint8_t *) &port, 2);
+  }
+  flow->time = flow_cache_now();
+  flow->entry = entry;
+  flow_cache_stats.inserts++;
+  return flow;
+}
+
+const struct flow_cache_stats * ICACHE_FLASH_ATTR flow_cache_stats_get(void) {
+  return &flow_cache_stats;
+}
+
+/*------------------------------------*/
+
+// Invalidation and configuration:
+
+// Remove the flows of the given translation entry (e.g. on its expiry)
+void ICACHE_FLASH_ATTR flow_cache_invalidate(const struct napt_entry *entry) {
+  uint16_t idx;
+
+  for (idx = 0; idx < FLOW_CACHE_SIZE; idx++) {
+    if (flow_cache_table[idx].key.proto && flow_cache_table[idx].entry == entry) {
+      flow_cache_table[idx].key.proto = 0;
+      flow_cache_stats.invalidations++;
+    }
+  }
+}
+
+// Remove all flows
+void ICACHE_FLASH_ATTR flow_cache_flush(void) {
+  uint16_t idx;
+
+  for (idx = 0; idx < FLOW_CACHE_SIZE; idx++) {
+    if (flow_cache_table[idx].key.proto) {
+      flow_cache_table[idx].key.proto = 0;
+      flow_cache_stats.invalidations++;
+    }
+  }
+  os_memset(flow_cache_missed, 0, sizeof(flow_cache_missed));
+}
+
+// Enable resp. disable the cache (the cached flows are removed)
+void ICACHE_FLASH_ATTR flow_cache_set_enabled(bool enabled) {
+  flow_cache_enabled = enabled;
+  flow_cache_flush();
+}
@@ -0,0 +1,187 @@
+// hmac_sha256.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-16
+//
+// Description: SHA-256 (FIPS 180-4) and HMAC-SHA-256 (RFC 2104), with which
+// the route advertisements of the mesh-nodes are authenticated under the
+// shared mesh-key (cf. mesh.c). The messages are short and rare, so the
+// compression function works on a single block buffer without unrolling.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "hmac_sha256.h"
+
+/*------------------------------------*/
+
+#define SHA256_BLOCK_LEN 64
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*------------------------------------*/
+
+// State of a hash computation
+struct sha256_ctx {
+  uint32_t state[8];
+  uint32_t len;       // Number of hashed bytes
+  uint8_t block[SHA256_BLOCK_LEN];
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static void sha256_compress(struct sha256_ctx *ctx);
+static void sha256_init(struct sha256_ctx *ctx);
+static void sha256_update(struct sha256_ctx *ctx, const uint8_t *data, uint16_t len);
+static void sha256_final(struct sha256_ctx *ctx, uint8_t *digest);
+
+// Hashing:
+void sha256(const uint8_t *data, uint16_t len, uint8_t *digest);
+void hmac_sha256(const uint8_t *key, uint16_t key_len, const uint8_t *data, uint16_t len, uint8_t *mac);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static const uint32_t sha256_k[64] = {
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Process the full block buffer of the context
+static void ICACHE_FLASH_ATTR sha256_compress(struct sha256_ctx *ctx) {
+  uint32_t w[64], s[8], t1, t2;
+  uint8_t idx;
+
+  for (idx = 0; idx < 16; idx++) {
+    w[idx] = ((uint32_t) ctx->block[4 * idx] << 24) | ((uint32_t) ctx->block[4 * idx + 1] << 16) | ((uint32_t) ctx->block[4 * idx + 2] << 8) | ctx->block[4 * idx + 3];
+  }
+  for (; idx < 64; idx++) {
+    w[idx] = w[idx - 16] + (ROTR(w[idx - 15], 7) ^ ROTR(w[idx - 15], 18) ^ (w[idx - 15] >> 3)) + w[idx - 7] +
+             (ROTR(w[idx - 2], 17) ^ ROTR(w[idx - 2], 19) ^ (w[idx - 2] >> 10));
+  }
+
+  os_memcpy(s, ctx->state, sizeof(s));
+  for (idx = 0; idx < 64; idx++) {
+    t1 = s[7] + (ROTR(s[4], 6) ^ ROTR(s[4], 11) ^ ROTR(s[4], 25)) + ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[idx] + w[idx];
+    t2 = (ROTR(s[0], 2) ^ ROTR(s[0], 13) ^ ROTR(s[0], 22)) + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+    s[7] = s[6];
+    s[6] = s[5];
+    s[5] = s[4];
+    s[4] = s[3] + t1;
+    s[3] = s[2];
+    s[2] = s[1];
+    s[1] = s[0];
+    s[0] = t1 + t2;
+  }
+  for (idx = 0; idx < 8; idx++) {
+    ctx->state[idx] += s[idx];
+  }
+}
+
+static void ICACHE_FLASH_ATTR sha256_init(struct sha256_ctx *ctx) {
+  ctx->state[0] = 0x6A09E667;
+  ctx->state[1] = 0xBB67AE85;
+  ctx->state[2] = 0x3C6EF372;
+  ctx->state[3] = 0xA54FF53A;
+  ctx->state[4] = 0x510E527F;
+  ctx->state[5] = 0x9B05688C;
+  ctx->state[6] = 0x1F83D9AB;
+  ctx->state[7] = 0x5BE0CD19;
+  ctx->len = 0;
+}
+
+static void ICACHE_FLASH_ATTR sha256_update(struct sha256_ctx *ctx, const uint8_t *data, uint16_t len) {
+  while (len--) {
+    ctx->block[ctx->len++ % SHA256_BLOCK_LEN] = *data++;
+    if (!(ctx->len % SHA256_BLOCK_LEN)) {
+      sha256_compress(ctx);
+    }
+  }
+}
+
+// Pad the message with 0x80, zeros and its length in bits and return the
+// digest (SHA256_DIGEST_LEN bytes)
+static void ICACHE_FLASH_ATTR sha256_final(struct sha256_ctx *ctx, uint8_t *digest) {
+  uint32_t bits = ctx->len * 8;
+  uint8_t pos = ctx->len % SHA256_BLOCK_LEN, idx;
+
+  ctx->block[pos++] = 0x80;
+  if (pos > SHA256_BLOCK_LEN - 8) {
+    os_memset(ctx->block + pos, 0, SHA256_BLOCK_LEN - pos);
+    sha256_compress(ctx);
+    pos = 0;
+  }
+  os_memset(ctx->block + pos, 0, SHA256_BLOCK_LEN - 4 - pos);
+  ctx->block[SHA256_BLOCK_LEN - 4] = bits >> 24;
+  ctx->block[SHA256_BLOCK_LEN - 3] = (bits >> 16) & 0xFF;
+  ctx->block[SHA256_BLOCK_LEN - 2] = (bits >> 8) & 0xFF;
+  ctx->block[SHA256_BLOCK_LEN - 1] = bits & 0xFF;
+  sha256_compress(ctx);
+
+  for (idx = 0; idx < 8; idx++) {
+    digest[4 * idx] = ctx->state[idx] >> 24;
+    digest[4 * idx + 1] = (ctx->state[idx] >> 16) & 0xFF;
+    digest[4 * idx + 2] = (ctx->state[idx] >> 8) & 0xFF;
+    digest[4 * idx + 3] = ctx->state[idx] & 0xFF;
+  }
+}
+
+/*------------------------------------*/
+
+// Hashing:
+
+// Return the SHA-256 digest (SHA256_DIGEST_LEN bytes) of the data
+void ICACHE_FLASH_ATTR sha256(const uint8_t *data, uint16_t len, uint8_t *digest) {
+  struct sha256_ctx ctx;
+
+  sha256_init(&ctx);
+  sha256_update(&ctx, data, len);
+  sha256_final(&ctx, digest);
+}
+
+// Return the HMAC-SHA-256 (SHA256_DIGEST_LEN bytes) of the data under the key;
+// keys longer than a block are hashed first
+void ICACHE_FLASH_ATTR hmac_sha256(const uint8_t *key, uint16_t key_len, const uint8_t *data, uint16_t len, uint8_t *mac) {
+  struct sha256_ctx ctx;
+  uint8_t pad[SHA256_BLOCK_LEN], inner[SHA256_DIGEST_LEN];
+  uint8_t idx;
+
+  os_memset(pad, 0, sizeof(pad));
+  if (key_len > SHA256_BLOCK_LEN) {
+    sha256(key, key_len, pad);
+  }
+  else {
+    os_memcpy(pad, key, key_len);
+  }
+
+  for (idx = 0; idx < SHA256_BLOCK_LEN; idx++) {
+    pad[idx] ^= 0x36;
+  }
+  sha256_init(&ctx);
+  sha256_update(&ctx, pad, SHA256_BLOCK_LEN);
+  sha256_update(&ctx, data, len);
+  sha256_final(&ctx, inner);
+
+  for (idx = 0; idx < SHA256_BLOCK_LEN; idx++) {
+    pad[idx] ^= 0x36 ^ 0x5C;
+  }
+  sha256_init(&ctx);
+  sha256_update(&ctx, pad, SHA256_BLOCK_LEN);
+  sha256_update(&ctx, inner, SHA256_DIGEST_LEN);
+  sha256_final(&ctx, mac);
+}
@@ -0,0 +1,249 @@
+// lifecycle.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: State machine of the router's lifecycle. It's driven only by
+// events: the actuation of the pushbutton, the callbacks of ESP-TOUCH (cf.
+// esp_touch.c), the WiFi-events handled by the router (cf. router.c) and a
+// single timeout-timer, so that nothing has to be polled:
+//
+//  IDLE          -- button, cached credentials -----------> FAST_BOOT
+//                -- button, no cached credentials --------> PROVISIONING
+//  FAST_BOOT     -- router up ----------------------------> ONLINE
+//                -- timeout (FAST_BOOT_TIMEOUT) ----------> PROVISIONING
+//  PROVISIONING  -- ESP-TOUCH succeeded, router up -------> ONLINE
+//                -- ESP-TOUCH succeeded, router not up ---> CONNECTING
+//                -- ESP-TOUCH failed ---------------------> IDLE
+//  CONNECTING    -- router up ----------------------------> ONLINE
+//  ONLINE        -- disconnected -------------------------> RECONNECTING
+//  RECONNECTING  -- router up ----------------------------> ONLINE
+//  CONNECTING,
+//  RECONNECTING  -- timeout ------------------------------> IDLE
+//
+// With FAST_BOOT, the station first tries to connect with the credentials of
+// the last successful activation (cf. fast_boot.c); ESP-TOUCH is only started,
+// if there are none or if the router isn't up within FAST_BOOT_TIMEOUT. During
+// PROVISIONING, the router usually comes up (the station got its address)
+// before ESP-TOUCH reports its success, which is remembered. The services of
+// the router are started on the first transition to ONLINE only; while
+// RECONNECTING, they keep running. The device-specific actions are executed by
+// the hooks passed to lifecycle_init (cf. user_main.c).
+
+#include "osapi.h"
+#include "user_interface.h"
+#include "lifecycle.h"
+#include "router.h"
+#include "config.h"
+#define LOG_MODULE LOG_MODULE_LIFECYCLE
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Status-functions:
+enum lifecycle_state lifecycle_state_get(void);
+const char *lifecycle_state_name(enum lifecycle_state state);
+const struct lifecycle_stats *lifecycle_stats_get(void);
+
+// Timer-functions:
+static void lifecycle_timeout_timerfunc(void *arg);
+
+// Transitions:
+static void lifecycle_enter(enum lifecycle_state state, uint32_t timeout);
+static void lifecycle_provision(void);
+static void lifecycle_online(void);
+static void lifecycle_disable(void);
+void lifecycle_event(enum lifecycle_event event);
+
+// Initialization and configuration:
+void lifecycle_init(const struct lifecycle_hooks *hooks);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static enum lifecycle_state lifecycle_state = LIFECYCLE_IDLE;
+static const struct lifecycle_hooks *lifecycle_hooks = NULL;
+static bool lifecycle_router_up = false;  // Router set up during PROVISIONING
+static uint32_t lifecycle_enabled_us = 0; // Time of the actuation of the pushbutton
+static struct lifecycle_stats lifecycle_stats;
+static os_timer_t lifecycle_timeout_timer;
+
+/*------------------------------------*/
+
+// Status-functions:
+
+// Return the current state of the router
+enum lifecycle_state ICACHE_FLASH_ATTR lifecycle_state_get(void) {
+  return lifecycle_state;
+}
+
+// Return the name of the given state
+const char * ICACHE_FLASH_ATTR lifecycle_state_name(enum lifecycle_state state) {
+  switch (state) {
+    case LIFECYCLE_IDLE: return "idle";
+    case LIFECYCLE_FAST_BOOT: return "fast_boot";
+    case LIFECYCLE_PROVISIONING: return "provisioning";
+    case LIFECYCLE_CONNECTING: return "connecting";
+    case LIFECYCLE_ONLINE: return "online";
+    case LIFECYCLE_RECONNECTING: return "reconnecting";
+  }
+  return "unknown";
+}
+
+// Return the counters of the state machine
+const struct lifecycle_stats * ICACHE_FLASH_ATTR lifecycle_stats_get(void) {
+  return &lifecycle_stats;
+}
+
+/*------------------------------------*/
+
+// Timer-functions:
+
+// Timer-function, that is executed, if the connection to the host access-point
+// couldn't be (re-)established in time
+static void ICACHE_FLASH_ATTR lifecycle_timeout_timerfunc(void *arg) {
+  lifecycle_event(LIFECYCLE_EVENT_TIMEOUT);
+}
+
+/*------------------------------------*/
+
+// Transitions:
+
+// Enter the given state; the timeout-timer is armed for timeout ms (0 = none)
+static void ICACHE_FLASH_ATTR lifecycle_enter(enum lifecycle_state state, uint32_t timeout) {
+  LOG_INFO("lifecycle_enter: %s -> %s\n", lifecycle_state_name(lifecycle_state), lifecycle_state_name(state));
+
+  lifecycle_state = state;
+  os_timer_disarm(&lifecycle_timeout_timer);
+  if (timeout) {
+    os_timer_setfn(&lifecycle_timeout_timer, (os_timer_func_t *) lifecycle_timeout_timerfunc, NULL);
+    os_timer_arm(&lifecycle_timeout_timer, timeout, false);
+  }
+}
+
+// Start ESP-TOUCH
+static void ICACHE_FLASH_ATTR lifecycle_provision(void) {
+  lifecycle_stats.provisionings++;
+  lifecycle_router_up = false;
+  lifecycle_enter(LIFECYCLE_PROVISIONING, 0);
+  if (!lifecycle_hooks->provision || !lifecycle_hooks->provision()) {
+    lifecycle_disable();
+  }
+}
+
+// The router came up after the actuation of the pushbutton; start its services
+static void ICACHE_FLASH_ATTR lifecycle_online(void) {
+  lifecycle_stats.up_fast = (lifecycle_state == LIFECYCLE_FAST_BOOT);
+  lifecycle_stats.up_time = (system_get_time() - lifecycle_enabled_us) / 1000;
+  LOG_INFO("lifecycle_online: Router up after %d ms (%s)!\n", lifecycle_stats.up_time, (lifecycle_stats.up_fast) ? "fast boot" : "ESP-TOUCH");
+
+  lifecycle_enter(LIFECYCLE_ONLINE, 0);
+  if (lifecycle_hooks->online) {
+    lifecycle_hooks->online();
+  }
+}
+
+// Return to IDLE and restore the initial state of the device (the state is set
+// first, so that events caused by the hook are ignored)
+static void ICACHE_FLASH_ATTR lifecycle_disable(void) {
+  lifecycle_enter(LIFECYCLE_IDLE, 0);
+  lifecycle_router_up = false;
+  if (lifecycle_hooks->disable) {
+    lifecycle_hooks->disable();
+  }
+}
+
+// Process an event; events, that don't apply to the current state, are ignored
+void ICACHE_FLASH_ATTR lifecycle_event(enum lifecycle_event event) {
+  if (!lifecycle_hooks) {
+    return;
+  }
+
+  switch (lifecycle_state) {
+    case LIFECYCLE_IDLE:
+      if (event != LIFECYCLE_EVENT_BUTTON) {
+        break;
+      }
+      lifecycle_enabled_us = system_get_time();
+      if (!lifecycle_hooks->enable || !lifecycle_hooks->enable()) {
+        lifecycle_disable();
+      }
+      else if (lifecycle_hooks->fast_boot && lifecycle_hooks->fast_boot()) {
+        lifecycle_stats.fast_boots++;
+        lifecycle_enter(LIFECYCLE_FAST_BOOT, FAST_BOOT_TIMEOUT);
+      }
+      else {
+        lifecycle_provision();
+      }
+      break;
+    case LIFECYCLE_FAST_BOOT:
+      // Failed attempts to connect are retried until the timeout
+      if (event == LIFECYCLE_EVENT_CONNECTED) {
+        lifecycle_online();
+      }
+      else if (event == LIFECYCLE_EVENT_TIMEOUT) {
+        LOG_WARN("lifecycle_event: Failed to connect with the cached credentials! Starting ESP-TOUCH!\n");
+        lifecycle_stats.fallbacks++;
+        lifecycle_provision();
+      }
+      break;
+    case LIFECYCLE_PROVISIONING:
+      if (event == LIFECYCLE_EVENT_CONNECTED || event == LIFECYCLE_EVENT_DISCONNECTED) {
+        lifecycle_router_up = (event == LIFECYCLE_EVENT_CONNECTED);
+      }
+      else if (event == LIFECYCLE_EVENT_ESPTOUCH_FAIL) {
+        lifecycle_disable();
+      }
+      else if (event == LIFECYCLE_EVENT_ESPTOUCH_SUCCESS && !lifecycle_router_up) {
+        lifecycle_enter(LIFECYCLE_CONNECTING, config_get()->conn_timeout);
+      }
+      else if (event == LIFECYCLE_EVENT_ESPTOUCH_SUCCESS) {
+        lifecycle_online();
+      }
+      break;
+    case LIFECYCLE_CONNECTING:
+      if (event == LIFECYCLE_EVENT_CONNECTED) {
+        lifecycle_online();
+      }
+      else if (event == LIFECYCLE_EVENT_TIMEOUT) {
+        lifecycle_disable();
+      }
+      break;
+    case LIFECYCLE_ONLINE:
+      // With the hitless reconnect (cf. router_set_hitless_reconnect), the
+      // clients are served until the reconnect timeout; otherwise, the router
+      // is given the connection timeout to reconnect (cf. config.c)
+      if (event == LIFECYCLE_EVENT_DISCONNECTED) {
+        lifecycle_enter(LIFECYCLE_RECONNECTING, (router_get_hitless_reconnect()) ? config_get()->reconnect_timeout : config_get()->conn_timeout);
+      }
+      break;
+    case LIFECYCLE_RECONNECTING:
+      if (event == LIFECYCLE_EVENT_CONNECTED) {
+        lifecycle_enter(LIFECYCLE_ONLINE, 0);
+      }
+      else if (event == LIFECYCLE_EVENT_TIMEOUT) {
+        lifecycle_disable();
+      }
+      break;
+  }
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration:
+
+// Reset the state machine to IDLE and set the hooks executing the actions of
+// the device
+void ICACHE_FLASH_ATTR lifecycle_init(const struct lifecycle_hooks *hooks) {
+  os_timer_disarm(&lifecycle_timeout_timer);
+  lifecycle_state = LIFECYCLE_IDLE;
+  lifecycle_router_up = false;
+  lifecycle_hooks = hooks;
+  os_memset(&lifecycle_stats, 0, sizeof(lifecycle_stats));
+}
@@ -0,0 +1,152 @@
+// log.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Sinks of the logging macros (cf. log.h). The levels and modules
+// are selected at compile time (LOG_LEVEL, LOG_MODULES); the sinks of the
+// remaining messages can be switched at runtime:
+//
+//  - LOG_SINK_UART prints the message with os_printf, which blocks for about
+//    87 us per character at 115200 baud, once the FIFO of the UART is full
+//  - LOG_SINK_RING (with LOG_RING) appends the message, prefixed with the
+//    system time in ms and the level, to a ring buffer of LOG_RING_SIZE bytes
+//    in the RAM, which can be requested via DEVICE_COM_PORT (cf. log_dump)
+//
+// The ring has a single writer (the SDK runs all callbacks in one context): the
+// message is copied first and the head is advanced afterwards, so that a reader
+// only has to compare the head before and after copying to drop the bytes
+// overwritten meanwhile; no lock is taken.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#define LOG_MODULE LOG_MODULE_LOG
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static void log_ring_put(const char *data, uint16_t len);
+
+// Output:
+void log_write(uint8_t level, uint16_t len);
+uint16_t log_dump(char *buffer, uint16_t size);
+
+// Status and configuration:
+const struct log_stats *log_stats_get(void);
+void log_set_sinks(uint8_t sinks);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+uint8_t log_sinks = ((LOG_UART) ? LOG_SINK_UART : 0) | ((LOG_RING) ? LOG_SINK_RING : 0);
+char log_line[LOG_LINE_MAX];  // Message being written (cf. LOG_WRITE)
+
+static struct log_stats log_stats;
+
+#if LOG_RING
+static char log_ring[LOG_RING_SIZE];
+static volatile uint32_t log_ring_head = 0; // Bytes written since the start
+#endif
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Append the given data to the ring buffer
+static void ICACHE_FLASH_ATTR log_ring_put(const char *data, uint16_t len) {
+#if LOG_RING
+  uint32_t head = log_ring_head;
+  uint16_t idx;
+
+  for (idx = 0; idx < len; idx++) {
+    log_ring[(head + idx) & (LOG_RING_SIZE - 1)] = data[idx];
+  }
+  log_ring_head = head + len; // Publish the data
+#endif
+}
+
+/*------------------------------------*/
+
+// Output:
+
+// Hand the message of the given length in log_line to the enabled sinks; the
+// length is the one returned by os_snprintf, i.e. that of the untruncated
+// message
+void ICACHE_FLASH_ATTR log_write(uint8_t level, uint16_t len) {
+  char prefix[16];
+
+  if (len >= LOG_LINE_MAX) {
+    len = LOG_LINE_MAX - 1; // A truncated message still ends with a newline
+    log_line[len - 1] = '\n';
+  }
+  log_stats.messages++;
+  if (log_sinks & LOG_SINK_UART) {
+    os_printf("%s", log_line);
+    log_stats.uart_bytes += len;
+  }
+  if (log_sinks & LOG_SINK_RING) {
+    log_ring_put(prefix, os_sprintf(prefix, "%u %c ", system_get_time() / 1000, "-EWID"[level]));
+    log_ring_put(log_line, len);
+  }
+}
+
+// Copy the newest messages of the ring buffer, that fit into the buffer (of
+// the given size), starting with a complete line; returns the number of bytes
+// copied
+uint16_t ICACHE_FLASH_ATTR log_dump(char *buffer, uint16_t size) {
+#if LOG_RING
+  uint32_t head = log_ring_head, start, end, len, skip = 0;
+  uint32_t idx;
+
+  if (!buffer || size == 0) {
+    return 0;
+  }
+  len = (head < LOG_RING_SIZE) ? head : LOG_RING_SIZE;
+  if (len > size) {
+    len = size;
+  }
+  start = head - len;
+  for (idx = 0; idx < len; idx++) {
+    buffer[idx] = log_ring[(start + idx) & (LOG_RING_SIZE - 1)];
+  }
+
+  // Drop the bytes, that have been overwritten while copying
+  end = log_ring_head;
+  if (end - start > LOG_RING_SIZE) {
+    skip = end - start - LOG_RING_SIZE;
+  }
+  // Start with a complete line, if the oldest one has been cut
+  if (start > 0 || skip) {
+    while (skip < len && buffer[skip++] != '\n');
+  }
+  if (skip >= len) {
+    return 0;
+  }
+  os_memmove(buffer, buffer + skip, len - skip);
+  return len - skip;
+#else
+  return 0;
+#endif
+}
+
+/*------------------------------------*/
+
+// Status and configuration:
+
+const struct log_stats * ICACHE_FLASH_ATTR log_stats_get(void) {
+  return &log_stats;
+}
+
+// Select the sinks of the messages (cf. LOG_SINK_*); the ring buffer is only
+// available with LOG_RING
+void ICACHE_FLASH_ATTR log_set_sinks(uint8_t sinks) {
+  log_sinks = sinks & (((LOG_RING) ? LOG_SINK_RING : 0) | LOG_SINK_UART);
+}
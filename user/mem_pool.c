@@ -0,0 +1,121 @@
+// mem_pool.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: This class implements pools of fixed-size blocks, which are
+// used instead of os_zalloc/os_free for objects, that are allocated and
+// released repeatedly while the router is running (timers, espconn control
+// blocks, NAPT- and portmap entries). The size of each pool is fixed at
+// compile-time (cf. user_config.h), so allocating and releasing blocks doesn't
+// fragment the heap; allocation and release are O(1).
+//
+// Every pool is registered on its initialization, so that its utilization
+// (used blocks, high-water mark, failed allocations) can be reported as
+// telemetry (cf. device_info.c).
+
+#include "c_types.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "espconn.h"
+#include "mem_pool.h"
+#define LOG_MODULE LOG_MODULE_MEM
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+void mem_pool_init(struct mem_pool *pool);
+void *mem_pool_alloc(struct mem_pool *pool);
+void mem_pool_free(struct mem_pool *pool, void *block);
+uint16_t mem_pool_index(struct mem_pool *pool, const void *block);
+const struct mem_pool *mem_pool_first(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+MEM_POOL_DEFINE(mem_pool_timers, sizeof(os_timer_t), MEM_POOL_TIMERS);
+MEM_POOL_DEFINE(mem_pool_espconn, sizeof(struct espconn), MEM_POOL_ESPCONN);
+MEM_POOL_DEFINE(mem_pool_esp_udp, sizeof(esp_udp), MEM_POOL_ESPCONN);
+
+static struct mem_pool *mem_pool_list = NULL;
+
+/*------------------------------------*/
+
+// (Re-)initialize the given pool (all blocks are released) and register it; the
+// fields name, storage, block_size and blocks have to be set already
+void ICACHE_FLASH_ATTR mem_pool_init(struct mem_pool *pool) {
+  struct mem_pool *entry;
+  uint16_t idx;
+
+  for (idx = 0; idx < pool->blocks; idx++) {
+    *(uint16_t *) (pool->storage + idx * pool->block_size) = (idx + 1 < pool->blocks) ? idx + 1 : MEM_POOL_BLOCK_NONE;
+  }
+  pool->free_head = (pool->blocks) ? 0 : MEM_POOL_BLOCK_NONE;
+  pool->used = pool->high_water = 0;
+  pool->failures = 0;
+  pool->initialized = true;
+
+  for (entry = mem_pool_list; entry && entry != pool; entry = entry->next);
+  if (!entry) {
+    pool->next = mem_pool_list;
+    mem_pool_list = pool;
+  }
+}
+
+// Allocate a zeroed block; returns NULL, if the pool is exhausted
+void * ICACHE_FLASH_ATTR mem_pool_alloc(struct mem_pool *pool) {
+  uint8_t *block;
+
+  // Pools defined by MEM_POOL_DEFINE are initialized on their first use
+  if (!pool->initialized) {
+    mem_pool_init(pool);
+  }
+  if (pool->free_head == MEM_POOL_BLOCK_NONE) {
+    pool->failures++;
+    return NULL;
+  }
+
+  block = pool->storage + pool->free_head * pool->block_size;
+  pool->free_head = *(uint16_t *) block;
+  os_memset(block, 0, pool->block_size);
+
+  pool->used++;
+  if (pool->used > pool->high_water) {
+    pool->high_water = pool->used;
+  }
+  return block;
+}
+
+// Return the given block to the pool
+void ICACHE_FLASH_ATTR mem_pool_free(struct mem_pool *pool, void *block) {
+  uint16_t idx = mem_pool_index(pool, block);
+
+  if (idx == MEM_POOL_BLOCK_NONE) {
+    LOG_ERROR("mem_pool_free: Block doesn't belong to %s!\n", pool->name);
+    return;
+  }
+  *(uint16_t *) block = pool->free_head;
+  pool->free_head = idx;
+  pool->used--;
+}
+
+// Return the index of the given block within the pool resp. MEM_POOL_BLOCK_NONE
+uint16_t ICACHE_FLASH_ATTR mem_pool_index(struct mem_pool *pool, const void *block) {
+  const uint8_t *ptr = (const uint8_t *) block;
+
+  if (!ptr || ptr < pool->storage || ptr >= pool->storage + pool->blocks * pool->block_size || (ptr - pool->storage) % pool->block_size) {
+    return MEM_POOL_BLOCK_NONE;
+  }
+  return (ptr - pool->storage) / pool->block_size;
+}
+
+// Return the first registered pool (the others are chained by next)
+const struct mem_pool * ICACHE_FLASH_ATTR mem_pool_first(void) {
+  return mem_pool_list;
+}
@@ -0,0 +1,729 @@
+// mesh.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-16
+//
+// Description: Routing between chained routers. If a router's station is
+// connected to the soft access-point of another router (mesh-node, cf. mesh in
+// config.c), it advertises the network of its own soft access-point and the
+// networks of the routers below it to the upstream router every
+// MESH_ADVERT_INTERVAL ms resp. as soon as it learns a new route. The
+// advertisement "MESH_ROUTES,<network>/<prefix>,...\n" is sent to MESH_PORT of
+// the gateway of the station; sibling networks (e.g. two adjacent /24) are
+// aggregated into one route, since they share the advertising router as next
+// hop.
+//
+// The advertisements and acknowledgements are authenticated by an HMAC-SHA-256
+// under the mesh-key shared by all routers of the chain (cf. mesh_key in
+// config.c): "<message>#<seq>#<MAC>\n", where the MAC (the first
+// MESH_MAC_LEN bytes in hex) covers the address of the sender and everything
+// before the last '#'. An advertisement has to carry a higher sequence number
+// than the last one of its sender, and an acknowledgement the one of the last
+// advertisement, so that recorded messages can't be replayed (a rebooted
+// mesh-node starts with a random sequence number, so its routes may have to
+// expire first). Other clients of the soft access-point don't know the key,
+// so they can't redirect the traffic of the network; in addition, only the
+// routers, that got their address from the DHCP-server as mesh-node (cf.
+// MESH_HOSTNAME and dhcp_server_is_mesh_node), are heard at all. Routers
+// without mesh-routing don't accept any routes. Hence, the topmost router of a
+// chain has to be a mesh-node as well: its advertisements to the host
+// access-point aren't acknowledged, so it keeps translating the packets. The
+// routes are installed with the sender as next hop, unless they overlap the
+// networks of the router's interfaces resp. the routes via other next hops,
+// and expire after MESH_ROUTE_TIMEOUT intervals without an advertisement resp.
+// as soon as the sender's lease has ended. The receipt is
+// acknowledged with "MESH_ROUTES_ACK,<installed routes>". Once the upstream
+// router has installed all advertised routes, the mesh-node forwards the
+// packets of its own and the downstream networks without translation (cf.
+// mesh_is_routed), so that only the topmost router of the chain translates
+// them; until then resp. after MESH_ROUTE_TIMEOUT intervals without an
+// acknowledgement, the packets are translated as usual. The existing
+// connections of the clients don't survive such a change of the mode.
+//
+// The routes are used by the fast path of napt_netif.c, which resolves the next
+// hop of the packets to the downstream networks by mesh_route_lookup; the
+// packets from the soft access-point's side to them are sent straight down
+// without translation (cf. mesh_lateral_lookup). lwip itself only routes by
+// the networks of its interfaces, so the packets, that the fast path can't
+// handle (e.g. because it's disabled), don't reach the downstream networks.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "espconn.h"
+#include "lwip/ip_addr.h"
+#include "mem_pool.h"
+#include "napt.h"
+#include "flow_cache.h"
+#include "dhcp_server.h"
+#include "config.h"
+#include "hmac_sha256.h"
+#include "mesh.h"
+#define LOG_MODULE LOG_MODULE_MESH
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define MESH_ADVERT_STRING "MESH_ROUTES"
+#define MESH_ACK_STRING "MESH_ROUTES_ACK,"
+#define MESH_PREFIX_MIN 8   // Shortest resp. longest accepted prefix
+#define MESH_PREFIX_MAX 30
+#define MESH_MAC_LEN 16     // Transmitted bytes of the HMAC
+#define MESH_MSG_MAX (sizeof(MESH_ADVERT_STRING) + (MESH_ROUTES_MAX + 1) * 19 + 12 + 2 * MESH_MAC_LEN + 2)
+
+/*------------------------------------*/
+
+// Network of an advertisement (host byte order)
+struct mesh_prefix {
+  uint32_t network;
+  uint8_t len;
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint32_t mesh_ntohl(uint32_t ip);
+static uint32_t mesh_mask(uint8_t len);
+static uint8_t mesh_mask_len(uint32_t netmask);
+static uint8_t mesh_aggregate(struct mesh_prefix *prefixes, uint8_t count);
+static bool mesh_parse_prefix(const char *str, uint16_t len, struct mesh_prefix *prefix);
+static bool mesh_route_add(uint32_t network, uint32_t netmask, uint32_t nexthop, uint32_t seq, bool *added);
+static void mesh_mac(uint32_t sender, const char *msg, uint16_t len, char *hex);
+static bool mesh_verify(uint32_t sender, char *msg, uint16_t len, uint32_t *seq);
+static void mesh_send(uint32_t ip, uint32_t sender, char *msg, uint16_t len, uint32_t seq);
+static void mesh_advert_recv(uint32_t remote, const char *msg, uint32_t seq);
+static void mesh_ack_recv(uint32_t remote, const char *msg, uint32_t seq);
+
+// Callback-functions:
+static void mesh_recv_cb(void *arg, char *data, unsigned short len);
+static void mesh_timer_cb(void *arg);
+
+// Routing:
+uint32_t mesh_route_lookup(uint32_t addr);
+uint32_t mesh_lateral_lookup(const uint8_t *iphdr, uint16_t len);
+bool mesh_is_routed(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, uint32_t ext_addr, uint32_t downstream);
+
+// Status-functions:
+bool mesh_is_routing(void);
+uint8_t mesh_route_count(void);
+const struct mesh_route *mesh_route_get(uint8_t idx);
+const struct mesh_stats *mesh_stats_get(void);
+
+// Initialization and configuration:
+void mesh_advertise(void);
+void mesh_upstream_lost(void);
+bool mesh_enable(uint32_t addr, uint32_t netmask, const char *key);
+void mesh_disable(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct mesh_route mesh_routes[MESH_ROUTES_MAX];
+static uint8_t mesh_routes_count = 0;
+static struct mesh_stats mesh_stats;
+
+static struct espconn *mesh_socket = NULL;
+static os_timer_t mesh_timer;
+
+static uint32_t mesh_addr = 0;                            // Soft access-point's
+static uint32_t mesh_network = 0, mesh_netmask = 0;       // address and network
+static bool mesh_node = false;      // Mesh-routing enabled (cf. mesh_enable)
+static bool mesh_routing = false;   // Upstream router installed all routes
+static uint8_t mesh_upstream_ttl = 0;
+static uint8_t mesh_advertised = 0; // Number of routes of the last advertisement
+static uint32_t mesh_seq = 0;       // Sequence number of the last advertisement
+static char mesh_key[CONFIG_MESH_KEY_LEN];
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Convert an address from network to host byte order resp. vice versa
+static uint32_t ICACHE_FLASH_ATTR mesh_ntohl(uint32_t ip) {
+  const uint8_t *bytes = (const uint8_t *) &ip;
+
+  return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Netmask of the given prefix length (host byte order)
+static uint32_t ICACHE_FLASH_ATTR mesh_mask(uint8_t len) {
+  return (len) ? 0xFFFFFFFFUL << (32 - len) : 0;
+}
+
+// Prefix length of a contiguous netmask (network byte order)
+static uint8_t ICACHE_FLASH_ATTR mesh_mask_len(uint32_t netmask) {
+  uint32_t mask = mesh_ntohl(netmask);
+
+  return (mask) ? 32 - __builtin_ctz(mask) : 0;
+}
+
+// Aggregate the prefixes, that are all reached via the same next hop: networks
+// contained in another one are dropped and siblings are merged into their
+// supernet, until nothing changes anymore; returns the remaining number
+static uint8_t ICACHE_FLASH_ATTR mesh_aggregate(struct mesh_prefix *prefixes, uint8_t count) {
+  struct mesh_prefix *a, *b;
+  uint32_t mask, bit;
+  bool merged = true;
+
+  while (merged) {
+    merged = false;
+    for (a = prefixes; a < prefixes + count && !merged; a++) {
+      for (b = a + 1; b < prefixes + count && !merged; b++) {
+        mask = mesh_mask((a->len < b->len) ? a->len : b->len);
+        bit = 1UL << (32 - a->len);
+        if (!((a->network ^ b->network) & mask)) {
+          if (b->len < a->len) {
+            *a = *b;
+          }
+        }
+        else if (a->len == b->len && a->len > MESH_PREFIX_MIN && (a->network ^ b->network) == bit) {
+          a->network &= ~bit;
+          a->len--;
+        }
+        else {
+          continue;
+        }
+        *b = prefixes[--count];
+        merged = true;
+      }
+    }
+  }
+  return count;
+}
+
+// Parse "<network>/<prefix>" (of the given length); the prefix has to be
+// within MESH_PREFIX_MIN and MESH_PREFIX_MAX and the network mustn't have host
+// bits set
+static bool ICACHE_FLASH_ATTR mesh_parse_prefix(const char *str, uint16_t len, struct mesh_prefix *prefix) {
+  char addr[16];
+  uint16_t idx;
+  uint32_t network;
+  uint8_t prefix_len = 0;
+
+  for (idx = 0; idx < len && str[idx] != '/'; idx++);
+  if (!idx || idx >= sizeof(addr) || idx + 1 >= len || len - idx > 3) {
+    return false;
+  }
+  os_memcpy(addr, str, idx);
+  addr[idx] = '\0';
+  for (idx++; idx < len; idx++) {
+    if (str[idx] < '0' || str[idx] > '9') {
+      return false;
+    }
+    prefix_len = prefix_len * 10 + (str[idx] - '0');
+  }
+  network = mesh_ntohl(ipaddr_addr(addr));
+  if (prefix_len < MESH_PREFIX_MIN || prefix_len > MESH_PREFIX_MAX || (network & ~mesh_mask(prefix_len))) {
+    return false;
+  }
+  prefix->network = network;
+  prefix->len = prefix_len;
+  return true;
+}
+
+// Install resp. refresh the route to network/netmask via nexthop (all in
+// network byte order) advertised with the sequence number seq; routes
+// overlapping the networks of the soft access-point and the station resp. the
+// routes via other next hops are rejected (a network, that has moved to
+// another downstream router, is accepted once the old route has expired resp.
+// its next hop has lost its lease). added is set, if the route is new.
+static bool ICACHE_FLASH_ATTR mesh_route_add(uint32_t network, uint32_t netmask, uint32_t nexthop, uint32_t seq, bool *added) {
+  struct mesh_route *route, *free = NULL;
+  struct ip_info station_info;
+
+  if (!((network ^ mesh_network) & netmask & mesh_netmask)) {
+    return false;
+  }
+  if (wifi_get_ip_info(STATION_IF, &station_info) && station_info.ip.addr &&
+      !((network ^ station_info.ip.addr) & netmask & station_info.netmask.addr)) {
+    return false;
+  }
+  for (route = mesh_routes; route < mesh_routes + MESH_ROUTES_MAX; route++) {
+    if (route->nexthop && route->nexthop != nexthop && !((network ^ route->network) & netmask & route->netmask)) {
+      LOG_WARN("mesh_route_add: " IPSTR "/%u overlaps the route via " IPSTR "!\n", IP2STR(&network), mesh_mask_len(netmask), IP2STR(&route->nexthop));
+      return false;
+    }
+  }
+  for (route = mesh_routes; route < mesh_routes + MESH_ROUTES_MAX; route++) {
+    if (route->nexthop && route->network == network && route->netmask == netmask) {
+      route->seq = seq;
+      route->ttl = MESH_ROUTE_TIMEOUT;
+      return true;
+    }
+    if (!route->nexthop && !free) {
+      free = route;
+    }
+  }
+  if (!free) {
+    LOG_WARN("mesh_route_add: The routing table is full!\n");
+    return false;
+  }
+
+  free->network = network;
+  free->netmask = netmask;
+  free->nexthop = nexthop;
+  free->seq = seq;
+  free->ttl = MESH_ROUTE_TIMEOUT;
+  mesh_routes_count++;
+  mesh_stats.routes_added++;
+  *added = true;
+
+  // The cached next hops of the flows to the network aren't valid anymore
+  flow_cache_flush();
+  LOG_INFO("mesh_route_add: " IPSTR "/%u via " IPSTR "\n", IP2STR(&network), mesh_mask_len(netmask), IP2STR(&nexthop));
+  return true;
+}
+
+// Write the MAC of the message (of the given length) sent by sender as
+// 2 * MESH_MAC_LEN hex-digits (and the termination) to hex
+static void ICACHE_FLASH_ATTR mesh_mac(uint32_t sender, const char *msg, uint16_t len, char *hex) {
+  uint8_t data[4 + MESH_MSG_MAX], mac[SHA256_DIGEST_LEN];
+  uint8_t idx;
+
+  os_memcpy(data, &sender, 4);
+  os_memcpy(data + 4, msg, len);
+  hmac_sha256((const uint8_t *) mesh_key, os_strlen(mesh_key), data, 4 + len, mac);
+  for (idx = 0; idx < MESH_MAC_LEN; idx++) {
+    os_sprintf(hex + 2 * idx, "%02x", mac[idx]);
+  }
+}
+
+// Check the MAC of the message of sender (of the given length, terminated),
+// return its sequence number and cut off "#<seq>#<MAC>"; returns false, if
+// there's no valid MAC
+static bool ICACHE_FLASH_ATTR mesh_verify(uint32_t sender, char *msg, uint16_t len, uint32_t *seq) {
+  char expected[2 * MESH_MAC_LEN + 1], *mac, *ptr;
+  uint8_t diff = 0, idx;
+
+  while (len && (msg[len - 1] == '\n' || msg[len - 1] == '\r')) {
+    msg[--len] = '\0';
+  }
+  if (!mesh_key[0] || len < 2 * MESH_MAC_LEN + 3 || msg[len - 2 * MESH_MAC_LEN - 1] != '#') {
+    return false;
+  }
+  mac = msg + len - 2 * MESH_MAC_LEN;
+  mesh_mac(sender, msg, mac - 1 - msg, expected);
+
+  // The comparison takes the same time for every mismatch
+  for (idx = 0; idx < 2 * MESH_MAC_LEN; idx++) {
+    diff |= expected[idx] ^ mac[idx];
+  }
+  if (diff) {
+    return false;
+  }
+
+  // Sequence number between the two '#'
+  mac[-1] = '\0';
+  for (ptr = mac - 2; ptr > msg && *ptr >= '0' && *ptr <= '9'; ptr--);
+  if (*ptr != '#' || ptr + 1 == mac - 1) {
+    return false;
+  }
+  *ptr = '\0';
+  for (*seq = 0, ptr++; *ptr; ptr++) {
+    *seq = *seq * 10 + (*ptr - '0');
+  }
+  return true;
+}
+
+// Send the message (of the given length, without the newline) with the
+// sequence number and the MAC of sender attached
+static void ICACHE_FLASH_ATTR mesh_send(uint32_t ip, uint32_t sender, char *msg, uint16_t len, uint32_t seq) {
+  len += os_sprintf(msg + len, "#%u#", seq);
+  mesh_mac(sender, msg, len - 1, msg + len);
+  len += 2 * MESH_MAC_LEN;
+  msg[len++] = '\n';
+
+  os_memcpy(mesh_socket->proto.udp->remote_ip, &ip, 4);
+  mesh_socket->proto.udp->remote_port = MESH_PORT;
+  if (espconn_sendto(mesh_socket, (uint8_t *) msg, len) != ESPCONN_OK) {
+    LOG_ERROR("mesh_send: Error while sending to " IPSTR "!\n", IP2STR(&ip));
+  }
+}
+
+// Install the routes of an advertisement (with the sequence number seq and a
+// valid MAC) of the downstream router remote and acknowledge them; new routes
+// are advertised upstream at once
+static void ICACHE_FLASH_ATTR mesh_advert_recv(uint32_t remote, const char *msg, uint32_t seq) {
+  struct mesh_prefix prefix;
+  struct mesh_route *route;
+  const char *ptr = msg + sizeof(MESH_ADVERT_STRING) - 1, *end;
+  char reply[sizeof(MESH_ACK_STRING) + 4 + 12 + 2 * MESH_MAC_LEN + 2];
+  uint8_t installed = 0;
+  bool added = false;
+
+  // Only the mesh-nodes bound to the DHCP-server may advertise routes, and
+  // only with a newer advertisement than the last one
+  for (route = mesh_routes; route < mesh_routes + MESH_ROUTES_MAX; route++) {
+    if (route->nexthop == remote && (int32_t) (seq - route->seq) <= 0) {
+      break;
+    }
+  }
+  if (!mesh_node || (remote & mesh_netmask) != mesh_network || remote == mesh_addr || !dhcp_server_is_mesh_node(remote) ||
+      route < mesh_routes + MESH_ROUTES_MAX) {
+    LOG_WARN("mesh_advert_recv: Ignoring the advertisement of " IPSTR "!\n", IP2STR(&remote));
+    mesh_stats.adverts_ignored++;
+    return;
+  }
+  mesh_stats.adverts_recv++;
+
+  while (*ptr == ',') {
+    ptr++;
+    for (end = ptr; *end && *end != ',' && *end != '\n'; end++);
+    if (mesh_parse_prefix(ptr, end - ptr, &prefix) && mesh_route_add(mesh_ntohl(prefix.network), mesh_ntohl(mesh_mask(prefix.len)), remote, seq, &added)) {
+      installed++;
+    }
+    else {
+      mesh_stats.routes_rejected++;
+    }
+    ptr = end;
+  }
+
+  mesh_send(remote, mesh_addr, reply, os_sprintf(reply, MESH_ACK_STRING "%u", installed), seq);
+  if (added) {
+    mesh_advertise();
+  }
+}
+
+// Acknowledgement of the upstream router (with a valid MAC) of the
+// advertisement with the sequence number seq; the packets are routed without
+// translation, if it has installed all routes of the last advertisement
+static void ICACHE_FLASH_ATTR mesh_ack_recv(uint32_t remote, const char *msg, uint32_t seq) {
+  struct ip_info station_info;
+  const char *ptr = msg + sizeof(MESH_ACK_STRING) - 1;
+  uint32_t installed = 0;
+  bool routing;
+
+  if (!mesh_node || !wifi_get_ip_info(STATION_IF, &station_info) || remote != station_info.gw.addr) {
+    return;
+  }
+  if (seq != mesh_seq) {
+    mesh_stats.acks_ignored++;
+    return;
+  }
+  mesh_stats.acks_recv++;
+  for (; *ptr >= '0' && *ptr <= '9'; ptr++) {
+    installed = installed * 10 + (*ptr - '0');
+  }
+
+  mesh_upstream_ttl = MESH_ROUTE_TIMEOUT;
+  routing = (installed == mesh_advertised);
+  if (routing != mesh_routing) {
+    mesh_routing = routing;
+    flow_cache_flush();
+    if (routing) {
+      LOG_INFO("mesh_ack_recv: Routing via " IPSTR " without translation!\n", IP2STR(&remote));
+    }
+    else {
+      LOG_WARN("mesh_ack_recv: " IPSTR " installed %u of %u routes; falling back to NAPT!\n", IP2STR(&remote), installed, mesh_advertised);
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Callback-functions:
+
+// Callback-function, that is executed on the receipt of a datagram on
+// MESH_PORT
+static void ICACHE_FLASH_ATTR mesh_recv_cb(void *arg, char *data, unsigned short len) {
+  char msg[MESH_MSG_MAX + 1];
+  remot_info *con_info = NULL;
+  uint32_t remote, seq;
+  bool valid;
+
+  if (!data || len > MESH_MSG_MAX || espconn_get_connection_info(mesh_socket, &con_info, 0) != ESPCONN_OK) {
+    return;
+  }
+  os_memcpy(msg, data, len);
+  msg[len] = '\0';
+  os_memcpy(&remote, con_info->remote_ip, 4);
+  valid = mesh_verify(remote, msg, len, &seq);
+
+  if (!os_strncmp(msg, MESH_ACK_STRING, sizeof(MESH_ACK_STRING) - 1)) {
+    if (!valid) {
+      LOG_WARN("mesh_recv_cb: Invalid MAC of the acknowledgement of " IPSTR "!\n", IP2STR(&remote));
+      mesh_stats.acks_ignored++;
+      return;
+    }
+    mesh_ack_recv(remote, msg, seq);
+  }
+  else if (!os_strncmp(msg, MESH_ADVERT_STRING, sizeof(MESH_ADVERT_STRING) - 1)) {
+    if (!valid) {
+      LOG_WARN("mesh_recv_cb: Invalid MAC of the advertisement of " IPSTR "!\n", IP2STR(&remote));
+      mesh_stats.adverts_ignored++;
+      return;
+    }
+    mesh_advert_recv(remote, msg, seq);
+  }
+}
+
+// Expire the routes and the acknowledgement of the upstream router and
+// advertise the routes again
+static void ICACHE_FLASH_ATTR mesh_timer_cb(void *arg) {
+  struct mesh_route *route;
+  bool expired = false;
+
+  // The routes expire without advertisements resp. with the lease of their next
+  // hop, whose address may be handed to another client afterwards
+  for (route = mesh_routes; route < mesh_routes + MESH_ROUTES_MAX; route++) {
+    if (route->nexthop && (!--route->ttl || !dhcp_server_is_mesh_node(route->nexthop))) {
+      LOG_INFO("mesh_timer_cb: Route to " IPSTR "/%u expired!\n", IP2STR(&route->network), mesh_mask_len(route->netmask));
+      route->nexthop = 0;
+      mesh_routes_count--;
+      mesh_stats.routes_expired++;
+      expired = true;
+    }
+  }
+  if (expired) {
+    flow_cache_flush();
+  }
+  if (mesh_upstream_ttl && !--mesh_upstream_ttl) {
+    mesh_upstream_lost();
+  }
+  mesh_advertise();
+}
+
+/*------------------------------------*/
+
+// Routing:
+
+// Return the next hop of the most specific route to the address (network byte
+// order) resp. 0, if it isn't part of a downstream network
+uint32_t ICACHE_FLASH_ATTR mesh_route_lookup(uint32_t addr) {
+  const struct mesh_route *route, *best = NULL;
+  uint8_t left = mesh_routes_count;
+
+  // The netmasks of matching routes are contained in each other, so the more
+  // specific one is the superset; the scan ends after the last used slot
+  for (route = mesh_routes; left; route++) {
+    if (!route->nexthop) {
+      continue;
+    }
+    left--;
+    if ((addr & route->netmask) == route->network && (!best || (route->netmask | best->netmask) != best->netmask)) {
+      best = route;
+    }
+  }
+  return (best) ? best->nexthop : 0;
+}
+
+// Return the downstream router, that a packet received on the soft access-
+// point network interface is forwarded to without translation, since its
+// destination lies in the network of a downstream router (0 otherwise); the
+// packets of the clients and the downstream networks to other downstream
+// networks don't take the detour via the upstream router resp. its
+// translation. This applies to every mesh-node with routes, including the
+// root of the chain.
+uint32_t ICACHE_FLASH_ATTR mesh_lateral_lookup(const uint8_t *iphdr, uint16_t len) {
+  uint32_t dest, nexthop;
+
+  if (!mesh_routes_count || len < 20 || (iphdr[0] >> 4) != 4 || iphdr[16] >= 224) {
+    return 0;
+  }
+  os_memcpy(&dest, iphdr + 16, 4);
+  nexthop = mesh_route_lookup(dest);
+  if (nexthop) {
+    mesh_stats.lateral++;
+  }
+  return nexthop;
+}
+
+// Check, if a packet, that has been received on the network interface if_idx,
+// is forwarded without translation: on a mesh-node, whose routes have been
+// installed by the upstream router, these are the packets from the own and the
+// downstream networks to other networks resp. the packets to them (except the
+// ones addressed to the router itself, ext_addr being the station's address).
+// The packets to the downstream networks have been looked up by
+// mesh_lateral_lookup already.
+// downstream is the next hop of the route to the source resp. destination of
+// the packet received on the soft access-point resp. the station network
+// interface (cf. mesh_route_lookup), which the caller looks up only once for
+// the accounting and the forwarding of the packet as well.
+bool ICACHE_FLASH_ATTR mesh_is_routed(uint8_t if_idx, const uint8_t *iphdr, uint16_t len, uint32_t ext_addr, uint32_t downstream) {
+  uint32_t src, dest;
+
+  if (!mesh_routing || len < 20 || (iphdr[0] >> 4) != 4) {
+    return false;
+  }
+  os_memcpy(&src, iphdr + 12, 4);
+  os_memcpy(&dest, iphdr + 16, 4);
+
+  if (if_idx == SOFTAP_IF) {
+    if (((src & mesh_netmask) != mesh_network && !downstream) || (dest & mesh_netmask) == mesh_network ||
+        dest == ext_addr || iphdr[16] >= 224) {
+      return false;
+    }
+    mesh_stats.routed[NAPT_DIR_OUT]++;
+    return true;
+  }
+  if ((dest & mesh_netmask) == mesh_network) {
+    if (dest == mesh_addr || (dest | mesh_netmask) == IPADDR_NONE) {
+      return false;
+    }
+  }
+  else if (!downstream) {
+    return false;
+  }
+  mesh_stats.routed[NAPT_DIR_IN]++;
+  return true;
+}
+
+/*------------------------------------*/
+
+// Status-functions:
+
+// Return, if the packets are routed without translation (cf. mesh_is_routed)
+bool ICACHE_FLASH_ATTR mesh_is_routing(void) {
+  return mesh_routing;
+}
+
+uint8_t ICACHE_FLASH_ATTR mesh_route_count(void) {
+  return mesh_routes_count;
+}
+
+// Return the route in the given slot of the table (< MESH_ROUTES_MAX; unused
+// slots have no next hop) resp. NULL
+const struct mesh_route * ICACHE_FLASH_ATTR mesh_route_get(uint8_t idx) {
+  return (idx < MESH_ROUTES_MAX) ? &mesh_routes[idx] : NULL;
+}
+
+const struct mesh_stats * ICACHE_FLASH_ATTR mesh_stats_get(void) {
+  return &mesh_stats;
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration:
+
+// Advertise the own and the downstream networks to the gateway of the station
+// network interface
+void ICACHE_FLASH_ATTR mesh_advertise(void) {
+  struct mesh_prefix prefixes[MESH_ROUTES_MAX + 1];
+  const struct mesh_route *route;
+  struct ip_info station_info;
+  char msg[MESH_MSG_MAX + 1];
+  uint32_t network;
+  uint16_t len;
+  uint8_t count = 0, idx;
+
+  if (!mesh_socket || !mesh_node || !wifi_get_ip_info(STATION_IF, &station_info) || !station_info.ip.addr || !station_info.gw.addr) {
+    return;
+  }
+
+  prefixes[count].network = mesh_ntohl(mesh_network);
+  prefixes[count++].len = mesh_mask_len(mesh_netmask);
+  for (route = mesh_routes; route < mesh_routes + MESH_ROUTES_MAX; route++) {
+    if (route->nexthop) {
+      prefixes[count].network = mesh_ntohl(route->network);
+      prefixes[count++].len = mesh_mask_len(route->netmask);
+    }
+  }
+  count = mesh_aggregate(prefixes, count);
+
+  len = os_sprintf(msg, MESH_ADVERT_STRING);
+  for (idx = 0; idx < count; idx++) {
+    network = mesh_ntohl(prefixes[idx].network);
+    len += os_sprintf(msg + len, "," IPSTR "/%u", IP2STR(&network), prefixes[idx].len);
+  }
+
+  mesh_advertised = count;
+  mesh_stats.adverts_sent++;
+  mesh_send(station_info.gw.addr, station_info.ip.addr, msg, len, ++mesh_seq);
+}
+
+// Fall back to translating the packets (e.g. on the disconnection of the
+// station network interface), until the upstream router acknowledges the
+// routes again
+void ICACHE_FLASH_ATTR mesh_upstream_lost(void) {
+  mesh_upstream_ttl = 0;
+  if (mesh_routing) {
+    LOG_WARN("mesh_upstream_lost: Falling back to NAPT!\n");
+    mesh_routing = false;
+    flow_cache_flush();
+  }
+}
+
+// Accept the advertisements of the downstream mesh-nodes on the soft access-
+// point's network addr/netmask and advertise the routes to the upstream router,
+// both authenticated by the given mesh-key (call after the soft access-point's
+// network configuration has been set); the routes are kept, if the mesh-
+// routing is already enabled
+bool ICACHE_FLASH_ATTR mesh_enable(uint32_t addr, uint32_t netmask, const char *key) {
+  if (!key || !key[0] || os_strlen(key) >= CONFIG_MESH_KEY_LEN) {
+    LOG_ERROR("mesh_enable: Invalid transfer parameter!\n");
+    return false;
+  }
+
+  LOG_INFO("mesh_enable: Enabling the mesh-routing!\n");
+
+  os_memset(mesh_key, 0, sizeof(mesh_key));
+  os_strcpy(mesh_key, key);
+  if (!mesh_seq) {
+    mesh_seq = os_random();
+  }
+  mesh_addr = addr;
+  mesh_network = addr & netmask;
+  mesh_netmask = netmask;
+  mesh_node = true;
+  mesh_upstream_lost();
+
+  if (!mesh_socket) {
+    mesh_socket = (struct espconn *) mem_pool_alloc(&mem_pool_espconn);
+    if (!mesh_socket) {
+      LOG_ERROR("mesh_enable: Failed to allocate the UDP-socket!\n");
+      return false;
+    }
+    mesh_socket->proto.udp = (esp_udp *) mem_pool_alloc(&mem_pool_esp_udp);
+    if (!mesh_socket->proto.udp) {
+      mem_pool_free(&mem_pool_espconn, mesh_socket);
+      mesh_socket = NULL;
+      LOG_ERROR("mesh_enable: Failed to allocate the UDP-socket!\n");
+      return false;
+    }
+    mesh_socket->type = ESPCONN_UDP;
+    mesh_socket->state = ESPCONN_NONE;
+    mesh_socket->proto.udp->local_port = MESH_PORT;
+    if (espconn_create(mesh_socket) != ESPCONN_OK) {
+      mem_pool_free(&mem_pool_esp_udp, mesh_socket->proto.udp);
+      mem_pool_free(&mem_pool_espconn, mesh_socket);
+      mesh_socket = NULL;
+      LOG_ERROR("mesh_enable: Failed to create the UDP-socket!\n");
+      return false;
+    }
+    espconn_regist_recvcb(mesh_socket, mesh_recv_cb);
+  }
+
+  os_timer_disarm(&mesh_timer);
+  os_timer_setfn(&mesh_timer, (os_timer_func_t *) mesh_timer_cb, NULL);
+  os_timer_arm(&mesh_timer, MESH_ADVERT_INTERVAL, true);
+  return true;
+}
+
+// Stop the advertisements and discard the routes (e.g. if the router is
+// disabled)
+void ICACHE_FLASH_ATTR mesh_disable(void) {
+  if (mesh_node) {
+    LOG_INFO("mesh_disable: Disabling the mesh-routing!\n");
+  }
+
+  os_timer_disarm(&mesh_timer);
+  if (mesh_socket) {
+    espconn_delete(mesh_socket);
+    mem_pool_free(&mem_pool_esp_udp, mesh_socket->proto.udp);
+    mem_pool_free(&mem_pool_espconn, mesh_socket);
+    mesh_socket = NULL;
+  }
+  mesh_upstream_lost();
+  os_memset(mesh_routes, 0, sizeof(mesh_routes));
+  mesh_routes_count = 0;
+  mesh_advertised = 0;
+  mesh_node = false;
+  os_memset(mesh_key, 0, sizeof(mesh_key));
+  mesh_addr = mesh_network = mesh_netmask = 0;
+}
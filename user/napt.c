@@ -0,0 +1,1199 @@
+// napt.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: This class implements the NAPT (Network Address and Port
+// Translation) engine of the router. Connections from the soft access-point's
+// network to other networks are translated to the address of the station network
+// interface and to a port resp. ICMP-identifier from the range defined in
+// user_config.h; the translation of answers is reverted accordingly.
+//
+// The translation entries are stored in a table, which is allocated by
+// napt_init (and only reallocated if its size changes); unused entries are
+// handed out by a memory pool (cf. mem_pool.h). Two open-addressing hash
+// indexes (linear probing, backward-shift deletion) allow to look up an entry
+// in constant time:
+//
+//  outbound - keyed on (protocol, source address/port, destination address/port)
+//             for packets from the soft access-point's network
+//  inbound  - keyed on (protocol, mapped port) for packets received on the
+//             station network interface
+//
+// Additionally, the used entries are kept in a LRU-list (most recently used
+// first), so that the oldest connection can be recycled once the table is full.
+// The timeout of an entry depends on its protocol and, for TCP, on the state of
+// the connection derived from the flags of the passing packets (SYN_SENT,
+// ESTABLISHED, FIN_WAIT, CLOSED), so that finished connections are removed by
+// the periodical napt_expire within seconds.
+//
+// Portmap entries bind a port on the station network interface statically to
+// an address and port in the internal network. They are kept in a statically
+// allocated pool of NAPT_PORTMAP_MAX entries with two hash indexes keyed on
+// (protocol, mapping port) resp. (protocol, destination address/port). The
+// mapping is applied in both directions; the direction of an entry only
+// determines, whether connections may be initiated from the external network
+// (NAPT_PORTMAP_DIR_IN) or only from the internal one (NAPT_PORTMAP_DIR_OUT).
+// Their mapping address is rewritten at once by napt_external_update, which
+// also suspends the expiry of the translation entries while the station
+// network interface is disconnected.
+//
+// Counters for monitoring the engine are provided by napt_stats_get; the
+// latency of the forwarding path is measured with the CPU's cycle counter by
+// the caller of the translation-functions (cf. napt_netif.c). The translation
+// entries of each client are counted by client_stats.c. The cached flows of
+// flow_cache.c are invalidated, whenever a translation entry is removed resp.
+// the portmaps or the addresses change.
+//
+// The class operates on plain IPv4-packets and doesn't depend on lwip, so that
+// it can also be compiled for the host (cf. Makefile).
+
+#include "c_types.h"
+#include "mem.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "user_interface.h"
+#include "napt.h"
+#include "napt_chksum.h"
+#include "mem_pool.h"
+#include "client_stats.h"
+#include "flow_cache.h"
+#include "mesh.h"
+#define LOG_MODULE LOG_MODULE_NAPT
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Byte-offsets of the header-fields used by the engine
+
+#define IP_HLEN_MIN 20
+#define IP_OFFSET_FRAG 6
+#define IP_OFFSET_PROTO 9
+#define IP_OFFSET_CHKSUM 10
+#define IP_OFFSET_SRC 12
+#define IP_OFFSET_DEST 16
+
+#define L4_OFFSET_SPORT 0
+#define L4_OFFSET_DPORT 2
+
+#define TCP_HLEN_MIN 20
+#define TCP_OFFSET_FLAGS 13
+#define TCP_OFFSET_CHKSUM 16
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_ACK 0x10
+
+#define UDP_HLEN 8
+#define UDP_OFFSET_CHKSUM 6
+
+#define ICMP_HLEN 8
+#define ICMP_OFFSET_CHKSUM 2
+#define ICMP_OFFSET_ID 4
+#define ICMP_TYPE_ECHO_REPLY 0
+#define ICMP_TYPE_ECHO_REQUEST 8
+
+// Size of the portmap hash indexes: smallest power of two >= 2 * NAPT_PORTMAP_MAX
+#define NAPT_SMEAR1(x) ((x) | ((x) >> 1))
+#define NAPT_SMEAR2(x) (NAPT_SMEAR1(x) | (NAPT_SMEAR1(x) >> 2))
+#define NAPT_SMEAR4(x) (NAPT_SMEAR2(x) | (NAPT_SMEAR2(x) >> 4))
+#define NAPT_SMEAR8(x) (NAPT_SMEAR4(x) | (NAPT_SMEAR4(x) >> 8))
+#define NAPT_PORTMAP_HASH_SIZE (NAPT_SMEAR8(2 * NAPT_PORTMAP_MAX - 1) + 1)
+
+// The ESP8266 as well as the x86-host are little-endian
+#define NAPT_HTONS(x) ((uint16_t) ((((x) & 0xFF) << 8) | (((x) >> 8) & 0xFF)))
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint16_t napt_get16(const uint8_t *ptr);
+static uint32_t napt_get32(const uint8_t *ptr);
+static uint32_t napt_mix(uint32_t h);
+static uint32_t napt_hash_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport);
+static uint32_t napt_hash_inbound(uint8_t proto, uint16_t mport);
+static uint32_t napt_entry_hash_outbound(uint16_t idx);
+static uint32_t napt_entry_hash_inbound(uint16_t idx);
+static uint32_t napt_portmap_hash_mport(uint16_t idx);
+static uint32_t napt_portmap_hash_dest(uint16_t idx);
+static uint32_t napt_now(void);
+static uint32_t napt_timeout(struct napt_entry *entry);
+static void napt_count_active(uint8_t proto, int8_t delta);
+static void napt_rewrite(uint8_t *iphdr, uint8_t *addr, uint8_t *port, uint8_t *chksum, bool pseudo_hdr, uint32_t new_addr, uint16_t new_port);
+
+// Hash indexes:
+static void napt_index_insert(uint16_t *index, uint32_t mask, uint32_t hash, uint16_t idx);
+static void napt_index_remove(uint16_t *index, uint32_t mask, uint16_t idx, uint32_t (*entry_hash)(uint16_t));
+
+// LRU-list:
+static void napt_lru_unlink(uint16_t idx);
+static void napt_lru_push(uint16_t idx);
+static void napt_touch(struct napt_entry *entry, uint8_t tcp_flags, uint8_t dir);
+
+// Table management:
+static uint16_t napt_new_port(uint8_t proto);
+static struct napt_entry *napt_evict_candidate(void);
+struct napt_entry *napt_find_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport);
+struct napt_entry *napt_find_inbound(uint8_t proto, uint16_t mport);
+struct napt_entry *napt_add(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport);
+void napt_remove(struct napt_entry *entry);
+uint16_t napt_count(void);
+void napt_expire(void);
+
+// Port mapping:
+struct napt_portmap *napt_portmap_find(uint8_t proto, uint16_t mport);
+static struct napt_portmap *napt_portmap_find_dest(uint8_t proto, uint32_t daddr, uint16_t dport);
+bool napt_portmap_add(uint8_t proto, uint32_t maddr, uint16_t mport, uint32_t daddr, uint16_t dport, uint8_t dir);
+bool napt_portmap_remove(uint8_t proto, uint16_t mport);
+void napt_portmap_clear(void);
+uint16_t napt_portmap_count(void);
+const struct napt_portmap *napt_portmap_next(const struct napt_portmap *portmap);
+
+// Statistics:
+uint32_t napt_ccount(void);
+void napt_stats_record_forward(uint32_t cycles, bool fastpath);
+const struct napt_stats *napt_stats_get(void);
+
+// Translation:
+static void napt_stats_count(uint8_t dir, const uint8_t *iphdr);
+napt_verdict napt_outbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr);
+napt_verdict napt_inbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr);
+struct napt_entry *napt_translated_entry(void);
+void napt_flow_hit(struct napt_entry *entry, uint8_t dir, const uint8_t *iphdr);
+
+// Initialization and configuration:
+bool napt_is_enabled(void);
+void napt_external_update(uint32_t addr);
+void napt_set_adaptive(bool enabled);
+void napt_set_tcp_tracking(bool enabled);
+void napt_enable(uint32_t addr, uint32_t netmask);
+void napt_disable(void);
+bool napt_init(uint16_t max_entries);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct mem_pool napt_entry_pool = {"napt_entries"}; // Storage is allocated by napt_init
+static struct napt_entry *napt_table = NULL;  // Blocks of napt_entry_pool
+static uint16_t *napt_outbound_index = NULL, *napt_inbound_index = NULL;
+static uint32_t napt_hash_mask = 0;
+
+static uint16_t napt_lru_head = NAPT_ENTRY_NONE, napt_lru_tail = NAPT_ENTRY_NONE;
+static uint16_t napt_port_next = NAPT_PORT_RANGE_START;
+
+static bool napt_enabled = false;
+static bool napt_adaptive = NAPT_ADAPTIVE_TIMEOUTS;
+static bool napt_tcp_tracking = NAPT_TCP_TRACKING;
+static os_timer_t napt_expire_timer;
+static uint32_t napt_network = 0, napt_netmask = 0;  // Soft access-point's network
+static bool napt_outage = false;          // Station network interface disconnected
+static uint32_t napt_outage_start = 0;    // Time of the disconnection (in ms)
+
+MEM_POOL_DEFINE(napt_portmap_pool, sizeof(struct napt_portmap), NAPT_PORTMAP_MAX);
+static struct napt_portmap *napt_portmap_table = (struct napt_portmap *) napt_portmap_pool_storage;
+static uint16_t napt_portmap_mport_index[NAPT_PORTMAP_HASH_SIZE], napt_portmap_dest_index[NAPT_PORTMAP_HASH_SIZE];
+
+static uint32_t napt_clock_us = 0, napt_clock_ms = 0;
+
+static struct napt_stats napt_stats;
+static struct napt_entry *napt_translated = NULL;  // Entry of the last forwarded packet
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Read an unaligned 16 bit value without changing the byte order
+static uint16_t ICACHE_FLASH_ATTR napt_get16(const uint8_t *ptr) {
+  uint16_t val;
+  os_memcpy(&val, ptr, sizeof(val));
+  return val;
+}
+
+// Read an unaligned 32 bit value without changing the byte order
+static uint32_t ICACHE_FLASH_ATTR napt_get32(const uint8_t *ptr) {
+  uint32_t val;
+  os_memcpy(&val, ptr, sizeof(val));
+  return val;
+}
+
+// Scramble the bits of the given value (finalizer of MurmurHash3)
+static uint32_t ICACHE_FLASH_ATTR napt_mix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85EBCA6B;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35;
+  h ^= h >> 16;
+  return h;
+}
+
+static uint32_t ICACHE_FLASH_ATTR napt_hash_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport) {
+  return napt_mix(src ^ napt_mix(dest ^ napt_mix((((uint32_t) sport << 16) | dport) ^ proto)));
+}
+
+static uint32_t ICACHE_FLASH_ATTR napt_hash_inbound(uint8_t proto, uint16_t mport) {
+  return napt_mix(((uint32_t) proto << 16) | mport);
+}
+
+static uint32_t ICACHE_FLASH_ATTR napt_entry_hash_outbound(uint16_t idx) {
+  struct napt_entry *entry = &napt_table[idx];
+  return napt_hash_outbound(entry->proto, entry->src, entry->sport, entry->dest, entry->dport);
+}
+
+static uint32_t ICACHE_FLASH_ATTR napt_entry_hash_inbound(uint16_t idx) {
+  struct napt_entry *entry = &napt_table[idx];
+  return napt_hash_inbound(entry->proto, entry->mport);
+}
+
+// The portmap indexes use the same hash functions as the NAPT-table (with the
+// mapping port resp. the destination in place of the connection)
+static uint32_t ICACHE_FLASH_ATTR napt_portmap_hash_mport(uint16_t idx) {
+  struct napt_portmap *portmap = &napt_portmap_table[idx];
+  return napt_hash_inbound(portmap->proto, portmap->mport);
+}
+
+static uint32_t ICACHE_FLASH_ATTR napt_portmap_hash_dest(uint16_t idx) {
+  struct napt_portmap *portmap = &napt_portmap_table[idx];
+  return napt_hash_outbound(portmap->proto, portmap->daddr, portmap->dport, 0, 0);
+}
+
+// Return a monotonic timestamp in ms; extends system_get_time() beyond its
+// overflow after about 71 minutes
+static uint32_t ICACHE_FLASH_ATTR napt_now(void) {
+  uint32_t now_us = system_get_time();
+  uint32_t elapsed_ms = (now_us - napt_clock_us) / 1000;
+
+  napt_clock_ms += elapsed_ms;
+  napt_clock_us += elapsed_ms * 1000;
+  return napt_clock_ms;
+}
+
+// Return the time after which the given entry expires, if it isn't used; once
+// the occupancy of the table exceeds NAPT_TIMEOUT_PRESSURE percent, the timeout
+// shrinks linearly down to the protocol's minimum at a full table
+static uint32_t ICACHE_FLASH_ATTR napt_timeout(struct napt_entry *entry) {
+  uint32_t timeout, timeout_min, delta, scale;
+  uint16_t threshold = (uint32_t) napt_entry_pool.blocks * NAPT_TIMEOUT_PRESSURE / 100;
+
+  switch (entry->proto) {
+    case NAPT_PROTO_TCP:
+      // Without state tracking, only the end of a connection is recognized
+      switch (entry->state & NAPT_TCP_STATE_MASK) {
+        case NAPT_TCP_SYN_SENT:
+          timeout = (napt_tcp_tracking) ? NAPT_TIMEOUT_TCP_SYN : NAPT_TIMEOUT_TCP;
+          timeout_min = (napt_tcp_tracking) ? NAPT_TIMEOUT_TCP_SYN_MIN : NAPT_TIMEOUT_TCP_MIN;
+          break;
+        case NAPT_TCP_FIN_WAIT:
+          timeout = NAPT_TIMEOUT_TCP_FIN_WAIT;
+          timeout_min = NAPT_TIMEOUT_TCP_FIN_WAIT_MIN;
+          break;
+        case NAPT_TCP_CLOSED:
+          timeout = (napt_tcp_tracking) ? NAPT_TIMEOUT_TCP_CLOSED : NAPT_TIMEOUT_TCP_FIN_WAIT;
+          timeout_min = (napt_tcp_tracking) ? NAPT_TIMEOUT_TCP_CLOSED_MIN : NAPT_TIMEOUT_TCP_FIN_WAIT_MIN;
+          break;
+        default:
+          timeout = NAPT_TIMEOUT_TCP;
+          timeout_min = NAPT_TIMEOUT_TCP_MIN;
+          break;
+      }
+      break;
+    case NAPT_PROTO_UDP:
+      timeout = NAPT_TIMEOUT_UDP;
+      timeout_min = NAPT_TIMEOUT_UDP_MIN;
+      break;
+    default:
+      timeout = NAPT_TIMEOUT_ICMP;
+      timeout_min = NAPT_TIMEOUT_ICMP_MIN;
+      break;
+  }
+
+  if (!napt_adaptive || napt_entry_pool.used <= threshold || timeout <= timeout_min) {
+    return timeout;
+  }
+
+  // Scale the range between the minimum and the regular timeout with the
+  // remaining capacity (fixed point, 1024 = 1.0); avoid the 32 bit overflow of
+  // the product for the long TCP-timeout
+  scale = (uint32_t) (napt_entry_pool.blocks - napt_entry_pool.used) * 1024 / (napt_entry_pool.blocks - threshold);
+  delta = timeout - timeout_min;
+  return timeout_min + ((delta < (1 << 22)) ? (delta * scale) >> 10 : (delta >> 10) * scale);
+}
+
+// Adjust the number of active entries of the given protocol
+static void ICACHE_FLASH_ATTR napt_count_active(uint8_t proto, int8_t delta) {
+  switch (proto) {
+    case NAPT_PROTO_TCP:
+      napt_stats.nr_active_napt_tcp += delta;
+      break;
+    case NAPT_PROTO_UDP:
+      napt_stats.nr_active_napt_udp += delta;
+      break;
+    default:
+      napt_stats.nr_active_napt_icmp += delta;
+      break;
+  }
+}
+
+// Replace an address and the correlating port of a packet and update the IP-
+// header-checksum as well as the checksum of the transport layer (if given);
+// pseudo_hdr determines, whether the address is part of the latter
+// The checksums are updated incrementally (cf. napt_chksum.c), so the cost
+// doesn't depend on the length of the packet
+static void ICACHE_FLASH_ATTR napt_rewrite(uint8_t *iphdr, uint8_t *addr, uint8_t *port, uint8_t *chksum, bool pseudo_hdr, uint32_t new_addr, uint16_t new_port) {
+  uint32_t delta = napt_chksum_delta(0, addr, (uint8_t *) &new_addr, 4);
+
+  napt_chksum_apply(iphdr + IP_OFFSET_CHKSUM, delta);
+  if (chksum) {
+    napt_chksum_apply(chksum, napt_chksum_delta((pseudo_hdr) ? delta : 0, port, (uint8_t *) &new_port, 2));
+    // A checksum of 0 means "no checksum" for UDP; 0xFFFF is equivalent in the
+    // one's complement arithmetic
+    if (!chksum[0] && !chksum[1]) {
+      chksum[0] = chksum[1] = 0xFF;
+    }
+  }
+  os_memcpy(addr, &new_addr, 4);
+  os_memcpy(port, &new_port, 2);
+}
+
+/*------------------------------------*/
+
+// Hash indexes:
+
+// Insert the entry idx into the given hash index (mask = size of the index - 1)
+static void ICACHE_FLASH_ATTR napt_index_insert(uint16_t *index, uint32_t mask, uint32_t hash, uint16_t idx) {
+  uint32_t slot = hash & mask;
+
+  while (index[slot] != NAPT_ENTRY_NONE) {
+    slot = (slot + 1) & mask;
+  }
+  index[slot] = idx;
+}
+
+// Remove the entry idx from the given hash index; the following entries of the
+// probe-sequence are shifted backwards, so that no tombstones are needed
+// (entry_hash returns the hash of the entry with the given index)
+static void ICACHE_FLASH_ATTR napt_index_remove(uint16_t *index, uint32_t mask, uint16_t idx, uint32_t (*entry_hash)(uint16_t)) {
+  uint32_t slot = entry_hash(idx) & mask, next, home;
+
+  while (index[slot] != idx) {
+    if (index[slot] == NAPT_ENTRY_NONE) {
+      return;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  next = slot;
+  for (;;) {
+    next = (next + 1) & mask;
+    if (index[next] == NAPT_ENTRY_NONE) {
+      break;
+    }
+    // Move the entry into the gap, if its home slot isn't located cyclically
+    // within (slot, next]
+    home = entry_hash(index[next]) & mask;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      index[slot] = index[next];
+      slot = next;
+    }
+  }
+  index[slot] = NAPT_ENTRY_NONE;
+}
+
+/*------------------------------------*/
+
+// LRU-list:
+
+static void ICACHE_FLASH_ATTR napt_lru_unlink(uint16_t idx) {
+  struct napt_entry *entry = &napt_table[idx];
+
+  if (entry->prev != NAPT_ENTRY_NONE) {
+    napt_table[entry->prev].next = entry->next;
+  }
+  else {
+    napt_lru_head = entry->next;
+  }
+  if (entry->next != NAPT_ENTRY_NONE) {
+    napt_table[entry->next].prev = entry->prev;
+  }
+  else {
+    napt_lru_tail = entry->prev;
+  }
+}
+
+static void ICACHE_FLASH_ATTR napt_lru_push(uint16_t idx) {
+  struct napt_entry *entry = &napt_table[idx];
+
+  entry->prev = NAPT_ENTRY_NONE;
+  entry->next = napt_lru_head;
+  if (napt_lru_head != NAPT_ENTRY_NONE) {
+    napt_table[napt_lru_head].prev = idx;
+  }
+  else {
+    napt_lru_tail = idx;
+  }
+  napt_lru_head = idx;
+}
+
+// Mark the entry as most recently used and advance the state of a TCP-
+// connection according to the flags of a packet sent in the given direction
+// (cf. NAPT_DIR_*):
+//
+//  SYN_SENT    -> ESTABLISHED on the first packet with an ACK
+//  any         -> FIN_WAIT    on the first FIN
+//  FIN_WAIT    -> CLOSED      on a FIN in the other direction
+//  any         -> CLOSED      on a RST
+static void ICACHE_FLASH_ATTR napt_touch(struct napt_entry *entry, uint8_t tcp_flags, uint8_t dir) {
+  uint16_t idx = entry - napt_table;
+  uint8_t state = entry->state & NAPT_TCP_STATE_MASK;
+
+  if (entry->proto == NAPT_PROTO_TCP && state != NAPT_TCP_CLOSED) {
+    if (tcp_flags & TCP_FLAG_RST) {
+      state = NAPT_TCP_CLOSED;
+    }
+    else {
+      if (state == NAPT_TCP_SYN_SENT && (tcp_flags & TCP_FLAG_ACK)) {
+        state = NAPT_TCP_ESTABLISHED;
+      }
+      if (tcp_flags & TCP_FLAG_FIN) {
+        entry->state |= (dir == NAPT_DIR_OUT) ? NAPT_TCP_FIN_OUT : NAPT_TCP_FIN_IN;
+        state = ((entry->state & (NAPT_TCP_FIN_OUT | NAPT_TCP_FIN_IN)) == (NAPT_TCP_FIN_OUT | NAPT_TCP_FIN_IN)) ? NAPT_TCP_CLOSED : NAPT_TCP_FIN_WAIT;
+      }
+    }
+    entry->state = (entry->state & ~NAPT_TCP_STATE_MASK) | state;
+  }
+  entry->last = napt_now();
+
+  if (napt_lru_head != idx) {
+    napt_lru_unlink(idx);
+    napt_lru_push(idx);
+  }
+}
+
+/*------------------------------------*/
+
+// Table management:
+
+// Get an unused port resp. ICMP-identifier from the range defined in
+// user_config.h (in network byte order); returns 0 if the range is exhausted
+static uint16_t ICACHE_FLASH_ATTR napt_new_port(uint8_t proto) {
+  uint32_t attempts;
+  uint16_t port;
+
+  for (attempts = NAPT_PORT_RANGE_END - NAPT_PORT_RANGE_START + 1; attempts > 0; attempts--) {
+    port = NAPT_HTONS(napt_port_next);
+    napt_port_next = (napt_port_next >= NAPT_PORT_RANGE_END) ? NAPT_PORT_RANGE_START : napt_port_next + 1;
+    if (!napt_find_inbound(proto, port) && !napt_portmap_find(proto, port)) {
+      return port;
+    }
+  }
+  return 0;
+}
+
+// Select the entry to recycle, if the table is full; the least recently used
+// NAPT_EVICT_SCAN entries are searched for a closing resp. closed TCP-
+// connection (FIN or RST seen) first and for an expired UDP- resp. ICMP-entry
+// second, otherwise the least recently used entry is chosen. If adaptive
+// timeouts are disabled, only the least recently used entry is recycled and
+// only once it has expired (returns NULL otherwise).
+static struct napt_entry * ICACHE_FLASH_ATTR napt_evict_candidate(void) {
+  struct napt_entry *entry, *idle = NULL;
+  uint16_t idx, scanned;
+  uint32_t now = napt_now();
+
+  if (!napt_adaptive) {
+    entry = &napt_table[napt_lru_tail];
+    return (now - entry->last >= napt_timeout(entry)) ? entry : NULL;
+  }
+
+  for (idx = napt_lru_tail, scanned = 0; idx != NAPT_ENTRY_NONE && scanned < NAPT_EVICT_SCAN; idx = entry->prev, scanned++) {
+    entry = &napt_table[idx];
+    if (entry->proto == NAPT_PROTO_TCP) {
+      if ((entry->state & NAPT_TCP_STATE_MASK) >= NAPT_TCP_FIN_WAIT) {
+        return entry;
+      }
+    }
+    else if (!idle && now - entry->last >= napt_timeout(entry)) {
+      idle = entry;
+    }
+  }
+  return (idle) ? idle : &napt_table[napt_lru_tail];
+}
+
+// Look up the translation entry of a connection from the internal network
+struct napt_entry * ICACHE_FLASH_ATTR napt_find_outbound(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport) {
+  uint32_t slot;
+  uint16_t idx;
+  struct napt_entry *entry;
+
+  if (!napt_table) {
+    return NULL;
+  }
+
+  slot = napt_hash_outbound(proto, src, sport, dest, dport) & napt_hash_mask;
+  while ((idx = napt_outbound_index[slot]) != NAPT_ENTRY_NONE) {
+    entry = &napt_table[idx];
+    if (entry->src == src && entry->dest == dest && entry->sport == sport && entry->dport == dport && entry->proto == proto) {
+      return entry;
+    }
+    slot = (slot + 1) & napt_hash_mask;
+  }
+  return NULL;
+}
+
+// Look up the translation entry of a port resp. ICMP-identifier of the station
+// network interface
+struct napt_entry * ICACHE_FLASH_ATTR napt_find_inbound(uint8_t proto, uint16_t mport) {
+  uint32_t slot;
+  uint16_t idx;
+  struct napt_entry *entry;
+
+  if (!napt_table) {
+    return NULL;
+  }
+
+  slot = napt_hash_inbound(proto, mport) & napt_hash_mask;
+  while ((idx = napt_inbound_index[slot]) != NAPT_ENTRY_NONE) {
+    entry = &napt_table[idx];
+    if (entry->mport == mport && entry->proto == proto) {
+      return entry;
+    }
+    slot = (slot + 1) & napt_hash_mask;
+  }
+  return NULL;
+}
+
+// Create a new translation entry; if the table is full, an existing entry is
+// recycled (cf. napt_evict_candidate)
+struct napt_entry * ICACHE_FLASH_ATTR napt_add(uint8_t proto, uint32_t src, uint16_t sport, uint32_t dest, uint16_t dport) {
+  struct napt_entry *entry;
+  uint16_t idx, mport;
+
+  if (!napt_table) {
+    return NULL;
+  }
+
+  if (napt_entry_pool.used >= napt_entry_pool.blocks) {
+    entry = napt_evict_candidate();
+    if (!entry) {
+      return NULL;
+    }
+    napt_remove(entry);
+    napt_stats.evictions++;
+  }
+
+  mport = napt_new_port(proto);
+  if (!mport) {
+    return NULL;
+  }
+
+  entry = (struct napt_entry *) mem_pool_alloc(&napt_entry_pool);
+  idx = mem_pool_index(&napt_entry_pool, entry);
+
+  entry->src = src;
+  entry->dest = dest;
+  entry->sport = sport;
+  entry->dport = dport;
+  entry->mport = mport;
+  entry->proto = proto;
+  entry->state = (proto == NAPT_PROTO_TCP) ? NAPT_TCP_SYN_SENT : 0;
+  entry->last = napt_now();
+
+  napt_index_insert(napt_outbound_index, napt_hash_mask, napt_entry_hash_outbound(idx), idx);
+  napt_index_insert(napt_inbound_index, napt_hash_mask, napt_entry_hash_inbound(idx), idx);
+  napt_lru_push(idx);
+  napt_count_active(proto, 1);
+  client_stats_napt(src, 1);
+  napt_stats.allocs++;
+
+  return entry;
+}
+
+// Remove the given translation entry from the table
+void ICACHE_FLASH_ATTR napt_remove(struct napt_entry *entry) {
+  uint16_t idx;
+
+  if (!napt_table || !entry) {
+    return;
+  }
+
+  idx = entry - napt_table;
+  napt_index_remove(napt_outbound_index, napt_hash_mask, idx, napt_entry_hash_outbound);
+  napt_index_remove(napt_inbound_index, napt_hash_mask, idx, napt_entry_hash_inbound);
+  napt_lru_unlink(idx);
+  napt_count_active(entry->proto, -1);
+  client_stats_napt(entry->src, -1);
+  flow_cache_invalidate(entry);
+
+  entry->proto = 0;
+  mem_pool_free(&napt_entry_pool, entry);
+}
+
+// Return the number of active translation entries
+uint16_t ICACHE_FLASH_ATTR napt_count(void) {
+  return napt_entry_pool.used;
+}
+
+// Remove all expired translation entries; called every NAPT_EXPIRE_INTERVAL ms,
+// so that finished connections don't occupy the table until it is full
+void ICACHE_FLASH_ATTR napt_expire(void) {
+  uint16_t idx, prev;
+  uint32_t now = napt_now();
+  struct napt_entry *entry;
+
+  // Nothing expires while the station network interface is disconnected
+  if (!napt_table || napt_outage) {
+    return;
+  }
+
+  // The timeouts differ per protocol and state, so the whole list is checked
+  for (idx = napt_lru_tail; idx != NAPT_ENTRY_NONE; idx = prev) {
+    entry = &napt_table[idx];
+    prev = entry->prev;
+    if (now - entry->last >= napt_timeout(entry)) {
+      napt_remove(entry);
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Port mapping:
+
+// Look up the portmap entry of a port of the station network interface (in
+// network byte order)
+struct napt_portmap * ICACHE_FLASH_ATTR napt_portmap_find(uint8_t proto, uint16_t mport) {
+  uint32_t slot;
+  uint16_t idx;
+  struct napt_portmap *portmap;
+
+  if (!napt_portmap_pool.used) {
+    return NULL;
+  }
+
+  slot = napt_hash_inbound(proto, mport) & (NAPT_PORTMAP_HASH_SIZE - 1);
+  while ((idx = napt_portmap_mport_index[slot]) != NAPT_ENTRY_NONE) {
+    portmap = &napt_portmap_table[idx];
+    if (portmap->mport == mport && portmap->proto == proto) {
+      return portmap;
+    }
+    slot = (slot + 1) & (NAPT_PORTMAP_HASH_SIZE - 1);
+  }
+  return NULL;
+}
+
+// Look up the portmap entry of an address and port in the internal network
+static struct napt_portmap * ICACHE_FLASH_ATTR napt_portmap_find_dest(uint8_t proto, uint32_t daddr, uint16_t dport) {
+  uint32_t slot;
+  uint16_t idx;
+  struct napt_portmap *portmap;
+
+  if (!napt_portmap_pool.used) {
+    return NULL;
+  }
+
+  slot = napt_hash_outbound(proto, daddr, dport, 0, 0) & (NAPT_PORTMAP_HASH_SIZE - 1);
+  while ((idx = napt_portmap_dest_index[slot]) != NAPT_ENTRY_NONE) {
+    portmap = &napt_portmap_table[idx];
+    if (portmap->daddr == daddr && portmap->dport == dport && portmap->proto == proto) {
+      return portmap;
+    }
+    slot = (slot + 1) & (NAPT_PORTMAP_HASH_SIZE - 1);
+  }
+  return NULL;
+}
+
+// Add a portmap entry (ports in host byte order); an existing entry for the
+// same protocol and mapping port is replaced
+bool ICACHE_FLASH_ATTR napt_portmap_add(uint8_t proto, uint32_t maddr, uint16_t mport, uint32_t daddr, uint16_t dport, uint8_t dir) {
+  struct napt_portmap *portmap;
+  uint16_t idx;
+
+  if (!proto || !mport || !dport || (dir != NAPT_PORTMAP_DIR_IN && dir != NAPT_PORTMAP_DIR_OUT)) {
+    LOG_ERROR("napt_portmap_add: Invalid transfer parameters!\n");
+    return false;
+  }
+
+  // The hash indexes are set up together with the pool on the first use
+  if (!napt_portmap_pool.initialized) {
+    mem_pool_init(&napt_portmap_pool);
+    os_memset(napt_portmap_mport_index, 0xFF, sizeof(napt_portmap_mport_index));
+    os_memset(napt_portmap_dest_index, 0xFF, sizeof(napt_portmap_dest_index));
+  }
+
+  napt_portmap_remove(proto, mport);
+  portmap = (struct napt_portmap *) mem_pool_alloc(&napt_portmap_pool);
+  if (!portmap) {
+    return false;
+  }
+
+  idx = mem_pool_index(&napt_portmap_pool, portmap);
+  portmap->proto = proto;
+  portmap->maddr = maddr;
+  portmap->mport = NAPT_HTONS(mport);
+  portmap->daddr = daddr;
+  portmap->dport = NAPT_HTONS(dport);
+  portmap->dir = dir;
+  portmap->valid = 1;
+  napt_index_insert(napt_portmap_mport_index, NAPT_PORTMAP_HASH_SIZE - 1, napt_portmap_hash_mport(idx), idx);
+  napt_index_insert(napt_portmap_dest_index, NAPT_PORTMAP_HASH_SIZE - 1, napt_portmap_hash_dest(idx), idx);
+  flow_cache_flush();
+  return true;
+}
+
+// Remove the portmap entry of the given protocol and mapping port (in host byte
+// order)
+bool ICACHE_FLASH_ATTR napt_portmap_remove(uint8_t proto, uint16_t mport) {
+  struct napt_portmap *portmap = napt_portmap_find(proto, NAPT_HTONS(mport));
+  uint16_t idx;
+
+  if (!portmap) {
+    return false;
+  }
+
+  idx = mem_pool_index(&napt_portmap_pool, portmap);
+  napt_index_remove(napt_portmap_mport_index, NAPT_PORTMAP_HASH_SIZE - 1, idx, napt_portmap_hash_mport);
+  napt_index_remove(napt_portmap_dest_index, NAPT_PORTMAP_HASH_SIZE - 1, idx, napt_portmap_hash_dest);
+  portmap->valid = 0;
+  mem_pool_free(&napt_portmap_pool, portmap);
+  flow_cache_flush();
+  return true;
+}
+
+// Remove all portmap entries (e.g. before loading the configured ones)
+void ICACHE_FLASH_ATTR napt_portmap_clear(void) {
+  const struct napt_portmap *portmap;
+
+  while ((portmap = napt_portmap_next(NULL))) {
+    napt_portmap_remove(portmap->proto, NAPT_HTONS(portmap->mport));
+  }
+}
+
+// Return the number of portmap entries
+uint16_t ICACHE_FLASH_ATTR napt_portmap_count(void) {
+  return napt_portmap_pool.used;
+}
+
+// Iterate over the portmap entries: return the entry following the given one
+// (the first one for NULL) resp. NULL at the end; adding or removing entries
+// while iterating may skip entries
+const struct napt_portmap * ICACHE_FLASH_ATTR napt_portmap_next(const struct napt_portmap *portmap) {
+  uint16_t idx = (portmap) ? (portmap - napt_portmap_table) + 1 : 0;
+
+  for (; idx < NAPT_PORTMAP_MAX; idx++) {
+    if (napt_portmap_table[idx].valid) {
+      return &napt_portmap_table[idx];
+    }
+  }
+  return NULL;
+}
+
+/*------------------------------------*/
+
+// Statistics:
+
+// Read the CPU's cycle counter
+uint32_t ICACHE_FLASH_ATTR napt_ccount(void) {
+#ifdef HOST_BUILD
+  return host_ccount();
+#else
+  uint32_t ccount;
+
+  __asm__ __volatile__("rsr %0, ccount" : "=a" (ccount));
+  return ccount;
+#endif
+}
+
+// Record a forwarded packet and its latency (measured with napt_ccount);
+// fastpath determines, if it bypassed the IP-stack
+void ICACHE_FLASH_ATTR napt_stats_record_forward(uint32_t cycles, bool fastpath) {
+  uint32_t latency_us = cycles / system_get_cpu_freq();
+  uint8_t bucket = 0;
+
+  if (fastpath) {
+    napt_stats.fastpath++;
+  }
+
+  while (bucket < NAPT_STATS_LATENCY_BUCKETS - 1 && latency_us >= (1UL << bucket)) {
+    bucket++;
+  }
+  napt_stats.latency[bucket]++;
+  napt_stats.latency_sum += latency_us;
+  napt_stats.latency_cycles = cycles;
+  if (latency_us > napt_stats.latency_max) {
+    napt_stats.latency_max = latency_us;
+  }
+}
+
+// Return the counters of the engine
+const struct napt_stats * ICACHE_FLASH_ATTR napt_stats_get(void) {
+  return &napt_stats;
+}
+
+/*------------------------------------*/
+
+// Translation:
+
+// Account a translated packet
+static void ICACHE_FLASH_ATTR napt_stats_count(uint8_t dir, const uint8_t *iphdr) {
+  napt_stats.packets[dir]++;
+  napt_stats.bytes[dir] += (iphdr[2] << 8) | iphdr[3];
+}
+
+// Translate a packet, that has been received on the soft access-point network
+// interface, to the address ext_addr of the station network interface
+napt_verdict ICACHE_FLASH_ATTR napt_outbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr) {
+  uint8_t *l4hdr, *chksum = NULL, proto, tcp_flags = 0;
+  uint16_t hlen, sport, dport = 0;
+  uint32_t src, dest;
+  struct napt_portmap *portmap;
+  struct napt_entry *entry;
+
+  if (!napt_enabled || !ext_addr || len < IP_HLEN_MIN || (iphdr[0] >> 4) != 4) {
+    return NAPT_PASS;
+  }
+  hlen = (iphdr[0] & 0x0F) * 4;
+  if (hlen < IP_HLEN_MIN || len < hlen) {
+    return NAPT_PASS;
+  }
+
+  // Only packets from the soft access-point's network resp. the networks of
+  // downstream routers (cf. mesh.c) to other networks are translated (no
+  // broad- or multicasts, no fragments and no packets to the networks of
+  // downstream routers, which are forwarded as they are)
+  src = napt_get32(iphdr + IP_OFFSET_SRC);
+  dest = napt_get32(iphdr + IP_OFFSET_DEST);
+  if ((dest & napt_netmask) == napt_network || iphdr[IP_OFFSET_DEST] >= 224 || mesh_route_lookup(dest) ||
+      ((src & napt_netmask) != napt_network && !mesh_route_lookup(src))) {
+    return NAPT_PASS;
+  }
+  if (napt_get16(iphdr + IP_OFFSET_FRAG) & NAPT_HTONS(0x3FFF)) {
+    return NAPT_PASS;
+  }
+
+  proto = iphdr[IP_OFFSET_PROTO];
+  l4hdr = iphdr + hlen;
+  len -= hlen;
+  switch (proto) {
+    case NAPT_PROTO_TCP:
+      if (len < TCP_HLEN_MIN) {
+        napt_stats.drops++;
+        return NAPT_DROP;
+      }
+      chksum = l4hdr + TCP_OFFSET_CHKSUM;
+      tcp_flags = l4hdr[TCP_OFFSET_FLAGS];
+      sport = napt_get16(l4hdr + L4_OFFSET_SPORT);
+      dport = napt_get16(l4hdr + L4_OFFSET_DPORT);
+      break;
+    case NAPT_PROTO_UDP:
+      if (len < UDP_HLEN) {
+        napt_stats.drops++;
+        return NAPT_DROP;
+      }
+      if (napt_get16(l4hdr + UDP_OFFSET_CHKSUM)) {
+        chksum = l4hdr + UDP_OFFSET_CHKSUM;
+      }
+      sport = napt_get16(l4hdr + L4_OFFSET_SPORT);
+      dport = napt_get16(l4hdr + L4_OFFSET_DPORT);
+      break;
+    case NAPT_PROTO_ICMP:
+      if (len < ICMP_HLEN || l4hdr[0] != ICMP_TYPE_ECHO_REQUEST) {
+        return NAPT_PASS;
+      }
+      chksum = l4hdr + ICMP_OFFSET_CHKSUM;
+      sport = napt_get16(l4hdr + ICMP_OFFSET_ID);
+      break;
+    default:
+      return NAPT_PASS;
+  }
+
+  // Packets of a portmapped device are sent from the statically mapped port
+  if (proto != NAPT_PROTO_ICMP && (portmap = napt_portmap_find_dest(proto, src, sport))) {
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_SRC, l4hdr + L4_OFFSET_SPORT, chksum, true, ext_addr, portmap->mport);
+    napt_stats.hits++;
+    napt_stats_count(NAPT_DIR_OUT, iphdr);
+    napt_translated = NULL;
+    return NAPT_FORWARD;
+  }
+
+  entry = napt_find_outbound(proto, src, sport, dest, dport);
+  if (!entry) {
+    napt_stats.misses++;
+    // New TCP-connections have to be initiated with a SYN
+    if (proto == NAPT_PROTO_TCP && !(tcp_flags & TCP_FLAG_SYN)) {
+      napt_stats.drops++;
+      return NAPT_DROP;
+    }
+    entry = napt_add(proto, src, sport, dest, dport);
+    if (!entry) {
+      napt_stats.drops++;
+      return NAPT_DROP;
+    }
+  }
+  else {
+    napt_stats.hits++;
+  }
+  napt_touch(entry, tcp_flags, NAPT_DIR_OUT);
+
+  if (proto == NAPT_PROTO_ICMP) {
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_SRC, l4hdr + ICMP_OFFSET_ID, chksum, false, ext_addr, entry->mport);
+  }
+  else {
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_SRC, l4hdr + L4_OFFSET_SPORT, chksum, true, ext_addr, entry->mport);
+  }
+  napt_stats_count(NAPT_DIR_OUT, iphdr);
+  napt_translated = entry;
+  return NAPT_FORWARD;
+}
+
+// Revert the translation of a packet, that has been received on the station
+// network interface with the address ext_addr
+napt_verdict ICACHE_FLASH_ATTR napt_inbound(uint8_t *iphdr, uint16_t len, uint32_t ext_addr) {
+  uint8_t *l4hdr, *chksum = NULL, proto, tcp_flags = 0;
+  uint16_t hlen, sport = 0, dport;
+  uint32_t src;
+  struct napt_portmap *portmap;
+  struct napt_entry *entry;
+
+  if (!napt_enabled || !ext_addr || len < IP_HLEN_MIN || (iphdr[0] >> 4) != 4) {
+    return NAPT_PASS;
+  }
+  hlen = (iphdr[0] & 0x0F) * 4;
+  if (hlen < IP_HLEN_MIN || len < hlen) {
+    return NAPT_PASS;
+  }
+  if (napt_get32(iphdr + IP_OFFSET_DEST) != ext_addr || (napt_get16(iphdr + IP_OFFSET_FRAG) & NAPT_HTONS(0x3FFF))) {
+    return NAPT_PASS;
+  }
+
+  src = napt_get32(iphdr + IP_OFFSET_SRC);
+  proto = iphdr[IP_OFFSET_PROTO];
+  l4hdr = iphdr + hlen;
+  len -= hlen;
+  switch (proto) {
+    case NAPT_PROTO_TCP:
+      if (len < TCP_HLEN_MIN) {
+        return NAPT_PASS;
+      }
+      chksum = l4hdr + TCP_OFFSET_CHKSUM;
+      tcp_flags = l4hdr[TCP_OFFSET_FLAGS];
+      sport = napt_get16(l4hdr + L4_OFFSET_SPORT);
+      dport = napt_get16(l4hdr + L4_OFFSET_DPORT);
+      break;
+    case NAPT_PROTO_UDP:
+      if (len < UDP_HLEN) {
+        return NAPT_PASS;
+      }
+      if (napt_get16(l4hdr + UDP_OFFSET_CHKSUM)) {
+        chksum = l4hdr + UDP_OFFSET_CHKSUM;
+      }
+      sport = napt_get16(l4hdr + L4_OFFSET_SPORT);
+      dport = napt_get16(l4hdr + L4_OFFSET_DPORT);
+      break;
+    case NAPT_PROTO_ICMP:
+      if (len < ICMP_HLEN || l4hdr[0] != ICMP_TYPE_ECHO_REPLY) {
+        return NAPT_PASS;
+      }
+      chksum = l4hdr + ICMP_OFFSET_CHKSUM;
+      dport = napt_get16(l4hdr + ICMP_OFFSET_ID);
+      break;
+    default:
+      return NAPT_PASS;
+  }
+
+  // Portmapped ports; devices with NAPT_PORTMAP_DIR_OUT don't accept new
+  // connections from the external network
+  if (proto != NAPT_PROTO_ICMP && (portmap = napt_portmap_find(proto, dport))) {
+    if (portmap->dir == NAPT_PORTMAP_DIR_OUT && proto == NAPT_PROTO_TCP && (tcp_flags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == TCP_FLAG_SYN) {
+      napt_stats.drops++;
+      return NAPT_DROP;
+    }
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_DEST, l4hdr + L4_OFFSET_DPORT, chksum, true, portmap->daddr, portmap->dport);
+    napt_stats.hits++;
+    napt_stats_count(NAPT_DIR_IN, iphdr);
+    napt_translated = NULL;
+    return NAPT_FORWARD;
+  }
+
+  // Only answers of the peer the connection has been initiated with are
+  // translated; everything else is addressed to the router itself
+  entry = napt_find_inbound(proto, dport);
+  if (!entry || entry->dest != src || entry->dport != sport) {
+    napt_stats.misses++;
+    return NAPT_PASS;
+  }
+  napt_stats.hits++;
+  napt_touch(entry, tcp_flags, NAPT_DIR_IN);
+
+  if (proto == NAPT_PROTO_ICMP) {
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_DEST, l4hdr + ICMP_OFFSET_ID, chksum, false, entry->src, entry->sport);
+  }
+  else {
+    napt_rewrite(iphdr, iphdr + IP_OFFSET_DEST, l4hdr + L4_OFFSET_DPORT, chksum, true, entry->src, entry->sport);
+  }
+  napt_stats_count(NAPT_DIR_IN, iphdr);
+  napt_translated = entry;
+  return NAPT_FORWARD;
+}
+
+// Translation entry of the last packet forwarded by napt_outbound resp.
+// napt_inbound (NULL for portmaps); only valid until the next call of the
+// NAPT-engine (cf. flow_cache_insert)
+struct napt_entry * ICACHE_FLASH_ATTR napt_translated_entry(void) {
+  return napt_translated;
+}
+
+// Account a packet, that has been translated by the flow cache (cf.
+// flow_cache.c), and refresh its translation entry (NULL for portmaps)
+void ICACHE_FLASH_ATTR napt_flow_hit(struct napt_entry *entry, uint8_t dir, const uint8_t *iphdr) {
+  if (entry) {
+    napt_touch(entry, 0, dir);
+  }
+  napt_stats.hits++;
+  napt_stats_count(dir, iphdr);
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration:
+
+// Return, if NAPT is enabled
+bool ICACHE_FLASH_ATTR napt_is_enabled(void) {
+  return napt_enabled;
+}
+
+// Enable NAPT for the network addr/netmask of the soft access-point
+void ICACHE_FLASH_ATTR napt_enable(uint32_t addr, uint32_t netmask) {
+  flow_cache_flush();
+  napt_network = addr & netmask;
+  napt_netmask = netmask;
+  napt_enabled = (napt_table != NULL);
+
+  // Periodically remove expired entries
+  if (napt_enabled) {
+    os_timer_disarm(&napt_expire_timer);
+    os_timer_setfn(&napt_expire_timer, (os_timer_func_t *) napt_expire, NULL);
+    os_timer_arm(&napt_expire_timer, NAPT_EXPIRE_INTERVAL, true);
+  }
+}
+
+// Set the address of the station network interface, that the connections are
+// translated to, and rewrite the mapping address of all portmap entries to it.
+// While the address is 0 (the station network interface is disconnected), the
+// translation entries don't expire; once an address is set again, their idle
+// time continues from where it stood at the disconnection, so that the
+// translations of the clients survive an outage of the uplink (cf.
+// ROUTER_HITLESS_RECONNECT).
+void ICACHE_FLASH_ATTR napt_external_update(uint32_t addr) {
+  uint32_t now = napt_now(), outage;
+  uint16_t idx;
+
+  flow_cache_flush();
+  if (!addr) {
+    if (!napt_outage) {
+      napt_outage = true;
+      napt_outage_start = now;
+    }
+    return;
+  }
+
+  if (napt_outage) {
+    outage = now - napt_outage_start;
+    for (idx = napt_lru_head; idx != NAPT_ENTRY_NONE; idx = napt_table[idx].next) {
+      napt_table[idx].last += outage;
+    }
+    napt_outage = false;
+  }
+  for (idx = 0; idx < NAPT_PORTMAP_MAX; idx++) {
+    if (napt_portmap_table[idx].valid) {
+      napt_portmap_table[idx].maddr = addr;
+    }
+  }
+}
+
+// Enable resp. disable the adaptive timeouts and the eviction of active entries,
+// if the table is full (cf. napt_timeout and napt_evict_candidate)
+void ICACHE_FLASH_ATTR napt_set_adaptive(bool enabled) {
+  napt_adaptive = enabled;
+}
+
+// Enable resp. disable the tracking of the state of TCP-connections (cf.
+// napt_touch); without it, only a FIN or RST shortens the timeout
+void ICACHE_FLASH_ATTR napt_set_tcp_tracking(bool enabled) {
+  napt_tcp_tracking = enabled;
+}
+
+// Disable NAPT; the existing translation entries are kept
+void ICACHE_FLASH_ATTR napt_disable(void) {
+  napt_enabled = false;
+  os_timer_disarm(&napt_expire_timer);
+  flow_cache_flush();
+}
+
+// Allocate the NAPT-table for max_entries connections and the correlating hash
+// indexes; all existing translation entries are discarded. The memory is only
+// reallocated, if the size of the table changes, so that enabling the router
+// repeatedly doesn't fragment the heap.
+bool ICACHE_FLASH_ATTR napt_init(uint16_t max_entries) {
+  uint32_t hash_size = 1;
+
+  napt_disable();
+  if (max_entries == 0 || max_entries >= NAPT_ENTRY_NONE) {
+    LOG_ERROR("napt_init: Invalid transfer parameter!\n");
+    return false;
+  }
+
+  // Keep the load factor of the hash indexes below 0.5
+  while (hash_size < 2 * (uint32_t) max_entries) {
+    hash_size <<= 1;
+  }
+
+  if (napt_table && napt_entry_pool.blocks != max_entries) {
+    os_free(napt_table);
+    os_free(napt_outbound_index);
+    os_free(napt_inbound_index);
+    napt_table = NULL;
+    napt_outbound_index = napt_inbound_index = NULL;
+  }
+  if (!napt_table) {
+    napt_table = (struct napt_entry *) os_zalloc(max_entries * sizeof(struct napt_entry));
+    napt_outbound_index = (uint16_t *) os_zalloc(hash_size * sizeof(uint16_t));
+    napt_inbound_index = (uint16_t *) os_zalloc(hash_size * sizeof(uint16_t));
+    if (!napt_table || !napt_outbound_index || !napt_inbound_index) {
+      LOG_ERROR("napt_init: Failed to allocate the NAPT-table!\n");
+      if (napt_table) {
+        os_free(napt_table);
+      }
+      if (napt_outbound_index) {
+        os_free(napt_outbound_index);
+      }
+      if (napt_inbound_index) {
+        os_free(napt_inbound_index);
+      }
+      napt_table = NULL;
+      napt_outbound_index = napt_inbound_index = NULL;
+      napt_entry_pool.blocks = 0;
+      return false;
+    }
+  }
+
+  os_memset(napt_outbound_index, 0xFF, hash_size * sizeof(uint16_t));
+  os_memset(napt_inbound_index, 0xFF, hash_size * sizeof(uint16_t));
+  napt_hash_mask = hash_size - 1;
+
+  // The entries are handed out by a pool on top of the table
+  napt_entry_pool.storage = (uint8_t *) napt_table;
+  napt_entry_pool.block_size = sizeof(struct napt_entry);
+  napt_entry_pool.blocks = max_entries;
+  mem_pool_init(&napt_entry_pool);
+  napt_lru_head = napt_lru_tail = NAPT_ENTRY_NONE;
+  napt_outage = false;
+  napt_stats.nr_active_napt_tcp = napt_stats.nr_active_napt_udp = napt_stats.nr_active_napt_icmp = 0;
+  client_stats_napt_reset();
+
+  napt_clock_us = system_get_time();
+  return true;
+}
@@ -0,0 +1,76 @@
+// napt_chksum.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: This class implements the incremental update of the internet
+// checksum (cf. RFC 1624) used by the NAPT-engine to rewrite addresses, ports
+// and ICMP-identifiers. Instead of summing up the whole packet again, only the
+// difference between the old and the new value of the rewritten fields is
+// added to the existing checksum:
+//
+//  HC' = ~(~HC + ~m + m')  (RFC 1624, eqn. 3)
+//
+// The difference (~m + m') is accumulated by napt_chksum_delta and can be
+// applied to several checksums by napt_chksum_apply, e.g. the difference of the
+// address to the IP-header-checksum as well as to the checksum of the
+// transport layer (pseudo-header). The result is independent of the length of
+// the packet.
+//
+// napt_chksum_valid verifies a complete checksum, e.g. the IP-header-checksum
+// of the packets, that bypass the checks of lwip (cf. napt_netif.c).
+//
+// All fields are processed as a sequence of 16 bit words in network byte order,
+// so the class doesn't depend on the endianness of the host.
+
+#include "c_types.h"
+#include "napt_chksum.h"
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+uint32_t napt_chksum_delta(uint32_t delta, const uint8_t *optr, const uint8_t *nptr, uint8_t len);
+void napt_chksum_apply(uint8_t *chksum, uint32_t delta);
+bool napt_chksum_valid(const uint8_t *data, uint16_t len);
+
+/*------------------------------------*/
+
+// Add the difference between the field optr and its replacement nptr (both len
+// bytes, len even) to the given delta; the delta starts with 0
+uint32_t ICACHE_FLASH_ATTR napt_chksum_delta(uint32_t delta, const uint8_t *optr, const uint8_t *nptr, uint8_t len) {
+  uint8_t idx;
+
+  for (idx = 0; idx < len; idx += 2) {
+    delta += (~((optr[idx] << 8) | optr[idx+1]) & 0xFFFF) + ((nptr[idx] << 8) | nptr[idx+1]);
+  }
+  return delta;
+}
+
+// Apply the given delta to the checksum (in network byte order)
+void ICACHE_FLASH_ATTR napt_chksum_apply(uint8_t *chksum, uint32_t delta) {
+  uint32_t x = (~((chksum[0] << 8) | chksum[1]) & 0xFFFF) + delta;
+
+  // Fold the carries back into the lower 16 bit (end-around carry)
+  x = (x & 0xFFFF) + (x >> 16);
+  x = (x & 0xFFFF) + (x >> 16);
+  x = ~x & 0xFFFF;
+  chksum[0] = x >> 8;
+  chksum[1] = x & 0xFF;
+}
+
+// Check the checksum contained in data (len bytes, len even): the one's
+// complement sum over all words including the checksum has to be 0xFFFF
+bool ICACHE_FLASH_ATTR napt_chksum_valid(const uint8_t *data, uint16_t len) {
+  uint32_t sum = 0;
+  uint16_t idx;
+
+  for (idx = 0; idx < len; idx += 2) {
+    sum += (data[idx] << 8) | data[idx+1];
+  }
+  sum = (sum & 0xFFFF) + (sum >> 16);
+  sum = (sum & 0xFFFF) + (sum >> 16);
+  return sum == 0xFFFF;
+}
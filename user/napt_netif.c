@@ -0,0 +1,529 @@
+// napt_netif.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: This class connects the NAPT-engine (cf. napt.c) to the network
+// interfaces of the ESP8266. Therefore, the input-functions of the station and
+// the soft access-point network interface are replaced by a hook, which
+// translates the received IPv4-packets in place before handing them to the
+// original input-function.
+//
+// Translated packets are forwarded by a fast path, which bypasses ip_input resp.
+// ip_forward of lwip: the TTL is decremented in the received pbuf, the ethernet-
+// header is stripped and the pbuf is handed directly to etharp_output of the
+// other network interface, which prepends the new ethernet-header in the same
+// space. Hence, the packet is neither copied nor reallocated. Packets, which
+// the fast path can't handle (chained pbufs, expiring TTL, oversized packets),
+// are passed on to lwip, which does the forwarding then. The time spent on
+// translated packets is recorded in the statistics of the engine, their size
+// in the counters of the client of the soft access-point (cf. client_stats.c).
+// The packets, that the fast path forwards to the station network interface,
+// are queued by the scheduler of the uplink (cf. uplink_sched.c).
+//
+// Packets of established flows are translated by the flow cache (cf.
+// flow_cache.c) instead of the NAPT-engine, which also provides their next hop
+// and its MAC-address; the packets, that miss the cache, insert their flow
+// with the translation entry and the next hop resolved for their own
+// forwarding.
+//
+// On a mesh-node, the packets of its own and the downstream networks are
+// forwarded to resp. from the upstream router by the fast path without
+// translation (cf. mesh.c); the packets to the networks of downstream routers
+// are sent to the respective router, also the ones received on the soft
+// access-point network interface (without translation as well).
+//
+// Optionally, the received IPv4-packets are processed in batches of up to
+// NAPT_BATCH_SIZE frames (cf. napt_netif_set_batch): the hook only collects
+// them and a batch is processed, once it's complete resp. by a task, that the
+// SDK executes after the current callback (so an incomplete batch doesn't
+// wait for further frames). All frames of a batch are translated first and
+// forwarded in a second pass, in which the next hop of each output interface
+// is resolved only once via the ARP-table and the ethernet-header is rewritten
+// in place, so that etharp_output isn't called per packet.
+//
+// Annotation: The NAPT-implementation contained in liblwip.a is not enabled
+// anymore (ip_napt_enable isn't called), so that only the packets matching a
+// translation entry of this engine are forwarded between the interfaces.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "netif/etharp.h"
+#include "napt.h"
+#include "napt_chksum.h"
+#include "napt_netif.h"
+#include "client_stats.h"
+#include "flow_cache.h"
+#include "uplink_sched.h"
+#include "mesh.h"
+#define LOG_MODULE LOG_MODULE_NAPT
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Provided by the SDK (cf. netif/wlan_lwip_if.h)
+struct netif *eagle_lwip_getif(uint8_t index);
+
+/*------------------------------------*/
+
+#define NAPT_NETIF_BATCH_MAX 16                 // Maximum size of a batch
+#define NAPT_NETIF_TASK_PRIO USER_TASK_PRIO_2   // Task processing incomplete batches
+
+/*------------------------------------*/
+
+// Received frame waiting for the processing of its batch
+struct napt_netif_frame {
+  struct pbuf *p;
+  uint8_t if_idx;
+};
+
+// Flow of a packet, that missed the flow cache, and its translation entry (cf.
+// flow_cache_insert)
+struct napt_netif_miss {
+  struct flow_cache_key key;
+  struct napt_entry *entry;
+};
+
+// Next hop and its MAC-address per output interface (indexed by STATION_IF
+// resp. SOFTAP_IF), which are reused for all frames of a batch
+struct napt_netif_arp {
+  uint32_t nexthop[2];  // 0, if not resolved yet
+  struct eth_addr ethaddr[2];
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static bool napt_netif_valid(const struct pbuf *p);
+static napt_verdict napt_netif_translate(struct pbuf *p, uint8_t if_idx, struct client_stats **client, uint32_t *downstream, struct flow_cache_entry **flow, struct napt_netif_miss *miss);
+static bool napt_netif_resolve(struct napt_netif_arp *arp, uint8_t out_idx, ip_addr_t *nexthop);
+static bool napt_netif_forward(struct pbuf *p, uint8_t if_idx, const struct client_stats *client, uint32_t downstream, struct napt_netif_arp *arp, struct flow_cache_entry *flow, const struct napt_netif_miss *miss);
+static void napt_netif_process(void);
+
+// Callback-functions:
+static err_t napt_netif_input(struct pbuf *p, struct netif *inp);
+static void napt_netif_task(os_event_t *evt);
+
+// Initialization and configuration resp. termination:
+void napt_netif_set_fastpath(bool enable);
+void napt_netif_set_batch(uint8_t size);
+void napt_netif_detach(void);
+bool napt_netif_attach(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct netif *napt_netifs[2] = {NULL, NULL}; // Indexed by STATION_IF resp. SOFTAP_IF
+static netif_input_fn napt_netif_orig_input[2] = {NULL, NULL};
+static bool napt_netif_fastpath = NAPT_FASTPATH;
+
+static struct napt_netif_frame napt_netif_batch[NAPT_NETIF_BATCH_MAX];
+static uint8_t napt_netif_batch_size = NAPT_BATCH_SIZE;
+static uint8_t napt_netif_batch_count = 0;
+static bool napt_netif_task_posted = false;
+static bool napt_netif_task_registered = false;
+static os_event_t napt_netif_task_queue[1];
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Check the IPv4-header of a received frame like ip_input would: version,
+// header length, total length (within the received data) and checksum
+static bool ICACHE_FLASH_ATTR napt_netif_valid(const struct pbuf *p) {
+  const uint8_t *iphdr = (const uint8_t *) p->payload + SIZEOF_ETH_HDR;
+  uint16_t len = p->len - SIZEOF_ETH_HDR, hlen, tot_len;
+
+  if (len < 20 || (iphdr[0] >> 4) != 4) {
+    return false;
+  }
+  hlen = (iphdr[0] & 0x0F) * 4;
+  tot_len = (iphdr[2] << 8) | iphdr[3];
+  return hlen >= 20 && hlen <= len && tot_len >= hlen && tot_len <= p->tot_len - SIZEOF_ETH_HDR && napt_chksum_valid(iphdr, hlen);
+}
+
+// Translate an IPv4-packet, that has been received on the network interface
+// if_idx, in place and account it to its client (returned in client for
+// packets from the clients, NULL otherwise); the downstream router, that the
+// packet is sent to, is returned in downstream (0, if none; cf. mesh.c), the
+// cached flow of the packet in flow, resp. its key and translation entry in
+// miss on a miss
+static napt_verdict ICACHE_FLASH_ATTR napt_netif_translate(struct pbuf *p, uint8_t if_idx, struct client_stats **client, uint32_t *downstream, struct flow_cache_entry **flow, struct napt_netif_miss *miss) {
+  struct eth_hdr *ethhdr = (struct eth_hdr *) p->payload;
+  uint8_t *iphdr = (uint8_t *) p->payload + SIZEOF_ETH_HDR;
+  uint32_t ext_addr = napt_netifs[STATION_IF]->ip_addr.addr, addr = 0, source = 0;
+  napt_verdict verdict;
+  bool routed;
+
+  *client = NULL;
+  *downstream = 0;
+  *flow = NULL;
+  miss->key.proto = 0;
+  miss->entry = NULL;
+
+  // The fast path bypasses the checks of ip_input, so invalid packets are left
+  // to lwip, which drops them
+  if (!napt_netif_valid(p)) {
+    return NAPT_PASS;
+  }
+
+  // The route to the destination of outbound packets is looked up first: the
+  // packets to the networks of downstream routers are sent back down without
+  // translation (cf. mesh_lateral_lookup). Otherwise, the route to the source
+  // of outbound resp. the destination of inbound packets is looked up once for
+  // the mesh-routing, the accounting and the next hop.
+  if (if_idx == SOFTAP_IF) {
+    *downstream = mesh_lateral_lookup(iphdr, p->len - SIZEOF_ETH_HDR);
+    os_memcpy(&addr, iphdr + 12, 4);
+    source = mesh_route_lookup(addr);
+  }
+  else {
+    os_memcpy(&addr, iphdr + 16, 4);
+    *downstream = mesh_route_lookup(addr);
+  }
+
+  // Packets, that are routed to resp. from the upstream router resp. to the
+  // downstream routers without translation (cf. mesh.c), are neither cached
+  // nor translated
+  routed = (if_idx == SOFTAP_IF && *downstream) || mesh_is_routed(if_idx, iphdr, p->len - SIZEOF_ETH_HDR, ext_addr, (if_idx == SOFTAP_IF) ? source : *downstream);
+  if (!routed) {
+    *flow = flow_cache_lookup(if_idx, iphdr, p->len - SIZEOF_ETH_HDR, &miss->key);
+  }
+
+  // Account the packet to the client (the source address of outbound packets
+  // is translated, the destination address of inbound packets is restored by
+  // the translation); the packets of the networks of downstream routers are
+  // accounted to the router, that they are sent by resp. to
+  if (if_idx == SOFTAP_IF) {
+    *client = client_stats_get((source) ? source : addr, ethhdr->src.addr);
+    if (routed) {
+      verdict = NAPT_FORWARD;
+    }
+    else if (*flow) {
+      flow_cache_apply(*flow, iphdr);
+      napt_flow_hit((*flow)->entry, NAPT_DIR_OUT, iphdr);
+      verdict = NAPT_FORWARD;
+    }
+    else {
+      verdict = napt_outbound(iphdr, p->len - SIZEOF_ETH_HDR, ext_addr);
+      miss->entry = napt_translated_entry();
+    }
+    if (verdict == NAPT_FORWARD) {
+      client_stats_record(*client, NAPT_DIR_OUT, (iphdr[2] << 8) | iphdr[3]);
+    }
+  }
+  else {
+    if (routed) {
+      verdict = NAPT_FORWARD;
+    }
+    else if (*flow) {
+      flow_cache_apply(*flow, iphdr);
+      napt_flow_hit((*flow)->entry, NAPT_DIR_IN, iphdr);
+      verdict = NAPT_FORWARD;
+    }
+    else {
+      verdict = napt_inbound(iphdr, p->len - SIZEOF_ETH_HDR, ext_addr);
+      miss->entry = napt_translated_entry();
+    }
+    if (verdict == NAPT_FORWARD) {
+      // The destination of translated packets has been restored
+      if (!routed) {
+        os_memcpy(&addr, iphdr + 16, 4);
+        *downstream = mesh_route_lookup(addr);
+      }
+      client_stats_record(client_stats_get((*downstream) ? *downstream : addr, NULL), NAPT_DIR_IN, (iphdr[2] << 8) | iphdr[3]);
+    }
+  }
+  return verdict;
+}
+
+// Look up the MAC-address of the next hop on the output interface out_idx in
+// the ARP-table, unless it has been resolved for a previous frame of the
+// batch already; returns false, if it isn't known (yet)
+static bool ICACHE_FLASH_ATTR napt_netif_resolve(struct napt_netif_arp *arp, uint8_t out_idx, ip_addr_t *nexthop) {
+  struct eth_addr *ethaddr;
+  ip_addr_t *ipaddr;
+
+  if (arp->nexthop[out_idx] == nexthop->addr) {
+    return true;
+  }
+  if (etharp_find_addr(napt_netifs[out_idx], nexthop, &ethaddr, &ipaddr) < 0) {
+    return false;
+  }
+  arp->nexthop[out_idx] = nexthop->addr;
+  os_memcpy(&arp->ethaddr[out_idx], ethaddr, ETHARP_HWADDR_LEN);
+  return true;
+}
+
+// Forward a translated packet, that has been received on the network interface
+// if_idx from the given client (NULL for packets to the clients), directly to
+// the other network interface resp. to the downstream router (downstream as
+// returned by napt_netif_translate, also for packets received on the soft
+// access-point network interface; within a batch, the next hop is resolved
+// via arp; NULL otherwise); the next hop of a cached flow is taken from it, the
+// flow of a packet, that missed the cache (cf. miss), is inserted.
+// Returns false, if the packet has to be forwarded by lwip instead (the pbuf
+// is untouched then).
+static bool ICACHE_FLASH_ATTR napt_netif_forward(struct pbuf *p, uint8_t if_idx, const struct client_stats *client, uint32_t downstream, struct napt_netif_arp *arp, struct flow_cache_entry *flow, const struct napt_netif_miss *miss) {
+  uint8_t *iphdr = (uint8_t *) p->payload + SIZEOF_ETH_HDR, ttl_proto[2];
+  uint8_t out_idx = (if_idx == SOFTAP_IF && !downstream) ? STATION_IF : SOFTAP_IF;
+  struct netif *outp = napt_netifs[out_idx];
+  struct eth_addr *ethaddr = NULL, *eth_ret;
+  struct eth_hdr *ethhdr;
+  ip_addr_t dest, nexthop, *ip_ret;
+
+  if (!napt_netif_fastpath || p->next || !outp || iphdr[8] <= 1 || p->len - SIZEOF_ETH_HDR > outp->mtu) {
+    return false;
+  }
+
+  // Next hop: packets to other networks than the one of the station network
+  // interface are sent to its gateway, packets to the networks of downstream
+  // routers to the respective router (cf. mesh.c)
+  os_memcpy(&dest.addr, iphdr + 16, 4);
+  if (flow) {
+    nexthop.addr = flow->nexthop;
+  }
+  else if (outp == napt_netifs[STATION_IF] && !ip_addr_netcmp(&dest, &outp->ip_addr, &outp->netmask)) {
+    nexthop = outp->gw;
+  }
+  else {
+    nexthop.addr = (outp == napt_netifs[SOFTAP_IF]) ? downstream : 0;
+    if (!nexthop.addr) {
+      nexthop = dest;
+    }
+  }
+  if (!nexthop.addr) {
+    return false;
+  }
+
+  // The flow of a packet, that missed the cache, is cached together with the
+  // next hop, once it has been resolved by the ARP-table; the packet itself is
+  // sent to the resolved MAC-address as well
+  if (!flow && miss->key.proto && etharp_find_addr(outp, &nexthop, &eth_ret, &ip_ret) >= 0) {
+    ethaddr = eth_ret;
+    flow = flow_cache_insert(&miss->key, miss->entry, iphdr, nexthop.addr, eth_ret->addr);
+  }
+
+  // Decrement the TTL and update the IP-header-checksum incrementally
+  ttl_proto[0] = iphdr[8] - 1;
+  ttl_proto[1] = iphdr[9];
+  napt_chksum_apply(iphdr + 10, napt_chksum_delta(0, iphdr + 8, ttl_proto, 2));
+  iphdr[8] = ttl_proto[0];
+
+  // etharp_output prepends the ethernet-header in place again (resp. queues the
+  // pbuf until the address is resolved, taking a reference of its own); the
+  // packets to the station network interface are sent by the scheduler
+  pbuf_header(p, -SIZEOF_ETH_HDR);
+  if (out_idx == STATION_IF && uplink_sched_enqueue(p, outp, nexthop.addr, client)) {
+    return true;
+  }
+
+  // For cached flows, resolved misses and within a batch, only the MAC-
+  // addresses of the received ethernet-header are replaced, if the next hop is
+  // known; etharp_output handles the others
+  if (flow) {
+    ethaddr = (struct eth_addr *) flow->mac;
+  }
+  else if (!ethaddr && arp && napt_netif_resolve(arp, out_idx, &nexthop)) {
+    ethaddr = &arp->ethaddr[out_idx];
+  }
+  if (ethaddr) {
+    pbuf_header(p, SIZEOF_ETH_HDR);
+    ethhdr = (struct eth_hdr *) p->payload;
+    os_memcpy(&ethhdr->dest, ethaddr, ETHARP_HWADDR_LEN);
+    os_memcpy(&ethhdr->src, outp->hwaddr, ETHARP_HWADDR_LEN);
+    outp->linkoutput(outp, p);
+  }
+  else {
+    etharp_output(outp, p, &nexthop);
+  }
+  pbuf_free(p);
+  return true;
+}
+
+// Process the collected batch of frames: translate all of them first, then
+// forward them in one pass; the forwarding latency of the batch is shared
+// equally by its packets
+static void ICACHE_FLASH_ATTR napt_netif_process(void) {
+  napt_verdict verdicts[NAPT_NETIF_BATCH_MAX];
+  struct client_stats *clients[NAPT_NETIF_BATCH_MAX];
+  uint32_t downstreams[NAPT_NETIF_BATCH_MAX];
+  struct flow_cache_entry *flows[NAPT_NETIF_BATCH_MAX];
+  struct napt_netif_miss misses[NAPT_NETIF_BATCH_MAX];
+  bool fastpath[NAPT_NETIF_BATCH_MAX];
+  struct napt_netif_frame *frame;
+  struct napt_netif_arp arp;
+  uint32_t ccount = napt_ccount(), cycles;
+  uint8_t count = napt_netif_batch_count, idx, forwarded = 0;
+
+  napt_netif_batch_count = 0;
+  for (idx = 0; idx < count; idx++) {
+    frame = &napt_netif_batch[idx];
+    verdicts[idx] = (napt_netifs[frame->if_idx] && napt_netifs[STATION_IF]) ? napt_netif_translate(frame->p, frame->if_idx, &clients[idx], &downstreams[idx], &flows[idx], &misses[idx]) : NAPT_DROP;
+  }
+
+  arp.nexthop[STATION_IF] = arp.nexthop[SOFTAP_IF] = 0;
+  for (idx = 0; idx < count; idx++) {
+    frame = &napt_netif_batch[idx];
+    fastpath[idx] = false;
+    if (verdicts[idx] == NAPT_DROP) {
+      pbuf_free(frame->p);
+      continue;
+    }
+    if (verdicts[idx] == NAPT_FORWARD) {
+      forwarded++;
+      if (napt_netif_forward(frame->p, frame->if_idx, clients[idx], downstreams[idx], &arp, flows[idx], &misses[idx])) {
+        fastpath[idx] = true;
+        continue;
+      }
+    }
+    napt_netif_orig_input[frame->if_idx](frame->p, napt_netifs[frame->if_idx]);
+  }
+
+  if (!forwarded) {
+    return;
+  }
+  cycles = (napt_ccount() - ccount) / forwarded;
+  for (idx = 0; idx < count; idx++) {
+    if (verdicts[idx] == NAPT_FORWARD) {
+      napt_stats_record_forward(cycles, fastpath[idx]);
+    }
+  }
+}
+
+/*------------------------------------*/
+
+// Callback-functions:
+
+// Input-hook of both network interfaces; translate IPv4-packets in place and
+// pass them on to the original input-function (resp. collect them for the
+// next batch)
+static err_t ICACHE_FLASH_ATTR napt_netif_input(struct pbuf *p, struct netif *inp) {
+  uint8_t if_idx = (inp == napt_netifs[SOFTAP_IF]) ? SOFTAP_IF : STATION_IF;
+  struct eth_hdr *ethhdr = (struct eth_hdr *) p->payload;
+  napt_verdict verdict = NAPT_PASS;
+  struct client_stats *client = NULL;
+  struct flow_cache_entry *flow = NULL;
+  struct napt_netif_miss miss;
+  uint32_t ccount = napt_ccount(), downstream = 0;
+  err_t err;
+
+  if (p->len > SIZEOF_ETH_HDR && ethhdr->type == PP_HTONS(ETHTYPE_IP)) {
+    if (napt_netif_batch_size > 1) {
+      napt_netif_batch[napt_netif_batch_count].p = p;
+      napt_netif_batch[napt_netif_batch_count].if_idx = if_idx;
+      napt_netif_batch_count++;
+      if (napt_netif_batch_count >= napt_netif_batch_size) {
+        napt_netif_process();
+      }
+      else if (!napt_netif_task_posted) {
+        napt_netif_task_posted = system_os_post(NAPT_NETIF_TASK_PRIO, 0, 0);
+      }
+      return ERR_OK;
+    }
+    verdict = (napt_netifs[STATION_IF]) ? napt_netif_translate(p, if_idx, &client, &downstream, &flow, &miss) : NAPT_DROP;
+  }
+
+  if (verdict == NAPT_DROP) {
+    pbuf_free(p);
+    return ERR_OK;
+  }
+  if (verdict == NAPT_FORWARD && napt_netif_forward(p, if_idx, client, downstream, NULL, flow, &miss)) {
+    napt_stats_record_forward(napt_ccount() - ccount, true);
+    return ERR_OK;
+  }
+  err = napt_netif_orig_input[if_idx](p, inp);
+
+  // The input-function of lwip forwards the packet synchronously, so this
+  // covers the whole forwarding path of translated packets
+  if (verdict == NAPT_FORWARD) {
+    napt_stats_record_forward(napt_ccount() - ccount, false);
+  }
+  return err;
+}
+
+// Task processing an incomplete batch after the callbacks of the SDK, which
+// delivered its frames
+static void ICACHE_FLASH_ATTR napt_netif_task(os_event_t *evt) {
+  napt_netif_task_posted = false;
+  if (napt_netif_batch_count) {
+    napt_netif_process();
+  }
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration resp. termination:
+
+// Enable resp. disable the fast path for translated packets (if disabled, lwip
+// forwards them)
+void ICACHE_FLASH_ATTR napt_netif_set_fastpath(bool enable) {
+  napt_netif_fastpath = enable;
+}
+
+// Set the number of frames processed per batch (1 disables the batching; at
+// most NAPT_NETIF_BATCH_MAX); the frames collected so far are processed at
+// once
+void ICACHE_FLASH_ATTR napt_netif_set_batch(uint8_t size) {
+  if (napt_netif_batch_count) {
+    napt_netif_process();
+  }
+  napt_netif_batch_size = (size < 1) ? 1 : (size > NAPT_NETIF_BATCH_MAX) ? NAPT_NETIF_BATCH_MAX : size;
+}
+
+// Restore the original input-functions of the network interfaces (the packets
+// of an incomplete batch and the ones queued for the station network interface
+// are dropped)
+void ICACHE_FLASH_ATTR napt_netif_detach(void) {
+  uint8_t if_idx;
+
+  while (napt_netif_batch_count) {
+    pbuf_free(napt_netif_batch[--napt_netif_batch_count].p);
+  }
+  uplink_sched_flush();
+  flow_cache_flush();
+
+  for (if_idx = STATION_IF; if_idx <= SOFTAP_IF; if_idx++) {
+    if (napt_netifs[if_idx] && napt_netifs[if_idx]->input == napt_netif_input) {
+      napt_netifs[if_idx]->input = napt_netif_orig_input[if_idx];
+    }
+    napt_netifs[if_idx] = NULL;
+  }
+}
+
+// Install the input-hook on the station and the soft access-point network
+// interface (both have to be up already)
+bool ICACHE_FLASH_ATTR napt_netif_attach(void) {
+  uint8_t if_idx;
+  struct netif *nif;
+
+  if (!napt_netif_task_registered) {
+    napt_netif_task_registered = system_os_task(napt_netif_task, NAPT_NETIF_TASK_PRIO, napt_netif_task_queue, 1);
+  }
+
+  for (if_idx = STATION_IF; if_idx <= SOFTAP_IF; if_idx++) {
+    nif = eagle_lwip_getif(if_idx);
+    if (!nif) {
+      LOG_ERROR("napt_netif_attach: Network interface %d isn't available!\n", if_idx);
+      napt_netif_detach();
+      return false;
+    }
+    // The interfaces are re-created by the SDK on changes of the operation-
+    // mode, so only hook interfaces, that haven't been hooked yet
+    if (nif->input != napt_netif_input) {
+      napt_netif_orig_input[if_idx] = nif->input;
+      nif->input = napt_netif_input;
+    }
+    napt_netifs[if_idx] = nif;
+  }
+  return true;
+}
@@ -8,12 +8,33 @@
 // a NAPT (Network Address and Port Translation) router. It handles the
 // configuration and initialization of the different network interfaces as well
 // as of the DNS- and DHCP-server. Furthermore, the class adds the possibility
-// to pre-define up to eight portmap entries in user_config.h, which are then
-// automatically loaded when the router is enabled.
+// to pre-define portmap entries in the configuration (cf. config.c), which are
+// then automatically loaded when the router is enabled. The settings of the
+// soft access-point, its network and the rates of the uplink (cf.
+// uplink_sched.c) are taken from the configuration as well. The translation
+// itself is done by the NAPT-engine in napt.c.
+//
+// With ROUTER_HITLESS_RECONNECT, a disconnection of the station network
+// interface doesn't affect the clients of the soft access-point: the soft
+// access-point, the DHCP-server and the NAPT-table are kept, the expiry of the
+// translations is suspended and, on the reconnect, only the external address
+// of the translations is updated.
+//
+// The router reports, when it's set up on resp. disconnected from the host
+// access-point, to the lifecycle state machine (cf. lifecycle.c).
+//
+// The associations of stations with the soft access-point are passed on to the
+// traffic accounting per client (cf. client_stats.c).
+//
+// Routers can be chained: a mesh-node (cf. mesh in config.c) advertises its
+// routes to the upstream router and installs the routes advertised by the
+// mesh-nodes on its soft access-point's network, so that only the topmost
+// router translates the packets (cf. mesh.c).
 //
 /******************************************************************************/
 // ATTENTION: This class relies on NeoCat's patch for the original lwip library
-// (cf. https://github.com/NeoCat/esp8266-Arduino/commit/4108c8dbced7769c75bcbb9ed880f1d3f178bcbe).
+// (cf. https://github.com/NeoCat/esp8266-Arduino/commit/4108c8dbced7769c75bcbb9ed880f1d3f178bcbe)
+// for forwarding packets between the network interfaces.
 /******************************************************************************/
 
 #include "c_types.h"
@@ -25,8 +46,19 @@
 #include "user_interface.h"
 #include "lwip/err.h"
 #include "lwip/dns.h"
-#include "lwip/lwip_napt.h"
+#include "napt.h"
+#include "napt_netif.h"
+#include "dns_proxy.h"
+#include "dhcp_server.h"
+#include "client_stats.h"
+#include "flow_cache.h"
+#include "uplink_sched.h"
+#include "lifecycle.h"
 #include "router.h"
+#include "config.h"
+#include "mesh.h"
+#define LOG_MODULE LOG_MODULE_ROUTER
+#include "log.h"
 #include "user_config.h"
 
 /*------------------------------------*/
@@ -36,25 +68,33 @@
 
 // Status-functions:
 bool is_connected(void);
+uint32_t router_outage_time(void);
 
 // Callback-functions:
 static void wifi_handle_event_cb(System_Event_t *evt);
 
 // Network configuration:
-static void portmap_update(ip_addr_t *station_ip_addr);
+static void external_addr_update(ip_addr_t *station_ip_addr);
 static void dns_set(void);
 static bool softap_network_config(void);
 
 // Initialization and configuration:
 static bool softap_init(void);
 static bool portmap_init(void);
+static void uplink_init(void);
+void router_set_hitless_reconnect(bool enabled);
+bool router_get_hitless_reconnect(void);
 void router_init(void);
+void router_disable(void);
 
 /*------------------------------------*/
 
 // Declaration and initialization of variables:
 
 bool router_connected;
+static bool router_hitless = ROUTER_HITLESS_RECONNECT;
+static bool router_softap_up = false;   // Soft access-point has been set up
+static uint32_t router_disconnected_us = 0; // Time of the last disconnection
 
 /*------------------------------------*/
 
@@ -65,6 +105,12 @@ bool ICACHE_FLASH_ATTR is_connected(void) {
   return router_connected;
 }
 
+// Return the duration of the current disconnection of the station network
+// interface (in ms; 0, if it's connected)
+uint32_t ICACHE_FLASH_ATTR router_outage_time(void) {
+  return (router_connected) ? 0 : (system_get_time() - router_disconnected_us) / 1000;
+}
+
 /*------------------------------------*/
 
 // Callback-functions:
@@ -75,25 +121,46 @@ static void ICACHE_FLASH_ATTR wifi_handle_event_cb(System_Event_t *evt) {
   switch (evt->event) {
     // Successfully connected to the host access-point
     case EVENT_STAMODE_CONNECTED:
-      os_printf("wifi_handle_event_cb: Connected to %s (channel: %d)!\n", evt->event_info.connected.ssid, evt->event_info.connected.channel);
+      LOG_INFO("wifi_handle_event_cb: Connected to %.32s (channel: %d)!\n", evt->event_info.connected.ssid, evt->event_info.connected.channel);
       break;
     // Disconnected from the host access-point
     case EVENT_STAMODE_DISCONNECTED:
-      os_printf("wifi_handle_event_cb: Disconnected from %s (reason: %d)!\n", evt->event_info.disconnected.ssid, evt->event_info.disconnected.reason);
-      router_connected = false;
+      LOG_WARN("wifi_handle_event_cb: Disconnected from %.32s (reason: %d)!\n", evt->event_info.disconnected.ssid, evt->event_info.disconnected.reason);
+
+      // Suspend the expiry of the translations until the reconnect (the
+      // event is repeated for every failed attempt to reconnect)
+      if (router_connected) {
+        router_disconnected_us = system_get_time();
+        external_addr_update(NULL);
+        mesh_upstream_lost();
+        router_connected = false;
+        lifecycle_event(LIFECYCLE_EVENT_DISCONNECTED);
+      }
       break;
     // Authentication mode of the host access-point changed
     case EVENT_STAMODE_AUTHMODE_CHANGE:
-      os_printf("wifi_handle_event_cb: Authentication mode changed from %d to %d!\n", evt->event_info.auth_change.old_mode, evt->event_info.auth_change.new_mode);
+      LOG_DEBUG("wifi_handle_event_cb: Authentication mode changed from %d to %d!\n", evt->event_info.auth_change.old_mode, evt->event_info.auth_change.new_mode);
       break;
     // Received an IP-address from the host access-point
     case EVENT_STAMODE_GOT_IP:
-      os_printf("wifi_handle_event_cb: Got IP-address!\n");
-
-      os_printf("IP-address: " IPSTR "\nNetmask: " IPSTR "\nGateway: " IPSTR "\n", IP2STR(&evt->event_info.got_ip.ip), IP2STR(&evt->event_info.got_ip.mask), IP2STR(&evt->event_info.got_ip.gw));
-
-      // Update the mapping IP-address of the portmap table
-      portmap_update(&evt->event_info.got_ip.ip);
+      LOG_INFO("wifi_handle_event_cb: Got IP-address!\n");
+
+      LOG_INFO("IP-address: " IPSTR "\nNetmask: " IPSTR "\nGateway: " IPSTR "\n", IP2STR(&evt->event_info.got_ip.ip), IP2STR(&evt->event_info.got_ip.mask), IP2STR(&evt->event_info.got_ip.gw));
+
+      // Translate the connections to the new address
+      external_addr_update(&evt->event_info.got_ip.ip);
+
+      // Keep the soft access-point, the DHCP-server and the NAPT-table, if
+      // they have already been set up, so that the clients don't notice the
+      // reconnect
+      if (router_hitless && router_softap_up) {
+        LOG_INFO("wifi_handle_event_cb: Reconnected after %d ms!\n", router_outage_time());
+        dns_set();
+        mesh_advertise();
+        router_connected = true;
+        lifecycle_event(LIFECYCLE_EVENT_CONNECTED);
+        break;
+      }
 
       // Set the WiFi operation-mode to STATIONAP_MODE and enable the soft
       // access-point
@@ -101,23 +168,30 @@ static void ICACHE_FLASH_ATTR wifi_handle_event_cb(System_Event_t *evt) {
         // Set the defined network configuration  for the soft access-point and
         // the DHCP-server's lease range
         if (softap_network_config()) {
-          // Set the DNS-server to use
+          // Set the DNS-server to use and advertise the routes to the
+          // upstream router (mesh-nodes only)
           dns_set();
+          mesh_advertise();
 
           // If an error occures while setting up the soft access-point,
           // router_connected is not set to true, so that the router will be
-          // disabled by the watchdog-timer (cf. user_main.c).
+          // disabled after ROUTER_CONN_TIMEOUT (cf. lifecycle.c).
           router_connected = true;
+          router_softap_up = true;
+          lifecycle_event(LIFECYCLE_EVENT_CONNECTED);
         }
       }
       break;
     // Device connected to the soft access-point
     case EVENT_SOFTAPMODE_STACONNECTED:
-      os_printf("wifi_handle_event_cb: Station " MACSTR " connected (AID: %d)!\n", MAC2STR(evt->event_info.sta_connected.mac), evt->event_info.sta_connected.aid);
+      LOG_INFO("wifi_handle_event_cb: Station " MACSTR " connected (AID: %d)!\n", MAC2STR(evt->event_info.sta_connected.mac), evt->event_info.sta_connected.aid);
+      client_stats_connect(evt->event_info.sta_connected.mac, evt->event_info.sta_connected.aid, dhcp_server_lookup(evt->event_info.sta_connected.mac));
       break;
     //Device disconnect from the soft access-point
     case EVENT_SOFTAPMODE_STADISCONNECTED:
-      os_printf("wifi_handle_event_cb: Station " MACSTR " disconnected (AID: %d)!\n", MAC2STR(evt->event_info.sta_disconnected.mac), evt->event_info.sta_disconnected.aid);
+      LOG_INFO("wifi_handle_event_cb: Station " MACSTR " disconnected (AID: %d)!\n", MAC2STR(evt->event_info.sta_disconnected.mac), evt->event_info.sta_disconnected.aid);
+      client_stats_disconnect(evt->event_info.sta_disconnected.mac);
+      flow_cache_flush();  // The address of the client may be reassigned
       break;
     default:
       break;
@@ -128,98 +202,107 @@ static void ICACHE_FLASH_ATTR wifi_handle_event_cb(System_Event_t *evt) {
 
 //Miscellaneous:
 
-// Update the mapping IP-address of the portmap table (e.g. if a new IP-address
-// for the station network interface is received from the DHCP-server of the
-// host router)
-// Annotation: ip_portmap_table is defined in lwip_napt.h
-static void ICACHE_FLASH_ATTR portmap_update(ip_addr_t *station_ip_addr) {
+// Update the external address of the translations and the portmap table (e.g.
+// if a new IP-address for the station network interface is received from the
+// DHCP-server of the host router); NULL marks the disconnection of the station
+// network interface (cf. napt_external_update)
+static void ICACHE_FLASH_ATTR external_addr_update(ip_addr_t *station_ip_addr) {
   if (!station_ip_addr) {
-    os_printf("portmap_update: Invalid transfer parameter!\n");
-    return;
-  }
-  if (!ip_portmap_table) {
-    os_printf("portmap_update: Please initialize ip_portmap_table first!\n");
+    LOG_WARN("external_addr_update: Suspending the translations!\n");
+    napt_external_update(0);
     return;
   }
 
-  os_printf("portmap_update: Updating portmap!\n");
+  LOG_INFO("external_addr_update: Updating the translations and the portmap!\n");
 
-  uint16_t idx = 0;
-
-  for (idx = 0; idx < IP_PORTMAP_MAX; idx++) {
-    if(ip_portmap_table[idx].valid) {
-      ip_portmap_table[idx].maddr = (*station_ip_addr).addr;
-    }
-  }
+  napt_external_update(station_ip_addr->addr);
 }
 
-// Set the DNS-server to use
+// Set the DNS-server to use; with DNS_PROXY, the clients are handed the
+// router's own address and their queries are forwarded to the DNS-server by the
+// DNS-proxy (cf. dns_proxy.c)
 static void ICACHE_FLASH_ATTR dns_set(void) {
-  os_printf("dns_set: Setting the DNS-server!\n");
+  LOG_INFO("dns_set: Setting the DNS-server!\n");
 
   ip_addr_t dns_server_ip;
+  struct ip_info softap_info;
 
   // Check, if a static server has been defined
-  if (DNS_SERVER_IP) {
+  if (config_get()->dns_server) {
     // Set the defined address
-    dns_server_ip.addr = ipaddr_addr(DNS_SERVER_IP);
+    dns_server_ip.addr = config_get()->dns_server;
   }
   else {
     // Set Google's DNS-server as default, if no other source has been defined
     IP4_ADDR(&dns_server_ip, 8, 8, 8, 8);
   }
-  dhcps_set_DNS((struct ip_addr *) &dns_server_ip);
 
-  os_printf("DNS-server: " IPSTR "\n", IP2STR(&dns_server_ip));
+  // Fall back to handing the DNS-server to the clients directly, if the proxy
+  // can't be enabled
+  if (DNS_PROXY && dns_proxy_enable(dns_server_ip.addr) && wifi_get_ip_info(SOFTAP_IF, &softap_info)) {
+    dhcp_server_set_dns(softap_info.ip.addr);
+    LOG_INFO("DNS-server: " IPSTR " (proxy for " IPSTR ")\n", IP2STR(&softap_info.ip), IP2STR(&dns_server_ip));
+  }
+  else {
+    dhcp_server_set_dns(dns_server_ip.addr);
+    LOG_INFO("DNS-server: " IPSTR "\n", IP2STR(&dns_server_ip));
+  }
 }
 
-// Set the defined network configuration and the DHCP-server's lease range
+// Set the defined network configuration and start the DHCP-server (cf.
+// dhcp_server.c); the SDK's DHCP-server is disabled, since it forgets the
+// bindings of the clients whenever it's restarted
 static bool ICACHE_FLASH_ATTR softap_network_config(void) {
-  os_printf("softap_network_config: Setting the defined network configuration and the DHCP-server's lease range!\n");
+  LOG_INFO("softap_network_config: Setting the defined network configuration and starting the DHCP-server!\n");
 
+  const struct config *config = config_get();
   struct ip_info softap_info;
-  struct dhcps_lease dhcp_lease;
 
-  // Stop the DHCP-server before setting the defined network configuration as
-  // well as the DHCP-server's lease range and enable NAPT for the soft access-
-  // point network interface
+  // Stop the SDK's DHCP-server before setting the defined network
+  // configuration, start the router's own DHCP-server and enable NAPT for the
+  // soft access-point network interface
   if (wifi_softap_dhcps_stop()) {
     // Set the defined network configuration
-    softap_info.ip.addr = ipaddr_addr(WIFI_AP_NETWORK_ADDR);
-    ip4_addr4(&softap_info.ip) = 1; // The router will always have the address X.X.X.1!
-    softap_info.netmask.addr = ipaddr_addr(WIFI_AP_NETWORK_NETMASK);
-    softap_info.gw.addr = ipaddr_addr(WIFI_AP_NETWORK_GW);
+    softap_info.ip.addr = config->ap_addr;
+    softap_info.netmask.addr = config->ap_netmask;
+    softap_info.gw.addr = config->ap_gw;
     if (wifi_set_ip_info(SOFTAP_IF, &softap_info)) {
-      // Configure the DHCP-server's lease range
-      const	char*	start_ip	=	DHCP_START_ADDR;
-      const	char*	end_ip	=	DHCP_STOP_ADDR;
-      dhcp_lease.start_ip.addr = ipaddr_addr(start_ip);
-      dhcp_lease.end_ip.addr = ipaddr_addr(end_ip);
-      if (wifi_softap_set_dhcps_lease(&dhcp_lease)) {
-        // Re-enable the DHCP-server
-        if (wifi_softap_dhcps_start()) {
-          // Enable NAPT for the soft access-point network interface
-          ip_napt_enable(softap_info.ip.addr, 1);
-
-          // Allow broadcasts also in SOFTAP_MODE
-          wifi_set_broadcast_if(STATIONAP_MODE);
-
+      // Start the DHCP-server with the defined lease range (the bindings of
+      // the clients are kept, if it's already running)
+      if (dhcp_server_start(softap_info.ip.addr, softap_info.netmask.addr, config->dhcp_start, config->dhcp_stop)) {
+        // Allow broadcasts also in SOFTAP_MODE
+        wifi_set_broadcast_if(STATIONAP_MODE);
+
+        // Enable NAPT for the soft access-point's network and hook it into
+        // the network interfaces
+        if (napt_netif_attach()) {
+          napt_enable(softap_info.ip.addr, softap_info.netmask.addr);
+
+          // Accept the routes of downstream mesh-nodes resp. route the
+          // packets to the upstream router without translation (cf.
+          // mesh.c); the packets are translated, if this fails
+          if (!config->mesh) {
+            mesh_disable();
+          }
+          else if (!mesh_enable(softap_info.ip.addr, softap_info.netmask.addr, config->mesh_key)) {
+            LOG_ERROR("softap_network_config: Failed to enable the mesh-routing!\n");
+          }
           return true;
         }
         else {
-          os_printf("softap_network_config: Failed to re-enable the DHCP-server!\n");
+          LOG_ERROR("softap_network_config: Failed to enable NAPT!\n");
         }
       }
       else {
-        os_printf("softap_network_config: Failed to set the DHCP-server's lease range!\n");
+        LOG_ERROR("softap_network_config: Failed to start the DHCP-server!\n");
       }
     }
     else {
-      os_printf("softap_network_config: Failed to set the soft access-point's network configuration!\n");
+      LOG_ERROR("softap_network_config: Failed to set the soft access-point's network configuration!\n");
     }
   }
   else {
-    os_printf("softap_network_config: Failed to stop the DHCP-server!\n");
+    LOG_ERROR("softap_network_config: Failed to stop the SDK's DHCP-server!\n");
   }
   return false;
 }
@@ -230,141 +313,139 @@ static bool ICACHE_FLASH_ATTR softap_network_config(void) {
 
 // Set up and initialize the soft access-point network interface
 static bool ICACHE_FLASH_ATTR softap_init(void) {
-  os_printf("softap_init: Setting up and initializing the soft access-point network interface!\n");
+  LOG_INFO("softap_init: Setting up and initializing the soft access-point network interface!\n");
 
   // Check, if the correct WiFi operation-mode is enabled (SOFTAP_MODE or
   // STATIONAP_MODE)
   if (wifi_get_opmode() >= SOFTAP_MODE) {
+    const struct config *config = config_get();
     struct softap_config ap_conf;
     uint8_t softap_mac_addr[6];
 
     if (wifi_get_macaddr(SOFTAP_IF, softap_mac_addr)) {
       // Set up the soft access-point configuration
-      os_memset(ap_conf, 0, sizeof(struct softap_config));
-      os_sprintf(ap_conf.ssid, "%s_" MACSTR, WIFI_AP_SSID_PREFIX, MAC2STR(softap_mac_addr)); // Generate the access-point's actual (unique) SSID from SSID_PREFIX and the soft access-point's MAC-address
+      os_memset(&ap_conf, 0, sizeof(struct softap_config));
+      os_sprintf(ap_conf.ssid, "%.13s_" MACSTR, config->ssid_prefix, MAC2STR(softap_mac_addr)); // Generate the access-point's actual (unique) SSID from the SSID-prefix (at most 13 characters, cf. config.h) and the soft access-point's MAC-address
       ap_conf.ssid_len = os_strlen(ap_conf.ssid);
-      if (!WIFI_AP_OPEN) {  // Set the authentication mode to WPA/WPA2 as well as the corresponding password, if WIFI_AP_OPEN is set to 0
+      if (!config->ap_open) {  // Set the authentication mode to WPA/WPA2 as well as the corresponding password, if the access-point isn't open
         ap_conf.authmode = AUTH_WPA_WPA2_PSK;
-        os_sprintf(ap_conf.password, "%s", WIFI_AP_PASSWORD); // os_memcpy doesn't automatically add a NULL-termination to a string, that's actually a define, so use os_sprintf or copy WIFI_AP_PASSWORD to a char *
+        os_sprintf(ap_conf.password, "%s", config->password);
       }
-      else {  // Set the authentication mode to open, if WIFI_AP_OPEN is set to 1 (no authentication needed to connect to the router's access-point)
+      else {  // Set the authentication mode to open, if the access-point is open (no authentication needed to connect to the router's access-point)
         ap_conf.authmode = AUTH_OPEN;
       }
-      ap_conf.max_connection = MAX_CLIENTS;
-      ap_conf.ssid_hidden = WIFI_AP_HIDDEN;
+      ap_conf.max_connection = config->max_clients;
+      ap_conf.ssid_hidden = config->ap_hidden;
 
       // Initialize the soft access-point network interface
       if (wifi_softap_set_config(&ap_conf)) {
         return true;
       }
       else {
-        os_printf("softap_init: Failed to set the soft access-point configuration!\n");
+        LOG_ERROR("softap_init: Failed to set the soft access-point configuration!\n");
       }
     }
     else {
-      os_printf("softap_init: Failed to obtain the soft access-point's MAC-address!\n");
+      LOG_ERROR("softap_init: Failed to obtain the soft access-point's MAC-address!\n");
     }
   }
   else {
-    os_printf("softap_init: Wrong WiFi operation-mode!\n");
+    LOG_ERROR("softap_init: Wrong WiFi operation-mode!\n");
   }
   return false;
 }
 
-// Load the pre-defined portmap entries (cf. user_config.h)
-// Attention: Call portmap_update as soon as an IP-address is obtained on the
+// Load the pre-defined portmap entries (cf. config.c); the entries of a
+// previous activation are removed first, so that cleared resp. modified entries
+// of the configuration don't stay active
+// Attention: Call external_addr_update as soon as an IP-address is obtained on the
 // station network interface! The port mapping won't work otherwise!
 bool ICACHE_FLASH_ATTR portmap_init(void) {
-  os_printf("portmap_init: Loading the pre-defined portmap entries!\n");
+  LOG_INFO("portmap_init: Loading the pre-defined portmap entries!\n");
 
-  ip_addr_t daddr;
+  const struct config_portmap *portmap = config_get()->portmap;
+  uint16_t idx = 0;
 
-  if (PORTMAP_ENABLE_1) {
-    if (PORTMAP_PROTO_1 && PORTMAP_MPORT_1 && PORTMAP_DADDR_1 && PORTMAP_DPORT_1 && PORTMAP_DIR_1) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_1);
-      if (!ip_portmap_add(PORTMAP_PROTO_1, 0, PORTMAP_MPORT_1, daddr.addr, PORTMAP_DPORT_1, PORTMAP_DIR_1)) {
-        os_printf("portmap_init: Failed to set portmap entry 1!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_2) {
-    if (PORTMAP_PROTO_2 && PORTMAP_MPORT_2 && PORTMAP_DADDR_2 && PORTMAP_DPORT_2 && PORTMAP_DIR_2) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_2);
-      if (!ip_portmap_add(PORTMAP_PROTO_2, 0, PORTMAP_MPORT_2, daddr.addr, PORTMAP_DPORT_2, PORTMAP_DIR_2)) {
-        os_printf("portmap_init: Failed to set portmap entry 2!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_3) {
-    if (PORTMAP_PROTO_3 && PORTMAP_MPORT_3 && PORTMAP_DADDR_3 && PORTMAP_DPORT_3 && PORTMAP_DIR_3) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_3);
-      if (!ip_portmap_add(PORTMAP_PROTO_3, 0, PORTMAP_MPORT_3, daddr.addr, PORTMAP_DPORT_3, PORTMAP_DIR_3)) {
-        os_printf("portmap_init: Failed to set portmap entry 3!\n");
-        return false;
-      }
+  napt_portmap_clear();
+  for (idx = 0; idx < CONFIG_PORTMAPS_MAX; idx++) {
+    if (portmap[idx].proto && !napt_portmap_add(portmap[idx].proto, 0, portmap[idx].mport, portmap[idx].daddr, portmap[idx].dport, portmap[idx].dir)) {
+      LOG_ERROR("portmap_init: Failed to set portmap entry %d!\n", idx + 1);
+      return false;
     }
   }
-  if (PORTMAP_ENABLE_4) {
-    if (PORTMAP_PROTO_4 && PORTMAP_MPORT_4 && PORTMAP_DADDR_4 && PORTMAP_DPORT_4 && PORTMAP_DIR_4) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_4);
-      if (!ip_portmap_add(PORTMAP_PROTO_4, 0, PORTMAP_MPORT_4, daddr.addr, PORTMAP_DPORT_4, PORTMAP_DIR_4)) {
-        os_printf("portmap_init: Failed to set portmap entry 4!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_5) {
-    if (PORTMAP_PROTO_5 && PORTMAP_MPORT_5 && PORTMAP_DADDR_5 && PORTMAP_DPORT_5 && PORTMAP_DIR_5) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_5);
-      if (!ip_portmap_add(PORTMAP_PROTO_5, 0, PORTMAP_MPORT_5, daddr.addr, PORTMAP_DPORT_5, PORTMAP_DIR_5)) {
-        os_printf("portmap_init: Failed to set portmap entry 5!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_6) {
-    if (PORTMAP_PROTO_6 && PORTMAP_MPORT_6 && PORTMAP_DADDR_6 && PORTMAP_DPORT_6 && PORTMAP_DIR_6) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_6);
-      if (!ip_portmap_add(PORTMAP_PROTO_6, 0, PORTMAP_MPORT_6, daddr.addr, PORTMAP_DPORT_6, PORTMAP_DIR_6)) {
-        os_printf("portmap_init: Failed to set portmap entry 6!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_7) {
-    if (PORTMAP_PROTO_7 && PORTMAP_MPORT_7 && PORTMAP_DADDR_7 && PORTMAP_DPORT_7 && PORTMAP_DIR_7) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_7);
-      if (!ip_portmap_add(PORTMAP_PROTO_7, 0, PORTMAP_MPORT_7, daddr.addr, PORTMAP_DPORT_7, PORTMAP_DIR_7)) {
-        os_printf("portmap_init: Failed to set portmap entry 7!\n");
-        return false;
-      }
-    }
-  }
-  if (PORTMAP_ENABLE_8) {
-    if (PORTMAP_PROTO_8 && PORTMAP_MPORT_8 && PORTMAP_DADDR_8 && PORTMAP_DPORT_8 && PORTMAP_DIR_8) {
-      daddr.addr = ipaddr_addr(PORTMAP_DADDR_8);
-      if (!ip_portmap_add(PORTMAP_PROTO_8, 0, PORTMAP_MPORT_8, daddr.addr, PORTMAP_DPORT_8, PORTMAP_DIR_8)) {
-        os_printf("portmap_init: Failed to set portmap entry 8!\n");
-        return false;
-      }
+  return true;
+}
+
+// Apply the rates of the uplink's scheduler and of its clients (cf. config.c);
+// the packets still queued and the rate limits of a previous activation are
+// discarded first
+static void ICACHE_FLASH_ATTR uplink_init(void) {
+  const struct config *config = config_get();
+  uint8_t idx;
+
+  uplink_sched_flush();
+  uplink_sched_set_rate(config->uplink_rate);
+  uplink_sched_clear_client_rates();
+  for (idx = 0; idx < CONFIG_CLIENT_RATES_MAX; idx++) {
+    if (config->client_rate[idx].rate) {
+      uplink_sched_set_client_rate(config->client_rate[idx].mac, config->client_rate[idx].rate);
     }
   }
-  return true;
+}
+
+// Enable resp. disable the hitless reconnect (cf. ROUTER_HITLESS_RECONNECT)
+void ICACHE_FLASH_ATTR router_set_hitless_reconnect(bool enabled) {
+  router_hitless = enabled;
+}
+
+// Return, if the hitless reconnect is enabled
+bool ICACHE_FLASH_ATTR router_get_hitless_reconnect(void) {
+  return router_hitless;
 }
 
 // Initialize the router
 void ICACHE_FLASH_ATTR router_init() {
-  os_printf("router_init: Initializing the router!\n");
+  LOG_INFO("router_init: Initializing the router!\n");
 
   router_connected = false;
+  router_softap_up = false;
+  router_disconnected_us = system_get_time();
+  client_stats_init();
+
+  // Allocate the NAPT-table (discards the translation entries of a previous
+  // activation)
+  if (!napt_init(NAPT_TABLE_SIZE)) {
+    LOG_ERROR("router_init: Failed to allocate the NAPT-table!\n");
+  }
 
   // Load the pre-defined portmap entries
   if (!portmap_init()) {  // Don't abort the program, if there is an error while loading the pre-defined portmap entries since this only affects the availability of certain devices connected to the router and not the router functionaliy itself
-    os_printf("router_init: Error while loading the pre-defined portmap entries!\n");
+    LOG_ERROR("router_init: Error while loading the pre-defined portmap entries!\n");
+  }
+  uplink_init();
+
+  // Identify the station as mesh-node to the upstream router's DHCP-server,
+  // which is required for the advertisements to be accepted (cf. mesh.c)
+  if (config_get()->mesh && !wifi_station_set_hostname((char *) MESH_HOSTNAME)) {
+    LOG_ERROR("router_init: Failed to set the hostname of the station!\n");
   }
 
   // Set the WiFi-event-handler-function
   wifi_set_event_handler_cb(wifi_handle_event_cb);
 }
+
+// Stop the services of the router and unhook the NAPT from the network
+// interfaces (call before setting the operation-mode to NULL_MODE, which frees
+// the interfaces), so that the next router_init starts from a clean state
+void ICACHE_FLASH_ATTR router_disable(void) {
+  LOG_INFO("router_disable: Disabling the router!\n");
+
+  mesh_disable();
+  dns_proxy_disable();
+  dhcp_server_stop();
+  napt_disable();
+  napt_netif_detach();  // Discards the queued packets and the cached flows
+
+  router_connected = false;
+  router_softap_up = false;
+}
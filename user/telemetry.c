@@ -0,0 +1,216 @@
+// telemetry.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Compact binary telemetry of the router (cf. the wire format in
+// telemetry.h). A sample holds the uptime, the free heap, the occupancy of the
+// NAPT-table, the forwarded bytes/s per direction, the dropped packets and the
+// number of associated clients; the rates are computed over the time since
+// the previous committed sample. Several samples are encoded into one frame,
+// so that a single datagram carries the history of a broadcast interval (cf.
+// vital_sign_broadcast in device_info.c).
+//
+// The frames are built by storing the fields in network byte order; there's no
+// string formatting involved. telemetry_decode is the counterpart for
+// collectors (cf. host/telemetry_collect.c).
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "telemetry.h"
+#include "napt.h"
+#include "client_stats.h"
+#define LOG_MODULE LOG_MODULE_DEVICE_INFO
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static uint8_t *telemetry_put16(uint8_t *ptr, uint16_t val);
+static uint8_t *telemetry_put32(uint8_t *ptr, uint32_t val);
+static uint16_t telemetry_get16(const uint8_t *ptr);
+static uint32_t telemetry_get32(const uint8_t *ptr);
+static uint8_t telemetry_clients(void);
+
+// Sampling:
+void telemetry_sample_take(struct telemetry_sample *sample, bool commit);
+
+// Encoding and decoding:
+uint16_t telemetry_encode(uint8_t *buffer, uint16_t size, const struct telemetry_header *header, const struct telemetry_sample *samples);
+bool telemetry_decode(const uint8_t *buffer, uint16_t len, struct telemetry_header *header, struct telemetry_sample *samples, uint8_t max);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+// State of the last committed sample
+static uint32_t telemetry_time = 0;         // System time (in us)
+static uint32_t telemetry_uptime = 0;       // Uptime (in s) ...
+static uint32_t telemetry_uptime_us = 0;    // ... and the remaining us
+static uint32_t telemetry_bytes[2] = {0, 0};
+static uint32_t telemetry_drops = 0;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+static uint8_t * ICACHE_FLASH_ATTR telemetry_put16(uint8_t *ptr, uint16_t val) {
+  ptr[0] = val >> 8;
+  ptr[1] = val;
+  return ptr + 2;
+}
+
+static uint8_t * ICACHE_FLASH_ATTR telemetry_put32(uint8_t *ptr, uint32_t val) {
+  ptr[0] = val >> 24;
+  ptr[1] = val >> 16;
+  ptr[2] = val >> 8;
+  ptr[3] = val;
+  return ptr + 4;
+}
+
+static uint16_t ICACHE_FLASH_ATTR telemetry_get16(const uint8_t *ptr) {
+  return ((uint16_t) ptr[0] << 8) | ptr[1];
+}
+
+static uint32_t ICACHE_FLASH_ATTR telemetry_get32(const uint8_t *ptr) {
+  return ((uint32_t) ptr[0] << 24) | ((uint32_t) ptr[1] << 16) | ((uint32_t) ptr[2] << 8) | ptr[3];
+}
+
+// Return the number of associated clients of the soft access-point
+static uint8_t ICACHE_FLASH_ATTR telemetry_clients(void) {
+  const struct client_stats *client;
+  uint8_t count = 0;
+
+  for (client = client_stats_next(NULL); client; client = client_stats_next(client)) {
+    if (client->aid) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/*------------------------------------*/
+
+// Sampling:
+
+// Take a sample of the router's state; the rates and drops are computed over
+// the time since the last committed sample, which is replaced by this one if
+// commit is set (the samples have to be committed at least every 71 minutes,
+// since the system time wraps around)
+void ICACHE_FLASH_ATTR telemetry_sample_take(struct telemetry_sample *sample, bool commit) {
+  const struct napt_stats *stats = napt_stats_get();
+  uint32_t now = system_get_time();
+  uint32_t elapsed = now - telemetry_time;
+  uint32_t uptime_us = telemetry_uptime_us + elapsed % 1000000;
+  uint32_t drops = stats->drops - telemetry_drops;
+  uint8_t dir;
+
+  sample->uptime = telemetry_uptime + elapsed / 1000000 + uptime_us / 1000000;
+  sample->free_heap = system_get_free_heap_size();
+  sample->napt_entries = napt_count();
+  sample->napt_size = NAPT_TABLE_SIZE;
+  for (dir = 0; dir < 2; dir++) {
+    sample->rate[dir] = (elapsed) ? (uint64_t) (stats->bytes[dir] - telemetry_bytes[dir]) * 1000000 / elapsed : 0;
+  }
+  sample->clients = telemetry_clients();
+  sample->flags = ((wifi_station_get_connect_status() == STATION_GOT_IP) ? TELEMETRY_FLAG_CONNECTED : 0) | ((napt_is_enabled()) ? TELEMETRY_FLAG_NAPT : 0);
+  sample->drops = (drops > 0xFFFF) ? 0xFFFF : drops;
+
+  if (commit) {
+    telemetry_time = now;
+    telemetry_uptime = sample->uptime;
+    telemetry_uptime_us = uptime_us % 1000000;
+    telemetry_bytes[NAPT_DIR_OUT] = stats->bytes[NAPT_DIR_OUT];
+    telemetry_bytes[NAPT_DIR_IN] = stats->bytes[NAPT_DIR_IN];
+    telemetry_drops = stats->drops;
+  }
+}
+
+/*------------------------------------*/
+
+// Encoding and decoding:
+
+// Encode a frame of the given header (the count of samples is taken from it)
+// and samples into the buffer (of the given size); returns the length of the
+// frame resp. 0, if it doesn't fit
+uint16_t ICACHE_FLASH_ATTR telemetry_encode(uint8_t *buffer, uint16_t size, const struct telemetry_header *header, const struct telemetry_sample *samples) {
+  const struct telemetry_sample *sample;
+  uint8_t *ptr = buffer;
+  uint8_t idx;
+
+  if (!buffer || !header || (header->count && !samples) || header->count > TELEMETRY_SAMPLES_MAX ||
+      size < TELEMETRY_HEADER_LEN + header->count * TELEMETRY_SAMPLE_LEN) {
+    LOG_ERROR("telemetry_encode: Invalid transfer parameters!\n");
+    return 0;
+  }
+
+  ptr = telemetry_put16(ptr, TELEMETRY_MAGIC);
+  *ptr++ = TELEMETRY_VERSION;
+  *ptr++ = TELEMETRY_HEADER_LEN;
+  *ptr++ = TELEMETRY_SAMPLE_LEN;
+  *ptr++ = header->count;
+  ptr = telemetry_put16(ptr, header->seq);
+  os_memcpy(ptr, header->mac, 6);
+  ptr = telemetry_put16(ptr + 6, (header->interval / 1000 > 0xFFFF) ? 0xFFFF : header->interval / 1000);
+  ptr = telemetry_put32(ptr, header->interval);
+
+  for (idx = 0; idx < header->count; idx++) {
+    sample = &samples[idx];
+    ptr = telemetry_put32(ptr, sample->uptime);
+    ptr = telemetry_put32(ptr, sample->free_heap);
+    ptr = telemetry_put16(ptr, sample->napt_entries);
+    ptr = telemetry_put16(ptr, sample->napt_size);
+    ptr = telemetry_put32(ptr, sample->rate[NAPT_DIR_OUT]);
+    ptr = telemetry_put32(ptr, sample->rate[NAPT_DIR_IN]);
+    *ptr++ = sample->clients;
+    *ptr++ = sample->flags;
+    ptr = telemetry_put16(ptr, sample->drops);
+  }
+  return ptr - buffer;
+}
+
+// Decode the frame in the buffer into the header and (at most max of) its
+// samples; returns false, if the buffer doesn't hold a complete frame of a
+// compatible version
+bool ICACHE_FLASH_ATTR telemetry_decode(const uint8_t *buffer, uint16_t len, struct telemetry_header *header, struct telemetry_sample *samples, uint8_t max) {
+  struct telemetry_sample *sample;
+  const uint8_t *ptr;
+  uint8_t header_len, sample_len, idx;
+
+  if (!buffer || !header || len < TELEMETRY_HEADER_LEN || telemetry_get16(buffer) != TELEMETRY_MAGIC) {
+    return false;
+  }
+  header_len = buffer[3];
+  sample_len = buffer[4];
+  if (!buffer[2] || header_len < ((buffer[2] > 1) ? TELEMETRY_HEADER_LEN : TELEMETRY_HEADER_LEN_V1) || sample_len < TELEMETRY_SAMPLE_LEN ||
+      len < header_len + (uint32_t) buffer[5] * sample_len) {
+    return false;
+  }
+
+  header->version = buffer[2];
+  header->count = buffer[5];
+  header->seq = telemetry_get16(buffer + 6);
+  os_memcpy(header->mac, buffer + 8, 6);
+  header->interval = (buffer[2] > 1) ? telemetry_get32(buffer + 16) : telemetry_get16(buffer + 14) * 1000;
+
+  for (idx = 0; idx < header->count && idx < max && samples; idx++) {
+    ptr = buffer + header_len + idx * sample_len;
+    sample = &samples[idx];
+    sample->uptime = telemetry_get32(ptr);
+    sample->free_heap = telemetry_get32(ptr + 4);
+    sample->napt_entries = telemetry_get16(ptr + 8);
+    sample->napt_size = telemetry_get16(ptr + 10);
+    sample->rate[NAPT_DIR_OUT] = telemetry_get32(ptr + 12);
+    sample->rate[NAPT_DIR_IN] = telemetry_get32(ptr + 16);
+    sample->clients = ptr[20];
+    sample->flags = ptr[21];
+    sample->drops = telemetry_get16(ptr + 22);
+  }
+  return true;
+}
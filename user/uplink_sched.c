@@ -0,0 +1,506 @@
+// uplink_sched.c
+// Copyright 2026 Lukas Friedrichsen
+// License: Apache License Version 2.0
+//
+// 2026-10-15
+//
+// Description: Scheduler of the packets forwarded from the clients of the soft
+// access-point to the station network interface (uplink). Without it, the
+// packets are queued in the order of their arrival by the WiFi-driver resp.
+// the host access-point, so that a single client uploading in bulk delays the
+// packets of all others (e.g. MQTT via the portmap).
+//
+// Therefore, the translated packets are shaped to uplink_rate (cf. config.c;
+// slightly below the throughput of the uplink), so that the queue builds up
+// here instead. Every client (cf. client_stats.c) has a queue of its own; the
+// packets of unknown clients share another one. The queues are served by a
+// deficit-round-robin scheduler with a quantum of UPLINK_SCHED_QUANTUM bytes,
+// so that every backlogged client gets an equal share of the uplink
+// independent of the size of its packets. Additionally, every client can be
+// limited to a rate of its own by a token-bucket (UPLINK_SCHED_CLIENT_RATE
+// resp. uplink_sched_set_client_rate; cf. client_rateN in config.c).
+//
+// The packets of portmapped devices (cf. portmap_init in router.c) and the
+// control traffic (DHCP, DNS and DEVICE_COM_PORT) are classified by their
+// ports and sent through a queue of their own with strict priority ahead of
+// the clients' queues (UPLINK_SCHED_PRIORITY), so that they neither wait for
+// the round of their client nor for the rate limit of it; they still count
+// against the rate of the uplink.
+//
+// A queued packet keeps its receive-buffer, so the queues are limited to
+// UPLINK_SCHED_QUEUE_LEN packets per client and UPLINK_SCHED_BACKLOG packets in
+// total; if the backlog is full, the newest packet of the longest client's
+// queue is dropped (never one of the priority queue). Whenever the
+// token-buckets don't allow to send the next packet, a timer resumes the
+// scheduler once enough tokens have been accumulated.
+//
+// Only the packets forwarded by the fast path of napt_netif.c are scheduled;
+// the packets forwarded by lwip (and the traffic of the router itself) are
+// sent directly.
+
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "netif/etharp.h"
+#include "napt.h"
+#include "client_stats.h"
+#include "uplink_sched.h"
+#define LOG_MODULE LOG_MODULE_UPLINK
+#include "log.h"
+#include "user_config.h"
+
+/*------------------------------------*/
+
+#define UPLINK_SCHED_QUEUES (MAX_CLIENTS + 1) // One per client and one for unknown clients
+#define UPLINK_SCHED_QUEUE_UNKNOWN MAX_CLIENTS
+#define UPLINK_SCHED_QUEUE_PRIO UPLINK_SCHED_QUEUES     // Served ahead of the others
+
+#define UPLINK_SCHED_PORT_DNS 53
+#define UPLINK_SCHED_PORT_DHCP_SERVER 67
+#define UPLINK_SCHED_PORT_DHCP_CLIENT 68
+
+/*------------------------------------*/
+
+// Token-bucket; the tokens are counted in byte-us (bytes * 10^6), so that the
+// fractions of a byte accumulated between two packets aren't lost
+struct uplink_sched_bucket {
+  uint64_t tokens;
+  uint32_t last;  // Time of the last update (system time in us)
+};
+
+// Queued packet
+struct uplink_sched_packet {
+  struct pbuf *p;
+  uint32_t nexthop;
+};
+
+// Queue of a client
+struct uplink_sched_queue {
+  struct uplink_sched_packet packets[UPLINK_SCHED_QUEUE_LEN];
+  uint8_t head;
+  uint8_t count;
+  bool visited;     // The quantum of the current round has been added
+  uint8_t mac[6];   // Client, to which the rate belongs
+  uint32_t deficit; // Bytes, that may be sent in the current round
+  uint32_t rate;    // Rate limit of the client (in bytes/s; 0 = unlimited)
+  struct uplink_sched_bucket bucket;
+};
+
+// Rate limit of a client set by uplink_sched_set_client_rate
+struct uplink_sched_limit {
+  uint8_t mac[6];
+  uint32_t rate;
+};
+
+/*------------------------------------*/
+
+// Definition of functions (so there won't be any complications because the
+// compiler resolves the scope top-down):
+
+// Helper-functions:
+static void uplink_sched_refill(struct uplink_sched_bucket *bucket, uint32_t rate, uint32_t now);
+static uint32_t uplink_sched_wait(struct uplink_sched_bucket *bucket, uint32_t rate, uint16_t len);
+static uint32_t uplink_sched_client_rate(const uint8_t *mac);
+static bool uplink_sched_control_port(uint16_t port);
+static bool uplink_sched_classify(const struct pbuf *p);
+static void uplink_sched_drop_tail(struct uplink_sched_queue *queue);
+static void uplink_sched_run(void);
+
+// Timer-functions:
+static void uplink_sched_timerfunc(void *arg);
+
+// Queueing:
+bool uplink_sched_enqueue(struct pbuf *p, struct netif *outp, uint32_t nexthop, const struct client_stats *client);
+const struct uplink_sched_stats *uplink_sched_stats_get(void);
+
+// Initialization and configuration:
+void uplink_sched_set_priority(bool enabled);
+bool uplink_sched_set_client_rate(const uint8_t *mac, uint32_t rate);
+void uplink_sched_clear_client_rates(void);
+void uplink_sched_set_rate(uint32_t rate);
+void uplink_sched_flush(void);
+
+/*------------------------------------*/
+
+// Declaration and initialization of variables:
+
+static struct uplink_sched_queue uplink_sched_queues[UPLINK_SCHED_QUEUES + 1];
+static struct uplink_sched_limit uplink_sched_limits[MAX_CLIENTS];
+static struct uplink_sched_bucket uplink_sched_link;
+static struct uplink_sched_stats uplink_sched_stats;
+static uint32_t uplink_sched_rate = UPLINK_SCHED_RATE;
+static bool uplink_sched_priority = UPLINK_SCHED_PRIORITY;
+static uint16_t uplink_sched_active = 0;  // Bitmask of the backlogged queues
+static uint8_t uplink_sched_next = 0;     // Queue served next
+static struct netif *uplink_sched_netif = NULL;
+static os_timer_t uplink_sched_timer;
+
+/*------------------------------------*/
+
+// Helper-functions:
+
+// Add the tokens accumulated since the last update to the bucket (up to
+// UPLINK_SCHED_BURST bytes)
+static void ICACHE_FLASH_ATTR uplink_sched_refill(struct uplink_sched_bucket *bucket, uint32_t rate, uint32_t now) {
+  uint64_t burst = (uint64_t) UPLINK_SCHED_BURST * 1000000;
+  uint32_t elapsed = now - bucket->last;
+
+  bucket->last = now;
+  if (elapsed >= UPLINK_SCHED_BURST * (1000000 / rate + 1)) {
+    bucket->tokens = burst;
+    return;
+  }
+  bucket->tokens += (uint64_t) rate * elapsed;
+  if (bucket->tokens > burst) {
+    bucket->tokens = burst;
+  }
+}
+
+// Return the time until the bucket holds the tokens for a packet of len bytes
+// (in us; 0, if it can be sent at once)
+static uint32_t ICACHE_FLASH_ATTR uplink_sched_wait(struct uplink_sched_bucket *bucket, uint32_t rate, uint16_t len) {
+  uint64_t needed = (uint64_t) len * 1000000;
+
+  if (bucket->tokens >= needed) {
+    return 0;
+  }
+  return (uint32_t) ((needed - bucket->tokens + rate - 1) / rate);
+}
+
+// Return the rate limit of the client with the given MAC-address
+static uint32_t ICACHE_FLASH_ATTR uplink_sched_client_rate(const uint8_t *mac) {
+  uint8_t idx;
+
+  for (idx = 0; idx < MAX_CLIENTS; idx++) {
+    if (uplink_sched_limits[idx].rate && os_memcmp(uplink_sched_limits[idx].mac, mac, 6) == 0) {
+      return uplink_sched_limits[idx].rate;
+    }
+  }
+  return UPLINK_SCHED_CLIENT_RATE;
+}
+
+// Return true, if the given port (in host byte order) belongs to the control
+// traffic
+static bool ICACHE_FLASH_ATTR uplink_sched_control_port(uint16_t port) {
+  return port == UPLINK_SCHED_PORT_DNS || port == UPLINK_SCHED_PORT_DHCP_SERVER || port == UPLINK_SCHED_PORT_DHCP_CLIENT || port == DEVICE_COM_PORT;
+}
+
+// Return true, if the given translated packet (without its ethernet-header) is
+// sent with priority: packets of portmapped devices (their source port is the
+// mapping port then) and of the control traffic
+static bool ICACHE_FLASH_ATTR uplink_sched_classify(const struct pbuf *p) {
+  const uint8_t *iphdr = (const uint8_t *) p->payload, *l4hdr;
+  uint16_t hlen = (iphdr[0] & 0x0F) * 4, sport, dport;
+
+  if (iphdr[9] != NAPT_PROTO_TCP && iphdr[9] != NAPT_PROTO_UDP) {
+    return false;
+  }
+  if (p->len < hlen + 4) {
+    return false;
+  }
+  l4hdr = iphdr + hlen;
+  sport = (l4hdr[0] << 8) | l4hdr[1];
+  dport = (l4hdr[2] << 8) | l4hdr[3];
+  if (uplink_sched_control_port(sport) || uplink_sched_control_port(dport)) {
+    return true;
+  }
+  return napt_portmap_find(iphdr[9], PP_HTONS(sport)) != NULL;
+}
+
+// Drop the newest packet of the given queue
+static void ICACHE_FLASH_ATTR uplink_sched_drop_tail(struct uplink_sched_queue *queue) {
+  queue->count--;
+  pbuf_free(queue->packets[(queue->head + queue->count) % UPLINK_SCHED_QUEUE_LEN].p);
+  uplink_sched_stats.backlog--;
+  uplink_sched_stats.drops++;
+  if (!queue->count) {
+    uplink_sched_active &= ~(1 << (queue - uplink_sched_queues));
+    queue->deficit = 0;
+    queue->visited = false;
+  }
+}
+
+// Send the queued packets in deficit-round-robin order, as long as the token-
+// buckets allow; otherwise, the timer is armed to resume once they do
+static void ICACHE_FLASH_ATTR uplink_sched_run(void) {
+  struct uplink_sched_queue *queue;
+  struct uplink_sched_packet *packet;
+  uint32_t now = system_get_time(), wait = 0, client_wait, link_wait = 0;
+  uint16_t blocked = 0, len;
+  ip_addr_t nexthop;
+  uint8_t idx;
+
+  os_timer_disarm(&uplink_sched_timer);
+  uplink_sched_refill(&uplink_sched_link, uplink_sched_rate, now);
+
+  while (uplink_sched_active & ~blocked) {
+    // The priority queue is served first, the others in their round
+    if (uplink_sched_active & (1 << UPLINK_SCHED_QUEUE_PRIO)) {
+      idx = UPLINK_SCHED_QUEUE_PRIO;
+    }
+    else if (!((uplink_sched_active & ~blocked) & (1 << uplink_sched_next))) {
+      uplink_sched_next = (uplink_sched_next + 1) % UPLINK_SCHED_QUEUES;
+      continue;
+    }
+    else {
+      idx = uplink_sched_next;
+    }
+    queue = &uplink_sched_queues[idx];
+    packet = &queue->packets[queue->head];
+    len = packet->p->tot_len;
+
+    if (idx != UPLINK_SCHED_QUEUE_PRIO) {
+      // A queue may send up to its deficit per round
+      if (!queue->visited) {
+        queue->deficit += UPLINK_SCHED_QUANTUM;
+        queue->visited = true;
+      }
+      if (len > queue->deficit) {
+        queue->visited = false;
+        uplink_sched_next = (uplink_sched_next + 1) % UPLINK_SCHED_QUEUES;
+        continue;
+      }
+
+      // Clients, that exceed their rate limit, are skipped until they may
+      // send again
+      if (queue->rate) {
+        uplink_sched_refill(&queue->bucket, queue->rate, now);
+        client_wait = uplink_sched_wait(&queue->bucket, queue->rate, len);
+        if (client_wait) {
+          blocked |= 1 << idx;
+          wait = (!wait || client_wait < wait) ? client_wait : wait;
+          uplink_sched_next = (uplink_sched_next + 1) % UPLINK_SCHED_QUEUES;
+          continue;
+        }
+      }
+    }
+
+    // Resume, once the uplink may send the packet
+    link_wait = uplink_sched_wait(&uplink_sched_link, uplink_sched_rate, len);
+    if (link_wait) {
+      break;
+    }
+
+    uplink_sched_link.tokens -= (uint64_t) len * 1000000;
+    if (idx != UPLINK_SCHED_QUEUE_PRIO) {
+      if (queue->rate) {
+        queue->bucket.tokens -= (uint64_t) len * 1000000;
+      }
+      queue->deficit -= len;
+    }
+    queue->head = (queue->head + 1) % UPLINK_SCHED_QUEUE_LEN;
+    queue->count--;
+    uplink_sched_stats.backlog--;
+    if (!queue->count) {
+      uplink_sched_active &= ~(1 << idx);
+      queue->deficit = 0;
+      queue->visited = false;
+      if (idx != UPLINK_SCHED_QUEUE_PRIO) {
+        uplink_sched_next = (uplink_sched_next + 1) % UPLINK_SCHED_QUEUES;
+      }
+    }
+
+    // etharp_output prepends the ethernet-header in place (cf. napt_netif.c)
+    nexthop.addr = packet->nexthop;
+    etharp_output(uplink_sched_netif, packet->p, &nexthop);
+    pbuf_free(packet->p);
+    uplink_sched_stats.sent++;
+  }
+
+  // The earliest of the blocked clients and the uplink resumes the scheduler
+  // (wait only holds the waits of the clients)
+  if (link_wait && (!wait || link_wait < wait)) {
+    wait = link_wait;
+  }
+  if (wait) {
+    os_timer_setfn(&uplink_sched_timer, (os_timer_func_t *) uplink_sched_timerfunc, NULL);
+    os_timer_arm(&uplink_sched_timer, (wait + 999) / 1000, false);
+  }
+}
+
+/*------------------------------------*/
+
+// Timer-functions:
+
+// Timer-function, that resumes the scheduler once the token-buckets allow to
+// send the next packet
+static void ICACHE_FLASH_ATTR uplink_sched_timerfunc(void *arg) {
+  uplink_sched_run();
+}
+
+/*------------------------------------*/
+
+// Queueing:
+
+// Queue a translated packet (without its ethernet-header) of the given client
+// (NULL, if it isn't known) for the station network interface outp; the
+// scheduler takes over the pbuf. Returns false, if the scheduler is disabled
+// (the pbuf is untouched then).
+bool ICACHE_FLASH_ATTR uplink_sched_enqueue(struct pbuf *p, struct netif *outp, uint32_t nexthop, const struct client_stats *client) {
+  struct uplink_sched_queue *queue, *longest;
+  uint8_t idx;
+
+  if (!uplink_sched_rate) {
+    return false;
+  }
+  uplink_sched_netif = outp;
+
+  if (uplink_sched_priority && uplink_sched_classify(p)) {
+    idx = UPLINK_SCHED_QUEUE_PRIO;
+    uplink_sched_stats.priority++;
+  }
+  else {
+    idx = (client) ? client_stats_slot(client) : UPLINK_SCHED_QUEUE_UNKNOWN;
+  }
+  queue = &uplink_sched_queues[idx];
+
+  // The slot of a client is reused for another one after its disassociation
+  if (idx == UPLINK_SCHED_QUEUE_PRIO) {
+    queue->rate = 0;
+  }
+  else if (idx == UPLINK_SCHED_QUEUE_UNKNOWN) {
+    queue->rate = UPLINK_SCHED_CLIENT_RATE;
+  }
+  else if (os_memcmp(queue->mac, client->mac, 6) != 0) {
+    os_memcpy(queue->mac, client->mac, 6);
+    queue->rate = uplink_sched_client_rate(client->mac);
+    queue->bucket.tokens = (uint64_t) UPLINK_SCHED_BURST * 1000000;
+    queue->bucket.last = system_get_time();
+  }
+
+  // If the backlog is full, the newest packet of the longest client's queue is
+  // dropped; the priority queue is never shortened, a packet of it takes the
+  // place of a client's one
+  if (uplink_sched_stats.backlog >= UPLINK_SCHED_BACKLOG && queue->count < UPLINK_SCHED_QUEUE_LEN) {
+    longest = (queue == &uplink_sched_queues[UPLINK_SCHED_QUEUE_PRIO]) ? NULL : queue;
+    for (idx = 0; idx < UPLINK_SCHED_QUEUES; idx++) {
+      if (uplink_sched_queues[idx].count && (!longest || uplink_sched_queues[idx].count > longest->count)) {
+        longest = &uplink_sched_queues[idx];
+      }
+    }
+    if (longest && longest != queue) {
+      uplink_sched_drop_tail(longest);
+    }
+  }
+  if (queue->count >= UPLINK_SCHED_QUEUE_LEN || uplink_sched_stats.backlog >= UPLINK_SCHED_BACKLOG) {
+    pbuf_free(p);
+    uplink_sched_stats.drops++;
+    return true;
+  }
+
+  queue->packets[(queue->head + queue->count) % UPLINK_SCHED_QUEUE_LEN].p = p;
+  queue->packets[(queue->head + queue->count) % UPLINK_SCHED_QUEUE_LEN].nexthop = nexthop;
+  queue->count++;
+  uplink_sched_active |= 1 << (queue - uplink_sched_queues);
+  uplink_sched_stats.enqueued++;
+  uplink_sched_stats.backlog++;
+  if (uplink_sched_stats.backlog > uplink_sched_stats.backlog_max) {
+    uplink_sched_stats.backlog_max = uplink_sched_stats.backlog;
+  }
+
+  uplink_sched_run();
+  return true;
+}
+
+const struct uplink_sched_stats * ICACHE_FLASH_ATTR uplink_sched_stats_get(void) {
+  return &uplink_sched_stats;
+}
+
+/*------------------------------------*/
+
+// Initialization and configuration:
+
+// Enable resp. disable the priority queue for the packets of portmapped
+// devices and the control traffic (if disabled, they are queued like the
+// other packets of their client)
+void ICACHE_FLASH_ATTR uplink_sched_set_priority(bool enabled) {
+  uplink_sched_priority = enabled;
+}
+
+// Limit the client with the given MAC-address to the given rate (in bytes/s);
+// 0 restores UPLINK_SCHED_CLIENT_RATE. Returns false, if MAX_CLIENTS clients
+// have a rate limit of their own already.
+bool ICACHE_FLASH_ATTR uplink_sched_set_client_rate(const uint8_t *mac, uint32_t rate) {
+  struct uplink_sched_limit *limit = NULL;
+  uint8_t idx;
+
+  for (idx = 0; idx < MAX_CLIENTS; idx++) {
+    if (uplink_sched_limits[idx].rate && os_memcmp(uplink_sched_limits[idx].mac, mac, 6) == 0) {
+      limit = &uplink_sched_limits[idx];
+      break;
+    }
+    if (!limit && !uplink_sched_limits[idx].rate) {
+      limit = &uplink_sched_limits[idx];
+    }
+  }
+  if (!limit) {
+    LOG_ERROR("uplink_sched_set_client_rate: Too many rate limits!\n");
+    return false;
+  }
+  os_memcpy(limit->mac, mac, 6);
+  limit->rate = rate;
+
+  // Apply the rate to the queue of the client, if it has one
+  for (idx = 0; idx < MAX_CLIENTS; idx++) {
+    if (os_memcmp(uplink_sched_queues[idx].mac, mac, 6) == 0) {
+      uplink_sched_queues[idx].rate = (rate) ? rate : UPLINK_SCHED_CLIENT_RATE;
+    }
+  }
+  return true;
+}
+
+// Remove the rate limits of all clients (they're limited to
+// UPLINK_SCHED_CLIENT_RATE again)
+void ICACHE_FLASH_ATTR uplink_sched_clear_client_rates(void) {
+  uint8_t idx;
+
+  os_memset(uplink_sched_limits, 0, sizeof(uplink_sched_limits));
+  for (idx = 0; idx < MAX_CLIENTS; idx++) {
+    uplink_sched_queues[idx].rate = UPLINK_SCHED_CLIENT_RATE;
+  }
+}
+
+// Set the rate, to which the uplink is shaped (in bytes/s); 0 disables the
+// scheduler (the queued packets are sent at once)
+void ICACHE_FLASH_ATTR uplink_sched_set_rate(uint32_t rate) {
+  struct uplink_sched_queue *queue;
+  ip_addr_t nexthop;
+  uint8_t idx;
+
+  uplink_sched_rate = rate;
+  if (rate) {
+    return;
+  }
+  os_timer_disarm(&uplink_sched_timer);
+  for (idx = 0; idx <= UPLINK_SCHED_QUEUES; idx++) {
+    queue = &uplink_sched_queues[idx];
+    while (queue->count) {
+      nexthop.addr = queue->packets[queue->head].nexthop;
+      etharp_output(uplink_sched_netif, queue->packets[queue->head].p, &nexthop);
+      pbuf_free(queue->packets[queue->head].p);
+      queue->head = (queue->head + 1) % UPLINK_SCHED_QUEUE_LEN;
+      queue->count--;
+      uplink_sched_stats.backlog--;
+      uplink_sched_stats.sent++;
+    }
+    queue->deficit = 0;
+    queue->visited = false;
+  }
+  uplink_sched_active = 0;
+}
+
+// Drop all queued packets (e.g. when the network interfaces are detached)
+void ICACHE_FLASH_ATTR uplink_sched_flush(void) {
+  uint8_t idx;
+
+  os_timer_disarm(&uplink_sched_timer);
+  for (idx = 0; idx <= UPLINK_SCHED_QUEUES; idx++) {
+    while (uplink_sched_queues[idx].count) {
+      uplink_sched_drop_tail(&uplink_sched_queues[idx]);
+    }
+  }
+  uplink_sched_next = 0;
+  uplink_sched_netif = NULL;
+}
@@ -10,24 +10,31 @@
 //       "S20 Smart Socket" (cf. itead.cc/smart-socket-eu/html) by ITEAD,
 //
 // a WiFi-enabled smart socket based on the ESP8266-microcontroller. The router
-// is activated by actuating the pushbutton. The device then enters
-// smart-configuration-mode and tries to connect to a network, whose
-// authentication credentials it obtains via ESP-TOUCH from a nearby intermediary-
-// device (e.g. a smartphone). Once connected, the router-functionality is enabled.
+// is activated by actuating the pushbutton. The device then connects with the
+// credentials of the last activation (cf. fast_boot.c) or, if there are none
+// or they don't work, enters smart-configuration-mode and tries to connect to a
+// network, whose authentication credentials it obtains via ESP-TOUCH from a
+// nearby intermediary-device (e.g. a smartphone). Once connected, the
+// router-functionality is enabled.
 // Up to eight devices can connect to the router's access-point at once and a
 // maximum bitrate of about 5 Mbps in both directions can be achieved.
 //
+// The transitions between these modes are made by an event-driven state
+// machine (cf. lifecycle.c), whose actions are implemented by the hooks below.
+//
 // Furthermore, the router periodically broadcasts a vital sign to enable
 // automated availability-monitoring. The device's meta-data can be requested
 // via an UDP-message to the router.
 // For the whole time, the device's status is displayed by the LEDs:
 //
-//  green (blinking):         smart-configuration-mode (ESP-TOUCH)
+//  green (blinking):         connecting (fast boot resp. ESP-TOUCH)
 //  green (steady):           successfully connected, router enabled
 //  blue:                     output power turned on
 //
 // The configuration of the router (including the settings concerning the port
-// mapping) can be modified in user_config.h.
+// mapping) is loaded from the flash at start-up and can be modified via an
+// UDP-message to the router (cf. config.c); its defaults as well as the
+// remaining settings can be modified in user_config.h.
 //
 /******************************************************************************/
 // ATTENTION: Tested and compiled with ESP-NONOS-SDK version 2.0.0_16_08_10!
@@ -38,7 +45,13 @@
 #include "user_interface.h"
 #include "device_info.h"
 #include "esp_touch.h"
+#include "fast_boot.h"
+#include "lifecycle.h"
+#include "mem_pool.h"
 #include "router.h"
+#include "config.h"
+#define LOG_MODULE LOG_MODULE_MAIN
+#include "log.h"
 #include "user_config.h"
 
 /*------------------------------------*/
@@ -48,11 +61,11 @@
 
 // Callback-functions:
 static void router_disable_cb(void);
+static void router_online_cb(void);
+static void esptouch_done_cb(bool success);
 
 // Timer- and interrupt-handler-functions:
 static void button_actuated_interrupt_handler(void *arg);
-static void router_conn_timeout_wdtfunc(void *arg);
-static void esptouch_over_timerfunc(os_timer_t *timer);
 static void led_blink_timerfunc(void *arg);
 
 // GPIO control:
@@ -63,6 +76,7 @@ static void output_power_off(void);
 
 // Initialization and configuration:
 static bool router_enable(void);
+static bool router_provision(void);
 static void gpio_pins_init(void);
 
 void user_init(void);
@@ -75,19 +89,34 @@ void user_rf_pre_init(void);
 
 // Declaration and initialization of variables:
 
-static os_timer_t *led_blink_timer = NULL, *router_conn_timeout_wdt = NULL;
+static os_timer_t *led_blink_timer = NULL;
+
+// Actions of the lifecycle state machine
+static const struct lifecycle_hooks router_lifecycle_hooks = {
+  router_enable,
+  fast_boot_connect,
+  router_provision,
+  router_online_cb,
+  router_disable_cb
+};
 
 /*------------------------------------*/
 
 // Callback-functions:
 
-// Callback-function, that disables the router; restores the initial state of
-// the program, so that the device  is ready to be re-activated via the pushbutton
+// Callback-function, that disables the router (executed on the return to
+// LIFECYCLE_IDLE); restores the initial state of the program, so that the
+// device is ready to be re-activated via the pushbutton
 static void ICACHE_FLASH_ATTR router_disable_cb(void) {
   // Disable all further communication- and interaction-functionalities,
   // including the periodical vital sign broadcasts as well as the possibility
   // to request the devices meta-data
   device_info_disable();
+  fast_boot_stop();
+
+  // Stop the router's services (DHCP-server, DNS-proxy, mesh-routing and NAPT)
+  // while the network interfaces still exist
+  router_disable();
 
   // Clear possible connections, set the operation-mode to NULL_MODE and reset
   // the WiFi-event-handler-function
@@ -97,14 +126,9 @@ static void ICACHE_FLASH_ATTR router_disable_cb(void) {
 
   if (led_blink_timer) {
     os_timer_disarm(led_blink_timer);
-    os_free(led_blink_timer);
+    mem_pool_free(&mem_pool_timers, led_blink_timer);
     led_blink_timer = NULL;
   }
-  if (router_conn_timeout_wdt) {
-    os_timer_disarm(router_conn_timeout_wdt);
-    os_free(router_conn_timeout_wdt);
-    router_conn_timeout_wdt = NULL;
-  }
 
   // Turn off the status-LED (the state of the smart plug's power outlet isn't
   // changed, so connected peripheral equipment doesn't get damaged or shut down
@@ -118,6 +142,38 @@ static void ICACHE_FLASH_ATTR router_disable_cb(void) {
   ETS_GPIO_INTR_ENABLE(); // Re-enable the interrupts
 }
 
+// Callback-function, that is executed once the router is enabled (on the first
+// transition to LIFECYCLE_ONLINE); signalize it and start the further
+// communication- and interaction-functionalities
+static void ICACHE_FLASH_ATTR router_online_cb(void) {
+  // Cache the BSSID and channel of the host access-point for the next
+  // activation
+  fast_boot_save();
+
+  // Disarm and free the led_blink_timer and switch the green status-LED on to
+  // signalize, that ESP-TOUCH was successful and the router is now enabled
+  if (led_blink_timer) {
+    os_timer_disarm(led_blink_timer);
+    mem_pool_free(&mem_pool_timers, led_blink_timer);
+    led_blink_timer = NULL;
+  }
+  status_led_on();
+
+  // Initialize further communication- and interaction-functionalities (e.g.
+  // the possibility for other devices to request's meta-dat via an
+  // UDP-message)
+  device_info_init();
+
+  // Start periodical vital-sign-broadcasts
+  vital_sign_bcast_start();
+}
+
+// Callback-function, that is executed once ESP-TOUCH succeeded resp. finally
+// failed; hand the result to the lifecycle state machine
+static void ICACHE_FLASH_ATTR esptouch_done_cb(bool success) {
+  lifecycle_event((success) ? LIFECYCLE_EVENT_ESPTOUCH_SUCCESS : LIFECYCLE_EVENT_ESPTOUCH_FAIL);
+}
+
 /*------------------------------------*/
 
 // Timer- and interrupt-handler-functions:
@@ -128,64 +184,8 @@ static void ICACHE_FLASH_ATTR button_actuated_interrupt_handler(void *arg) {
   // Disable the interrupt whilst the device is activated
   ETS_GPIO_INTR_DISABLE();
 
-  // Try to initialize the router
-  router_enable();
-}
-
-// Timer-function to periodically check, if the connection to the router has
-// has been lost or if a timeout occured; restore the device's initial state in
-// that case
-static void ICACHE_FLASH_ATTR router_conn_timeout_wdtfunc(void *arg) {
-  if (!is_connected()) {
-    os_printf("router_conn_timeout_wdtfunc: Connection got lost or a timeout occured!\n");
-    router_disable_cb(); // Disable the router
-  }
-}
-
-// Timer-function, to periodically check, if ESP-TOUCH is still running and enable
-// the watchdog-timer as well as the periodical vital-sign-broadcasts and further
-// communication- and interaction-functionalities if it was successful or reset
-// the device in case it failed
-static void ICACHE_FLASH_ATTR esptouch_over_timerfunc(os_timer_t *timer) {
-  // Check, if ESP-TOUCH was successful
-  if (!esptouch_is_running()) {
-    // Disarm the timer and free the occupied resources
-    if (timer) {
-      os_timer_disarm(timer);
-      os_free(timer);
-    }
-
-    if (esptouch_was_successful()) {
-      // Disarm and free the led_blink_timer and switch the green status-LED
-      // on to signalize, that ESP-TOUCH was successful and the router is now
-      // enabled
-      if (led_blink_timer) {
-        os_timer_disarm(led_blink_timer);
-        os_free(led_blink_timer);
-        led_blink_timer = NULL;
-      }
-      status_led_on();
-
-      // Arm the watchdog-timer to periodically check on possible connection-
-      // losses or timeouts
-      os_timer_disarm(router_conn_timeout_wdt);
-      os_timer_setfn(router_conn_timeout_wdt, (os_timer_func_t *) router_conn_timeout_wdtfunc, NULL);
-      os_timer_arm(router_conn_timeout_wdt, ROUTER_CONN_TIMEOUT_WDT_INTERVAL, true);
-
-      // Initialize further communication- and interaction-functionalities (e.g.
-      // the possibility for other devices to request's meta-dat via an
-      // UDP-message)
-      device_info_init();
-
-      // Start periodical vital-sign-broadcasts
-      vital_sign_bcast_start();
-    }
-    else {
-      // Call router_disable_cb to free all further occupied resources and
-      // restore the device's initial state
-      router_disable_cb();
-    }
-  }
+  // Try to initialize the router (cf. router_enable)
+  lifecycle_event(LIFECYCLE_EVENT_BUTTON);
 }
 
 // Timer-function, that toggles the status-LED
@@ -229,16 +229,18 @@ static void ICACHE_FLASH_ATTR output_power_off(void) {
 
 // Initialization and configuration:
 
-// Initialize the router and start the smart-configuration-mode (ESP-TOUCH)
+// Initialize the router; executed on the actuation of the pushbutton in
+// LIFECYCLE_IDLE (the station is then connected by fast_boot_connect resp.
+// router_provision)
 static bool ICACHE_FLASH_ATTR router_enable(void) {
-  os_printf("router_enable: Initializing the router and starting ESP-TOUCH!\n");
+  LOG_INFO("router_enable: Initializing the router!\n");
 
   // Initialize the timer to toggle the status-LED while the smart-configuration-
   // mode is in progress
   if (!led_blink_timer) {
-    led_blink_timer = (os_timer_t *) os_zalloc(sizeof(os_timer_t));
+    led_blink_timer = (os_timer_t *) mem_pool_alloc(&mem_pool_timers);
     if (!led_blink_timer) { // Won't cause the program to abort since this only affects the status-LED
-      os_printf("router_enable: Failed to initialize led_blink_timer! Continuing without!\n");
+      LOG_WARN("router_enable: Failed to initialize led_blink_timer! Continuing without!\n");
     }
     else {
       // Start the timer to toggle the status-LED to signalize, that the device
@@ -249,44 +251,30 @@ static bool ICACHE_FLASH_ATTR router_enable(void) {
     }
   }
 
-  // Initialize the watchdog-timer to continually check, if the connection to the
-  // router has been lost
-  if (!router_conn_timeout_wdt) {
-    router_conn_timeout_wdt = (os_timer_t *) os_zalloc(sizeof(os_timer_t));
-  }
-  if (router_conn_timeout_wdt) {
-    // Periodically check, whether ESP-TOUCH has been finished yet and, if yes, if it
-    // was successful or not
-    os_timer_t *esptouch_wait_timer = (os_timer_t *) os_zalloc(sizeof(os_timer_t));
-    if (esptouch_wait_timer) {
-      os_timer_disarm(esptouch_wait_timer);
-      os_timer_setfn(esptouch_wait_timer, (os_timer_func_t *) esptouch_over_timerfunc, esptouch_wait_timer); // Assign the timer-function
-      os_timer_arm(esptouch_wait_timer, 500, true);  // Arm the timer; check on ESP-TOUCH once every 500ms
-
-      // Initialize the router
-      router_init();
-
-      // Initialize and start ESP-TOUCH
-      esptouch_init();
-
-      return true;
-    }
-    else {
-      os_printf("router_enable: Failed to initialize esptouch_wait_timer!\n");
-    }
-  }
-  else {
-    os_printf("router_enable: Failed to initialize router_conn_timeout_wdt!\n");
-  }
-  // Call router_disable_cb to free all occupied resources and restore the
-  // device's initial state
-  router_disable_cb();
-  return false;
+  // Initialize the router
+  router_init();
+
+  return true;
+}
+
+// Start the smart-configuration-mode (ESP-TOUCH), if there are no cached
+// credentials or the fast boot failed
+static bool ICACHE_FLASH_ATTR router_provision(void) {
+  LOG_INFO("router_provision: Starting ESP-TOUCH!\n");
+
+  fast_boot_stop();
+
+  // Initialize and start ESP-TOUCH; its result is handed to the lifecycle
+  // state machine (cf. esptouch_done_cb), that also restores the device's
+  // initial state on a failure
+  esptouch_init(esptouch_done_cb);
+
+  return true;
 }
 
 // Initialize the GPIO-pins to function as intended
 static void ICACHE_FLASH_ATTR gpio_pins_init(void) {
-  os_printf("gpio_pins_init: Initializing GPIO-pins!\n");
+  LOG_INFO("gpio_pins_init: Initializing GPIO-pins!\n");
 
   // Initialize the GPIO-subsystem
   gpio_init();
@@ -323,7 +311,7 @@ static void ICACHE_FLASH_ATTR gpio_pins_init(void) {
 
 // Entry point in the program; start the initialization-process
 void user_init(void) {
-  os_printf("user_init: Starting the initialization-process!\n");
+  LOG_INFO("user_init: Starting the initialization-process!\n");
 
   // Clear possible connections, set the operation-mode to NULL_MODE and reset
   // the WiFi-event-handler-function
@@ -331,6 +319,12 @@ void user_init(void) {
   wifi_set_opmode(NULL_MODE);
   wifi_set_event_handler_cb(NULL);
 
+  // Load the configuration of the router (cf. config.c)
+  config_load();
+
+  // Initialize the lifecycle state machine
+  lifecycle_init(&router_lifecycle_hooks);
+
   // Initialize the GPIO-pins
   gpio_pins_init();
 